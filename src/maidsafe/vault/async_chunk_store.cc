@@ -0,0 +1,227 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/async_chunk_store.h"
+
+#include <atomic>
+#include <string>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace {
+
+// Keys are spread over more strands than there are threads, so that a queue of operations on one
+// key doesn't hold up unrelated keys which happen to share its strand.
+const uint32_t kStrandsPerThread(8);
+
+template <typename Result>
+void SetResult(std::promise<Result>& promise, const std::function<Result()>& operation) {
+  try {
+    promise.set_value(operation());
+  }
+  catch (...) {
+    promise.set_exception(std::current_exception());
+  }
+}
+
+void SetResult(std::promise<void>& promise, const std::function<void()>& operation) {
+  try {
+    operation();
+    promise.set_value();
+  }
+  catch (...) {
+    promise.set_exception(std::current_exception());
+  }
+}
+
+template <typename Result>
+void Forward(std::promise<Result>& promise, std::future<Result>& result) {
+  try {
+    promise.set_value(result.get());
+  }
+  catch (...) {
+    promise.set_exception(std::current_exception());
+  }
+}
+
+void Forward(std::promise<void>& promise, std::future<void>& result) {
+  try {
+    result.get();
+    promise.set_value();
+  }
+  catch (...) {
+    promise.set_exception(std::current_exception());
+  }
+}
+
+template <typename Result>
+struct Batch {
+  typedef std::function<void(std::vector<std::future<Result>>)> Functor;
+
+  Batch(size_t size, Functor functor_in)
+      : results(size), remaining(size), functor(std::move(functor_in)) {}
+
+  void Set(size_t index, std::future<Result> result) {
+    results[index] = std::move(result);
+    if (--remaining == 0)
+      functor(std::move(results));
+  }
+
+  std::vector<std::future<Result>> results;
+  std::atomic<size_t> remaining;
+  Functor functor;
+};
+
+}  // unnamed namespace
+
+AsyncChunkStore::AsyncChunkStore(const fs::path& disk_path, DiskUsage max_disk_usage,
+                                 uint32_t io_thread_count)
+    : AsyncChunkStore(disk_path, max_disk_usage, ChunkStore::Mode::kPersistent, io_thread_count) {}
+
+AsyncChunkStore::AsyncChunkStore(const fs::path& disk_path, DiskUsage max_disk_usage,
+                                 ChunkStore::Mode mode, uint32_t io_thread_count)
+    : chunk_store_(disk_path, max_disk_usage, mode),
+      asio_service_(io_thread_count),
+      strands_() {
+  for (uint32_t i(0); i != io_thread_count * kStrandsPerThread; ++i) {
+    strands_.push_back(std::unique_ptr<boost::asio::io_service::strand>(
+        new boost::asio::io_service::strand(asio_service_.service())));
+  }
+}
+
+AsyncChunkStore::~AsyncChunkStore() {
+  asio_service_.Stop();
+}
+
+template <typename Result>
+void AsyncChunkStore::Post(const KeyType& key, std::function<Result()> operation,
+                           std::function<void(std::future<Result>)> functor) {
+  Strand(key).post([operation, functor] {
+    std::promise<Result> promise;
+    SetResult(promise, operation);
+    try {
+      functor(promise.get_future());
+    }
+    catch (const std::exception& e) {
+      LOG(kError) << "AsyncChunkStore functor threw: " << boost::diagnostic_information(e);
+    }
+  });
+}
+
+boost::asio::io_service::strand& AsyncChunkStore::Strand(const KeyType& key) {
+  auto id(boost::apply_visitor(GetIdentityVisitor(), key));
+  return *strands_[std::hash<std::string>()(id.string()) % strands_.size()];
+}
+
+void AsyncChunkStore::Get(const KeyType& key, GetFunctor functor) {
+  Post<NonEmptyString>(key, [this, key] { return chunk_store_.Get(key); }, functor);
+}
+
+void AsyncChunkStore::Put(const KeyType& key, const NonEmptyString& value, PutFunctor functor) {
+  Put(key, ChunkBuffer(value), functor);
+}
+
+void AsyncChunkStore::GetBuffer(const KeyType& key, GetBufferFunctor functor) {
+  Post<ChunkBuffer>(key, [this, key] { return chunk_store_.GetBuffer(key); }, functor);
+}
+
+void AsyncChunkStore::Put(const KeyType& key, const ChunkBuffer& value, PutFunctor functor) {
+  Post<void>(key, [this, key, value] { chunk_store_.Put(key, value); }, functor);
+}
+
+void AsyncChunkStore::Delete(const KeyType& key, PutFunctor functor) {
+  Post<void>(key, [this, key] { chunk_store_.Delete(key); }, functor);
+}
+
+void AsyncChunkStore::Get(const std::vector<KeyType>& keys, BatchGetFunctor functor) {
+  if (keys.empty()) {
+    asio_service_.service().post(
+        [functor] { functor(std::vector<std::future<NonEmptyString>>()); });
+    return;
+  }
+  auto batch(std::make_shared<Batch<NonEmptyString>>(keys.size(), functor));
+  for (size_t i(0); i != keys.size(); ++i) {
+    Get(keys[i], [batch, i](std::future<NonEmptyString> result) {
+      batch->Set(i, std::move(result));
+    });
+  }
+}
+
+void AsyncChunkStore::Put(const std::vector<std::pair<KeyType, NonEmptyString>>& entries,
+                          BatchPutFunctor functor) {
+  if (entries.empty()) {
+    asio_service_.service().post([functor] { functor(std::vector<std::future<void>>()); });
+    return;
+  }
+  auto batch(std::make_shared<Batch<void>>(entries.size(), functor));
+  for (size_t i(0); i != entries.size(); ++i) {
+    Put(entries[i].first, entries[i].second, [batch, i](std::future<void> result) {
+      batch->Set(i, std::move(result));
+    });
+  }
+}
+
+std::future<NonEmptyString> AsyncChunkStore::Get(const KeyType& key) {
+  auto promise(std::make_shared<std::promise<NonEmptyString>>());
+  Get(key, [promise](std::future<NonEmptyString> result) { Forward(*promise, result); });
+  return promise->get_future();
+}
+
+std::future<void> AsyncChunkStore::Put(const KeyType& key, const NonEmptyString& value) {
+  auto promise(std::make_shared<std::promise<void>>());
+  Put(key, value, [promise](std::future<void> result) { Forward(*promise, result); });
+  return promise->get_future();
+}
+
+std::future<ChunkBuffer> AsyncChunkStore::GetBuffer(const KeyType& key) {
+  auto promise(std::make_shared<std::promise<ChunkBuffer>>());
+  GetBuffer(key, [promise](std::future<ChunkBuffer> result) { Forward(*promise, result); });
+  return promise->get_future();
+}
+
+std::future<void> AsyncChunkStore::Put(const KeyType& key, const ChunkBuffer& value) {
+  auto promise(std::make_shared<std::promise<void>>());
+  Put(key, value, [promise](std::future<void> result) { Forward(*promise, result); });
+  return promise->get_future();
+}
+
+std::future<void> AsyncChunkStore::Delete(const KeyType& key) {
+  auto promise(std::make_shared<std::promise<void>>());
+  Delete(key, [promise](std::future<void> result) { Forward(*promise, result); });
+  return promise->get_future();
+}
+
+std::vector<AsyncChunkStore::KeyType> AsyncChunkStore::ElementsToStore(
+    std::set<KeyType> element_list) {
+  return chunk_store_.ElementsToStore(std::move(element_list));
+}
+
+void AsyncChunkStore::SetMaxDiskUsage(DiskUsage max_disk_usage) {
+  chunk_store_.SetMaxDiskUsage(max_disk_usage);
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,113 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_ASYNC_CHUNK_STORE_H_
+#define MAIDSAFE_VAULT_ASYNC_CHUNK_STORE_H_
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "boost/asio/strand.hpp"
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/types.h"
+
+#include "maidsafe/vault/chunk_buffer.h"
+#include "maidsafe/vault/chunk_store.h"
+#include "maidsafe/vault/parameters.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+// Runs ChunkStore operations on a dedicated pool of I/O threads, so that callers handling messages
+// aren't blocked by disk latency.  Each functor is invoked on an I/O thread with a ready future,
+// whose get() returns the result or rethrows the error from the operation.
+//
+// Operations on the same key are executed in the order they were submitted, so a Get issued after
+// a Put (or Delete) of the same key always observes it.  Operations on different keys run
+// concurrently, up to the number of I/O threads.
+class AsyncChunkStore {
+ public:
+  typedef ChunkStore::KeyType KeyType;
+  typedef std::function<void(std::future<NonEmptyString>)> GetFunctor;
+  typedef std::function<void(std::future<ChunkBuffer>)> GetBufferFunctor;
+  typedef std::function<void(std::future<void>)> PutFunctor;
+  typedef std::function<void(std::vector<std::future<NonEmptyString>>)> BatchGetFunctor;
+  typedef std::function<void(std::vector<std::future<void>>)> BatchPutFunctor;
+
+  AsyncChunkStore(const boost::filesystem::path& disk_path, DiskUsage max_disk_usage,
+                  uint32_t io_thread_count = detail::Parameters::chunk_store_io_thread_count);
+  AsyncChunkStore(const boost::filesystem::path& disk_path, DiskUsage max_disk_usage,
+                  ChunkStore::Mode mode,
+                  uint32_t io_thread_count = detail::Parameters::chunk_store_io_thread_count);
+  // Blocks until all submitted operations have completed and their functors have returned.
+  ~AsyncChunkStore();
+  AsyncChunkStore(const AsyncChunkStore&) = delete;
+  AsyncChunkStore& operator=(const AsyncChunkStore&) = delete;
+
+  void Get(const KeyType& key, GetFunctor functor);
+  void Put(const KeyType& key, const NonEmptyString& value, PutFunctor functor);
+  // The buffer variants share the chunk with the caller rather than copying it into the queue.
+  void GetBuffer(const KeyType& key, GetBufferFunctor functor);
+  void Put(const KeyType& key, const ChunkBuffer& value, PutFunctor functor);
+  void Delete(const KeyType& key, PutFunctor functor);
+
+  // Batched variants; 'functor' is invoked once, after every element has completed, with the
+  // results in the same order as the input.
+  void Get(const std::vector<KeyType>& keys, BatchGetFunctor functor);
+  void Put(const std::vector<std::pair<KeyType, NonEmptyString>>& entries,
+           BatchPutFunctor functor);
+
+  std::future<NonEmptyString> Get(const KeyType& key);
+  std::future<void> Put(const KeyType& key, const NonEmptyString& value);
+  std::future<ChunkBuffer> GetBuffer(const KeyType& key);
+  std::future<void> Put(const KeyType& key, const ChunkBuffer& value);
+  std::future<void> Delete(const KeyType& key);
+
+  std::vector<KeyType> ElementsToStore(std::set<KeyType> element_list);
+  void SetMaxDiskUsage(DiskUsage max_disk_usage);
+
+  DiskUsage GetMaxDiskUsage() const { return chunk_store_.GetMaxDiskUsage(); }
+  DiskUsage GetCurrentDiskUsage() const { return chunk_store_.GetCurrentDiskUsage(); }
+  boost::filesystem::path GetDiskPath() const { return chunk_store_.GetDiskPath(); }
+  std::vector<KeyType> GetKeys() const { return chunk_store_.GetKeys(); }
+  uint64_t GetEvictionCount() const { return chunk_store_.GetEvictionCount(); }
+
+ private:
+  template <typename Result>
+  void Post(const KeyType& key, std::function<Result()> operation,
+            std::function<void(std::future<Result>)> functor);
+  boost::asio::io_service::strand& Strand(const KeyType& key);
+
+  ChunkStore chunk_store_;
+  AsioService asio_service_;
+  std::vector<std::unique_ptr<boost::asio::io_service::strand>> strands_;
+};
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_ASYNC_CHUNK_STORE_H_
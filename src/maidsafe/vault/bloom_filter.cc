@@ -0,0 +1,99 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/bloom_filter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace maidsafe {
+
+namespace vault {
+
+// Sized as usual for 'capacity' items, with m = -n ln(p) / ln(2)^2 bits and k = (m / n) ln(2)
+// hashes, each derived from two independent ones as h1 + i * h2.
+BloomFilter::BloomFilter(size_t capacity, double false_positive_rate)
+    : capacity_(std::max<size_t>(capacity, 1)),
+      size_(0),
+      bit_count_(0),
+      hash_count_(0),
+      bits_() {
+  const double kLn2(std::log(2.0));
+  double rate(std::min(std::max(false_positive_rate, 1e-9), 0.5));
+  bit_count_ = std::max<uint64_t>(
+      64, static_cast<uint64_t>(std::ceil(-static_cast<double>(capacity_) * std::log(rate) /
+                                          (kLn2 * kLn2))));
+  bit_count_ = (bit_count_ + 63) / 64 * 64;
+  hash_count_ = static_cast<unsigned int>(std::max(1.0, std::min(30.0, std::round(
+      static_cast<double>(bit_count_) / static_cast<double>(capacity_) * kLn2))));
+  bits_.assign(static_cast<size_t>(bit_count_ / 64), 0);
+}
+
+bool BloomFilter::Add(const std::string& item) {
+  uint64_t first(0), second(0);
+  Hash(item, first, second);
+  bool added(false);
+  for (unsigned int i(0); i != hash_count_; ++i) {
+    uint64_t bit((first + i * second) % bit_count_);
+    uint64_t mask(uint64_t(1) << (bit % 64));
+    if ((bits_[static_cast<size_t>(bit / 64)] & mask) == 0) {
+      bits_[static_cast<size_t>(bit / 64)] |= mask;
+      added = true;
+    }
+  }
+  if (added)
+    ++size_;
+  return added;
+}
+
+bool BloomFilter::MayContain(const std::string& item) const {
+  uint64_t first(0), second(0);
+  Hash(item, first, second);
+  for (unsigned int i(0); i != hash_count_; ++i) {
+    uint64_t bit((first + i * second) % bit_count_);
+    if ((bits_[static_cast<size_t>(bit / 64)] & (uint64_t(1) << (bit % 64))) == 0)
+      return false;
+  }
+  return true;
+}
+
+void BloomFilter::Clear() {
+  std::fill(bits_.begin(), bits_.end(), 0);
+  size_ = 0;
+}
+
+// 64-bit FNV-1a, with the second hash taken from a further mix of the first.  The second is odd,
+// so the probes don't collapse onto one bit.
+void BloomFilter::Hash(const std::string& item, uint64_t& first, uint64_t& second) const {
+  uint64_t hash(14695981039346656037ULL);
+  for (unsigned char c : item) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  first = hash;
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  second = hash | 1;
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,60 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_BLOOM_FILTER_H_
+#define MAIDSAFE_VAULT_BLOOM_FILTER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace maidsafe {
+
+namespace vault {
+
+// A set of strings answering membership queries with no false negatives, and false positives at
+// about 'false_positive_rate' while it holds no more than 'capacity' strings.  Strings can't be
+// removed, so a filter grown stale by removals from the set it summarises must be rebuilt.  Not
+// thread-safe.
+class BloomFilter {
+ public:
+  BloomFilter(size_t capacity, double false_positive_rate);
+
+  // Returns true if 'item' wasn't already (or falsely appeared to be) in the filter.
+  bool Add(const std::string& item);
+  bool MayContain(const std::string& item) const;
+  void Clear();
+
+  size_t capacity() const { return capacity_; }
+  // The number of items added, not counting those which already appeared to be present.
+  size_t size() const { return size_; }
+
+ private:
+  void Hash(const std::string& item, uint64_t& first, uint64_t& second) const;
+
+  size_t capacity_, size_;
+  uint64_t bit_count_;
+  unsigned int hash_count_;
+  std::vector<uint64_t> bits_;
+};
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_BLOOM_FILTER_H_
@@ -0,0 +1,208 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/cache_handler/cache_manager.h"
+
+#ifdef MAIDSAFE_WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <future>
+#include <set>
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/vault/parameters.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace {
+
+// Returns zero if it can't be determined.
+uint64_t PhysicalMemory() {
+#ifdef MAIDSAFE_WIN32
+  MEMORYSTATUSEX status;
+  status.dwLength = sizeof(status);
+  return GlobalMemoryStatusEx(&status) ? status.ullTotalPhys : 0;
+#else
+  long pages(sysconf(_SC_PHYS_PAGES)), page_size(sysconf(_SC_PAGE_SIZE));
+  return (pages > 0 && page_size > 0) ?
+      static_cast<uint64_t>(pages) * static_cast<uint64_t>(page_size) : 0;
+#endif
+}
+
+const uint64_t kDefaultMemoryBudget(104857600);  // 100Mb
+const uint64_t kExpectedChunkSize(256 * 1024);
+const size_t kMinExpectedEntries(1024);
+
+size_t ExpectedEntries(const CacheBudget& budget) {
+  uint64_t total(budget.memory.data + budget.disk.data);
+  return std::max(static_cast<size_t>(total / kExpectedChunkSize), kMinExpectedEntries);
+}
+
+}  // unnamed namespace
+
+CacheBudget CacheBudget::FromEnvironment(const fs::path& disk_path, DiskUsage max_disk_usage) {
+  uint64_t physical_memory(PhysicalMemory());
+  MemoryUsage memory(physical_memory == 0 ? kDefaultMemoryBudget :
+                     physical_memory / 100 * detail::Parameters::cache_memory_percentage);
+  DiskUsage disk(max_disk_usage.data / 100 * detail::Parameters::cache_disk_percentage);
+
+  // The cache directory may not have been created yet, so check the nearest existing ancestor.
+  boost::system::error_code error_code;
+  fs::path existing(disk_path);
+  while (!existing.empty() && !fs::exists(existing, error_code))
+    existing = existing.parent_path();
+  if (!existing.empty()) {
+    fs::space_info space(fs::space(existing, error_code));
+    if (!error_code && space.available / 2 < disk.data) {
+      LOG(kInfo) << "Limiting the disk cache to " << space.available / 2 << " bytes of the "
+                 << space.available << " free.";
+      disk.data = space.available / 2;
+    }
+  }
+  return CacheBudget(memory, disk);
+}
+
+// A chunk is counted once when looked up and missed, and again when stored, so a single request
+// counts twice.
+const unsigned int CacheManager::kDiskAdmissionFrequency(3);
+
+CacheManager::CacheManager(const fs::path& disk_path, const CacheBudget& budget)
+    : frequency_sketch_(ExpectedEntries(budget)),
+      disk_counters_(),
+      promoted_(0),
+      demoted_(0),
+      pending_writes_mutex_(),
+      pending_writes_(),
+      memory_cache_(budget.memory, 0, &frequency_sketch_,
+                    [this](const KeyType& key, const ChunkBuffer& value) { Demote(key, value); }),
+      disk_cache_(disk_path, budget.disk, ChunkStore::Mode::kCache) {
+  LOG(kInfo) << "Cache budget: " << budget.memory.data << " bytes of memory, " << budget.disk.data
+             << " bytes of disk.";
+}
+
+boost::optional<ChunkBuffer> CacheManager::Get(const KeyType& key, Lifetime lifetime) {
+  auto value(memory_cache_.Find(key));
+  if (value || lifetime == Lifetime::kShortTerm)
+    return value;
+  if (!OnDisk(key)) {
+    disk_counters_.Miss();
+    return boost::none;
+  }
+  try {
+    value = disk_cache_.GetBuffer(key).get();
+  }
+  catch (const std::exception& e) {
+    // Evicted since it was found in the index, most likely.
+    LOG(kVerbose) << "Failed to read "
+                  << HexSubstr(boost::apply_visitor(GetIdentityVisitor(), key).string())
+                  << " from the disk cache: " << boost::diagnostic_information(e);
+    disk_counters_.Miss();
+    return boost::none;
+  }
+  disk_counters_.Hit(value->size());
+  if (memory_cache_.Store(key, *value))
+    promoted_.fetch_add(1, std::memory_order_relaxed);
+  return value;
+}
+
+void CacheManager::Store(const KeyType& key, const ChunkBuffer& value, Lifetime lifetime) {
+  if (lifetime == Lifetime::kShortTerm) {
+    memory_cache_.Store(key, value);
+    return;
+  }
+  // Refused by the memory tier, either for its size or in favour of the entries already there.
+  if (!memory_cache_.Store(key, value, true))
+    StoreOnDisk(key, value);
+}
+
+CacheBudget CacheManager::GetBudget() const {
+  return CacheBudget(memory_cache_.GetMaxMemoryUsage(), disk_cache_.GetMaxDiskUsage());
+}
+
+CacheManager::Statistics CacheManager::GetStatistics() const {
+  Statistics statistics;
+  statistics.memory = memory_cache_.GetStatistics();
+  statistics.disk = disk_counters_.Get();
+  statistics.promoted = promoted_.load(std::memory_order_relaxed);
+  statistics.demoted = demoted_.load(std::memory_order_relaxed);
+  statistics.memory_usage = memory_cache_.GetCurrentMemoryUsage();
+  statistics.disk_usage = disk_cache_.GetCurrentDiskUsage();
+  statistics.disk_evictions = disk_cache_.GetEvictionCount();
+  return statistics;
+}
+
+void CacheManager::Demote(const KeyType& key, const ChunkBuffer& value) {
+  if (StoreOnDisk(key, value))
+    demoted_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool CacheManager::StoreOnDisk(const KeyType& key, const ChunkBuffer& value) {
+  if (frequency_sketch_.Frequency(detail::DataNameVariantHash()(key)) < kDiskAdmissionFrequency) {
+    disk_counters_.Rejected();
+    return false;
+  }
+  disk_counters_.Admitted(value.size());
+  {
+    std::lock_guard<std::mutex> lock(pending_writes_mutex_);
+    ++pending_writes_[key];
+  }
+  disk_cache_.Put(key, value, [this, key](std::future<void> result) {
+    {
+      std::lock_guard<std::mutex> lock(pending_writes_mutex_);
+      auto itr(pending_writes_.find(key));
+      if (--itr->second == 0)
+        pending_writes_.erase(itr);
+    }
+    try {
+      result.get();
+    }
+    catch (const std::exception& e) {
+      LOG(kError) << "Failed to store "
+                  << HexSubstr(boost::apply_visitor(GetIdentityVisitor(), key).string())
+                  << " in the disk cache: " << boost::diagnostic_information(e);
+    }
+  });
+  return true;
+}
+
+bool CacheManager::OnDisk(const KeyType& key) {
+  {
+    std::lock_guard<std::mutex> lock(pending_writes_mutex_);
+    if (pending_writes_.count(key) != 0)
+      return true;
+  }
+  std::set<KeyType> keys;
+  keys.insert(key);
+  return disk_cache_.ElementsToStore(keys).empty();
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
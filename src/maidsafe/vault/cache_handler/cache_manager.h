@@ -0,0 +1,124 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_CACHE_HANDLER_CACHE_MANAGER_H_
+#define MAIDSAFE_VAULT_CACHE_HANDLER_CACHE_MANAGER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+#include "boost/filesystem/path.hpp"
+#include "boost/optional/optional.hpp"
+
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/data_types/data_name_variant.h"
+
+#include "maidsafe/vault/async_chunk_store.h"
+#include "maidsafe/vault/cache_statistics.h"
+#include "maidsafe/vault/chunk_buffer.h"
+#include "maidsafe/vault/frequency_sketch.h"
+#include "maidsafe/vault/sharded_memory_cache.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+// Capacities of the cache handler's memory and disk tiers.
+struct CacheBudget {
+  CacheBudget(MemoryUsage memory_in, DiskUsage disk_in) : memory(memory_in), disk(disk_in) {}
+
+  // The memory tier gets Parameters::cache_memory_percentage of the physical memory (or 100Mb if
+  // that can't be determined).  The disk tier gets Parameters::cache_disk_percentage of the vault's
+  // 'max_disk_usage', but no more than half the space currently free at 'disk_path'.
+  static CacheBudget FromEnvironment(const boost::filesystem::path& disk_path,
+                                     DiskUsage max_disk_usage);
+
+  MemoryUsage memory;
+  DiskUsage disk;
+};
+
+// Two-tier chunk cache: a ShardedMemoryCache in front of an evicting AsyncChunkStore, sharing one
+// FrequencySketch for admission to both.
+//
+// Short-term cacheable chunks are only held in memory.  Long-term cacheable ones are stored in
+// memory first, and are demoted to disk when evicted from memory rather than dropped; a miss in
+// memory is looked up on disk, and a disk hit is promoted back into memory.  A promoted chunk is
+// still on disk, so isn't written again if it's demoted.  Chunks are only written to disk once
+// they have been requested or stored at least kDiskAdmissionFrequency times recently, so chunks
+// seen once, or looked up once and then stored, don't cost a disk write.
+class CacheManager {
+ public:
+  typedef DataNameVariant KeyType;
+
+  enum class Lifetime { kShortTerm, kLongTerm };
+
+  struct Statistics {
+    Statistics()
+        : memory(), disk(), promoted(0), demoted(0), memory_usage(0), disk_usage(0),
+          disk_evictions(0) {}
+    CacheStatistics memory, disk;
+    // Chunks moved from disk to memory on a hit, and from memory to disk on eviction.
+    uint64_t promoted, demoted;
+    MemoryUsage memory_usage;
+    DiskUsage disk_usage;
+    uint64_t disk_evictions;
+  };
+
+  static const unsigned int kDiskAdmissionFrequency;
+
+  CacheManager(const boost::filesystem::path& disk_path, const CacheBudget& budget);
+  CacheManager(const CacheManager&) = delete;
+  CacheManager& operator=(const CacheManager&) = delete;
+
+  // Misses are reported without throwing.  A key absent from the disk tier's index (and its queued
+  // writes) is a miss without touching the disk; otherwise the lookup blocks until the chunk has
+  // been read, so a hit is only reported with the chunk in hand.
+  boost::optional<ChunkBuffer> Get(const KeyType& key, Lifetime lifetime);
+  // Disk writes are queued on the disk tier's I/O threads; a subsequent Get for the same key is
+  // ordered after them.
+  void Store(const KeyType& key, const ChunkBuffer& value, Lifetime lifetime);
+
+  CacheBudget GetBudget() const;
+  Statistics GetStatistics() const;
+
+ private:
+  void Demote(const KeyType& key, const ChunkBuffer& value);
+  // Applies the admission frequency threshold before writing; returns whether it was written.
+  bool StoreOnDisk(const KeyType& key, const ChunkBuffer& value);
+  bool OnDisk(const KeyType& key);
+
+  FrequencySketch frequency_sketch_;
+  CacheCounters disk_counters_;
+  std::atomic<uint64_t> promoted_, demoted_;
+  // The keys of the disk writes queued but not yet completed, with a count of each.
+  std::mutex pending_writes_mutex_;
+  std::map<KeyType, int> pending_writes_;
+  // Demotes into 'disk_cache_', which is only used once both are constructed.
+  ShardedMemoryCache memory_cache_;
+  // Updates 'pending_writes_' from its I/O threads, so must be destroyed first, which waits for
+  // them to finish.
+  AsyncChunkStore disk_cache_;
+};
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_CACHE_HANDLER_CACHE_MANAGER_H_
@@ -25,22 +25,13 @@ namespace maidsafe {
 
 namespace vault {
 
-namespace {
-
-MemoryUsage mem_usage = MemoryUsage(524288000);  // 500Mb
-MemoryUsage cache_usage = MemoryUsage(mem_usage * 2 / 5);
-MemoryUsage mem_only_cache_usage = MemoryUsage(100);  // size in elements
-DiskUsage cache_size = DiskUsage(200);
-
-}  // unnamed namespace
-
 CacheHandlerService::CacheHandlerService(routing::Routing& routing,
-                                         const boost::filesystem::path& vault_root_dir)
+                                         const boost::filesystem::path& vault_root_dir,
+                                         DiskUsage max_disk_usage)
     : routing_(routing),
       dispatcher_(routing),
-      cache_size_(cache_size),
-      cache_data_store_(vault_root_dir / "cache" / "cache", DiskUsage(cache_usage)),
-      mem_only_cache_(mem_only_cache_usage) {
+      cache_manager_(vault_root_dir / "cache" / "cache",
+                     CacheBudget::FromEnvironment(vault_root_dir, max_disk_usage)) {
   routing_.kNodeId();
 }
 
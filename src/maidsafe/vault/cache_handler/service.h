@@ -19,16 +19,17 @@
 #ifndef MAIDSAFE_VAULT_CACHE_HANDLER_SERVICE_H_
 #define MAIDSAFE_VAULT_CACHE_HANDLER_SERVICE_H_
 
+#include <future>
 #include <type_traits>
 
-#include "maidsafe/vault/chunk_store.h"
-#include "maidsafe/vault/memory_fifo.h"
+#include "maidsafe/vault/chunk_buffer.h"
 
 #include "maidsafe/routing/routing_api.h"
 #include "maidsafe/nfs/message_wrapper.h"
 #include "maidsafe/vault/message_types.h"
 #include "maidsafe/nfs/message_types.h"
 
+#include "maidsafe/vault/cache_handler/cache_manager.h"
 #include "maidsafe/vault/cache_handler/dispatcher.h"
 
 
@@ -56,13 +57,19 @@ class CacheHandlerService {
   typedef void VaultMessages;
   typedef bool HandleMessageReturnType;
 
-  CacheHandlerService(routing::Routing& routing, const boost::filesystem::path& vault_root_dir);
+  // The cache tiers are sized from 'max_disk_usage' (the vault's) as per CacheBudget.
+  CacheHandlerService(routing::Routing& routing, const boost::filesystem::path& vault_root_dir,
+                      DiskUsage max_disk_usage);
 
   template <typename MessageType>
   HandleMessageReturnType HandleMessage(const MessageType& message,
                                         const typename MessageType::Sender& sender,
                                         const typename MessageType::Receiver& receiver);
 
+  // Lookups, store attempts and usage per tier, for measuring the caches' effectiveness on real
+  // traffic.
+  CacheManager::Statistics GetCacheStatistics() const { return cache_manager_.GetStatistics(); }
+
   friend class detail::PutToCacheVisitor;
   template<typename RequestorType> friend class detail::GetFromCacheVisitor;
   friend class test::CacheHandlerServiceTest;
@@ -92,9 +99,7 @@ class CacheHandlerService {
 
   routing::Routing& routing_;
   CacheHandlerDispatcher dispatcher_;
-  DiskUsage cache_size_;
-  ChunkStore cache_data_store_;
-  MemoryFIFO mem_only_cache_;
+  CacheManager cache_manager_;
 };
 
 template <typename MessageType>
@@ -160,10 +165,12 @@ template <typename Data>
 boost::optional<Data> CacheHandlerService::CacheGet(const typename Data::Name& data_name,
                                                     IsShortTermCacheable) {
   try {
+    auto content(cache_manager_.Get(GetDataNameVariant(Data::Tag::kValue, data_name.value),
+                                    CacheManager::Lifetime::kShortTerm));
+    if (!content)
+      return boost::optional<Data>();
     return boost::optional<Data>(
-               Data(data_name,
-                    typename Data::serialised_type(mem_only_cache_.Get(
-                        GetDataNameVariant(Data::Tag::kValue, data_name.value)))));
+               Data(data_name, typename Data::serialised_type(content->value())));
   }
   catch (const std::exception&) {
     return boost::optional<Data>();
@@ -174,10 +181,12 @@ template <typename Data>
 boost::optional<Data> CacheHandlerService::CacheGet(const typename Data::Name& data_name,
                                                     IsLongTermCacheable) {
   try {
+    auto content(cache_manager_.Get(GetDataNameVariant(Data::Tag::kValue, data_name.value),
+                                    CacheManager::Lifetime::kLongTerm));
+    if (!content)
+      return boost::optional<Data>();
     return boost::optional<Data>(
-               Data(data_name,
-                    typename Data::serialised_type(cache_data_store_.Get(
-                        GetDataNameVariant(Data::Tag::kValue, data_name.value)))));
+               Data(data_name, typename Data::serialised_type(content->value())));
   }
   catch (const std::exception&) {
     return boost::optional<Data>();
@@ -194,10 +203,10 @@ void CacheHandlerService::SendGetResponse(const Data& data, const nfs::MessageId
 template <typename Data>
 void CacheHandlerService::CacheStore(const Data& data, IsLongTermCacheable) {
   try {
-    LOG(kVerbose) << "CacheHandlerService::CacheStore: cache_data_store: "
+    LOG(kVerbose) << "CacheHandlerService::CacheStore: long term: "
                   << HexSubstr(data.name().value) << " on " << DebugId(routing_.kNodeId());
-    cache_data_store_.Put(GetDataNameVariant(Data::Tag::kValue, data.name().value),
-                          data.Serialise().data);
+    cache_manager_.Store(GetDataNameVariant(Data::Tag::kValue, data.name().value),
+                         ChunkBuffer(data.Serialise().data), CacheManager::Lifetime::kLongTerm);
   }
   catch (const std::exception&) {
     LOG(kError) << "Failed to store data in to the cache";
@@ -207,9 +216,9 @@ void CacheHandlerService::CacheStore(const Data& data, IsLongTermCacheable) {
 template <typename Data>
 void CacheHandlerService::CacheStore(const Data& data, IsShortTermCacheable) {
   try {
-    LOG(kVerbose) << "CacheHandlerService::CacheStore: mem_only_cache";
-    mem_only_cache_.Store(GetDataNameVariant(Data::Tag::kValue, data.name().value),
-                          data.Serialise().data);
+    LOG(kVerbose) << "CacheHandlerService::CacheStore: short term";
+    cache_manager_.Store(GetDataNameVariant(Data::Tag::kValue, data.name().value),
+                         ChunkBuffer(data.Serialise().data), CacheManager::Lifetime::kShortTerm);
   }
   catch (const std::exception&) {
     LOG(kError) << "Failed to store data in to the cache";
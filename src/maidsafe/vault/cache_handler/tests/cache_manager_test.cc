@@ -0,0 +1,195 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/cache_handler/cache_manager.h"
+
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/vault/parameters.h"
+#include "maidsafe/vault/tests/chunk_store_test_utils.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+namespace {
+
+typedef CacheManager::KeyType KeyType;
+typedef CacheManager::Lifetime Lifetime;
+
+const uint64_t kOneKB(1024);
+
+struct SetName : public boost::static_visitor<> {
+  explicit SetName(const NonEmptyString& value) : value_(value) {}
+
+  template <typename T>
+  void operator()(T& key) const {
+    key.value = Identity(crypto::Hash<crypto::SHA512>(value_));
+  }
+
+  const NonEmptyString& value_;
+};
+
+std::pair<KeyType, ChunkBuffer> GenerateKeyValue(uint64_t size) {
+  KeyType key(GetRandomDataNameType());
+  NonEmptyString value(RandomAlphaNumericString(static_cast<size_t>(size)));
+  boost::apply_visitor(SetName(value), key);
+  return std::make_pair(key, ChunkBuffer(value));
+}
+
+}  // unnamed namespace
+
+class CacheManagerTest : public testing::Test {
+ protected:
+  CacheManagerTest()
+      : test_path_(maidsafe::test::CreateTestPath("MaidSafe_Test_CacheManager")),
+        cache_path_(*test_path_ / "cache") {}
+
+  // Looks 'key' up as a long-term cacheable chunk, 'count' times.
+  void Request(CacheManager& cache_manager, const KeyType& key, int count) {
+    for (int i(0); i != count; ++i)
+      cache_manager.Get(key, Lifetime::kLongTerm);
+  }
+
+  const maidsafe::test::TestPath test_path_;
+  const boost::filesystem::path cache_path_;
+};
+
+TEST_F(CacheManagerTest, BEH_Budget) {
+  CacheBudget budget(CacheBudget::FromEnvironment(cache_path_, DiskUsage(100 * kOneKB)));
+  EXPECT_GT(budget.memory.data, 0U);
+  EXPECT_LE(budget.disk.data, detail::Parameters::cache_disk_percentage * kOneKB);
+
+  CacheManager cache_manager(cache_path_, budget);
+  EXPECT_EQ(budget.memory.data, cache_manager.GetBudget().memory.data);
+  EXPECT_EQ(budget.disk.data, cache_manager.GetBudget().disk.data);
+}
+
+TEST_F(CacheManagerTest, BEH_ShortTerm) {
+  CacheManager cache_manager(cache_path_, CacheBudget(MemoryUsage(8 * kOneKB),
+                                                      DiskUsage(64 * kOneKB)));
+  auto entry(GenerateKeyValue(kOneKB));
+  EXPECT_FALSE(cache_manager.Get(entry.first, Lifetime::kShortTerm));
+  cache_manager.Store(entry.first, entry.second, Lifetime::kShortTerm);
+  auto value(cache_manager.Get(entry.first, Lifetime::kShortTerm));
+  ASSERT_TRUE(static_cast<bool>(value));
+  EXPECT_TRUE(value->value() == entry.second.value());
+
+  auto statistics(cache_manager.GetStatistics());
+  EXPECT_EQ(1U, statistics.memory.hits);
+  EXPECT_EQ(1U, statistics.memory.misses);
+  EXPECT_EQ(kOneKB, statistics.memory.hit_bytes);
+  EXPECT_EQ(kOneKB, statistics.memory_usage.data);
+  // Short-term chunks never reach the disk tier.
+  EXPECT_EQ(0U, statistics.disk.hits + statistics.disk.misses);
+  EXPECT_EQ(0U, statistics.disk.admitted + statistics.disk.rejected);
+}
+
+TEST_F(CacheManagerTest, BEH_DiskAdmission) {
+  CacheManager cache_manager(cache_path_, CacheBudget(MemoryUsage(4 * kOneKB),
+                                                      DiskUsage(64 * kOneKB)));
+  // Too large for the memory tier, and only written to disk once it has been seen again after
+  // the lookup and store of a single request.
+  auto entry(GenerateKeyValue(8 * kOneKB));
+  EXPECT_FALSE(cache_manager.Get(entry.first, Lifetime::kLongTerm));
+  cache_manager.Store(entry.first, entry.second, Lifetime::kLongTerm);
+  EXPECT_EQ(1U, cache_manager.GetStatistics().disk.rejected);
+  EXPECT_FALSE(cache_manager.Get(entry.first, Lifetime::kLongTerm));
+
+  // The write is queued, but a lookup straight after it still hits.
+  cache_manager.Store(entry.first, entry.second, Lifetime::kLongTerm);
+  auto value(cache_manager.Get(entry.first, Lifetime::kLongTerm));
+  ASSERT_TRUE(static_cast<bool>(value));
+  EXPECT_TRUE(value->value() == entry.second.value());
+
+  auto statistics(cache_manager.GetStatistics());
+  EXPECT_EQ(1U, statistics.disk.admitted);
+  EXPECT_EQ(8 * kOneKB, statistics.disk.admitted_bytes);
+  EXPECT_EQ(1U, statistics.disk.hits);
+  EXPECT_EQ(8 * kOneKB, statistics.disk.hit_bytes);
+  EXPECT_EQ(8 * kOneKB, statistics.disk_usage.data);
+  EXPECT_EQ(0U, statistics.promoted);
+}
+
+TEST_F(CacheManagerTest, BEH_DemotionAndPromotion) {
+  const uint64_t kCapacity(4);
+  CacheManager cache_manager(cache_path_, CacheBudget(MemoryUsage(kCapacity * kOneKB),
+                                                      DiskUsage(64 * kOneKB)));
+  std::vector<std::pair<KeyType, ChunkBuffer>> cold, hot;
+  for (uint64_t i(0); i != kCapacity; ++i) {
+    cold.push_back(GenerateKeyValue(kOneKB));
+    Request(cache_manager, cold.back().first, 2);
+    cache_manager.Store(cold.back().first, cold.back().second, Lifetime::kLongTerm);
+  }
+  EXPECT_EQ(kCapacity * kOneKB, cache_manager.GetStatistics().memory_usage.data);
+  EXPECT_EQ(0U, cache_manager.GetStatistics().disk_usage.data);
+
+  // More popular chunks displace the cold ones, which are moved to disk rather than dropped.
+  for (uint64_t i(0); i != kCapacity; ++i) {
+    hot.push_back(GenerateKeyValue(kOneKB));
+    Request(cache_manager, hot.back().first, 5);
+    cache_manager.Store(hot.back().first, hot.back().second, Lifetime::kLongTerm);
+  }
+  for (const auto& entry : cold) {
+    auto value(cache_manager.Get(entry.first, Lifetime::kLongTerm));
+    ASSERT_TRUE(static_cast<bool>(value));
+    EXPECT_TRUE(value->value() == entry.second.value());
+  }
+  auto statistics(cache_manager.GetStatistics());
+  EXPECT_EQ(kCapacity, statistics.demoted);
+  EXPECT_EQ(kCapacity, statistics.disk.hits);
+  EXPECT_EQ(kCapacity * kOneKB, statistics.disk_usage.data);
+
+  // Once requested more often than the chunks in memory, a disk hit is promoted back into memory,
+  // displacing (and so demoting) a hot chunk.
+  Request(cache_manager, cold[0].first, 1);
+  statistics = cache_manager.GetStatistics();
+  EXPECT_EQ(1U, statistics.promoted);
+  EXPECT_EQ(kCapacity + 1, statistics.demoted);
+  EXPECT_EQ(kCapacity + 1, statistics.disk.hits);
+
+  // The promoted chunk is still on disk, so isn't written again when it's next displaced.
+  for (uint64_t i(0); i != kCapacity; ++i) {
+    auto entry(GenerateKeyValue(kOneKB));
+    Request(cache_manager, entry.first, 12);
+    cache_manager.Store(entry.first, entry.second, Lifetime::kLongTerm);
+  }
+  statistics = cache_manager.GetStatistics();
+  EXPECT_EQ(2 * kCapacity, statistics.demoted);
+  EXPECT_EQ(2 * kCapacity, statistics.disk.admitted);
+  uint64_t disk_hits(statistics.disk.hits);
+  auto value(cache_manager.Get(cold[0].first, Lifetime::kLongTerm));
+  ASSERT_TRUE(static_cast<bool>(value));
+  EXPECT_TRUE(value->value() == cold[0].second.value());
+  statistics = cache_manager.GetStatistics();
+  EXPECT_EQ(disk_hits + 1, statistics.disk.hits);
+  EXPECT_EQ(2 * kCapacity * kOneKB, statistics.disk_usage.data);
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -39,7 +39,7 @@ class CacheHandlerServiceTest : public testing::Test {
       : kTestRoot_(maidsafe::test::CreateTestPath("MaidSafe_Test_Vault")),
         vault_root_dir_(*kTestRoot_ / RandomAlphaNumericString(8)),
         routing_(passport::CreatePmidAndSigner().first),
-        cache_handler_service_(routing_, vault_root_dir_),
+        cache_handler_service_(routing_, vault_root_dir_, DiskUsage(1073741824)),
         asio_service_(2) {
     boost::filesystem::create_directory(vault_root_dir_);
   }
@@ -0,0 +1,52 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/cache_statistics.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+double CacheStatistics::HitRatio() const {
+  return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / (hits + misses);
+}
+
+CacheStatistics& operator+=(CacheStatistics& lhs, const CacheStatistics& rhs) {
+  lhs.hits += rhs.hits;
+  lhs.misses += rhs.misses;
+  lhs.admitted += rhs.admitted;
+  lhs.rejected += rhs.rejected;
+  lhs.hit_bytes += rhs.hit_bytes;
+  lhs.admitted_bytes += rhs.admitted_bytes;
+  return lhs;
+}
+
+CacheStatistics CacheCounters::Get() const {
+  CacheStatistics statistics;
+  statistics.hits = hits_.load(std::memory_order_relaxed);
+  statistics.misses = misses_.load(std::memory_order_relaxed);
+  statistics.admitted = admitted_.load(std::memory_order_relaxed);
+  statistics.rejected = rejected_.load(std::memory_order_relaxed);
+  statistics.hit_bytes = hit_bytes_.load(std::memory_order_relaxed);
+  statistics.admitted_bytes = admitted_bytes_.load(std::memory_order_relaxed);
+  return statistics;
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,74 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_CACHE_STATISTICS_H_
+#define MAIDSAFE_VAULT_CACHE_STATISTICS_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace maidsafe {
+
+namespace vault {
+
+// Counts of lookups and store attempts for a cache tier since it was constructed.
+struct CacheStatistics {
+  CacheStatistics()
+      : hits(0), misses(0), admitted(0), rejected(0), hit_bytes(0), admitted_bytes(0) {}
+
+  // Hits as a fraction of all lookups, or zero if there have been none.
+  double HitRatio() const;
+
+  uint64_t hits, misses;
+  // Store attempts accepted, and refused by the admission policy.
+  uint64_t admitted, rejected;
+  // Total sizes of the values returned by hits, and of the values admitted.
+  uint64_t hit_bytes, admitted_bytes;
+};
+
+CacheStatistics& operator+=(CacheStatistics& lhs, const CacheStatistics& rhs);
+
+// Thread-safe accumulator of CacheStatistics.
+class CacheCounters {
+ public:
+  CacheCounters()
+      : hits_(0), misses_(0), admitted_(0), rejected_(0), hit_bytes_(0), admitted_bytes_(0) {}
+  CacheCounters(const CacheCounters&) = delete;
+  CacheCounters& operator=(const CacheCounters&) = delete;
+
+  void Hit(uint64_t bytes) {
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    hit_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+  }
+  void Miss() { misses_.fetch_add(1, std::memory_order_relaxed); }
+  void Admitted(uint64_t bytes) {
+    admitted_.fetch_add(1, std::memory_order_relaxed);
+    admitted_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+  }
+  void Rejected() { rejected_.fetch_add(1, std::memory_order_relaxed); }
+  CacheStatistics Get() const;
+
+ private:
+  std::atomic<uint64_t> hits_, misses_, admitted_, rejected_, hit_bytes_, admitted_bytes_;
+};
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_CACHE_STATISTICS_H_
@@ -0,0 +1,56 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/chunk_buffer.h"
+
+#include <cstring>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+ChunkBuffer::ChunkBuffer() : content_() {}
+
+ChunkBuffer::ChunkBuffer(NonEmptyString content)
+    : content_(std::make_shared<const NonEmptyString>(std::move(content))) {}
+
+const char* ChunkBuffer::data() const { return content_ ? content_->string().data() : nullptr; }
+
+size_t ChunkBuffer::size() const { return content_ ? content_->string().size() : 0; }
+
+const NonEmptyString& ChunkBuffer::value() const {
+  if (!content_) {
+    LOG(kError) << "ChunkBuffer::value called on empty buffer";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+  return *content_;
+}
+
+bool operator==(const ChunkBuffer& lhs, const ChunkBuffer& rhs) {
+  return lhs.size() == rhs.size() &&
+         (lhs.data() == rhs.data() || std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+}
+
+bool operator!=(const ChunkBuffer& lhs, const ChunkBuffer& rhs) { return !(lhs == rhs); }
+
+}  // namespace vault
+
+}  // namespace maidsafe
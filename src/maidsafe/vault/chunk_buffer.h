@@ -0,0 +1,59 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_CHUNK_BUFFER_H_
+#define MAIDSAFE_VAULT_CHUNK_BUFFER_H_
+
+#include <cstddef>
+#include <memory>
+
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+// Immutable, reference-counted chunk contents.  Copying a ChunkBuffer shares the underlying bytes
+// rather than duplicating them, so a chunk read once can be handed through the stores, caches and
+// response paths without a copy at each hop.  The content is a NonEmptyString, which is moved in
+// if passed as an rvalue.
+class ChunkBuffer {
+ public:
+  ChunkBuffer();
+  explicit ChunkBuffer(NonEmptyString content);
+
+  const char* data() const;
+  size_t size() const;
+  bool empty() const { return size() == 0; }
+
+  // Throws if the buffer is empty.
+  const NonEmptyString& value() const;
+
+ private:
+  std::shared_ptr<const NonEmptyString> content_;
+};
+
+// Compares contents, not identity.
+bool operator==(const ChunkBuffer& lhs, const ChunkBuffer& rhs);
+bool operator!=(const ChunkBuffer& lhs, const ChunkBuffer& rhs);
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_CHUNK_BUFFER_H_
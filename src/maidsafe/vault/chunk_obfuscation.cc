@@ -0,0 +1,173 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/chunk_obfuscation.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MAIDSAFE_VAULT_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+namespace {
+
+void XorPortable(const char* input, const char* keystream, char* output, size_t size) {
+  size_t i(0);
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t data, key;
+    std::memcpy(&data, input + i, sizeof(data));
+    std::memcpy(&key, keystream + i, sizeof(key));
+    data ^= key;
+    std::memcpy(output + i, &data, sizeof(data));
+  }
+  for (; i != size; ++i)
+    output[i] = input[i] ^ keystream[i];
+}
+
+#ifdef MAIDSAFE_VAULT_X86_DISPATCH
+
+__attribute__((target("sse2")))
+void XorSse2(const char* input, const char* keystream, char* output, size_t size) {
+  size_t i(0);
+  for (; i + 16 <= size; i += 16) {
+    __m128i data(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)));
+    __m128i key(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keystream + i)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_xor_si128(data, key));
+  }
+  XorPortable(input + i, keystream + i, output + i, size - i);
+}
+
+__attribute__((target("avx2")))
+void XorAvx2(const char* input, const char* keystream, char* output, size_t size) {
+  size_t i(0);
+  for (; i + 64 <= size; i += 64) {
+    __m256i data0(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i)));
+    __m256i data1(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i + 32)));
+    __m256i key0(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keystream + i)));
+    __m256i key1(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keystream + i + 32)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), _mm256_xor_si256(data0, key0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i + 32),
+                        _mm256_xor_si256(data1, key1));
+  }
+  XorSse2(input + i, keystream + i, output + i, size - i);
+}
+
+__attribute__((target("avx512f")))
+void XorAvx512(const char* input, const char* keystream, char* output, size_t size) {
+  size_t i(0);
+  for (; i + 64 <= size; i += 64) {
+    __m512i data(_mm512_loadu_si512(input + i));
+    __m512i key(_mm512_loadu_si512(keystream + i));
+    _mm512_storeu_si512(output + i, _mm512_xor_si512(data, key));
+  }
+  XorSse2(input + i, keystream + i, output + i, size - i);
+}
+
+#endif
+
+std::vector<std::pair<std::string, XorFunction>> DetectXorFunctions() {
+  std::vector<std::pair<std::string, XorFunction>> functions;
+  functions.push_back(std::make_pair(std::string("portable"), &XorPortable));
+#ifdef MAIDSAFE_VAULT_X86_DISPATCH
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2"))
+    functions.push_back(std::make_pair(std::string("sse2"), &XorSse2));
+  if (__builtin_cpu_supports("avx2"))
+    functions.push_back(std::make_pair(std::string("avx2"), &XorAvx2));
+  if (__builtin_cpu_supports("avx512f"))
+    functions.push_back(std::make_pair(std::string("avx512"), &XorAvx512));
+#endif
+  return functions;
+}
+
+}  // unnamed namespace
+
+XorFunction GetXorFunction() {
+  static const XorFunction kXor(GetSupportedXorFunctions().back().second);
+  return kXor;
+}
+
+std::vector<std::pair<std::string, XorFunction>> GetSupportedXorFunctions() {
+  static const std::vector<std::pair<std::string, XorFunction>> kFunctions(DetectXorFunctions());
+  return kFunctions;
+}
+
+}  // namespace detail
+
+const size_t ChunkObfuscator::kBlockSize_;
+
+ChunkObfuscator::ChunkObfuscator(const Identity& name, size_t size)
+    : kXor_(detail::GetXorFunction()),
+      kSize_(size),
+      offset_(0),
+      keystream_(),
+      chain_block_(name.string()),
+      handed_out_(0) {}
+
+void ChunkObfuscator::Apply(const char* input, size_t size, char* output) {
+  if (size > kSize_ - offset_) {
+    LOG(kError) << "Can't apply " << size << " bytes of keystream; only " << kSize_ - offset_
+                << " remain.";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+  while (size != 0) {
+    size_t block_size(std::min(size, kBlockSize_));
+    kXor_(input, Keystream(block_size), output, block_size);
+    input += block_size;
+    output += block_size;
+    size -= block_size;
+  }
+}
+
+const char* ChunkObfuscator::Keystream(size_t size) {
+  keystream_.erase(0, handed_out_);
+  while (keystream_.size() < size) {
+    chain_block_ = crypto::Hash<crypto::SHA512>(chain_block_).string();
+    keystream_ += chain_block_;
+  }
+  handed_out_ = size;
+  offset_ += size;
+  return keystream_.data();
+}
+
+std::string ObfuscateChunk(const Identity& name, const NonEmptyString& content) {
+  std::string result(content.string().size(), 0);
+  ChunkObfuscator(name, result.size()).Apply(content.string().data(), result.size(), &result[0]);
+  return result;
+}
+
+void DeobfuscateChunk(const Identity& name, std::string& content) {
+  ChunkObfuscator(name, content.size()).Apply(content.data(), content.size(), &content[0]);
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
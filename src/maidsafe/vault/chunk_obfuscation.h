@@ -0,0 +1,85 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_CHUNK_OBFUSCATION_H_
+#define MAIDSAFE_VAULT_CHUNK_OBFUSCATION_H_
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// XORs 'size' bytes of 'input' with 'keystream' into 'output', which may be the same as 'input'.
+typedef void (*XorFunction)(const char* input, const char* keystream, char* output, size_t size);
+
+// The widest implementation supported by the CPU, chosen on first use.
+XorFunction GetXorFunction();
+// Every implementation the CPU supports, narrowest first, named for tests and benchmarks.
+std::vector<std::pair<std::string, XorFunction>> GetSupportedXorFunctions();
+
+}  // namespace detail
+
+// Obfuscates or deobfuscates chunk contents bit-for-bit as crypto::ObfuscateData and
+// crypto::DeobfuscateData do.  Both XOR the data with the SHA-512 hash chain of the chunk's name,
+// i.e. Hash(name), Hash(Hash(name)) and so on, cut to the data's size; so applying the same stream
+// twice restores the input.
+//
+// Unlike the crypto functions, the data can be processed in pieces (so a chunk can be streamed to
+// or from disk without an obfuscated copy of the whole of it), in place, and using the widest
+// vector instructions (SSE2, AVX2 or AVX-512) the CPU supports.
+class ChunkObfuscator {
+ public:
+  // 'size' is the total number of bytes which will be passed to Apply.
+  ChunkObfuscator(const Identity& name, size_t size);
+  ChunkObfuscator(const ChunkObfuscator&) = delete;
+  ChunkObfuscator& operator=(const ChunkObfuscator&) = delete;
+
+  // Applies the next 'size' bytes of keystream to 'input', writing to 'output'.  'output' may be
+  // the same as 'input'.
+  void Apply(const char* input, size_t size, char* output);
+
+ private:
+  const char* Keystream(size_t size);
+
+  static const size_t kBlockSize_ = 4096;
+
+  const detail::XorFunction kXor_;
+  const size_t kSize_;
+  size_t offset_;
+  // The bytes last handed out, followed by the unused remainder of the latest hash, 'chain_block_'.
+  std::string keystream_, chain_block_;
+  size_t handed_out_;
+};
+
+// Convenience wrappers over ChunkObfuscator for a whole chunk.
+std::string ObfuscateChunk(const Identity& name, const NonEmptyString& content);
+void DeobfuscateChunk(const Identity& name, std::string& content);
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_CHUNK_OBFUSCATION_H_
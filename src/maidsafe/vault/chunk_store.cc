@@ -29,6 +29,9 @@
 #include "maidsafe/common/utils.h"
 #include "maidsafe/common/crypto.h"
 
+#include "maidsafe/vault/chunk_obfuscation.h"
+#include "maidsafe/vault/chunk_store.pb.h"
+
 namespace fs = boost::filesystem;
 
 namespace maidsafe {
@@ -37,12 +40,27 @@ namespace vault {
 
 namespace {
 
+// The journal is folded into a fresh manifest once it holds more entries than this or than the
+// index itself, whichever is larger, keeping the cost of snapshots amortised constant per write.
+const size_t kMinJournalEntriesBeforeSnapshot(10000);
+
+// Number of the manifest's entries checked against the disk on start-up.
+const size_t kManifestCheckSampleSize(64);
+
+// Each journal starts with a random token identifying the instance which opened it.
+const size_t kJournalTokenSize(8);
+
+// Chunks are obfuscated and written a block of this size at a time.
+const size_t kWriteBlockSize(64 * 1024);
+
 struct UsedSpace {
   UsedSpace() {}
   UsedSpace(UsedSpace&& other)
-      : directories(std::move(other.directories)), disk_usage(std::move(other.disk_usage)) {}
+      : directories(std::move(other.directories)), files(std::move(other.files)),
+        disk_usage(std::move(other.disk_usage)) {}
 
   std::vector<fs::path> directories;
+  std::vector<std::pair<fs::path, uint64_t>> files;
   DiskUsage disk_usage;
 };
 
@@ -50,10 +68,13 @@ UsedSpace GetUsedSpace(fs::path directory) {
   UsedSpace used_space;
   try {
     for (fs::directory_iterator it(directory); it != fs::directory_iterator(); ++it) {
-      if (fs::is_directory(*it))
+      if (fs::is_directory(*it)) {
         used_space.directories.push_back(it->path());
-      else
-        used_space.disk_usage.data += fs::file_size(*it);
+      } else {
+        uint64_t file_size(fs::file_size(*it));
+        used_space.disk_usage.data += file_size;
+        used_space.files.push_back(std::make_pair(it->path(), file_size));
+      }
     }
   } catch (const std::exception& e) {
     LOG(kError) << "GetUsedSpace when handling " << directory
@@ -63,184 +84,388 @@ UsedSpace GetUsedSpace(fs::path directory) {
   return used_space;
 }
 
-DiskUsage InitialiseDiskRoot(const fs::path& disk_root) {
-  boost::system::error_code error_code;
+DiskUsage ScanDiskUsage(const fs::path& disk_root,
+                        std::vector<std::pair<fs::path, uint64_t>>& files) {
   DiskUsage disk_usage(0);
-  if (!fs::exists(disk_root, error_code)) {
-    if (!fs::create_directories(disk_root, error_code)) {
-      LOG(kError) << "Can't create disk root at " << disk_root << ": " << error_code.message();
-      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  std::vector<fs::path> dirs_to_do;
+  dirs_to_do.push_back(disk_root);
+  while (!dirs_to_do.empty()) {
+    std::vector<std::future<UsedSpace>> futures;
+    for (uint32_t i = 0; i < 16 && !dirs_to_do.empty(); ++i) {
+      auto temp_copy(dirs_to_do.back());
+      auto future = std::async(std::launch::async,
+                               [=] { return GetUsedSpace(temp_copy); });
+      dirs_to_do.pop_back();
+      futures.push_back(std::move(future));
     }
-  } else {
-    std::vector<fs::path> dirs_to_do;
-    dirs_to_do.push_back(disk_root);
-    while (!dirs_to_do.empty()) {
-      std::vector<std::future<UsedSpace>> futures;
-      for (uint32_t i = 0; i < 16 && !dirs_to_do.empty(); ++i) {
-        auto temp_copy(dirs_to_do.back());
-        auto future = std::async(std::launch::async,
-                                 [=] { return GetUsedSpace(temp_copy); });
-        dirs_to_do.pop_back();
-        futures.push_back(std::move(future));
-      }
-      try {
-        while (!futures.empty()) {
-          auto future = std::move(futures.back());
-          futures.pop_back();
-          UsedSpace result = future.get();
-          disk_usage.data += result.disk_usage.data;
-          std::move(result.directories.begin(), result.directories.end(),
-                    std::back_inserter(dirs_to_do));
-        }
-      }
-      catch (const std::system_error& exception) {
-        LOG(kError) << boost::diagnostic_information(exception);
-        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
-      }
-      catch (...) {
-        LOG(kError) << "exception during InitialiseDiskRoot";
-        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+    try {
+      while (!futures.empty()) {
+        auto future = std::move(futures.back());
+        futures.pop_back();
+        UsedSpace result = future.get();
+        disk_usage.data += result.disk_usage.data;
+        std::move(result.directories.begin(), result.directories.end(),
+                  std::back_inserter(dirs_to_do));
+        std::move(result.files.begin(), result.files.end(), std::back_inserter(files));
       }
     }
+    catch (const std::system_error& exception) {
+      LOG(kError) << boost::diagnostic_information(exception);
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+    }
+    catch (...) {
+      LOG(kError) << "exception during InitialiseDiskRoot";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+    }
   }
   return disk_usage;
 }
 
+// Reverses the nesting applied by KeyToFilePath, i.e. concatenates the path below disk_root.
+std::string StoredFileName(const fs::path& disk_root, const fs::path& file_path) {
+  std::string file_name(file_path.string().substr(disk_root.string().size()));
+  file_name.erase(std::remove_if(std::begin(file_name), std::end(file_name),
+                                 [](char c) { return c == '/' || c == '\\'; }),
+                  std::end(file_name));
+  return file_name;
+}
+
+void AppendUint32(std::string& buffer, uint32_t value) {
+  for (int i(0); i != 4; ++i)
+    buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+uint32_t ParseUint32(const char* buffer) {
+  uint32_t value(0);
+  for (int i(0); i != 4; ++i)
+    value |= static_cast<uint32_t>(static_cast<unsigned char>(buffer[i])) << (8 * i);
+  return value;
+}
+
+// Obfuscates 'value' as it's written, so the obfuscated chunk is never held in memory as a whole.
+bool WriteObfuscatedFile(const fs::path& file_path, const Identity& name,
+                         const NonEmptyString& value) {
+  const std::string& content(value.string());
+  ChunkObfuscator obfuscator(name, content.size());
+  std::string block(std::min(content.size(), kWriteBlockSize), 0);
+  std::ofstream file(file_path.string(), std::ios::binary | std::ios::trunc);
+  for (size_t offset(0); offset < content.size() && file; offset += block.size()) {
+    size_t block_size(std::min(content.size() - offset, block.size()));
+    obfuscator.Apply(content.data() + offset, block_size, &block[0]);
+    file.write(block.data(), block_size);
+  }
+  file.close();
+  return !file.fail();
+}
+
+ChunkStore::KeyType ParseEntryName(const protobuf::ChunkStoreEntry& entry) {
+  return GetDataNameVariant(static_cast<DataTagValue>(entry.type()), Identity(entry.name()));
+}
+
 }  // unnamed namespace
 
-ChunkStore::ChunkStore(const fs::path& disk_path, DiskUsage max_disk_usage)
+ChunkStore::ChunkStore(const fs::path& disk_path, DiskUsage max_disk_usage,
+                       size_t path_cache_size)
+    : ChunkStore(disk_path, max_disk_usage, Mode::kPersistent, path_cache_size) {}
+
+ChunkStore::ChunkStore(const fs::path& disk_path, DiskUsage max_disk_usage, Mode mode,
+                       size_t path_cache_size)
     : kDiskPath_(disk_path),
-      max_disk_usage_(std::move(max_disk_usage)),
-      current_disk_usage_(InitialiseDiskRoot(kDiskPath_)),
+      kManifestPath_(disk_path.string() + ".manifest"),
+      kJournalPath_(disk_path.string() + ".journal"),
+      kPreviousJournalPath_(disk_path.string() + ".journal.old"),
+      max_disk_usage_(max_disk_usage.data),
+      current_disk_usage_(0),
       kDepth_(5),
-      mutex_(),
-      get_identity_visitor_() {
-  if (current_disk_usage_ > max_disk_usage_) {
-    LOG(kError) << "current disk usage " << current_disk_usage_
-                << " is greater than max disk usage " << max_disk_usage_;
+      stripes_(),
+      index_mutex_(),
+      journal_mutex_(),
+      get_identity_visitor_(),
+      index_(),
+      kPathCacheSize_(path_cache_size),
+      path_cache_mutex_(),
+      path_cache_list_(),
+      path_cache_(),
+      pending_journal_records_(),
+      journal_(),
+      journal_entries_(0),
+      entries_since_snapshot_(0),
+      journal_token_(),
+      snapshot_running_(false),
+      previous_journal_(false),
+      snapshotter_(),
+      kMode_(mode),
+      eviction_order_(),
+      eviction_count_(0),
+      trimmer_mutex_(),
+      trimmer_condition_(),
+      stop_trimmer_(false),
+      trimmer_(),
+      segment_store_() {
+  if (kMode_ == Mode::kPersistent &&
+      detail::Parameters::chunk_store_layout == ChunkStoreLayout::kSegments) {
+    segment_store_.reset(new SegmentStore(disk_path, max_disk_usage));
+    return;
+  }
+  InitialiseIndex();
+  if (kMode_ == Mode::kCache) {
+    eviction_order_.reset(new detail::SegmentedLru(max_disk_usage_.load()));
+    for (const auto& entry : index_)
+      eviction_order_->Insert(entry.first, entry.second);
+    if (current_disk_usage_.load() > max_disk_usage_.load())
+      TrimToLowWatermark();
+    trimmer_ = std::thread([this] { RunTrimmer(); });
+  } else if (current_disk_usage_.load() > max_disk_usage_.load()) {
+    LOG(kError) << "current disk usage " << current_disk_usage_.load()
+                << " is greater than max disk usage " << max_disk_usage_.load();
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::cannot_exceed_limit));
   }
 }
 
-ChunkStore::~ChunkStore() {}
+ChunkStore::~ChunkStore() {
+  if (trimmer_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(trimmer_mutex_);
+      stop_trimmer_ = true;
+    }
+    trimmer_condition_.notify_one();
+    trimmer_.join();
+  }
+  if (snapshotter_.joinable())
+    snapshotter_.join();
+  try {
+    std::lock_guard<std::mutex> lock(journal_mutex_);
+    // Only snapshot if the journal on disk is still ours, i.e. the disk root hasn't been removed
+    // or reopened by another instance in the meantime.
+    std::string token(kJournalTokenSize, 0);
+    std::ifstream journal(kJournalPath_.string(), std::ios::binary);
+    if (journal_.is_open() && journal.read(&token[0], token.size()) && token == journal_token_) {
+      journal.close();
+      if (journal_entries_ != 0 || previous_journal_)
+        WriteManifest();
+      journal_.close();
+      fs::remove(kJournalPath_);
+      if (previous_journal_)
+        fs::remove(kPreviousJournalPath_);
+    }
+  }
+  catch (const std::exception& e) {
+    LOG(kError) << "Failed to write manifest for " << kDiskPath_ << ": "
+                << boost::diagnostic_information(e);
+  }
+}
 
 void ChunkStore::Put(const KeyType& key, const NonEmptyString& value) {
-  std::unique_lock<std::mutex> lock(mutex_);
+  if (segment_store_)
+    return segment_store_->Put(key, value);
   if (!fs::exists(kDiskPath_)) {
     LOG(kError) << "ChunkStore::Put kDiskPath_ " << kDiskPath_ << " doesn't exists";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
   }
 
   auto key_tag_and_id(boost::apply_visitor(GetTagValueAndIdentityVisitor(), key));
-  auto content(crypto::ObfuscateData(key_tag_and_id.second, value));
-  auto hash(crypto::Hash<crypto::SHA512>(key_tag_and_id.second));
-  auto file_path(KeyToFilePath(GetDataNameVariant(key_tag_and_id.first, hash)));
+  auto resolved(Resolve(key));
+  const KeyType& stored_name(resolved.stored_name);
+  const fs::path& file_path(resolved.file_path);
   LOG(kVerbose) << "ChunkStore::Put file_path " << file_path;
-  uint32_t value_size(static_cast<uint32_t>(content.data.string().size()));
-  uint64_t file_size(0), size(0);
-  bool increment(true);
-  boost::system::error_code error_code;
-
-  if (fs::exists(file_path, error_code)) {
-    if (error_code) {
-      LOG(kError) << "Unable to determine file status for " << file_path << ": "
-                  << error_code.message();
-      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
-    }
-    file_size = fs::file_size(file_path, error_code);
-    if (error_code) {
-      LOG(kError) << "Error getting file size of " << file_path << ": " << error_code.message();
-      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
-    }
-  }
-  if (file_size != 0) {
-    if (file_size <= value_size) {
-      size = value_size - file_size;
-    } else {
-      size = file_size - value_size;
-      increment = false;
-    }
-  } else {
-    size = value_size;
-  }
-
-  if (increment) {
-    if (!HasDiskSpace(size)) {
+  uint64_t value_size(value.string().size()), file_size(0);
+
+  std::unique_lock<std::mutex> stripe_lock(Stripe(resolved.stored_id), std::defer_lock);
+  uint64_t reserved(0);
+  // In kCache mode, room is made before taking the stripe lock, since evicting takes the stripe
+  // locks of the victims.  Concurrent Puts may take the room first, so this is retried.
+  for (int attempt(0);; ++attempt) {
+    if (kMode_ == Mode::kCache)
+      MakeRoom(value_size);
+    stripe_lock.lock();
+    file_size = 0;
+    FindInIndex(stored_name, file_size);
+    reserved = value_size > file_size ? value_size - file_size : 0;
+    if (reserved == 0 || ReserveDiskSpace(reserved))
+      break;
+    if (kMode_ == Mode::kPersistent || attempt == 2) {
       LOG(kError) << "Cannot store "
                   << HexSubstr(boost::apply_visitor(get_identity_visitor_, key).string())
-                  << " since the addition of " << size << " bytes exceeds max of "
-                  << max_disk_usage_ << " bytes.";
+                  << " since the addition of " << reserved << " bytes exceeds max of "
+                  << max_disk_usage_.load() << " bytes.";
       BOOST_THROW_EXCEPTION(MakeError(CommonErrors::cannot_exceed_limit));
     }
+    stripe_lock.unlock();
   }
-  if (!WriteFile(file_path, content.data.string())) {
+
+  protobuf::ChunkStoreEntry entry;
+  entry.set_type(static_cast<uint32_t>(key_tag_and_id.first));
+  entry.set_name(resolved.stored_id.string());
+  entry.set_size(value_size);
+  try {
+    AppendToJournal(stored_name, entry);
+  }
+  catch (const std::exception&) {
+    current_disk_usage_ -= reserved;
+    throw;
+  }
+  // The shard directory usually exists already, so it's only created if the first write fails.
+  boost::system::error_code error_code;
+  if (!WriteObfuscatedFile(file_path, key_tag_and_id.second, value) &&
+      !(fs::create_directories(file_path.parent_path(), error_code) &&
+        WriteObfuscatedFile(file_path, key_tag_and_id.second, value))) {
+    current_disk_usage_ -= reserved;
+    CompleteJournalEntry(stored_name);
     LOG(kError) << "Failed to write "
                 << HexSubstr(boost::apply_visitor(get_identity_visitor_, key).string())
                 << " to disk.";
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
   }
 
-  if (increment) {
-    current_disk_usage_.data += size;
-  } else {
-    current_disk_usage_.data -= size;
+  if (file_size > value_size)
+    current_disk_usage_ -= file_size - value_size;
+  {
+    std::lock_guard<std::mutex> lock(index_mutex_);
+    index_[stored_name] = value_size;
+  }
+  CompleteJournalEntry(stored_name);
+  if (kMode_ == Mode::kCache) {
+    eviction_order_->Insert(stored_name, value_size);
+    stripe_lock.unlock();
+    if (AboveHighWatermark())
+      WakeTrimmer();
   }
 }
 
+void ChunkStore::Put(const KeyType& key, const ChunkBuffer& value) { Put(key, value.value()); }
+
 void ChunkStore::Delete(const KeyType& key) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  auto key_tag_and_id(boost::apply_visitor(GetTagValueAndIdentityVisitor(), key));
-  auto hash(crypto::Hash<crypto::SHA512>(key_tag_and_id.second));
-  auto path(KeyToFilePath(GetDataNameVariant(key_tag_and_id.first, hash)));
+  if (segment_store_)
+    return segment_store_->Delete(key);
+  auto resolved(Resolve(key));
+  std::lock_guard<std::mutex> stripe_lock(Stripe(resolved.stored_id));
+  RemoveChunkFile(resolved);
+}
+
+void ChunkStore::RemoveChunkFile(const ResolvedKey& resolved) {
+  const KeyType& stored_name(resolved.stored_name);
+  const fs::path& path(resolved.file_path);
   boost::system::error_code error_code;
-  uint64_t file_size(fs::file_size(path, error_code));
+  uint64_t file_size(0);
+  if (!FindInIndex(stored_name, file_size))
+    file_size = fs::file_size(path, error_code);
   if (error_code) {
     LOG(kError) << "Error getting file size of " << path << ": " << error_code.message();
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
   }
+
+  protobuf::ChunkStoreEntry entry;
+  entry.set_type(static_cast<uint32_t>(
+      boost::apply_visitor(GetTagValueAndIdentityVisitor(), stored_name).first));
+  entry.set_name(resolved.stored_id.string());
+  AppendToJournal(stored_name, entry);
   if (!fs::remove(path, error_code) || error_code) {
+    CompleteJournalEntry(stored_name);
     LOG(kError) << "Error removing " << path << ": " << error_code.message();
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
   }
-  current_disk_usage_.data -= file_size;
+  current_disk_usage_ -= file_size;
+  {
+    std::lock_guard<std::mutex> lock(index_mutex_);
+    index_.erase(stored_name);
+  }
+  CompleteJournalEntry(stored_name);
+  if (kMode_ == Mode::kCache)
+    eviction_order_->Erase(stored_name);
 }
 
 NonEmptyString ChunkStore::Get(const KeyType& key) const {
-  std::lock_guard<std::mutex> lock(mutex_);
+  if (segment_store_)
+    return segment_store_->Get(key);
   auto key_tag_and_id(boost::apply_visitor(GetTagValueAndIdentityVisitor(), key));
-  auto hash(crypto::Hash<crypto::SHA512>(key_tag_and_id.second));
-  auto content(ReadFile(KeyToFilePath(GetDataNameVariant(key_tag_and_id.first, hash))));
-  return crypto::DeobfuscateData(key_tag_and_id.second, crypto::CipherText(content));
+  auto resolved(Resolve(key));
+  const fs::path& file_path(resolved.file_path);
+  // Read straight into the string which is deobfuscated in place and returned.
+  std::string content;
+  {
+    std::lock_guard<std::mutex> stripe_lock(Stripe(resolved.stored_id));
+    if (!ReadFile(file_path, &content) || content.empty()) {
+      LOG(kVerbose) << "Failed to read " << file_path;
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+    }
+  }
+  if (kMode_ == Mode::kCache)
+    eviction_order_->Touch(resolved.stored_name);
+  DeobfuscateChunk(key_tag_and_id.second, content);
+  return NonEmptyString(std::move(content));
+}
+
+ChunkBuffer ChunkStore::GetBuffer(const KeyType& key) const { return ChunkBuffer(Get(key)); }
+
+std::vector<ChunkStore::KeyType> ChunkStore::ElementsToStore(std::set<KeyType> element_list) {
+  if (segment_store_)
+    return segment_store_->ElementsToStore(std::move(element_list));
+  std::vector<std::pair<KeyType, KeyType>> stored_names;
+  for (const auto& element : element_list)
+    stored_names.push_back(std::make_pair(element, StoredName(element)));
+
+  std::vector<KeyType> to_store;
+  std::lock_guard<std::mutex> lock(index_mutex_);
+  for (const auto& names : stored_names) {
+    if (index_.find(names.second) == index_.end())
+      to_store.push_back(names.first);
+  }
+  return to_store;
 }
 
 void ChunkStore::SetMaxDiskUsage(DiskUsage max_disk_usage) {
-  if (current_disk_usage_ > max_disk_usage) {
-    LOG(kError) << "current_disk_usage_ " << current_disk_usage_.data
+  if (segment_store_)
+    return segment_store_->SetMaxDiskUsage(max_disk_usage);
+  if (kMode_ == Mode::kCache) {
+    max_disk_usage_.store(max_disk_usage.data);
+    eviction_order_->SetCapacity(max_disk_usage.data);
+    MakeRoom(0);
+    return;
+  }
+  if (current_disk_usage_.load() > max_disk_usage.data) {
+    LOG(kError) << "current_disk_usage_ " << current_disk_usage_.load()
                 << " exceeds target max_disk_usage " << max_disk_usage.data;
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
   }
-  max_disk_usage_ = max_disk_usage;
+  max_disk_usage_.store(max_disk_usage.data);
+}
+
+DiskUsage ChunkStore::GetMaxDiskUsage() const {
+  return segment_store_ ? segment_store_->GetMaxDiskUsage() : DiskUsage(max_disk_usage_.load());
+}
+
+DiskUsage ChunkStore::GetCurrentDiskUsage() const {
+  return segment_store_ ? segment_store_->GetCurrentDiskUsage() :
+                          DiskUsage(current_disk_usage_.load());
 }
 
 std::vector<ChunkStore::KeyType> ChunkStore::GetKeys() const {
   std::vector<DataNameVariant> keys;
-  fs::directory_iterator end_iter;
-
-  if (fs::exists(kDiskPath_) && fs::is_directory(kDiskPath_)) {
-    for (fs::directory_iterator dir_iter(kDiskPath_); dir_iter != end_iter; ++dir_iter) {
-      if (fs::is_regular_file(dir_iter->status()))
-        keys.push_back(detail::GetDataNameVariant(*dir_iter));
-    }
+  // The segments index the names themselves, so these are mapped to the names stored under.
+  if (segment_store_) {
+    for (const auto& key : segment_store_->GetKeys())
+      keys.push_back(StoredName(key));
+    return keys;
   }
+  std::lock_guard<std::mutex> lock(index_mutex_);
+  keys.reserve(index_.size());
+  for (const auto& entry : index_)
+    keys.push_back(entry.first);
   return keys;
 }
 
 fs::path ChunkStore::GetFilePath(const KeyType& key) const {
-  return kDiskPath_ / detail::GetFileName(key);
+  return kDiskPath_ / maidsafe::detail::GetFileName(key);
 }
 
-bool ChunkStore::HasDiskSpace(uint64_t required_space) const {
-  return current_disk_usage_ + required_space <= max_disk_usage_;
+bool ChunkStore::ReserveDiskSpace(uint64_t required_space) {
+  uint64_t current_usage(current_disk_usage_.load());
+  do {
+    if (current_usage + required_space > max_disk_usage_.load())
+      return false;
+  } while (!current_disk_usage_.compare_exchange_weak(current_usage,
+                                                      current_usage + required_space));
+  return true;
 }
 
 fs::path ChunkStore::KeyToFilePath(const KeyType& key) const {
@@ -254,12 +479,412 @@ fs::path ChunkStore::KeyToFilePath(const KeyType& key) const {
   for (uint32_t i = 0; i < directory_depth; ++i)
     disk_path /= file_name.string().substr(i, 1);
 
-  boost::system::error_code ec;
-  fs::create_directories(disk_path, ec);
-
   return fs::path(disk_path / file_name.string().substr(directory_depth));
 }
 
+ChunkStore::ResolvedKey ChunkStore::Resolve(const KeyType& key) const {
+  {
+    std::lock_guard<std::mutex> lock(path_cache_mutex_);
+    auto itr(path_cache_.find(key));
+    if (itr != path_cache_.end()) {
+      path_cache_list_.splice(path_cache_list_.begin(), path_cache_list_, itr->second);
+      return itr->second->second;
+    }
+  }
+
+  auto key_tag_and_id(boost::apply_visitor(GetTagValueAndIdentityVisitor(), key));
+  Identity stored_id(crypto::Hash<crypto::SHA512>(key_tag_and_id.second));
+  auto stored_name(GetDataNameVariant(key_tag_and_id.first, stored_id));
+  ResolvedKey resolved(stored_name, stored_id, KeyToFilePath(stored_name));
+  if (kPathCacheSize_ == 0)
+    return resolved;
+
+  std::lock_guard<std::mutex> lock(path_cache_mutex_);
+  if (path_cache_.count(key) == 0) {
+    path_cache_list_.push_front(std::make_pair(key, resolved));
+    path_cache_.insert(std::make_pair(key, path_cache_list_.begin()));
+    if (path_cache_.size() > kPathCacheSize_) {
+      path_cache_.erase(path_cache_list_.back().first);
+      path_cache_list_.pop_back();
+    }
+  }
+  return resolved;
+}
+
+ChunkStore::KeyType ChunkStore::StoredName(const KeyType& key) const {
+  auto key_tag_and_id(boost::apply_visitor(GetTagValueAndIdentityVisitor(), key));
+  return GetDataNameVariant(key_tag_and_id.first,
+                            crypto::Hash<crypto::SHA512>(key_tag_and_id.second));
+}
+
+std::mutex& ChunkStore::Stripe(const Identity& stored_id) const {
+  // Stored names are SHA512 hashes, so their leading bytes spread chunks evenly over the stripes.
+  const std::string& id(stored_id.string());
+  return stripes_[((static_cast<unsigned char>(id[0]) << 8) | static_cast<unsigned char>(id[1])) %
+                  kStripeCount_];
+}
+
+bool ChunkStore::FindInIndex(const KeyType& stored_name, uint64_t& size) const {
+  std::lock_guard<std::mutex> lock(index_mutex_);
+  auto itr(index_.find(stored_name));
+  if (itr == index_.end())
+    return false;
+  size = itr->second;
+  return true;
+}
+
+void ChunkStore::MakeRoom(uint64_t required) {
+  while (current_disk_usage_.load() + required > max_disk_usage_.load() && EvictOne()) {
+  }
+}
+
+void ChunkStore::TrimToLowWatermark() {
+  const uint64_t kLowWatermark(max_disk_usage_.load() *
+                               detail::Parameters::disk_cache_low_watermark / 100);
+  while (current_disk_usage_.load() > kLowWatermark && EvictOne()) {
+  }
+}
+
+bool ChunkStore::EvictOne() {
+  auto victim(eviction_order_->Victim());
+  if (!victim)
+    return false;
+  Identity stored_id(boost::apply_visitor(get_identity_visitor_, *victim));
+  ResolvedKey resolved(*victim, stored_id, KeyToFilePath(*victim));
+  std::lock_guard<std::mutex> stripe_lock(Stripe(stored_id));
+  uint64_t size(0);
+  if (!FindInIndex(*victim, size)) {
+    // Deleted since it was chosen.
+    eviction_order_->Erase(*victim);
+    return true;
+  }
+  try {
+    RemoveChunkFile(resolved);
+    ++eviction_count_;
+  }
+  catch (const std::exception& e) {
+    // Dropped from the order regardless, so that a failing file can't stall eviction.
+    LOG(kError) << "Failed to evict " << resolved.file_path << ": "
+                << boost::diagnostic_information(e);
+    eviction_order_->Erase(*victim);
+  }
+  return true;
+}
+
+bool ChunkStore::AboveHighWatermark() const {
+  return current_disk_usage_.load() >
+         max_disk_usage_.load() * detail::Parameters::disk_cache_high_watermark / 100;
+}
+
+void ChunkStore::RunTrimmer() {
+  std::unique_lock<std::mutex> lock(trimmer_mutex_);
+  for (;;) {
+    trimmer_condition_.wait(lock, [this] { return stop_trimmer_ || AboveHighWatermark(); });
+    if (stop_trimmer_)
+      return;
+    lock.unlock();
+    TrimToLowWatermark();
+    lock.lock();
+  }
+}
+
+void ChunkStore::WakeTrimmer() {
+  // Taking the mutex orders this against the trimmer checking its condition, so the notification
+  // can't be missed.
+  { std::lock_guard<std::mutex> lock(trimmer_mutex_); }
+  trimmer_condition_.notify_one();
+}
+
+void ChunkStore::InitialiseIndex() {
+  boost::system::error_code error_code;
+  if (!fs::exists(kDiskPath_, error_code)) {
+    // Any manifest left behind describes a disk root which no longer exists.
+    fs::remove(kManifestPath_, error_code);
+    fs::remove(kJournalPath_, error_code);
+    fs::remove(kPreviousJournalPath_, error_code);
+    if (!fs::create_directories(kDiskPath_, error_code)) {
+      LOG(kError) << "Can't create disk root at " << kDiskPath_ << ": " << error_code.message();
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+    }
+    WriteManifest();
+    return OpenJournal();
+  }
+
+  bool replayed(false);
+  if (LoadManifest()) {
+    // The previous journal, if any, holds the entries made before the current one was started.
+    const fs::path kJournalPaths[] = {kPreviousJournalPath_, kJournalPath_};
+    for (const auto& journal_path : kJournalPaths) {
+      if (fs::exists(journal_path, error_code)) {
+        ReplayJournal(journal_path);
+        replayed = true;
+      }
+    }
+    if (!MatchesDisk()) {
+      LOG(kWarning) << kManifestPath_ << " doesn't match the files on disk, scanning disk.";
+      ScanDiskRoot();
+      replayed = true;
+    }
+  } else {
+    LOG(kWarning) << "No valid manifest for " << kDiskPath_ << ", scanning disk.";
+    ScanDiskRoot();
+    replayed = true;
+  }
+
+  if (replayed) {
+    WriteManifest();
+    fs::remove(kPreviousJournalPath_, error_code);
+  }
+  OpenJournal();
+}
+
+bool ChunkStore::LoadManifest() {
+  boost::system::error_code error_code;
+  std::string serialised_manifest;
+  if (!fs::exists(kManifestPath_, error_code) || !ReadFile(kManifestPath_, &serialised_manifest))
+    return false;
+
+  protobuf::ChunkStoreManifest manifest;
+  if (!manifest.ParseFromString(serialised_manifest)) {
+    LOG(kWarning) << "Failed to parse " << kManifestPath_;
+    return false;
+  }
+
+  std::map<KeyType, uint64_t> index;
+  uint64_t disk_usage(0);
+  try {
+    for (const auto& entry : manifest.entries()) {
+      if (!entry.has_size() || !index.insert(std::make_pair(ParseEntryName(entry),
+                                                            entry.size())).second)
+        return false;
+      disk_usage += entry.size();
+    }
+  }
+  catch (const std::exception& e) {
+    LOG(kWarning) << "Invalid entry in " << kManifestPath_ << ": "
+                  << boost::diagnostic_information(e);
+    return false;
+  }
+  if (disk_usage != manifest.disk_usage()) {
+    LOG(kWarning) << kManifestPath_ << " records usage of " << manifest.disk_usage()
+                  << " but its entries total " << disk_usage;
+    return false;
+  }
+
+  index_.swap(index);
+  current_disk_usage_.store(disk_usage);
+  return true;
+}
+
+void ChunkStore::ReplayJournal(const fs::path& journal_path) {
+  std::string journal;
+  if (!ReadFile(journal_path, &journal))
+    return;
+
+  std::set<KeyType> touched_names;
+  size_t offset(kJournalTokenSize);
+  while (offset + 4 <= journal.size()) {
+    uint32_t entry_size(ParseUint32(&journal[offset]));
+    if (offset + 4 + entry_size > journal.size())
+      break;  // torn final entry
+    protobuf::ChunkStoreEntry entry;
+    if (!entry.ParseFromArray(&journal[offset + 4], static_cast<int>(entry_size)))
+      break;
+    try {
+      touched_names.insert(ParseEntryName(entry));
+    }
+    catch (const std::exception&) {
+      break;
+    }
+    offset += 4 + entry_size;
+  }
+
+  // Each journal entry is written before the file operation it describes, which may not have
+  // completed, so the disk is the authority for every name touched since the last manifest.
+  LOG(kInfo) << "ChunkStore at " << kDiskPath_ << " wasn't closed cleanly; verifying "
+             << touched_names.size() << " recently modified chunks.";
+  for (const auto& name : touched_names) {
+    auto itr(index_.find(name));
+    if (itr != index_.end()) {
+      current_disk_usage_ -= itr->second;
+      index_.erase(itr);
+    }
+    boost::system::error_code error_code;
+    uint64_t file_size(fs::file_size(KeyToFilePath(name), error_code));
+    if (!error_code) {
+      index_.insert(std::make_pair(name, file_size));
+      current_disk_usage_ += file_size;
+    }
+  }
+}
+
+bool ChunkStore::MatchesDisk() const {
+  // The entries to check are chosen by stepping through the index at random strides.
+  size_t remaining(index_.size()), samples(std::min(kManifestCheckSampleSize, index_.size()));
+  auto itr(index_.begin());
+  while (samples != 0) {
+    if (RandomUint32() % remaining < samples) {
+      boost::system::error_code error_code;
+      uint64_t file_size(fs::file_size(KeyToFilePath(itr->first), error_code));
+      if (error_code || file_size != itr->second) {
+        LOG(kWarning) << KeyToFilePath(itr->first) << " is recorded as " << itr->second
+                      << " bytes, but its size is " << file_size << " ("
+                      << error_code.message() << ")";
+        return false;
+      }
+      --samples;
+    }
+    --remaining;
+    ++itr;
+  }
+  return true;
+}
+
+void ChunkStore::ScanDiskRoot() {
+  std::vector<std::pair<fs::path, uint64_t>> files;
+  current_disk_usage_.store(ScanDiskUsage(kDiskPath_, files).data);
+  index_.clear();
+  for (const auto& file : files) {
+    try {
+      index_.insert(std::make_pair(
+          maidsafe::detail::GetDataNameVariant(fs::path(StoredFileName(kDiskPath_, file.first))),
+          file.second));
+    }
+    catch (const std::exception&) {
+      LOG(kWarning) << "Ignoring unrecognised file " << file.first;
+    }
+  }
+}
+
+void ChunkStore::WriteManifest() {
+  // The index is copied so as to hold index_mutex_ only briefly.
+  std::map<KeyType, uint64_t> index;
+  {
+    std::lock_guard<std::mutex> lock(index_mutex_);
+    index = index_;
+  }
+  protobuf::ChunkStoreManifest manifest;
+  uint64_t disk_usage(0);
+  for (const auto& entry : index) {
+    auto key_tag_and_id(boost::apply_visitor(GetTagValueAndIdentityVisitor(), entry.first));
+    auto proto_entry(manifest.add_entries());
+    proto_entry->set_type(static_cast<uint32_t>(key_tag_and_id.first));
+    proto_entry->set_name(key_tag_and_id.second.string());
+    proto_entry->set_size(entry.second);
+    disk_usage += entry.second;
+  }
+  manifest.set_disk_usage(disk_usage);
+
+  // Write then rename, so that a crash leaves either the old or the new manifest intact.
+  fs::path temp_path(kManifestPath_.string() + ".tmp");
+  if (!WriteFile(temp_path, manifest.SerializeAsString())) {
+    LOG(kError) << "Failed to write " << temp_path;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  boost::system::error_code error_code;
+  fs::rename(temp_path, kManifestPath_, error_code);
+  if (error_code) {
+    LOG(kError) << "Failed to rename " << temp_path << ": " << error_code.message();
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+}
+
+void ChunkStore::OpenJournal() {
+  journal_.close();
+  journal_.clear();
+  journal_.open(kJournalPath_.string(), std::ios::binary | std::ios::out | std::ios::trunc);
+  journal_token_ = RandomString(kJournalTokenSize);
+  journal_.write(journal_token_.data(), journal_token_.size());
+  journal_entries_ = 0;
+
+  // Operations still in flight may not be reflected in the last snapshot, so carry them over.
+  for (const auto& record : pending_journal_records_) {
+    journal_.write(record.second.data(), record.second.size());
+    ++journal_entries_;
+  }
+  journal_.flush();
+  if (!journal_) {
+    LOG(kError) << "Failed to open " << kJournalPath_;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+}
+
+void ChunkStore::AppendToJournal(const KeyType& stored_name,
+                                 const protobuf::ChunkStoreEntry& entry) {
+  std::string serialised_entry(entry.SerializeAsString()), record;
+  AppendUint32(record, static_cast<uint32_t>(serialised_entry.size()));
+  record += serialised_entry;
+
+  std::lock_guard<std::mutex> lock(journal_mutex_);
+  size_t index_size(0);
+  {
+    std::lock_guard<std::mutex> index_lock(index_mutex_);
+    index_size = index_.size();
+  }
+  ++journal_entries_;
+  if (++entries_since_snapshot_ > std::max(kMinJournalEntriesBeforeSnapshot, index_size) &&
+      !snapshot_running_) {
+    StartSnapshot();
+  }
+
+  journal_.write(record.data(), record.size());
+  journal_.flush();
+  if (!journal_) {
+    LOG(kError) << "Failed to append to " << kJournalPath_;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  pending_journal_records_[stored_name] = record;
+}
+
+void ChunkStore::CompleteJournalEntry(const KeyType& stored_name) {
+  std::lock_guard<std::mutex> lock(journal_mutex_);
+  pending_journal_records_.erase(stored_name);
+}
+
+void ChunkStore::StartSnapshot() {
+  // Every change to the index from here on is recorded in the new journal, and any operation still
+  // in flight is carried into it, so the snapshot can be taken at any time later.
+  if (!previous_journal_) {
+    journal_.close();
+    boost::system::error_code error_code;
+    fs::rename(kJournalPath_, kPreviousJournalPath_, error_code);
+    entries_since_snapshot_ = 0;
+    if (error_code) {
+      // Carries on with the same journal, to try again once as many more entries are added.
+      LOG(kError) << "Failed to rename " << kJournalPath_ << ": " << error_code.message();
+      journal_.clear();
+      journal_.open(kJournalPath_.string(), std::ios::binary | std::ios::out | std::ios::app);
+      return;
+    }
+    previous_journal_ = true;
+    OpenJournal();
+  }
+  entries_since_snapshot_ = 0;
+  snapshot_running_ = true;
+  // The previous snapshot's thread has already released journal_mutex_ for the last time.
+  if (snapshotter_.joinable())
+    snapshotter_.join();
+  snapshotter_ = std::thread([this] { SnapshotIndex(); });
+}
+
+void ChunkStore::SnapshotIndex() {
+  bool written(false);
+  try {
+    WriteManifest();
+    boost::system::error_code error_code;
+    fs::remove(kPreviousJournalPath_, error_code);
+    written = true;
+  }
+  catch (const std::exception& e) {
+    LOG(kError) << "Failed to write manifest for " << kDiskPath_ << ", keeping the previous "
+                << "journal: " << boost::diagnostic_information(e);
+  }
+  std::lock_guard<std::mutex> lock(journal_mutex_);
+  if (written)
+    previous_journal_ = false;
+  snapshot_running_ = false;
+}
+
 }  // namespace vault
 
 }  // namespace maidsafe
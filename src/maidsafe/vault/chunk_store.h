@@ -20,14 +20,22 @@
 #define MAIDSAFE_VAULT_CHUNK_STORE_H_
 
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <functional>
 #include <future>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <utility>
 #include <deque>
+#include <fstream>
+#include <list>
 #include <set>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "boost/filesystem/path.hpp"
@@ -37,6 +45,11 @@
 #include "maidsafe/common/types.h"
 #include "maidsafe/common/data_types/data_name_variant.h"
 
+#include "maidsafe/vault/chunk_buffer.h"
+#include "maidsafe/vault/parameters.h"
+#include "maidsafe/vault/segment_store.h"
+#include "maidsafe/vault/segmented_lru.h"
+
 namespace maidsafe {
 
 namespace vault {
@@ -45,41 +58,152 @@ namespace test {
 class ChunkStoreTest;
 }
 
+namespace protobuf {
+class ChunkStoreEntry;
+}
+
+// Stores each chunk in its own file under a nested directory tree.  An index of stored names and
+// sizes is persisted as a manifest beside the disk root (snapshot plus a journal of the names
+// touched since), so that start-up doesn't need to walk the whole tree.  Once the journal grows
+// long, a new one is started and the manifest rewritten on a background thread, after which the
+// previous journal is removed.  The tree is only scanned when the manifest is missing or fails
+// its consistency checks, which include comparing a sample of its entries with the files on disk.
+//
+// Put, Get and Delete may be called concurrently.  Hashing and deobfuscation run without any lock
+// held; the file operation for a chunk (including Put's obfuscation, which is streamed to the file)
+// is serialised only against other operations on chunks in the same lock stripe, and disk usage is
+// accounted atomically.
+//
+// The stored name and file path of recently used keys are cached, so repeated operations on a hot
+// chunk don't rehash its name.  Directories are only created by Put, and only when writing the file
+// finds them missing.
+//
+// In kPersistent mode, Parameters::chunk_store_layout may select ChunkStoreLayout::kSegments
+// instead, in which case all of the above is replaced by a SegmentStore under the disk root.
+//
+// A store constructed in kCache mode evicts chunks rather than refusing Puts once full.  The order
+// of eviction is segmented LRU (see detail::SegmentedLru), tracked in memory from Puts and Gets;
+// after a restart the existing chunks start out in probation.  A background thread evicts from the
+// high watermark down to the low one (see Parameters::disk_cache_high_watermark), and a Put which
+// still finds the store full evicts enough itself.
 class ChunkStore {
  public:
   typedef DataNameVariant KeyType;
+  enum class Mode { kPersistent, kCache };
 
-  ChunkStore(const boost::filesystem::path& disk_path, DiskUsage max_disk_usage);
+  ChunkStore(const boost::filesystem::path& disk_path, DiskUsage max_disk_usage,
+             size_t path_cache_size = detail::Parameters::chunk_store_path_cache_size);
+  ChunkStore(const boost::filesystem::path& disk_path, DiskUsage max_disk_usage, Mode mode,
+             size_t path_cache_size = detail::Parameters::chunk_store_path_cache_size);
   ~ChunkStore();
   ChunkStore(const ChunkStore&) = delete;
   ChunkStore& operator=(const ChunkStore&) = delete;
 
   void Put(const KeyType& key, const NonEmptyString& value);
+  // 'value' must not be empty.
+  void Put(const KeyType& key, const ChunkBuffer& value);
   void Delete(const KeyType& key);
   NonEmptyString Get(const KeyType& key) const;
+  // As Get, but the result can be shared by further consumers without being copied.
+  ChunkBuffer GetBuffer(const KeyType& key) const;
 
   // Return list of elements that should have but not exists yet
   std::vector<KeyType> ElementsToStore(std::set<KeyType> element_list);
 
   void SetMaxDiskUsage(DiskUsage max_disk_usage);
 
-  DiskUsage GetMaxDiskUsage() const { return max_disk_usage_; }
-  DiskUsage GetCurrentDiskUsage() const { return current_disk_usage_; }
+  DiskUsage GetMaxDiskUsage() const;
+  DiskUsage GetCurrentDiskUsage() const;
   boost::filesystem::path GetDiskPath() const { return kDiskPath_; }
+  // Returns the names the chunks are stored under, as held in the index
   std::vector<KeyType> GetKeys() const;
+  // Number of chunks evicted since construction; always zero in kPersistent mode.
+  uint64_t GetEvictionCount() const { return eviction_count_.load(); }
 
   friend class test::ChunkStoreTest;
 
  private:
+  static const size_t kStripeCount_ = 64;
+
+  struct ResolvedKey {
+    ResolvedKey(KeyType stored_name_in, Identity stored_id_in,
+                boost::filesystem::path file_path_in)
+        : stored_name(std::move(stored_name_in)), stored_id(std::move(stored_id_in)),
+          file_path(std::move(file_path_in)) {}
+    KeyType stored_name;
+    Identity stored_id;
+    boost::filesystem::path file_path;
+  };
+  typedef std::list<std::pair<KeyType, ResolvedKey>> PathCacheList;
+
+  // Returns the stored name and file path for 'key', from the cache if possible.
+  ResolvedKey Resolve(const KeyType& key) const;
   boost::filesystem::path GetFilePath(const KeyType& key) const;
-  bool HasDiskSpace(uint64_t required_space) const;
+  // Adds 'required_space' to the current usage if that doesn't exceed the maximum.
+  bool ReserveDiskSpace(uint64_t required_space);
+  // Doesn't touch the disk.
   boost::filesystem::path KeyToFilePath(const KeyType& key) const;
-
-  const boost::filesystem::path kDiskPath_;
-  DiskUsage max_disk_usage_, current_disk_usage_;
+  KeyType StoredName(const KeyType& key) const;
+  std::mutex& Stripe(const Identity& stored_id) const;
+  bool FindInIndex(const KeyType& stored_name, uint64_t& size) const;
+  // Requires the stripe lock for 'resolved' to be held.
+  void RemoveChunkFile(const ResolvedKey& resolved);
+
+  // kCache mode only.  MakeRoom evicts until 'required' more bytes fit, or nothing is left to
+  // evict.
+  void MakeRoom(uint64_t required);
+  void TrimToLowWatermark();
+  bool EvictOne();
+  bool AboveHighWatermark() const;
+  void RunTrimmer();
+  void WakeTrimmer();
+
+  void InitialiseIndex();
+  bool LoadManifest();
+  void ReplayJournal(const boost::filesystem::path& journal_path);
+  // Checks that a random sample of the index's entries are files of the recorded size.
+  bool MatchesDisk() const;
+  void ScanDiskRoot();
+  // Writes a snapshot of the index, which may change meanwhile.  Doesn't require journal_mutex_.
+  void WriteManifest();
+  void OpenJournal();
+  // Require journal_mutex_ to be held.  StartSnapshot moves the journal aside to be kept until the
+  // background snapshot taken by SnapshotIndex has been written, unless a previous journal is still
+  // kept after a failed snapshot, in which case it's only retried.
+  void StartSnapshot();
+  void SnapshotIndex();
+  // The entry stays pending (and is carried into any new journal) until CompleteJournalEntry is
+  // called for the same name, once the file operation and index update have finished.
+  void AppendToJournal(const KeyType& stored_name, const protobuf::ChunkStoreEntry& entry);
+  void CompleteJournalEntry(const KeyType& stored_name);
+
+  const boost::filesystem::path kDiskPath_, kManifestPath_, kJournalPath_, kPreviousJournalPath_;
+  std::atomic<uint64_t> max_disk_usage_, current_disk_usage_;
   const uint32_t kDepth_;
-  mutable std::mutex mutex_;
+  mutable std::array<std::mutex, kStripeCount_> stripes_;
+  mutable std::mutex index_mutex_, journal_mutex_;
   GetIdentityVisitor get_identity_visitor_;
+  std::map<KeyType, uint64_t> index_;
+  const size_t kPathCacheSize_;
+  mutable std::mutex path_cache_mutex_;
+  // Most recently used first.
+  mutable PathCacheList path_cache_list_;
+  mutable std::map<KeyType, PathCacheList::iterator> path_cache_;
+  std::map<KeyType, std::string> pending_journal_records_;
+  std::ofstream journal_;
+  size_t journal_entries_, entries_since_snapshot_;
+  std::string journal_token_;
+  bool snapshot_running_, previous_journal_;
+  std::thread snapshotter_;
+  const Mode kMode_;
+  std::unique_ptr<detail::SegmentedLru> eviction_order_;
+  std::atomic<uint64_t> eviction_count_;
+  std::mutex trimmer_mutex_;
+  std::condition_variable trimmer_condition_;
+  bool stop_trimmer_;
+  std::thread trimmer_;
+  // Only set for ChunkStoreLayout::kSegments, when it handles every operation.
+  std::unique_ptr<SegmentStore> segment_store_;
 };
 
 }  // namespace vault
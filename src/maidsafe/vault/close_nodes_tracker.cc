@@ -0,0 +1,148 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/close_nodes_tracker.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "maidsafe/routing/parameters.h"
+
+#include "maidsafe/vault/parameters.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace {
+
+size_t CommonLeadingBits(const std::string& lhs, const std::string& rhs) {
+  for (size_t i(0); i != lhs.size(); ++i) {
+    unsigned char difference(static_cast<unsigned char>(lhs[i] ^ rhs[i]));
+    if (difference != 0) {
+      size_t bits(i * 8);
+      for (unsigned char mask(0x80); (difference & mask) == 0; mask >>= 1)
+        ++bits;
+      return bits;
+    }
+  }
+  return lhs.size() * 8;
+}
+
+// Sorts the ranges and merges those which overlap.  Ranges of ids sharing a prefix either nest or
+// are disjoint.
+std::vector<IdRange> Merge(std::vector<IdRange> ranges) {
+  std::sort(std::begin(ranges), std::end(ranges));
+  std::vector<IdRange> merged;
+  for (auto& range : ranges) {
+    if (!merged.empty() && range.first <= merged.back().second)
+      merged.back().second = std::max(merged.back().second, range.second);
+    else
+      merged.push_back(std::move(range));
+  }
+  return merged;
+}
+
+}  // unnamed namespace
+
+IdRange WholeIdRange() {
+  return std::make_pair(std::string(NodeId::kSize, '\0'), std::string(NodeId::kSize, '\xff'));
+}
+
+CloseNodesTracker::CloseNodesTracker(const NodeId& this_node_id)
+    : kThisNodeId_(this_node_id), close_nodes_(), updates_since_full_scan_(0) {}
+
+std::vector<IdRange> CloseNodesTracker::Update(const NodeId& lost_node, const NodeId& new_node,
+                                               const std::vector<NodeId>& close_nodes) {
+  std::set<NodeId> new_close_nodes(std::begin(close_nodes), std::end(close_nodes));
+  if (new_node != NodeId())
+    new_close_nodes.insert(new_node);
+  if (lost_node != NodeId())
+    new_close_nodes.erase(lost_node);
+  new_close_nodes.erase(kThisNodeId_);
+
+  std::vector<NodeId> lost_nodes, new_nodes;
+  std::set_difference(std::begin(close_nodes_), std::end(close_nodes_),
+                      std::begin(new_close_nodes), std::end(new_close_nodes),
+                      std::back_inserter(lost_nodes));
+  if (lost_node != NodeId() && close_nodes_.count(lost_node) == 0)
+    lost_nodes.push_back(lost_node);
+  std::set_difference(std::begin(new_close_nodes), std::end(new_close_nodes),
+                      std::begin(close_nodes_), std::end(close_nodes_),
+                      std::back_inserter(new_nodes));
+
+  // The lost nodes' ranges are those of the close nodes before the change, and the new nodes'
+  // those after it.
+  std::vector<IdRange> ranges;
+  for (const auto& node : lost_nodes) {
+    auto lost_ranges(RangesNear(node));
+    ranges.insert(std::end(ranges), std::begin(lost_ranges), std::end(lost_ranges));
+  }
+  close_nodes_.swap(new_close_nodes);
+  for (const auto& node : new_nodes) {
+    auto new_ranges(RangesNear(node));
+    ranges.insert(std::end(ranges), std::begin(new_ranges), std::end(new_ranges));
+  }
+  if (++updates_since_full_scan_ >= detail::Parameters::churn_full_scan_interval) {
+    updates_since_full_scan_ = 0;
+    return std::vector<IdRange>(1, WholeIdRange());
+  }
+  return Merge(std::move(ranges));
+}
+
+// For an id sharing exactly b leading bits with 'node', which of 'node' and another node is closer
+// is decided by the first bit at which those two differ.  So every node sharing exactly b leading
+// bits with 'node' is closer, and once there are group_size + 1 of them, 'node' can't be amongst
+// that id's holders, even allowing one more holder than the group size.  The ids sharing exactly b
+// leading bits with 'node' are those with its first b bits, then bit b flipped.
+std::vector<IdRange> CloseNodesTracker::RangesNear(const NodeId& node) const {
+  const std::string kId(node.string());
+  const size_t kBitCount(kId.size() * 8);
+  const size_t kHolderCount(routing::Parameters::group_size + 1);
+  std::vector<size_t> closer_counts(kBitCount, 0);
+  auto count([&](const NodeId& other) {
+    size_t bits(CommonLeadingBits(kId, other.string()));
+    if (bits < kBitCount)
+      ++closer_counts[bits];
+  });
+  count(kThisNodeId_);
+  for (const auto& close_node : close_nodes_) {
+    if (close_node != node)
+      count(close_node);
+  }
+
+  std::vector<IdRange> ranges(1, std::make_pair(kId, kId));
+  for (size_t bits(0); bits != kBitCount; ++bits) {
+    if (closer_counts[bits] >= kHolderCount)
+      continue;
+    size_t byte(bits / 8);
+    unsigned char mask(static_cast<unsigned char>(0x80 >> (bits % 8)));
+    unsigned char flipped(static_cast<unsigned char>(kId[byte]) ^ mask);
+    std::string first(kId.substr(0, byte)), last(first);
+    first += static_cast<char>(flipped & ~(mask - 1));
+    first.append(kId.size() - byte - 1, '\0');
+    last += static_cast<char>(flipped | (mask - 1));
+    last.append(kId.size() - byte - 1, '\xff');
+    ranges.push_back(std::make_pair(std::move(first), std::move(last)));
+  }
+  return ranges;
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,70 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_CLOSE_NODES_TRACKER_H_
+#define MAIDSAFE_VAULT_CLOSE_NODES_TRACKER_H_
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+// An inclusive range of ids, as given by NodeId::string().  The persona accounts maps are ordered
+// the same way, so each range is a contiguous run of their entries.
+typedef std::pair<std::string, std::string> IdRange;
+
+IdRange WholeIdRange();
+
+// Follows this node's close nodes through the successive churn events, to narrow down which
+// accounts each event can affect: those with a changed node amongst the holders of their id.  The
+// close nodes before the first event aren't known, which only widens the ranges returned.  Not
+// thread-safe.
+class CloseNodesTracker {
+ public:
+  explicit CloseNodesTracker(const NodeId& this_node_id);
+
+  // Records the change (either node may be zero) and returns the ranges of ids it can affect,
+  // sorted and disjoint.  The known close nodes are replaced by 'close_nodes', those after the
+  // change, so any which left or joined without being reported are treated as lost or new too.
+  // Every Parameters::churn_full_scan_interval'th call returns the whole id space instead, so that
+  // accounts which are out of range for any other reason are found too.
+  std::vector<IdRange> Update(const NodeId& lost_node, const NodeId& new_node,
+                              const std::vector<NodeId>& close_nodes);
+  // The ranges of ids which could have 'node' amongst their routing::Parameters::group_size + 1
+  // closest of this node and the known close nodes.
+  std::vector<IdRange> RangesNear(const NodeId& node) const;
+
+  size_t size() const { return close_nodes_.size(); }
+
+ private:
+  const NodeId kThisNodeId_;
+  std::set<NodeId> close_nodes_;
+  int updates_since_full_scan_;
+};
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_CLOSE_NODES_TRACKER_H_
@@ -0,0 +1,148 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_COMMIT_QUEUE_H_
+#define MAIDSAFE_VAULT_COMMIT_QUEUE_H_
+
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace maidsafe {
+
+namespace vault {
+
+// Commits the actions resolved by concurrent handlers together, through one Commit(CommitList) of
+// 'Database' (Db, GroupDb or DataManagerDataBase), without delaying any of them.  The first
+// caller to find no batch being committed commits its own action, and then any which were queued
+// meanwhile, until the queue is empty; the others wait for it.  Each caller returns once the batch
+// holding its action has been written, with that action's result, or throws its error.
+template <typename Database>
+class CommitQueue {
+ public:
+  typedef typename Database::CommitList CommitList;
+  typedef typename CommitList::value_type::first_type Key;
+  typedef typename CommitList::value_type::second_type CommitFunctor;
+  typedef decltype(std::declval<Database&>().Commit(std::declval<const CommitList&>())) Futures;
+  typedef decltype(std::declval<typename Futures::value_type&>().get()) Result;
+
+  explicit CommitQueue(Database& database);
+
+  Result Commit(const Key& key, CommitFunctor functor);
+
+  // The number of batches committed, and of the actions in them.
+  uint64_t BatchCount() const;
+  uint64_t ActionCount() const;
+
+ private:
+  CommitQueue(const CommitQueue&);
+  CommitQueue& operator=(const CommitQueue&);
+
+  struct Pending {
+    Pending(const Key& key_in, CommitFunctor functor_in)
+        : key(key_in), functor(std::move(functor_in)), result() {}
+    Key key;
+    CommitFunctor functor;
+    std::promise<Result> result;
+  };
+
+  void CommitBatch(std::vector<std::shared_ptr<Pending>>& batch);
+
+  Database& database_;
+  mutable std::mutex mutex_;
+  std::vector<std::shared_ptr<Pending>> queue_;
+  bool committing_;
+  uint64_t batch_count_, action_count_;
+};
+
+// ==================== Implementation =============================================================
+
+template <typename Database>
+CommitQueue<Database>::CommitQueue(Database& database)
+    : database_(database), mutex_(), queue_(), committing_(false), batch_count_(0),
+      action_count_(0) {}
+
+template <typename Database>
+typename CommitQueue<Database>::Result CommitQueue<Database>::Commit(const Key& key,
+                                                                    CommitFunctor functor) {
+  auto pending(std::make_shared<Pending>(key, std::move(functor)));
+  auto result(pending->result.get_future());
+  std::unique_lock<std::mutex> lock(mutex_);
+  queue_.push_back(pending);
+  if (!committing_) {
+    committing_ = true;
+    while (!queue_.empty()) {
+      std::vector<std::shared_ptr<Pending>> batch;
+      batch.swap(queue_);
+      lock.unlock();
+      CommitBatch(batch);
+      lock.lock();
+      ++batch_count_;
+      action_count_ += batch.size();
+    }
+    committing_ = false;
+  }
+  lock.unlock();
+  return result.get();
+}
+
+template <typename Database>
+void CommitQueue<Database>::CommitBatch(std::vector<std::shared_ptr<Pending>>& batch) {
+  CommitList commit_list;
+  for (const auto& pending : batch)
+    commit_list.push_back(std::make_pair(pending->key, pending->functor));
+  Futures results;
+  try {
+    results = database_.Commit(commit_list);
+  }
+  catch (const std::exception&) {
+    for (const auto& pending : batch)
+      pending->result.set_exception(std::current_exception());
+    return;
+  }
+  for (size_t i(0); i != batch.size(); ++i) {
+    try {
+      batch[i]->result.set_value(results[i].get());
+    }
+    catch (const std::exception&) {
+      batch[i]->result.set_exception(std::current_exception());
+    }
+  }
+}
+
+template <typename Database>
+uint64_t CommitQueue<Database>::BatchCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return batch_count_;
+}
+
+template <typename Database>
+uint64_t CommitQueue<Database>::ActionCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return action_count_;
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_COMMIT_QUEUE_H_
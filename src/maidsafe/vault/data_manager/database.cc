@@ -18,38 +18,107 @@
 
 #include "maidsafe/vault/data_manager/database.h"
 
+#include <algorithm>
+#include <exception>
+#include <iterator>
+#include <thread>
 #include <utility>
 #include <cstdint>
 #include <string>
 
-#include "boost/filesystem.hpp"
 #include "boost/algorithm/string.hpp"
+#include "boost/filesystem.hpp"
 
 #include "maidsafe/common/log.h"
-#include "maidsafe/common/utils.h"
 #include "maidsafe/common/sqlite3_wrapper.h"
+#include "maidsafe/common/utils.h"
 
+#include "maidsafe/vault/key_utils.h"
+#include "maidsafe/vault/parameters.h"
 #include "maidsafe/vault/data_manager/data_manager.h"
 
 namespace maidsafe {
 
 namespace vault {
 
-DataManagerDataBase::DataManagerDataBase(const boost::filesystem::path& db_path)
-  : data_base_(), kDbPath_(db_path), write_operations_(0) {
-  data_base_.reset(new sqlite::Database(db_path,
-                                        sqlite::Mode::kReadWriteCreate));
-  std::string query(
-      "CREATE TABLE IF NOT EXISTS DataManagerAccounts ("
-      "Chunk_Name TEXT  PRIMARY KEY NOT NULL, Chunk_Size TEXT NOT NULL,"
-      "Storage_Nodes TEXT NOT NULL);");
-  sqlite::Transaction transaction{*data_base_};
-  sqlite::Statement statement{*data_base_, query};
-  statement.Step();
-  transaction.Commit();
+namespace {
+
+// Versions of the store's layout:
+//   0: the SQLite table DataManagerAccounts, holding hex-encoded names and decimal sizes as text
+//   1: serialised protobuf::DataManagerValues under the bare fixed-width keys
+//   2: dictionary-encoded rows, as below
+const std::string kSchemaVersion("2");
+
+// The keyspace is split by a leading byte between the rows, the dictionary entries (each keyed by
+// its id as four big-endian bytes) and the schema version.
+const char kRowPrefix('r');
+const char kDictionaryPrefix('p');
+const std::string kSchemaVersionKey("v");
+
+const int kDictionaryIdWidth(4);
+const size_t kDictionaryKeySize(1 + kDictionaryIdWidth);
+const size_t kSerialisedKeySize(NodeId::kSize + detail::PaddedWidth::value);
+// The number of rows migrated in each batch.
+const size_t kMigrationBatchSize(1000);
+// The key filter is built to hold at least this many keys, or twice the number in the store.
+const size_t kMinKeyFilterCapacity(1 << 16);
+const double kKeyFilterFalsePositiveRate(0.01);
+
+std::string DictionaryKey(uint32_t id) {
+  return kDictionaryPrefix + detail::ToFixedWidthString<kDictionaryIdWidth>(id);
+}
+
+uint32_t DictionaryId(const std::string& key) {
+  return detail::FromFixedWidthString<kDictionaryIdWidth>(key.substr(1));
+}
+
+// The rows' names are hashes, so splitting the range of their first two bytes evenly splits the
+// rows evenly too.  Returns the start of the 'index'th of 'count' such ranges, or the end of the
+// last if 'index' is 'count'.
+std::string PartitionBound(size_t index, size_t count) {
+  const std::string kRowsBegin(1, kRowPrefix);
+  if (index == 0)
+    return kRowsBegin;
+  if (index == count)
+    return PrefixEnd(kRowsBegin);
+  return kRowsBegin + detail::ToFixedWidthString<2>(static_cast<uint32_t>(index * 65536 / count));
+}
+
+size_t TransferScanPartitionCount() {
+  size_t count(detail::Parameters::data_manager_transfer_scan_threads);
+  if (count == 0)
+    count = std::thread::hardware_concurrency();
+  return std::min<size_t>(std::max<size_t>(count, 1), 256);
+}
+
+}  // unnamed namespace
+
+DataManagerDataBase::DataManagerDataBase(const boost::filesystem::path& db_path,
+                                         size_t value_cache_size)
+    : mutex_(),
+      data_base_(new VaultDataBase(db_path)),
+      dictionary_(),
+      dictionary_loaded_(false),
+      holder_index_(),
+      holder_index_built_(false),
+      key_filter_(kMinKeyFilterCapacity, kKeyFilterFalsePositiveRate),
+      key_filter_deletions_(0),
+      key_filter_rebuilding_(false),
+      keys_added_during_rebuild_(),
+      key_filter_builder_(),
+      kValueCacheSize_(value_cache_size),
+      value_cache_list_(),
+      value_cache_(),
+      cache_counters_(),
+      kDbPath_(db_path) {
+  Open();
+  BuildHolderIndex();
+  key_filter_ = BuildKeyFilter(*data_base_->GetSnapshot());
 }
 
 DataManagerDataBase::~DataManagerDataBase() {
+  if (key_filter_builder_.joinable())
+    key_filter_builder_.join();
   try {
     data_base_.reset();
     boost::filesystem::remove_all(kDbPath_);
@@ -60,11 +129,46 @@ DataManagerDataBase::~DataManagerDataBase() {
 }
 
 std::unique_ptr<DataManager::Value> DataManagerDataBase::Commit(const DataManager::Key& key,
-    std::function<detail::DbAction(std::unique_ptr<DataManager::Value>& value)> functor) {
+                                                                CommitFunctor functor) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  VaultDataBase::Batch batch(*data_base_);
+  auto value(DoCommit(key, functor, batch));
+  CommitBatch(batch);
+  return value;
+}
+
+std::vector<std::future<std::unique_ptr<DataManager::Value>>> DataManagerDataBase::Commit(
+    const CommitList& commit_list) {
+  std::vector<std::future<std::unique_ptr<DataManager::Value>>> results;
+  results.reserve(commit_list.size());
+  std::lock_guard<std::mutex> lock(mutex_);
+  VaultDataBase::Batch batch(*data_base_);
+  for (const auto& entry : commit_list) {
+    std::promise<std::unique_ptr<DataManager::Value>> result;
+    try {
+      result.set_value(DoCommit(entry.first, entry.second, batch));
+    }
+    catch (...) {
+      result.set_exception(std::current_exception());
+    }
+    results.push_back(result.get_future());
+  }
+  CommitBatch(batch);
+  return results;
+}
+
+void DataManagerDataBase::SetGroupCommitWindow(std::chrono::milliseconds max_delay,
+                                               int max_writes) {
+  data_base_->SetGroupCommitWindow(max_delay, max_writes);
+}
+
+std::unique_ptr<DataManager::Value> DataManagerDataBase::DoCommit(const DataManager::Key& key,
+                                                                  const CommitFunctor& functor,
+                                                                  VaultDataBase::Batch& batch) {
   assert(functor);
   std::unique_ptr<DataManager::Value> value;
   try {
-    value.reset(new DataManager::Value(Get(key)));
+    value.reset(new DataManager::Value(GetValue(key, &batch)));
   }
   catch (const maidsafe_error& error) {
     if (error.code() != make_error_code(VaultErrors::no_such_account)) {
@@ -73,81 +177,94 @@ std::unique_ptr<DataManager::Value> DataManagerDataBase::Commit(const DataManage
       throw;  // For db errors
     }
   }
+  auto old_holders(value ? value->AllPmids() : std::vector<PmidName>());
   if (detail::DbAction::kPut == functor(value)) {
     assert(value);
     LOG(kInfo) << "DataManagerDataBase::Commit putting entry";
-    Put(key, std::move(*value));
+    Put(key, *value, batch);
+    UpdateHolderIndex(key, old_holders, value->AllPmids());
   } else {
     LOG(kInfo) << "DataManagerDataBase::Commit deleting entry";
     if (!value)
       BOOST_THROW_EXCEPTION(MakeError(CommonErrors::null_pointer));
-    Delete(key);
+    Delete(key, batch);
+    UpdateHolderIndex(key, old_holders, std::vector<PmidName>());
     return value;
   }
   return nullptr;
 }
 
-void DataManagerDataBase::Put(const DataManager::Key& key, const DataManager::Value& value) {
+void DataManagerDataBase::Put(const DataManager::Key& key, const DataManager::Value& value,
+                              VaultDataBase::Batch& batch) {
   if (!data_base_)
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_not_presented));
-  CheckPoint();
-
-  sqlite::Transaction transaction{*data_base_};
-  std::string query(
-      "INSERT OR REPLACE INTO DataManagerAccounts (Chunk_Name, Chunk_size,"
-      " Storage_Nodes) VALUES (?, ?, ?)");
-  sqlite::Statement statement{*data_base_, query};
-
-  std::string storage_nodes;
-  for (auto& storage_node : value.AllPmids())
-    storage_nodes += NodeId(storage_node->string()).ToStringEncoded(NodeId::EncodingType::kHex) +
-                         ";";
-//  LOG(kVerbose) << "inserting pmids as " << storage_nodes;
-  statement.BindText(3, storage_nodes);
-
-  std::string chunk_size(std::to_string(value.chunk_size()));
-//  LOG(kVerbose) << "inserting chunk size as " << chunk_size;
-  statement.BindText(2, chunk_size);
+  if (value.chunk_size() == 0) {
+    LOG(kError) << "DataManagerDataBase::Put Cannot encode if not a complete db value";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+  if (!dictionary_loaded_)
+    LoadDictionary();
+  data_base_->Put(EncodeKey(key), EncodeValue(value, batch), batch);
+  CacheValue(key, value);
+  auto key_string(EncodeKey(key));
+  key_filter_.Add(key_string);
+  if (key_filter_rebuilding_)
+    keys_added_during_rebuild_.push_back(std::move(key_string));
+}
 
-  std::string chunk_name(EncodeKey(key));
-//  LOG(kVerbose) << "inserting chunk_name as " << chunk_name;
-  statement.BindText(1, chunk_name);
+DataManager::Value DataManagerDataBase::Get(const DataManager::Key& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return GetValue(key);
+}
 
-  statement.Step();
-  transaction.Commit();
+bool DataManagerDataBase::Exists(const DataManager::Key& key) {
+  if (!data_base_)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_not_presented));
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (key_filter_.size() > key_filter_.capacity() ||
+      key_filter_deletions_ > key_filter_.capacity() / 2) {
+    StartKeyFilterRebuild();
+  }
+  auto key_string(EncodeKey(key));
+  if (!key_filter_.MayContain(key_string))
+    return false;
+  DataManager::Value value;
+  if (FindCachedValue(key, value))
+    return true;
+  std::string value_string;
+  data_base_->Get(key_string, value_string);
+  return !value_string.empty();
 }
 
-DataManager::Value DataManagerDataBase::Get(const DataManager::Key& key) {
+DataManager::Value DataManagerDataBase::GetValue(const DataManager::Key& key,
+                                                 const VaultDataBase::Batch* batch) {
   if (!data_base_)
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_not_presented));
   DataManager::Value value;
-  std::string query(
-      "SELECT Chunk_Size, Storage_Nodes FROM DataManagerAccounts WHERE Chunk_Name=?");
-  sqlite::Statement statement{*data_base_, query};
-  auto chunk_name(EncodeKey(key));
-  LOG(kVerbose) << "looking for chunk " << chunk_name;
-  statement.BindText(1, chunk_name);
-  if (statement.Step() == sqlite::StepResult::kSqliteRow) {
-    value = ComposeValue(statement.ColumnText(0), statement.ColumnText(1));
-  } else {
-    LOG(kWarning) << "dones't got account for chunk " << EncodeKey(key);
+  if (FindCachedValue(key, value))
+    return value;
+  std::string value_string;
+  if (batch)
+    data_base_->Get(EncodeKey(key), value_string, *batch);
+  else
+    data_base_->Get(EncodeKey(key), value_string);
+  if (value_string.empty()) {
+    LOG(kWarning) << "dones't got account for chunk " << HexSubstr(key.name.string());
     BOOST_THROW_EXCEPTION(MakeError(VaultErrors::no_such_account));
   }
+  if (!dictionary_loaded_)
+    LoadDictionary();
+  value = DecodeValue(value_string, dictionary_);
+  CacheValue(key, value);
   return value;
 }
 
-void DataManagerDataBase::Delete(const DataManager::Key& key) {
+void DataManagerDataBase::Delete(const DataManager::Key& key, VaultDataBase::Batch& batch) {
   if (!data_base_)
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_not_presented));
-  CheckPoint();
-
-  sqlite::Transaction transaction{*data_base_};
-  std::string query("DELETE FROM DataManagerAccounts WHERE Chunk_Name=?");
-  sqlite::Statement statement{*data_base_, query};
-  auto key_string(EncodeKey(key));
-  statement.BindText(1, key_string);
-  statement.Step();
-  transaction.Commit();
+  data_base_->Delete(EncodeKey(key), batch);
+  UncacheValue(key);
+  ++key_filter_deletions_;
 }
 
 std::map<DataManager::Key, DataManager::Value> DataManagerDataBase::GetRelatedAccounts(
@@ -155,18 +272,12 @@ std::map<DataManager::Key, DataManager::Value> DataManagerDataBase::GetRelatedAc
   if (!data_base_)
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_not_presented));
 
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!holder_index_built_)
+    BuildHolderIndex();
   std::map<DataManager::Key, DataManager::Value> result;
-  std::string query(
-      "SELECT * FROM DataManagerAccounts WHERE Storage_Nodes LIKE ?");
-  sqlite::Statement statement{*data_base_, query};
-  std::string target('%' + NodeId(pmid_name->string()).ToStringEncoded(
-                        NodeId::EncodingType::kHex) + '%');
-  statement.BindText(1, target);
-  while (statement.Step() == sqlite::StepResult::kSqliteRow) {
-    DataManager::Key key(ComposeKey(statement.ColumnText(0)));
-    DataManagerValue value(ComposeValue(statement.ColumnText(1), statement.ColumnText(2)));
-    result[key] = value;
-  }
+  for (const auto& key : holder_index_.Get(pmid_name))
+    result[key] = GetValue(key);
   return std::move(result);
 }
 
@@ -174,86 +285,406 @@ DataManager::TransferInfo DataManagerDataBase::GetTransferInfo(
     std::shared_ptr<routing::CloseNodesChange> close_nodes_change) {
   if (!data_base_)
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_not_presented));
+  // The snapshots are all taken together, so see the same rows.  These only refer to dictionary
+  // entries already present, so a copy of the dictionary taken with them can decode them all.
+  const size_t kPartitionCount(TransferScanPartitionCount());
+  std::vector<std::unique_ptr<KeyValueBackend::Snapshot>> snapshots;
+  detail::PmidDictionary dictionary;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dictionary_loaded_)
+      LoadDictionary();
+    dictionary = dictionary_;
+    for (size_t i(0); i != kPartitionCount; ++i)
+      snapshots.push_back(data_base_->GetSnapshot());
+  }
+
+  std::vector<std::future<TransferScanResult>> futures;
+  for (size_t i(0); i != kPartitionCount; ++i) {
+    auto& snapshot(*snapshots[i]);
+    std::string begin(PartitionBound(i, kPartitionCount)),
+        end(PartitionBound(i + 1, kPartitionCount));
+    futures.push_back(std::async(std::launch::async, [=, &snapshot, &dictionary] {
+      return ScanForTransfer(snapshot, begin, end, dictionary, *close_nodes_change);
+    }));
+  }
 
+  // The partitions are merged in order, so each destination's accounts stay in key order.
   std::vector<DataManager::Key> prune_vector;
   DataManager::TransferInfo transfer_info;
+  std::exception_ptr error;
+  for (auto& future : futures) {
+    try {
+      auto result(future.get());
+      for (auto& transfer : result.first) {
+        auto& accounts(transfer_info[transfer.first]);
+        std::move(std::begin(transfer.second), std::end(transfer.second),
+                  std::back_inserter(accounts));
+      }
+      std::move(std::begin(result.second), std::end(result.second),
+                std::back_inserter(prune_vector));
+    }
+    catch (...) {
+      if (!error)
+        error = std::current_exception();
+    }
+  }
+  snapshots.clear();
+  if (error)
+    std::rethrow_exception(error);
+  Prune(prune_vector);
+  return transfer_info;
+}
 
-  std::string query("SELECT * from DataManagerAccounts");
-  sqlite::Statement statement{*data_base_, query};
-  while (statement.Step() == sqlite::StepResult::kSqliteRow) {
-    DataManager::Key key(ComposeKey(statement.ColumnText(0)));
-    DataManager::Value value(ComposeValue(statement.ColumnText(1), statement.ColumnText(2)));
+DataManagerDataBase::TransferScanResult DataManagerDataBase::ScanForTransfer(
+    KeyValueBackend::Snapshot& snapshot, const std::string& begin, const std::string& end,
+    const detail::PmidDictionary& dictionary,
+    const routing::CloseNodesChange& close_nodes_change) const {
+  TransferScanResult result;
+  auto& transfer_info(result.first);
+  snapshot.Scan(begin, end, [&](const std::string& key_string, const std::string& value_string) {
+    DataManager::Key key(DecodeKey(key_string));
 
-    auto check_holder_result = close_nodes_change->CheckHolders(NodeId(key.name.string()));
+    auto check_holder_result = close_nodes_change.CheckHolders(NodeId(key.name.string()));
     if (check_holder_result.proximity_status == routing::GroupRangeStatus::kInRange) {
       LOG(kVerbose) << "Db::GetTransferInfo in range";
       if (check_holder_result.new_holder == NodeId())
-        continue;
+        return true;
       LOG(kVerbose) << "Db::GetTransferInfo having new holder " << check_holder_result.new_holder;
       auto found_itr = transfer_info.find(check_holder_result.new_holder);
       if (found_itr != transfer_info.end()) {
         LOG(kInfo) << "Db::GetTransferInfo add into transfering account "
                    << HexSubstr(key.name.string()) << " to " << check_holder_result.new_holder;
-        found_itr->second.push_back(std::make_pair(key, value));
+        found_itr->second.push_back(std::make_pair(key, DecodeValue(value_string, dictionary)));
       } else {  // create
         LOG(kInfo) << "Db::GetTransferInfo create transfering account "
                    << HexSubstr(key.name.string()) << " to " << check_holder_result.new_holder;
         std::vector<DataManager::KvPair> kv_pair;
-        kv_pair.push_back(std::make_pair(key, value));
+        kv_pair.push_back(std::make_pair(key, DecodeValue(value_string, dictionary)));
         transfer_info.insert(std::make_pair(check_holder_result.new_holder, std::move(kv_pair)));
       }
     } else {
 //      VLOG(VisualiserAction::kRemoveAccount, key.name);
-      prune_vector.push_back(key);
+      result.second.push_back(key);
     }
+    return true;
+  });
+  return result;
+}
+
+void DataManagerDataBase::Prune(const std::vector<DataManager::Key>& keys) {
+  const size_t kBatchSize(std::max<size_t>(detail::Parameters::prune_batch_size, 1));
+  for (size_t begin(0); begin < keys.size(); begin += kBatchSize) {
+    size_t end(std::min(begin + kBatchSize, keys.size()));
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dictionary_loaded_)
+      LoadDictionary();
+    // The accounts' holders are taken from their current values, which may have changed since the
+    // snapshot was scanned.
+    std::vector<std::pair<DataManager::Key, std::vector<PmidName>>> pruned_holders;
+    VaultDataBase::Batch batch(*data_base_);
+    for (size_t i(begin); i != end; ++i) {
+      std::string value_string;
+      data_base_->Get(EncodeKey(keys[i]), value_string, batch);
+      if (value_string.empty())
+        continue;
+      pruned_holders.push_back(
+          std::make_pair(keys[i], DecodeValue(value_string, dictionary_).AllPmids()));
+      Delete(keys[i], batch);  // Ignore Delete failure here ?
+    }
+    CommitBatch(batch);
+    for (const auto& pruned : pruned_holders)
+      UpdateHolderIndex(pruned.first, pruned.second, std::vector<PmidName>());
   }
-  for (const auto& key : prune_vector)
-    Delete(key);  // Ignore Delete failure here ?
-  return transfer_info;
 }
 
 void DataManagerDataBase::HandleTransfer(const std::vector<DataManager::KvPair>& contents) {
   LOG(kVerbose) << "DataManager AcoccountTransfer DataManagerDataBase::HandleTransfer";
-  for (const auto& kv_pair : contents) {
-    try {
-      Get(kv_pair.first);
-    }
-    catch (const maidsafe_error& error) {
-      LOG(kInfo) << "DataManager AcoccountTransfer DataManagerDataBase::HandleTransfer "
-                 << error.what();
-      if ((error.code() != make_error_code(CommonErrors::no_such_element)) &&
-          (error.code() != make_error_code(VaultErrors::no_such_account))) {
-        throw;  // For db errors
-      } else {
+  std::lock_guard<std::mutex> lock(mutex_);
+  VaultDataBase::Batch batch(*data_base_);
+  try {
+    for (const auto& kv_pair : contents) {
+      try {
+        GetValue(kv_pair.first, &batch);
+      }
+      catch (const maidsafe_error& error) {
         LOG(kInfo) << "DataManager AcoccountTransfer DataManagerDataBase::HandleTransfer "
-                   << "inserting account " << HexSubstr(kv_pair.first.name.string());
-        Put(kv_pair.first, kv_pair.second);
+                   << error.what();
+        if ((error.code() != make_error_code(CommonErrors::no_such_element)) &&
+            (error.code() != make_error_code(VaultErrors::no_such_account))) {
+          throw;  // For db errors
+        } else {
+          LOG(kInfo) << "DataManager AcoccountTransfer DataManagerDataBase::HandleTransfer "
+                     << "inserting account " << HexSubstr(kv_pair.first.name.string());
+          Put(kv_pair.first, kv_pair.second, batch);
+          UpdateHolderIndex(kv_pair.first, std::vector<PmidName>(), kv_pair.second.AllPmids());
+        }
       }
     }
   }
+  catch (...) {
+    // The batch is discarded, along with the writes which the index and dictionary reflect.
+    Invalidate();
+    throw;
+  }
+  CommitBatch(batch);
 }
 
-DataManager::Value DataManagerDataBase::ComposeValue(const std::string& chunk_size,
-                                                     const std::string& pmids) const {
-  DataManager::Value value;
-//  LOG(kVerbose) << "chunk_size is " << chunk_size;
-  value.SetChunkSize(std::stoi(chunk_size));
-  std::vector<std::string> storage_nodes;
-//  LOG(kVerbose) << "pmids are " << pmids;
-  // The following line will throw an error msg to be printed out on screen :
-  // find_iterator.hpp:243:30: runtime error: load of value ...
-  boost::algorithm::split(storage_nodes, pmids, boost::is_any_of(";"));
-  storage_nodes.pop_back();
-  for (auto& storage_node : storage_nodes)
-    value.AddPmid(PmidName(Identity(NodeId(storage_node, NodeId::EncodingType::kHex).string())));
-  return value;
+void DataManagerDataBase::BuildHolderIndex() {
+  holder_index_.Clear();
+  if (!dictionary_loaded_)
+    LoadDictionary();
+  data_base_->ScanPrefix(std::string(1, kRowPrefix),
+                         [this](const std::string& key_string, const std::string& value_string) {
+    holder_index_.Update(DecodeKey(key_string), std::vector<PmidName>(),
+                         DecodeValue(value_string, dictionary_).AllPmids());
+    return true;
+  });
+  holder_index_built_ = true;
+}
+
+void DataManagerDataBase::UpdateHolderIndex(const DataManager::Key& key,
+                                            const std::vector<PmidName>& old_holders,
+                                            const std::vector<PmidName>& new_holders) {
+  if (holder_index_built_)
+    holder_index_.Update(key, old_holders, new_holders);
+}
+
+void DataManagerDataBase::CommitBatch(VaultDataBase::Batch& batch) {
+  try {
+    batch.Commit();
+  }
+  catch (...) {
+    Invalidate();
+    throw;
+  }
+}
+
+BloomFilter DataManagerDataBase::BuildKeyFilter(KeyValueBackend::Snapshot& snapshot) {
+  size_t count(0);
+  snapshot.ScanPrefix(std::string(1, kRowPrefix),
+                      [&count](const std::string& /*key_string*/,
+                                const std::string& /*value_string*/) {
+    ++count;
+    return true;
+  });
+  BloomFilter key_filter(std::max(kMinKeyFilterCapacity, 2 * count), kKeyFilterFalsePositiveRate);
+  snapshot.ScanPrefix(std::string(1, kRowPrefix),
+                      [&key_filter](const std::string& key_string,
+                                     const std::string& /*value_string*/) {
+    key_filter.Add(key_string);
+    return true;
+  });
+  return key_filter;
+}
+
+void DataManagerDataBase::StartKeyFilterRebuild() {
+  if (key_filter_rebuilding_)
+    return;
+  // A previous builder has finished with mutex_ by the time it clears key_filter_rebuilding_.
+  if (key_filter_builder_.joinable())
+    key_filter_builder_.join();
+  std::shared_ptr<KeyValueBackend::Snapshot> snapshot(data_base_->GetSnapshot());
+  key_filter_rebuilding_ = true;
+  key_filter_deletions_ = 0;
+  keys_added_during_rebuild_.clear();
+  key_filter_builder_ = std::thread([this, snapshot] { RebuildKeyFilter(snapshot); });
+}
+
+void DataManagerDataBase::RebuildKeyFilter(std::shared_ptr<KeyValueBackend::Snapshot> snapshot) {
+  std::unique_ptr<BloomFilter> key_filter;
+  try {
+    key_filter.reset(new BloomFilter(BuildKeyFilter(*snapshot)));
+  }
+  catch (const std::exception& e) {
+    // The current filter still has no false negatives, so is kept until the next attempt.
+    LOG(kError) << "Failed to rebuild the key filter: " << boost::diagnostic_information(e);
+  }
+  snapshot.reset();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (key_filter) {
+    for (const auto& key_string : keys_added_during_rebuild_)
+      key_filter->Add(key_string);
+    key_filter_ = std::move(*key_filter);
+  }
+  keys_added_during_rebuild_.clear();
+  key_filter_rebuilding_ = false;
+}
+
+void DataManagerDataBase::Invalidate() {
+  holder_index_built_ = false;
+  dictionary_loaded_ = false;
+  value_cache_.clear();
+  value_cache_list_.clear();
+}
+
+bool DataManagerDataBase::FindCachedValue(const DataManager::Key& key,
+                                          DataManager::Value& value) {
+  if (kValueCacheSize_ == 0)
+    return false;
+  auto itr(value_cache_.find(key));
+  if (itr == value_cache_.end()) {
+    cache_counters_.Miss();
+    return false;
+  }
+  value_cache_list_.splice(value_cache_list_.begin(), value_cache_list_, itr->second);
+  value = itr->second->second;
+  cache_counters_.Hit(0);
+  return true;
 }
 
-void DataManagerDataBase::CheckPoint() {
-  if (++write_operations_ > 1000) {
-    data_base_->CheckPoint();
-    write_operations_ = 0;
+void DataManagerDataBase::CacheValue(const DataManager::Key& key,
+                                     const DataManager::Value& value) {
+  if (kValueCacheSize_ == 0)
+    return;
+  auto itr(value_cache_.find(key));
+  if (itr != value_cache_.end()) {
+    itr->second->second = value;
+    value_cache_list_.splice(value_cache_list_.begin(), value_cache_list_, itr->second);
+    return;
   }
+  value_cache_list_.push_front(std::make_pair(key, value));
+  value_cache_.insert(std::make_pair(key, value_cache_list_.begin()));
+  cache_counters_.Admitted(0);
+  if (value_cache_.size() > kValueCacheSize_) {
+    value_cache_.erase(value_cache_list_.back().first);
+    value_cache_list_.pop_back();
+  }
+}
+
+void DataManagerDataBase::UncacheValue(const DataManager::Key& key) {
+  auto itr(value_cache_.find(key));
+  if (itr == value_cache_.end())
+    return;
+  value_cache_list_.erase(itr->second);
+  value_cache_.erase(itr);
+}
+
+void DataManagerDataBase::Open() {
+  LoadDictionary();
+  std::string version;
+  data_base_->Get(kSchemaVersionKey, version);
+  if (version == kSchemaVersion)
+    return;
+  if (!version.empty()) {
+    LOG(kError) << "Unknown data manager schema version " << version;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+  // A migration interrupted part way is simply run again, keeping the ids given to holders by the
+  // rows it has already written.
+  MigrateTextSchema();
+  MigrateSerialisedRows();
+  data_base_->Put(kSchemaVersionKey, kSchemaVersion);
+}
+
+void DataManagerDataBase::MigrateTextSchema() {
+  if (detail::Parameters::metadata_backend != KeyValueBackendType::kSqlite)
+    return;
+  sqlite::Database legacy(kDbPath_, sqlite::Mode::kReadWrite);
+  {
+    sqlite::Statement table(legacy, "SELECT name FROM sqlite_master WHERE type='table' AND "
+                                    "name='DataManagerAccounts'");
+    if (table.Step() != sqlite::StepResult::kSqliteRow)
+      return;
+  }
+  LOG(kInfo) << "DataManagerDataBase migrating accounts from the text schema";
+  {
+    sqlite::Statement statement(legacy, "SELECT Chunk_Name, Chunk_Size, Storage_Nodes FROM "
+                                        "DataManagerAccounts");
+    std::unique_ptr<VaultDataBase::Batch> batch(new VaultDataBase::Batch(*data_base_));
+    size_t count(0);
+    while (statement.Step() == sqlite::StepResult::kSqliteRow) {
+      DataManager::Key key(DataManager::Key::FixedWidthString(HexDecode(statement.ColumnText(0))));
+      DataManager::Value value(std::stoull(statement.ColumnText(1)));
+      std::string pmids(statement.ColumnText(2));
+      std::vector<std::string> storage_nodes;
+      boost::algorithm::split(storage_nodes, pmids, boost::is_any_of(";"));
+      for (const auto& storage_node : storage_nodes) {
+        if (!storage_node.empty())
+          value.AddPmid(PmidName(Identity(NodeId(storage_node,
+                                                 NodeId::EncodingType::kHex).string())));
+      }
+      Put(key, value, *batch);
+      if (++count % kMigrationBatchSize == 0) {
+        CommitBatch(*batch);
+        batch.reset(new VaultDataBase::Batch(*data_base_));
+      }
+    }
+    CommitBatch(*batch);
+  }
+  legacy.Execute("DROP TABLE DataManagerAccounts");
+}
+
+void DataManagerDataBase::MigrateSerialisedRows() {
+  std::string begin;
+  for (;;) {
+    std::vector<std::pair<std::string, std::string>> rows;
+    data_base_->Scan(begin, std::string(),
+                     [&](const std::string& key_string, const std::string& value_string) {
+      if (key_string.size() == kSerialisedKeySize)
+        rows.push_back(std::make_pair(key_string, value_string));
+      begin = key_string;
+      return rows.size() < kMigrationBatchSize;
+    });
+    if (rows.empty())
+      return;
+    LOG(kInfo) << "DataManagerDataBase migrating " << rows.size() << " serialised accounts";
+    begin.push_back('\0');
+    VaultDataBase::Batch batch(*data_base_);
+    for (const auto& row : rows) {
+      data_base_->Delete(row.first, batch);
+      Put(DataManager::Key(DataManager::Key::FixedWidthString(row.first)),
+          DataManager::Value(row.second), batch);
+    }
+    CommitBatch(batch);
+  }
+}
+
+void DataManagerDataBase::LoadDictionary() {
+  dictionary_.Clear();
+  data_base_->ScanPrefix(std::string(1, kDictionaryPrefix),
+                         [this](const std::string& key_string, const std::string& value_string) {
+    // Other keys with the prefix are rows of an earlier schema, yet to be migrated.
+    if (key_string.size() != kDictionaryKeySize)
+      return true;
+    dictionary_.Insert(DictionaryId(key_string), PmidName(Identity(value_string)));
+    return true;
+  });
+  dictionary_loaded_ = true;
+}
+
+std::string DataManagerDataBase::EncodeValue(const DataManager::Value& value,
+                                             VaultDataBase::Batch& batch) {
+  std::vector<uint32_t> pmid_ids;
+  for (const auto& pmid_name : value.AllPmids()) {
+    uint32_t id(0);
+    if (!dictionary_.Find(pmid_name, id)) {
+      id = dictionary_.Add(pmid_name);
+      data_base_->Put(DictionaryKey(id), pmid_name->string(), batch);
+    }
+    pmid_ids.push_back(id);
+  }
+  return detail::EncodeRow(value.chunk_size(), pmid_ids);
+}
+
+DataManager::Value DataManagerDataBase::DecodeValue(const std::string& row,
+                                                    const detail::PmidDictionary& dictionary) {
+  uint64_t chunk_size(0);
+  std::vector<uint32_t> pmid_ids;
+  detail::DecodeRow(row, chunk_size, pmid_ids);
+  std::vector<PmidName> pmids;
+  pmids.reserve(pmid_ids.size());
+  for (const auto& id : pmid_ids)
+    pmids.push_back(dictionary.Name(id));
+  return DataManager::Value(chunk_size, std::move(pmids));
+}
+
+std::string DataManagerDataBase::EncodeKey(const DataManager::Key& key) const {
+  return kRowPrefix + key.ToFixedWidthString().string();
+}
+
+DataManager::Key DataManagerDataBase::DecodeKey(const std::string& key_string) const {
+  return DataManager::Key(DataManager::Key::FixedWidthString(key_string.substr(1)));
 }
 
 }  // namespace vault
@@ -19,50 +19,149 @@
 #ifndef MAIDSAFE_VAULT_DATA_MANAGER_DATABASE_H_
 #define MAIDSAFE_VAULT_DATA_MANAGER_DATABASE_H_
 
+#include <chrono>
+#include <future>
+#include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
-#include "maidsafe/common/sqlite3_wrapper.h"
-
+#include "maidsafe/vault/bloom_filter.h"
+#include "maidsafe/vault/cache_statistics.h"
+#include "maidsafe/vault/database_operations.h"
+#include "maidsafe/vault/parameters.h"
 #include "maidsafe/vault/data_manager/data_manager.h"
+#include "maidsafe/vault/data_manager/row_format.h"
 
 namespace maidsafe {
 
 namespace vault {
 
+// Rows are stored in the compact format of detail::EncodeRow, with the holders' names kept once
+// each in a dictionary alongside them.  A store written by an earlier schema is migrated when
+// opened.
 class DataManagerDataBase {
  public:
-  explicit DataManagerDataBase(const boost::filesystem::path& db_path);
+  typedef std::function<detail::DbAction(std::unique_ptr<DataManager::Value>& value)>
+      CommitFunctor;
+  typedef std::vector<std::pair<DataManager::Key, CommitFunctor>> CommitList;
+
+  // Up to 'value_cache_size' of the most recently used accounts are held decoded in memory.
+  explicit DataManagerDataBase(
+      const boost::filesystem::path& db_path,
+      size_t value_cache_size = detail::Parameters::data_manager_value_cache_size);
   ~DataManagerDataBase();
 
-  std::unique_ptr<DataManager::Value> Commit(const DataManager::Key& key,
-      std::function<detail::DbAction(std::unique_ptr<DataManager::Value>& value)> functor);
+  std::unique_ptr<DataManager::Value> Commit(const DataManager::Key& key, CommitFunctor functor);
+  // Commits each entry in order, as above, making all their writes in a single batch.  An error
+  // from an entry is returned in its future and doesn't affect the others.  If writing the batch
+  // fails, none of the writes are made and the error is thrown.
+  std::vector<std::future<std::unique_ptr<DataManager::Value>>> Commit(
+      const CommitList& commit_list);
   DataManager::Value Get(const DataManager::Key& key);
-
+  // Answers from a Bloom filter of the keys where it can, so most missing accounts cost neither a
+  // store read nor an exception.  Once the filter has grown stale, a fresh one is built from a
+  // snapshot on a background thread, and swapped in when done.
+  bool Exists(const DataManager::Key& key);
+  // See VaultDataBase::SetGroupCommitWindow.
+  void SetGroupCommitWindow(std::chrono::milliseconds max_delay, int max_writes);
+
+  // Looks up the accounts in an index of their holders, so costs O(accounts held by 'pmid_name').
   std::map<DataManager::Key, DataManager::Value> GetRelatedAccounts(const PmidName& pmid_name);
+  // Scans snapshots of the db, so other users can proceed meanwhile, splitting the rows between
+  // Parameters::data_manager_transfer_scan_threads threads.  Then deletes the accounts out of range
+  // in batches of at most Parameters::prune_batch_size.
   DataManager::TransferInfo GetTransferInfo(
       std::shared_ptr<routing::CloseNodesChange> close_nodes_change);
   void HandleTransfer(const std::vector<DataManager::KvPair>& contents);
 
- private:
-  void Put(const DataManager::Key& key, const DataManager::Value& value);
-  void Delete(const DataManager::Key& key);
-
-  DataManager::Value ComposeValue(const std::string& chunk_size, const std::string& pmids) const;
-  DataManager::Key ComposeKey(const std::string& chunk_name) const {
-    return DataManager::Key(DataManager::Key::FixedWidthString(HexDecode(chunk_name)));
-  }
-  std::string EncodeKey(const DataManager::Key& key) const {
-    return HexEncode(key.ToFixedWidthString().string());
-  }
-
-  void CheckPoint();
+  // Counts the account lookups made on the value cache, and the accounts admitted to it, leaving
+  // the byte totals at zero.
+  CacheStatistics GetCacheStatistics() const { return cache_counters_.Get(); }
 
-  std::unique_ptr<sqlite::Database> data_base_;
+ private:
+  typedef std::list<std::pair<DataManager::Key, DataManager::Value>> ValueCacheList;
+  // The accounts to transfer, and the keys of those to prune.
+  typedef std::pair<DataManager::TransferInfo, std::vector<DataManager::Key>> TransferScanResult;
+
+  // Loads the dictionary, first bringing the store up to the current schema version if need be.
+  void Open();
+  void MigrateTextSchema();
+  void MigrateSerialisedRows();
+
+  // These require mutex_ to be held.
+  std::unique_ptr<DataManager::Value> DoCommit(const DataManager::Key& key,
+                                               const CommitFunctor& functor,
+                                               VaultDataBase::Batch& batch);
+  // Reads through 'batch' if one is given.
+  DataManager::Value GetValue(const DataManager::Key& key,
+                              const VaultDataBase::Batch* batch = nullptr);
+  // The row is written in 'batch' along with any new dictionary entries it refers to.
+  void Put(const DataManager::Key& key, const DataManager::Value& value,
+           VaultDataBase::Batch& batch);
+  void Delete(const DataManager::Key& key, VaultDataBase::Batch& batch);
+  // Scans the rows of 'snapshot' with keys in [begin, end).  Doesn't require mutex_.
+  TransferScanResult ScanForTransfer(KeyValueBackend::Snapshot& snapshot, const std::string& begin,
+                                     const std::string& end,
+                                     const detail::PmidDictionary& dictionary,
+                                     const routing::CloseNodesChange& close_nodes_change) const;
+  // Deletes the accounts, as they are now, taking mutex_ for each batch.  Doesn't require mutex_.
+  void Prune(const std::vector<DataManager::Key>& keys);
+  // The index reflects the writes of a batch before it's committed, so is rebuilt from the store
+  // if they aren't made.
+  void BuildHolderIndex();
+  void UpdateHolderIndex(const DataManager::Key& key, const std::vector<PmidName>& old_holders,
+                         const std::vector<PmidName>& new_holders);
+  void CommitBatch(VaultDataBase::Batch& batch);
+  // The filter is only ever added to, so it covers the keys of any batch which isn't committed
+  // too.  It's rebuilt once the keys deleted or added since it was built could have raised its
+  // false positive rate much beyond that intended.  Doesn't require mutex_.
+  static BloomFilter BuildKeyFilter(KeyValueBackend::Snapshot& snapshot);
+  // Requires mutex_ to be held.  Starts RebuildKeyFilter on key_filter_builder_ unless running.
+  void StartKeyFilterRebuild();
+  // Takes mutex_ only to swap the new filter in, along with the keys added since 'snapshot'.
+  void RebuildKeyFilter(std::shared_ptr<KeyValueBackend::Snapshot> snapshot);
+  // Discards the index, dictionary and value cache, to be rebuilt from the store, after writes
+  // which they reflect aren't made.
+  void Invalidate();
+  // The value cache is written through by Put and Delete, so always agrees with the store.
+  bool FindCachedValue(const DataManager::Key& key, DataManager::Value& value);
+  void CacheValue(const DataManager::Key& key, const DataManager::Value& value);
+  void UncacheValue(const DataManager::Key& key);
+  void LoadDictionary();
+  // Requires the dictionary to be loaded.  Writes a dictionary entry for each holder of 'value'
+  // which doesn't yet have one.
+  std::string EncodeValue(const DataManager::Value& value, VaultDataBase::Batch& batch);
+  // 'dictionary' is dictionary_, or a copy taken for decoding rows without mutex_ held.
+  static DataManager::Value DecodeValue(const std::string& row,
+                                        const detail::PmidDictionary& dictionary);
+
+  std::string EncodeKey(const DataManager::Key& key) const;
+  DataManager::Key DecodeKey(const std::string& key_string) const;
+
+  std::mutex mutex_;
+  std::unique_ptr<VaultDataBase> data_base_;
+  detail::PmidDictionary dictionary_;
+  bool dictionary_loaded_;
+  HolderIndex<DataManager::Key> holder_index_;
+  bool holder_index_built_;
+  BloomFilter key_filter_;
+  // Counted since the snapshot the filter is built from.
+  size_t key_filter_deletions_;
+  bool key_filter_rebuilding_;
+  // Added to the filter since the snapshot being rebuilt from, so to be added to the new filter.
+  std::vector<std::string> keys_added_during_rebuild_;
+  std::thread key_filter_builder_;
+  const size_t kValueCacheSize_;
+  // Most recently used first.
+  ValueCacheList value_cache_list_;
+  std::map<DataManager::Key, ValueCacheList::iterator> value_cache_;
+  CacheCounters cache_counters_;
   const boost::filesystem::path kDbPath_;
-  int write_operations_;
 };
 
 }  // namespace vault
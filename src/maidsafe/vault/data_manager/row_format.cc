@@ -0,0 +1,134 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/data_manager/row_format.h"
+
+#include <cassert>
+#include <limits>
+#include <utility>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+namespace {
+
+void AppendVarint(uint64_t value, std::string& output) {
+  while (value >= 0x80) {
+    output.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  output.push_back(static_cast<char>(value));
+}
+
+uint64_t ReadVarint(const std::string& input, size_t& position) {
+  uint64_t value(0);
+  for (int shift(0); shift < 64; shift += 7) {
+    if (position == input.size())
+      break;
+    uint64_t group(static_cast<unsigned char>(input[position++]));
+    value |= (group & 0x7f) << shift;
+    if ((group & 0x80) == 0)
+      return value;
+  }
+  LOG(kError) << "Truncated or overlong varint in data manager row";
+  BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+}
+
+}  // unnamed namespace
+
+bool PmidDictionary::Find(const PmidName& pmid_name, uint32_t& id) const {
+  auto itr(ids_.find(pmid_name));
+  if (itr == ids_.end())
+    return false;
+  id = itr->second;
+  return true;
+}
+
+uint32_t PmidDictionary::Add(const PmidName& pmid_name) {
+  assert(ids_.find(pmid_name) == ids_.end());
+  uint32_t id(static_cast<uint32_t>(names_.size()));
+  names_.push_back(pmid_name);
+  known_.push_back(true);
+  ids_.insert(std::make_pair(pmid_name, id));
+  return id;
+}
+
+void PmidDictionary::Insert(uint32_t id, const PmidName& pmid_name) {
+  if (id < names_.size() && known_[id]) {
+    if (names_[id] == pmid_name)
+      return;
+    LOG(kError) << "Pmid dictionary id " << id << " is already taken";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+  if (id >= names_.size()) {
+    names_.resize(id + 1);
+    known_.resize(id + 1, false);
+  }
+  names_[id] = pmid_name;
+  known_[id] = true;
+  ids_[pmid_name] = id;
+}
+
+const PmidName& PmidDictionary::Name(uint32_t id) const {
+  if (id >= names_.size() || !known_[id]) {
+    LOG(kError) << "Unknown pmid dictionary id " << id;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  return names_[id];
+}
+
+void PmidDictionary::Clear() {
+  names_.clear();
+  known_.clear();
+  ids_.clear();
+}
+
+std::string EncodeRow(uint64_t chunk_size, const std::vector<uint32_t>& pmid_ids) {
+  std::string row;
+  row.reserve(10 + 2 * pmid_ids.size());
+  AppendVarint(chunk_size, row);
+  for (const auto& id : pmid_ids)
+    AppendVarint(id, row);
+  return row;
+}
+
+void DecodeRow(const std::string& row, uint64_t& chunk_size, std::vector<uint32_t>& pmid_ids) {
+  size_t position(0);
+  chunk_size = ReadVarint(row, position);
+  pmid_ids.clear();
+  while (position != row.size()) {
+    uint64_t id(ReadVarint(row, position));
+    if (id > std::numeric_limits<uint32_t>::max()) {
+      LOG(kError) << "Out of range pmid dictionary id in data manager row";
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+    }
+    pmid_ids.push_back(static_cast<uint32_t>(id));
+  }
+}
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
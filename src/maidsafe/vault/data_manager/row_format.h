@@ -0,0 +1,71 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_DATA_MANAGER_ROW_FORMAT_H_
+#define MAIDSAFE_VAULT_DATA_MANAGER_ROW_FORMAT_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "maidsafe/vault/types.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Maps the PmidNames held in DataManagerDataBase to small integer ids, assigned in order from 0.
+// The same few hundred holders recur across every row, so a row stores their ids rather than their
+// names.  Not thread-safe.
+class PmidDictionary {
+ public:
+  PmidDictionary() : names_(), known_(), ids_() {}
+
+  // Returns false if 'pmid_name' hasn't been given an id.
+  bool Find(const PmidName& pmid_name, uint32_t& id) const;
+  // Gives 'pmid_name', which mustn't already have one, the next free id.
+  uint32_t Add(const PmidName& pmid_name);
+  // Restores an entry read back from the store.  Throws if 'id' is already taken by another name.
+  void Insert(uint32_t id, const PmidName& pmid_name);
+  // Throws CommonErrors::parsing_error if 'id' isn't known.
+  const PmidName& Name(uint32_t id) const;
+  void Clear();
+  size_t size() const { return ids_.size(); }
+
+ private:
+  std::vector<PmidName> names_;
+  std::vector<bool> known_;
+  std::map<PmidName, uint32_t> ids_;
+};
+
+// A row is the chunk size followed by the holders' dictionary ids in order, each as a base-128
+// varint, least significant group first.
+std::string EncodeRow(uint64_t chunk_size, const std::vector<uint32_t>& pmid_ids);
+// Throws CommonErrors::parsing_error if 'row' is truncated or malformed.
+void DecodeRow(const std::string& row, uint64_t& chunk_size, std::vector<uint32_t>& pmid_ids);
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_DATA_MANAGER_ROW_FORMAT_H_
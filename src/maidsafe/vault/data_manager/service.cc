@@ -51,7 +51,8 @@ inline bool ForThisPersona(const Message& message) {
 
 DataManagerService::DataManagerService(const passport::Pmid& pmid, routing::Routing& routing,
                                        nfs_client::DataGetter& data_getter,
-                                       const boost::filesystem::path& vault_root_dir)
+                                       const boost::filesystem::path& vault_root_dir,
+                                       AsioService& vault_asio_service)
     : routing_(routing),
       asio_service_(2),
       data_getter_(data_getter),
@@ -63,12 +64,20 @@ DataManagerService::DataManagerService(const passport::Pmid& pmid, routing::Rout
       dispatcher_(routing_, pmid),
       get_timer_(asio_service_),
       db_(UniqueDbPath(vault_root_dir)),
+      resolved_commits_(db_),
       sync_puts_(NodeId(pmid.name()->string())),
       sync_deletes_(NodeId(pmid.name()->string())),
       sync_add_pmids_(NodeId(pmid.name()->string())),
       sync_remove_pmids_(NodeId(pmid.name()->string())),
       account_transfer_(),
-      temp_store_(detail::Parameters::temp_store_size) {}
+      paged_account_transfer_(vault_asio_service.service(), SerialiseAccount,
+                              [this](const NodeId& peer, const std::string& serialised_transfer) {
+                                dispatcher_.SendAccountTransfer(peer, serialised_transfer);
+                              }),
+      temp_store_(detail::Parameters::temp_store_size) {
+  db_.SetGroupCommitWindow(detail::Parameters::data_manager_group_commit_delay,
+                           detail::Parameters::data_manager_group_commit_size);
+}
 
 // ==================== Put implementation =========================================================
 template <>
@@ -285,7 +294,7 @@ uint64_t DataManagerService::Replicate(const DataManager::Key& key, nfs::Message
     return chunk_size;
   }
   try {
-    auto serialises_value(temp_store_.Get(data_name));
+    auto serialises_value(temp_store_.GetBuffer(data_name));
     detail::DataManagerSendPutRequestVisitor<DataManagerService> send_put_request_visitor(
        this, *pmid_name, serialises_value, message_id);
     boost::apply_visitor(send_put_request_visitor, data_name);
@@ -323,7 +332,7 @@ void DataManagerService::HandleMessage(
       if (resolved_action) {
         LOG(kInfo) << "SynchroniseFromDataManagerToDataManager ActionDataManagerPut "
                    << "resolved for chunk " << HexSubstr(resolved_action->key.name.string());
-        db_.Commit(resolved_action->key, resolved_action->action);
+        resolved_commits_.Commit(resolved_action->key, resolved_action->action);
         Replicate(resolved_action->key, resolved_action->action.kMessageId);
       }
       break;
@@ -336,7 +345,7 @@ void DataManagerService::HandleMessage(
       if (resolved_action) {
         LOG(kInfo) << "SynchroniseFromDataManagerToDataManager ActionDataManagerDelete "
                    << "resolved for chunk " << HexSubstr(resolved_action->key.name.string());
-        auto value(db_.Commit(resolved_action->key, resolved_action->action));
+        auto value(resolved_commits_.Commit(resolved_action->key, resolved_action->action));
         LOG(kInfo) << "SynchroniseFromDataManagerToDataManager ActionDataManagerDelete "
                    << "the chunk " << HexSubstr(resolved_action->key.name.string());
         if (value) {
@@ -365,7 +374,7 @@ void DataManagerService::HandleMessage(
                    << " for chunk " << HexSubstr(unresolved_action.key.name.string())
                    << " and pmid_node " << HexSubstr(unresolved_action.action.kPmidName->string());
         try {
-          db_.Commit(resolved_action->key, resolved_action->action);
+          resolved_commits_.Commit(resolved_action->key, resolved_action->action);
         }
         catch (const maidsafe_error& error) {
           if (error.code() != make_error_code(CommonErrors::no_such_element))
@@ -387,7 +396,7 @@ void DataManagerService::HandleMessage(
         // BEFORE_RELEASE double check whether the "mute" solution is enough
         //                as the pmid_node will get added eventually and may cause problem for get
         try {
-          db_.Commit(resolved_action->key, resolved_action->action);
+          resolved_commits_.Commit(resolved_action->key, resolved_action->action);
         } catch(maidsafe_error& error) {
           LOG(kWarning) << "having error when trying to commit remove pmid to db : "
                         << boost::diagnostic_information(error);
@@ -408,13 +417,10 @@ void DataManagerService::HandleMessage(
     const typename AccountTransferFromDataManagerToDataManager::Sender& sender,
     const typename AccountTransferFromDataManagerToDataManager::Receiver& /*receiver*/) {
   LOG(kInfo) << "DataManager received account from " << sender.data;
-  protobuf::AccountTransfer account_transfer_proto;
-  if (!account_transfer_proto.ParseFromString(message.contents->data)) {
-    LOG(kError) << "Failed to parse account transfer ";
-  }
-  for (const auto& serialised_account : account_transfer_proto.serialised_accounts()) {
-    HandleAccountTransferEntry(serialised_account, sender);
-  }
+  paged_account_transfer_.Receive(sender.data, message.contents->data,
+                                  [&](const std::string& serialised_account) {
+                                    HandleAccountTransferEntry(serialised_account, sender);
+                                  });
 }
 
 template <>
@@ -491,20 +497,22 @@ void DataManagerService::TransferAccount(const NodeId& dest,
 //    LOG(kWarning) << "DataManager account just received";
 //    return;
 //  } MAID-357
-  protobuf::AccountTransfer account_transfer_proto;
   for (auto& account : accounts) {
     VLOG(nfs::Persona::kDataManager, VisualiserAction::kAccountTransfer, account.first.name,
          Identity{ dest.string() });
-    protobuf::DataManagerKeyValuePair kv_msg;
-    kv_msg.set_key(account.first.Serialise());
-    kv_msg.set_value(account.second.Serialise());
-    account_transfer_proto.add_serialised_accounts(kv_msg.SerializeAsString());
     LOG(kVerbose) << "DataManager sent account " << DebugId(account.first.name)
                   << " to " << HexSubstr(dest.string())
                   << " with vaule " << account.second.Print();
   }
   LOG(kVerbose) << "DataManagerService::TransferAccount send account_transfer";
-  dispatcher_.SendAccountTransfer(dest, account_transfer_proto.SerializeAsString());
+  paged_account_transfer_.Transfer(dest, accounts);
+}
+
+std::string DataManagerService::SerialiseAccount(const AccountType& account) {
+  protobuf::DataManagerKeyValuePair kv_msg;
+  kv_msg.set_key(account.first.Serialise());
+  kv_msg.set_value(account.second.Serialise());
+  return kv_msg.SerializeAsString();
 }
 
 template <>
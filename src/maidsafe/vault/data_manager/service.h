@@ -44,9 +44,11 @@
 
 #include "maidsafe/vault/account_transfer_handler.h"
 #include "maidsafe/vault/accumulator.h"
-#include "maidsafe/vault/memory_fifo.h"
+#include "maidsafe/vault/commit_queue.h"
+#include "maidsafe/vault/memory_cache.h"
 #include "maidsafe/vault/message_types.h"
 #include "maidsafe/vault/operation_visitors.h"
+#include "maidsafe/vault/paged_account_transfer.h"
 #include "maidsafe/vault/parameters.h"
 #include "maidsafe/vault/sync.h"
 #include "maidsafe/vault/types.h"
@@ -75,9 +77,11 @@ class DataManagerService {
   typedef void HandleMessageReturnType;
   using AccountType = std::pair<Key, DataManagerValue>;
 
+  // 'vault_asio_service' runs the paged account transfers' timer.
   DataManagerService(const passport::Pmid& pmid, routing::Routing& routing,
                      nfs_client::DataGetter& data_getter,
-                     const boost::filesystem::path& vault_root_dir);
+                     const boost::filesystem::path& vault_root_dir,
+                     AsioService& vault_asio_service);
 
   template <typename MessageType>
   void HandleMessage(const MessageType& message, const typename MessageType::Sender& sender,
@@ -211,9 +215,11 @@ class DataManagerService {
   template <typename UnresolvedAction>
   void DoSync(const UnresolvedAction& unresolved_action);
 
+  // Sends the accounts in pages, paced by the receiver's acknowledgements.
   void TransferAccount(const NodeId& dest,
                        const std::vector<Db<DataManager::Key,
                                          DataManager::Value>::KvPair>& accounts);
+  static std::string SerialiseAccount(const AccountType& account);
 
   void HandleAccountTransfer(const AccountType& account);
 
@@ -279,12 +285,15 @@ class DataManagerService {
   DataManagerDispatcher dispatcher_;
   routing::Timer<std::pair<PmidName, GetResponseContents>> get_timer_;
   DataManagerDataBase db_;
+  // Commits the actions resolved by concurrently handled sync messages in shared batches.
+  CommitQueue<DataManagerDataBase> resolved_commits_;
   Sync<DataManager::UnresolvedPut> sync_puts_;
   Sync<DataManager::UnresolvedDelete> sync_deletes_;
   Sync<DataManager::UnresolvedAddPmid> sync_add_pmids_;
   Sync<DataManager::UnresolvedRemovePmid> sync_remove_pmids_;
   AccountTransferHandler<nfs::PersonaTypes<nfs::Persona::kDataManager>> account_transfer_;
-  MemoryFIFO temp_store_;
+  PagedAccountTransfer<AccountType> paged_account_transfer_;
+  MemoryCache temp_store_;
 
  protected:
   std::mutex lock_guard;
@@ -390,11 +399,11 @@ void DataManagerService::HandlePut(const Data& data, const MaidName& maid_name,
     cost *= routing::Parameters::group_size;
     try {
       LOG(kVerbose) << "Store in temp memeory";
-      auto serialised_data(data.Serialise().data);
+      ChunkBuffer serialised_data(data.Serialise().data);
       temp_store_.Store(GetDataNameVariant(Data::Tag::kValue, data.name().value),
                                serialised_data);
       DoSync(DataManager::UnresolvedPut(DataManager::Key(data.name()),
-                                        ActionDataManagerPut(serialised_data.string().size(),
+                                        ActionDataManagerPut(serialised_data.size(),
                                                              message_id),
                                         routing_.kNodeId()));
       dispatcher_.SendPutResponse<Data>(maid_name, data.name(), cost, message_id);
@@ -416,12 +425,12 @@ void DataManagerService::HandleSendPutRequest(
 template <typename Data>
 bool DataManagerService::EntryExist(const typename Data::Name& name) {
   try {
-    db_.Get(DataManager::Key(name.value, Data::Tag::kValue));
-    LOG(kInfo) << "Entry does not exist";
-    return true;
+    bool exists(db_.Exists(DataManager::Key(name.value, Data::Tag::kValue)));
+    LOG(kInfo) << (exists ? "Entry exists" : "Entry does not exist");
+    return exists;
   }
-  catch (const maidsafe_error& /*error*/) {
-    LOG(kInfo) << "Entry does not exist";
+  catch (const maidsafe_error& error) {
+    LOG(kError) << "DataManagerService::EntryExist " << boost::diagnostic_information(error);
     return false;
   }
   catch (...) {
@@ -528,11 +537,9 @@ void DataManagerService::HandleGet(const typename Data::Name& data_name,
   LOG(kVerbose) << "DataManagerService::HandleGet " << HexSubstr(data_name.value)
                 << message_id.data;
   try {
+    auto content(temp_store_.GetBuffer(DataNameVariant(data_name)));
     dispatcher_.SendGetResponseSuccess(
-        requestor,
-        Data(data_name,
-             typename Data::serialised_type(temp_store_.Get(DataNameVariant(data_name)))),
-        message_id);
+        requestor, Data(data_name, typename Data::serialised_type(content.value())), message_id);
     return;
   }
   catch (const maidsafe_error& /*error*/) {
@@ -737,7 +744,7 @@ void DataManagerService::DoGetResponseForReplication(const PmidName& pmid_node,
 
   if (contents.content) {
     temp_store_.Store(GetDataNameVariant(Data::Tag::kValue, data_name.value),
-                      typename Data::serialised_type(*contents.content));
+                      ChunkBuffer(*contents.content));
     Replicate(DataManager::Key(data_name.value, Data::Tag::kValue), nfs::MessageId(RandomInt32()));
   }
 }
@@ -753,7 +760,7 @@ bool DataManagerService::SendGetResponse(
     dispatcher_.SendGetResponseSuccess(get_response_op->requestor_id, data,
                                        get_response_op->message_id);
     temp_store_.Store(GetDataNameVariant(Data::Tag::kValue, data.name().value),
-                      data.Serialise().data);
+                      ChunkBuffer(data.Serialise().data));
     return true;
   } catch(const maidsafe_error& e) {
     error = e;
@@ -16,10 +16,14 @@
     See the Licences for the specific language governing permissions and limitations relating to
     use of the MaidSafe Software.                                                                 */
 
+#include "maidsafe/common/sqlite3_wrapper.h"
 #include "maidsafe/common/test.h"
 #include "maidsafe/passport/passport.h"
 #include "maidsafe/routing/close_nodes_change.h"
 
+#include "maidsafe/vault/database_operations.h"
+#include "maidsafe/vault/key_utils.h"
+#include "maidsafe/vault/parameters.h"
 #include "maidsafe/vault/data_manager/database.h"
 #include "maidsafe/vault/data_manager/data_manager.h"
 #include "maidsafe/vault/tests/tests_utils.h"
@@ -31,23 +35,26 @@ namespace vault {
 
 namespace test {
 
-class DataManagerDatabaseTest : public testing::Test {
+// Runs each test against every backend.
+class DataManagerDatabaseTest : public testing::TestWithParam<KeyValueBackendType> {
  public:
   DataManagerDatabaseTest()
-      : kTestRoot_(maidsafe::test::CreateTestPath("MaidSafe_Test_Vault")) {}
+      : metadata_backend_(GetParam()),
+        kTestRoot_(maidsafe::test::CreateTestPath("MaidSafe_Test_Vault")) {}
 
  protected:
+  const ScopedMetadataBackend metadata_backend_;
   const maidsafe::test::TestPath kTestRoot_;
 };
 
-TEST_F(DataManagerDatabaseTest, BEH_GetFromEmpty) {
+TEST_P(DataManagerDatabaseTest, BEH_GetFromEmpty) {
   DataManagerDataBase db(UniqueDbPath(*kTestRoot_));
   ImmutableData data(NonEmptyString(RandomString(kTestChunkSize)));
   DataManager::Key key(data.name());
   EXPECT_ANY_THROW(db.Get(key));
 }
 
-TEST_F(DataManagerDatabaseTest, BEH_AddPmid) {
+TEST_P(DataManagerDatabaseTest, BEH_AddPmid) {
   DataManagerDataBase db(UniqueDbPath(*kTestRoot_));
   std::vector<PmidName> pmid_nodes;
   for (int i(0); i < 10; ++i)
@@ -68,7 +75,7 @@ TEST_F(DataManagerDatabaseTest, BEH_AddPmid) {
     EXPECT_EQ(pmid_nodes[i], results[i]);
 }
 
-TEST_F(DataManagerDatabaseTest, BEH_AddDuplicatedPmid) {
+TEST_P(DataManagerDatabaseTest, BEH_AddDuplicatedPmid) {
   DataManagerDataBase db(UniqueDbPath(*kTestRoot_));
   PmidName pmid_name(Identity(RandomString(64)));
   ImmutableData data(NonEmptyString(RandomString(kTestChunkSize)));
@@ -84,7 +91,7 @@ TEST_F(DataManagerDatabaseTest, BEH_AddDuplicatedPmid) {
   EXPECT_EQ(results.back(), pmid_name);
 }
 
-TEST_F(DataManagerDatabaseTest, BEH_RemovePmid) {
+TEST_P(DataManagerDatabaseTest, BEH_RemovePmid) {
   DataManagerDataBase db(UniqueDbPath(*kTestRoot_));
   std::vector<PmidName> pmid_nodes;
   for (int i(0); i < 10; ++i)
@@ -112,7 +119,7 @@ TEST_F(DataManagerDatabaseTest, BEH_RemovePmid) {
     EXPECT_EQ(pmid_nodes[i], results[i]);
 }
 
-TEST_F(DataManagerDatabaseTest, BEH_Delete) {
+TEST_P(DataManagerDatabaseTest, BEH_Delete) {
   DataManagerDataBase db(UniqueDbPath(*kTestRoot_));
   ImmutableData data(NonEmptyString(RandomString(kTestChunkSize)));
   DataManager::Key key(data.name());
@@ -144,7 +151,7 @@ TEST_F(DataManagerDatabaseTest, BEH_Delete) {
   EXPECT_ANY_THROW(db.Get(key));
 }
 
-TEST_F(DataManagerDatabaseTest, BEH_GetRelatedAccounts) {
+TEST_P(DataManagerDatabaseTest, BEH_GetRelatedAccounts) {
   DataManagerDataBase db(UniqueDbPath(*kTestRoot_));
   PmidName pmid_name(Identity(RandomString(64)));
   { // from empty
@@ -206,9 +213,18 @@ TEST_F(DataManagerDatabaseTest, BEH_GetRelatedAccounts) {
     auto result(db.GetRelatedAccounts(pmid_name));
     EXPECT_EQ(result.size(), 4);
   }
+  { // target removed from an account, then an account deleted
+    ActionDataManagerRemovePmid action_remove_pmid(pmid_name);
+    db.Commit(key, action_remove_pmid);
+    auto result(db.GetRelatedAccounts(pmid_name));
+    EXPECT_EQ(result.size(), 3);
+    EXPECT_TRUE(result.find(key) == result.end());
+    db.Commit(result.begin()->first, ActionDataManagerDelete(nfs::MessageId(RandomInt32())));
+    EXPECT_EQ(db.GetRelatedAccounts(pmid_name).size(), 2);
+  }
 }
 
-TEST_F(DataManagerDatabaseTest, BEH_GetTransferInfo) {
+TEST_P(DataManagerDatabaseTest, BEH_GetTransferInfo) {
   DataManagerDataBase db(UniqueDbPath(*kTestRoot_));
   std::map<DataManager::Key, DataManager::Value> key_value_map;
   std::vector<NodeId> pmid_nodes;
@@ -304,7 +320,51 @@ TEST_F(DataManagerDatabaseTest, BEH_GetTransferInfo) {
     EXPECT_ANY_THROW(db.Get(key));
 }
 
-TEST_F(DataManagerDatabaseTest, BEH_HandleTransfer) {
+TEST_P(DataManagerDatabaseTest, BEH_ParallelTransferInfo) {
+  const unsigned int kScanThreads(detail::Parameters::data_manager_transfer_scan_threads);
+  DataManagerDataBase serial_db(UniqueDbPath(*kTestRoot_)),
+      parallel_db(UniqueDbPath(*kTestRoot_));
+  std::vector<DataManager::Key> keys;
+  for (int i(0); i < 2000; ++i) {
+    keys.push_back(DataManager::Key(Identity(RandomString(64)), ImmutableData::Tag::kValue));
+    DataManager::Value value(kTestChunkSize);
+    value.AddPmid(PmidName(Identity(RandomString(64))));
+    std::vector<DataManager::KvPair> transferred;
+    transferred.push_back(std::make_pair(keys.back(), value));
+    serial_db.HandleTransfer(transferred);
+    parallel_db.HandleTransfer(transferred);
+  }
+
+  NodeId vault_id(RandomString(64));
+  std::vector<NodeId> old_close_nodes;
+  for (int i(0); i < 16; ++i)
+    old_close_nodes.push_back(NodeId(RandomString(64)));
+  std::vector<NodeId> new_close_nodes(old_close_nodes);
+  new_close_nodes.push_back(NodeId(RandomString(64)));
+  std::shared_ptr<routing::CloseNodesChange> close_nodes_change(
+      new routing::CloseNodesChange(vault_id, old_close_nodes, new_close_nodes));
+
+  detail::Parameters::data_manager_transfer_scan_threads = 1;
+  auto serial_result(serial_db.GetTransferInfo(close_nodes_change));
+  detail::Parameters::data_manager_transfer_scan_threads = 4;
+  auto parallel_result(parallel_db.GetTransferInfo(close_nodes_change));
+  detail::Parameters::data_manager_transfer_scan_threads = kScanThreads;
+
+  // Each destination's accounts are in key order either way.
+  ASSERT_EQ(serial_result.size(), parallel_result.size());
+  for (const auto& transfer : serial_result) {
+    const auto& accounts(parallel_result[transfer.first]);
+    ASSERT_EQ(transfer.second.size(), accounts.size());
+    for (size_t i(0); i != accounts.size(); ++i) {
+      EXPECT_EQ(transfer.second[i].first, accounts[i].first);
+      EXPECT_EQ(transfer.second[i].second, accounts[i].second);
+    }
+  }
+  for (const auto& key : keys)
+    EXPECT_EQ(serial_db.Exists(key), parallel_db.Exists(key));
+}
+
+TEST_P(DataManagerDatabaseTest, BEH_HandleTransfer) {
   DataManagerDataBase db(UniqueDbPath(*kTestRoot_));
   ImmutableData data(NonEmptyString(RandomString(kTestChunkSize)));
   DataManager::Key key(data.name());
@@ -348,6 +408,116 @@ TEST_F(DataManagerDatabaseTest, BEH_HandleTransfer) {
   }
 }
 
+TEST_P(DataManagerDatabaseTest, BEH_Exists) {
+  DataManagerDataBase db(UniqueDbPath(*kTestRoot_));
+  DataManager::Key key(Identity(RandomString(64)), ImmutableData::Tag::kValue);
+  EXPECT_FALSE(db.Exists(key));
+  db.Commit(key, ActionDataManagerPut(kTestChunkSize, nfs::MessageId(RandomUint32())));
+  EXPECT_TRUE(db.Exists(key));
+  db.Commit(key, ActionDataManagerDelete(nfs::MessageId(RandomInt32())));
+  EXPECT_FALSE(db.Exists(key));
+
+  DataManager::Value value(kTestChunkSize);
+  value.AddPmid(PmidName(Identity(RandomString(64))));
+  std::vector<DataManager::KvPair> transferred;
+  transferred.push_back(std::make_pair(key, value));
+  db.HandleTransfer(transferred);
+  EXPECT_TRUE(db.Exists(key));
+  EXPECT_FALSE(db.Exists(DataManager::Key(Identity(RandomString(64)),
+                                          ImmutableData::Tag::kValue)));
+}
+
+TEST_P(DataManagerDatabaseTest, BEH_ValueCache) {
+  DataManagerDataBase db(UniqueDbPath(*kTestRoot_), 2);
+  std::vector<DataManager::Key> keys;
+  for (int i(0); i < 3; ++i) {
+    keys.push_back(DataManager::Key(Identity(RandomString(64)), ImmutableData::Tag::kValue));
+    db.Commit(keys.back(), ActionDataManagerPut(kTestChunkSize, nfs::MessageId(RandomUint32())));
+  }
+  // Each Commit looked its account up before putting it, so missed.
+  auto statistics(db.GetCacheStatistics());
+  EXPECT_EQ(0U, statistics.hits);
+  EXPECT_EQ(3U, statistics.misses);
+  EXPECT_EQ(3U, statistics.admitted);
+
+  // The first account was evicted by the third.
+  db.Get(keys[2]);
+  db.Get(keys[1]);
+  db.Get(keys[0]);
+  statistics = db.GetCacheStatistics();
+  EXPECT_EQ(2U, statistics.hits);
+  EXPECT_EQ(4U, statistics.misses);
+
+  // Writes go through the cache, so the Commits' lookups and the next Get all hit.
+  PmidName pmid_name(Identity(RandomString(64)));
+  db.Commit(keys[0], ActionDataManagerAddPmid(pmid_name));
+  EXPECT_TRUE(db.Get(keys[0]).HasTarget(pmid_name));
+  db.Commit(keys[0], ActionDataManagerDelete(nfs::MessageId(RandomInt32())));
+  EXPECT_ANY_THROW(db.Get(keys[0]));
+  statistics = db.GetCacheStatistics();
+  EXPECT_EQ(5U, statistics.hits);
+  EXPECT_EQ(5U, statistics.misses);
+}
+
+TEST_P(DataManagerDatabaseTest, BEH_MigrateSerialisedRows) {
+  // Nothing written to the in-memory backend survives reopening the db.
+  if (GetParam() == KeyValueBackendType::kMemory)
+    return;
+  auto db_path(UniqueDbPath(*kTestRoot_));
+  std::map<DataManager::Key, DataManager::Value> accounts;
+  PmidName pmid_name(Identity(RandomString(64)));
+  {  // Written as before the dictionary-encoded schema, under the bare fixed-width keys.
+    VaultDataBase legacy(db_path);
+    for (int i(0); i < 10; ++i) {
+      DataManager::Key key(Identity(RandomString(64)), ImmutableData::Tag::kValue);
+      DataManager::Value value(kTestChunkSize + i);
+      value.AddPmid(PmidName(Identity(RandomString(64))));
+      value.AddPmid(pmid_name);
+      accounts[key] = value;
+      legacy.Put(key.name.string() + detail::ToFixedWidthString<detail::PaddedWidth::value>(
+                                         static_cast<uint32_t>(key.type)),
+                 value.Serialise());
+    }
+  }
+  DataManagerDataBase db(db_path);
+  for (const auto& account : accounts)
+    EXPECT_EQ(account.second, db.Get(account.first));
+  EXPECT_EQ(accounts.size(), db.GetRelatedAccounts(pmid_name).size());
+}
+
+TEST_P(DataManagerDatabaseTest, BEH_MigrateTextSchema) {
+  if (GetParam() != KeyValueBackendType::kSqlite)
+    return;
+  auto db_path(UniqueDbPath(*kTestRoot_));
+  DataManager::Key key(Identity(RandomString(64)), ImmutableData::Tag::kValue);
+  DataManager::Value value(kTestChunkSize);
+  std::string storage_nodes;
+  for (int i(0); i < 4; ++i) {
+    value.AddPmid(PmidName(Identity(RandomString(64))));
+    storage_nodes += NodeId(value.AllPmids().back()->string()).ToStringEncoded(
+                         NodeId::EncodingType::kHex) + ";";
+  }
+  {  // Written as by the original text schema.
+    sqlite::Database legacy(db_path, sqlite::Mode::kReadWriteCreate);
+    legacy.Execute("CREATE TABLE DataManagerAccounts (Chunk_Name TEXT  PRIMARY KEY NOT NULL, "
+                   "Chunk_Size TEXT NOT NULL, Storage_Nodes TEXT NOT NULL);");
+    sqlite::Statement statement(legacy, "INSERT INTO DataManagerAccounts (Chunk_Name, Chunk_Size,"
+                                        " Storage_Nodes) VALUES (?, ?, ?)");
+    statement.BindText(1, HexEncode(key.name.string() +
+        detail::ToFixedWidthString<detail::PaddedWidth::value>(static_cast<uint32_t>(key.type))));
+    statement.BindText(2, std::to_string(kTestChunkSize));
+    statement.BindText(3, storage_nodes);
+    statement.Step();
+  }
+  DataManagerDataBase db(db_path);
+  EXPECT_EQ(value, db.Get(key));
+  EXPECT_EQ(1U, db.GetRelatedAccounts(value.AllPmids().front()).size());
+}
+
+INSTANTIATE_TEST_CASE_P(Backends, DataManagerDatabaseTest,
+                        testing::Values(KeyValueBackendType::kSqlite, KeyValueBackendType::kMemory,
+                                        KeyValueBackendType::kLsm));
+
 }  //  namespace test
 
 }  //  namespace vault
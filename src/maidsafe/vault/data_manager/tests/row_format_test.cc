@@ -0,0 +1,89 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <limits>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/vault/data_manager/row_format.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+TEST(PmidDictionaryTest, BEH_AddAndInsert) {
+  detail::PmidDictionary dictionary;
+  PmidName first(Identity(RandomString(64))), second(Identity(RandomString(64)));
+  uint32_t id(0);
+  EXPECT_FALSE(dictionary.Find(first, id));
+  EXPECT_EQ(0U, dictionary.Add(first));
+  EXPECT_EQ(1U, dictionary.Add(second));
+  EXPECT_TRUE(dictionary.Find(second, id));
+  EXPECT_EQ(1U, id);
+  EXPECT_EQ(first, dictionary.Name(0));
+  EXPECT_ANY_THROW(dictionary.Name(2));
+
+  // Entries read back from a store needn't arrive in order, nor be contiguous.
+  detail::PmidDictionary restored;
+  restored.Insert(5, second);
+  restored.Insert(0, first);
+  EXPECT_NO_THROW(restored.Insert(0, first));
+  EXPECT_ANY_THROW(restored.Insert(0, second));
+  EXPECT_EQ(second, restored.Name(5));
+  EXPECT_ANY_THROW(restored.Name(3));
+  EXPECT_EQ(6U, restored.Add(PmidName(Identity(RandomString(64)))));
+  restored.Clear();
+  EXPECT_EQ(0U, restored.size());
+  EXPECT_FALSE(restored.Find(first, id));
+}
+
+TEST(RowFormatTest, BEH_EncodeAndDecode) {
+  std::vector<uint32_t> pmid_ids;
+  pmid_ids.push_back(0);
+  pmid_ids.push_back(127);
+  pmid_ids.push_back(128);
+  pmid_ids.push_back(300);
+  pmid_ids.push_back(std::numeric_limits<uint32_t>::max());
+  uint64_t chunk_size(std::numeric_limits<uint64_t>::max());
+  std::string row(detail::EncodeRow(chunk_size, pmid_ids));
+  // 10 bytes for the size, then 1 + 1 + 2 + 2 + 5 for the ids.
+  EXPECT_EQ(21U, row.size());
+
+  uint64_t decoded_size(0);
+  std::vector<uint32_t> decoded_ids;
+  detail::DecodeRow(row, decoded_size, decoded_ids);
+  EXPECT_EQ(chunk_size, decoded_size);
+  EXPECT_EQ(pmid_ids, decoded_ids);
+
+  detail::DecodeRow(detail::EncodeRow(1024, std::vector<uint32_t>()), decoded_size, decoded_ids);
+  EXPECT_EQ(1024U, decoded_size);
+  EXPECT_TRUE(decoded_ids.empty());
+
+  EXPECT_ANY_THROW(detail::DecodeRow(std::string(), decoded_size, decoded_ids));
+  EXPECT_ANY_THROW(detail::DecodeRow(row.substr(0, row.size() - 1), decoded_size, decoded_ids));
+  EXPECT_ANY_THROW(detail::DecodeRow(std::string(11, '\xff'), decoded_size, decoded_ids));
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
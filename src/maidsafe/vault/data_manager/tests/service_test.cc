@@ -31,16 +31,18 @@ namespace vault {
 
 namespace test {
 
-class DataManagerServiceTest : public testing::Test {
+// Runs each test against every backend.
+class DataManagerServiceTest : public testing::TestWithParam<KeyValueBackendType> {
  public:
   DataManagerServiceTest()
-      : pmid_(passport::CreatePmidAndSigner().first),
+      : metadata_backend_(GetParam()),
+        asio_service_(2),
+        pmid_(passport::CreatePmidAndSigner().first),
         kTestRoot_(maidsafe::test::CreateTestPath("MaidSafe_Test_Vault")),
         vault_root_dir_(*kTestRoot_),
         routing_(pmid_),
         data_getter_(asio_service_, routing_),
-        data_manager_service_(pmid_, routing_, data_getter_, vault_root_dir_),
-        asio_service_(2) {}
+        data_manager_service_(pmid_, routing_, data_getter_, vault_root_dir_, asio_service_) {}
 
   typedef std::function<
       void(const std::pair<PmidName, GetResponseFromPmidNodeToDataManager::Contents>&)> Functor;
@@ -71,13 +73,16 @@ class DataManagerServiceTest : public testing::Test {
     DataManager::Key key(data.name());
     auto group_source(CreateGroupSource(data.name()));
   }
+  // Selects the backend of data_manager_service_'s db, so constructed first.
+  const ScopedMetadataBackend metadata_backend_;
+  // Used by data_getter_ and data_manager_service_, so constructed before them.
+  AsioService asio_service_;
   passport::Pmid pmid_;
   const maidsafe::test::TestPath kTestRoot_;
   boost::filesystem::path vault_root_dir_;
   routing::Routing routing_;
   nfs_client::DataGetter data_getter_;
   DataManagerService data_manager_service_;
-  AsioService asio_service_;
 };
 
 template <typename UnresolvedActionType>
@@ -141,7 +146,7 @@ DataManagerServiceTest::GetUnresolvedActions<DataManager::UnresolvedRemovePmid>(
   return data_manager_service_.sync_remove_pmids_.GetUnresolvedActions();
 }
 
-TEST_F(DataManagerServiceTest, BEH_Various) {
+TEST_P(DataManagerServiceTest, BEH_Various) {
   //  PutRequestFromMaidManagerToDataManager
   {
     NodeId maid_node_id(RandomString(NodeId::kSize)), data_name_id;
@@ -214,7 +219,7 @@ TEST_F(DataManagerServiceTest, BEH_Various) {
   }
 }
 
-TEST_F(DataManagerServiceTest, BEH_DeleteRequestFromMaidManagerToDataManager) {
+TEST_P(DataManagerServiceTest, BEH_DeleteRequestFromMaidManagerToDataManager) {
   NodeId maid_node_id(RandomString(NodeId::kSize));
   auto content(CreateContent<DeleteRequestFromMaidManagerToDataManager::Contents>());
   auto delete_request(CreateMessage<DeleteRequestFromMaidManagerToDataManager>(content));
@@ -224,7 +229,7 @@ TEST_F(DataManagerServiceTest, BEH_DeleteRequestFromMaidManagerToDataManager) {
   EXPECT_TRUE(GetUnresolvedActions<DataManager::UnresolvedDelete>().size() == 0);
 }
 
-TEST_F(DataManagerServiceTest, BEH_FirstPut) {
+TEST_P(DataManagerServiceTest, BEH_FirstPut) {
   auto content(CreateContent<PutRequestFromMaidManagerToDataManager::Contents>());
   NodeId maid_node_id(RandomString(NodeId::kSize)), data_name_id;
   data_name_id = NodeId(content.name.raw_name.string());
@@ -237,7 +242,7 @@ TEST_F(DataManagerServiceTest, BEH_FirstPut) {
   EXPECT_ANY_THROW(Get(key));
 }
 
-TEST_F(DataManagerServiceTest, BEH_Put) {
+TEST_P(DataManagerServiceTest, BEH_Put) {
   auto content(CreateContent<PutRequestFromMaidManagerToDataManager::Contents>());
   PmidName pmid_name(Identity(RandomString(64)));
   DataManager::Key key(content.name.raw_name, content.name.type);
@@ -252,7 +257,7 @@ TEST_F(DataManagerServiceTest, BEH_Put) {
   EXPECT_EQ(Get(key).chunk_size(), kTestChunkSize);
 }
 
-TEST_F(DataManagerServiceTest, BEH_Delete) {
+TEST_P(DataManagerServiceTest, BEH_Delete) {
   PmidName pmid_name(Identity(RandomString(64)));
   ImmutableData data(NonEmptyString(RandomString(kTestChunkSize)));
   DataManager::Key key(data.name());
@@ -269,7 +274,7 @@ TEST_F(DataManagerServiceTest, BEH_Delete) {
   EXPECT_ANY_THROW(Get(key));
 }
 
-TEST_F(DataManagerServiceTest, BEH_AddPmid) {
+TEST_P(DataManagerServiceTest, BEH_AddPmid) {
   ImmutableData data(NonEmptyString(RandomString(kTestChunkSize)));
   DataManager::Key key(data.name());
   auto group_source(CreateGroupSource(data.name()));
@@ -296,7 +301,7 @@ TEST_F(DataManagerServiceTest, BEH_AddPmid) {
   }
 }
 
-TEST_F(DataManagerServiceTest, BEH_RemovePmid) {
+TEST_P(DataManagerServiceTest, BEH_RemovePmid) {
   PmidName pmid_name(Identity(RandomString(64)));
   ImmutableData data(NonEmptyString(RandomString(kTestChunkSize)));
   DataManager::Key key(data.name());
@@ -318,6 +323,10 @@ TEST_F(DataManagerServiceTest, BEH_RemovePmid) {
   EXPECT_TRUE(Get(key).AllPmids().size() == 1);
 }
 
+INSTANTIATE_TEST_CASE_P(Backends, DataManagerServiceTest,
+                        testing::Values(KeyValueBackendType::kSqlite, KeyValueBackendType::kMemory,
+                                        KeyValueBackendType::kLsm));
+
 }  //  namespace test
 
 }  //  namespace vault
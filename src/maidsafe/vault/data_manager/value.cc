@@ -63,6 +63,9 @@ DataManagerValue::DataManagerValue(const DataManagerValue& other) {
 DataManagerValue::DataManagerValue(uint64_t size)
     : size_(size), pmids_() {}
 
+DataManagerValue::DataManagerValue(uint64_t size, std::vector<PmidName> pmids)
+    : size_(size), pmids_(std::move(pmids)) {}
+
 DataManagerValue::DataManagerValue(DataManagerValue&& other) MAIDSAFE_NOEXCEPT
     : size_(std::move(other.size_)), pmids_(std::move(other.pmids_)) {}
 
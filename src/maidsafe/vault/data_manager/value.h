@@ -31,6 +31,7 @@
 #include "maidsafe/routing/routing_api.h"
 
 #include "maidsafe/vault/data_manager/data_manager.pb.h"
+#include "maidsafe/vault/holder_index.h"
 #include "maidsafe/vault/types.h"
 
 namespace maidsafe {
@@ -44,6 +45,8 @@ class DataManagerValue {
   explicit DataManagerValue(const std::string& serialised_value);
   DataManagerValue(DataManagerValue&& other) MAIDSAFE_NOEXCEPT;
   explicit DataManagerValue(uint64_t size);
+  // Takes 'pmids' as they are, without AddPmid's check for duplicates.
+  DataManagerValue(uint64_t size, std::vector<PmidName> pmids);
   std::string Serialise() const;
 
   DataManagerValue& operator=(const DataManagerValue& other);
@@ -75,6 +78,15 @@ class DataManagerValue {
 
 bool operator==(const DataManagerValue& lhs, const DataManagerValue& rhs);
 
+namespace detail {
+
+template <>
+struct HolderTraits<DataManagerValue> {
+  static std::vector<PmidName> Holders(const DataManagerValue& value) { return value.AllPmids(); }
+};
+
+}  // namespace detail
+
 }  // namespace vault
 
 }  // namespace maidsafe
@@ -18,97 +18,116 @@
 
 #include "maidsafe/vault/database_operations.h"
 
-#include <utility>
-#include <cstdint>
 #include <string>
+#include <utility>
 
+#include "maidsafe/common/error.h"
 #include "maidsafe/common/log.h"
-#include "maidsafe/common/utils.h"
+
+#include "maidsafe/vault/parameters.h"
 
 namespace maidsafe {
 
 namespace vault {
 
-VaultDataBase::VaultDataBase(const boost::filesystem::path& db_path)
-  : data_base_(), seeking_statement_(), write_operations_(0) {
-  data_base_.reset(new sqlite::Database(db_path,
-                                        sqlite::Mode::kReadWriteCreate));
-  std::string query(
-      "CREATE TABLE IF NOT EXISTS KeyValuePairs ("
-      "KEY TEXT  PRIMARY KEY NOT NULL, VALUE TEXT NOT NULL);");
-  sqlite::Transaction transaction{*data_base_};
-  sqlite::Statement statement{*data_base_, query};
-  statement.Step();
-  transaction.Commit();
+VaultDataBase::Batch::Batch(VaultDataBase& data_base)
+    : data_base_(data_base), outer_(nullptr), writes_(), open_(true), failed_(false) {}
+
+VaultDataBase::Batch::Batch(Batch& outer)
+    : data_base_(outer.data_base_), outer_(&outer), writes_(), open_(true), failed_(false) {
+  data_base_.CheckBatch(outer);
+}
+
+VaultDataBase::Batch::~Batch() {
+  if (open_ && outer_)
+    outer_->failed_ = true;
 }
 
+void VaultDataBase::Batch::Commit() {
+  data_base_.CheckBatch(*this);
+  open_ = false;
+  if (failed_) {
+    LOG(kError) << "Can't commit a batch with a nested batch which wasn't committed";
+    if (outer_)
+      outer_->failed_ = true;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unable_to_handle_request));
+  }
+  if (outer_) {
+    for (auto& write : writes_)
+      outer_->writes_[write.first] = std::move(write.second);
+  } else if (!writes_.empty()) {
+    data_base_.backend_->Write(writes_);
+  }
+  writes_.clear();
+}
+
+VaultDataBase::VaultDataBase(const boost::filesystem::path& db_path)
+    : backend_(MakeKeyValueBackend(detail::Parameters::metadata_backend, db_path)) {}
+
+VaultDataBase::VaultDataBase(const boost::filesystem::path& db_path,
+                             KeyValueBackendType backend_type)
+    : backend_(MakeKeyValueBackend(backend_type, db_path)) {}
+
 void VaultDataBase::Put(const KEY& key, const VALUE& value) {
-  if (!data_base_)
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_not_presented));
-  CheckPoint();
-
-  sqlite::Transaction transaction{*data_base_};
-  std::string query(
-      "INSERT OR REPLACE INTO KeyValuePairs (KEY, VALUE) VALUES (?, ?)");
-  sqlite::Statement statement{*data_base_, query};
-  statement.BindText(1, key);
-  statement.BindText(2, value);
-  statement.Step();
-  transaction.Commit();
+  backend_->Put(key, value);
 }
 
 void VaultDataBase::Get(const KEY& key, VALUE& value) {
-  if (!data_base_)
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_not_presented));
-
-  std::string query(
-      "SELECT VALUE FROM KeyValuePairs WHERE KEY=?");
-  sqlite::Statement statement{*data_base_, query};
-  statement.BindText(1, key);
-  if (statement.Step() == sqlite::StepResult::kSqliteRow)
-    value = statement.ColumnText(0);
+  backend_->Get(key, value);
 }
 
 void VaultDataBase::Delete(const KEY& key) {
-  if (!data_base_)
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_not_presented));
-  CheckPoint();
-
-  sqlite::Transaction transaction{*data_base_};
-  std::string query(
-      "DELETE FROM KeyValuePairs WHERE KEY=?");
-  sqlite::Statement statement{*data_base_, query};
-  statement.BindText(1, key);
-  statement.Step();
-  transaction.Commit();
+  backend_->Delete(key);
 }
 
-bool VaultDataBase::SeekNext(std::pair<KEY, VALUE>& result) {
-  if (!data_base_)
-    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::db_not_presented));
+void VaultDataBase::Put(const KEY& key, const VALUE& value, Batch& batch) {
+  CheckBatch(batch);
+  batch.writes_[key] = value;
+}
 
-  if (!seeking_statement_) {
-    std::string query("SELECT * from KeyValuePairs");
-    seeking_statement_.reset(new sqlite::Statement(*data_base_, query));
-  }
-  if (seeking_statement_->Step() == sqlite::StepResult::kSqliteRow) {
-    result = std::make_pair(seeking_statement_->ColumnText(0),
-                            seeking_statement_->ColumnText(1));
-    return true;
-  } else {
-    seeking_statement_.reset();
-    return false;
+void VaultDataBase::Get(const KEY& key, VALUE& value, const Batch& batch) {
+  CheckBatch(batch);
+  for (const Batch* itr(&batch); itr; itr = itr->outer_) {
+    auto found(itr->writes_.find(key));
+    if (found != itr->writes_.end()) {
+      if (found->second)
+        value = *found->second;
+      return;
+    }
   }
+  backend_->Get(key, value);
+}
+
+void VaultDataBase::Delete(const KEY& key, Batch& batch) {
+  CheckBatch(batch);
+  batch.writes_[key] = boost::none;
 }
 
-void VaultDataBase::CheckPoint() {
-  if (++write_operations_ > 1000) {
-    data_base_->CheckPoint();
-    write_operations_ = 0;
+void VaultDataBase::Scan(const KEY& begin, const KEY& end, const ScanFunctor& functor) {
+  if (!end.empty() && end <= begin)
+    return;
+  backend_->Scan(begin, end, functor);
+}
+
+void VaultDataBase::ScanPrefix(const KEY& prefix, const ScanFunctor& functor) {
+  Scan(prefix, PrefixEnd(prefix), functor);
+}
+
+std::unique_ptr<KeyValueBackend::Snapshot> VaultDataBase::GetSnapshot() {
+  return backend_->GetSnapshot();
+}
+
+void VaultDataBase::SetGroupCommitWindow(std::chrono::milliseconds max_delay, int max_writes) {
+  backend_->SetGroupCommitWindow(max_delay, max_writes);
+}
+
+void VaultDataBase::CheckBatch(const Batch& batch) const {
+  if (&batch.data_base_ != this || !batch.open_) {
+    LOG(kError) << "The batch is closed, or belongs to another database";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
   }
 }
 
 }  // namespace vault
 
 }  // namespace maidsafe
-
@@ -19,32 +19,72 @@
 #ifndef MAIDSAFE_VAULT_DATABASE_OPERATIONS_H_
 #define MAIDSAFE_VAULT_DATABASE_OPERATIONS_H_
 
+#include <chrono>
+#include <memory>
 #include <string>
-#include <utility>
 
-#include "maidsafe/common/sqlite3_wrapper.h"
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/vault/key_value_backend.h"
 
 namespace maidsafe {
 
 namespace vault {
 
+// The store under a persona database, on the backend chosen by Parameters::metadata_backend unless
+// one is given.  Thread-safe.
 class VaultDataBase {
   typedef std::string VALUE;
  public:
   typedef std::string KEY;
+  typedef KeyValueBackend::ScanFunctor ScanFunctor;
+
+  // Collects the writes passed to it through Put and Delete, written atomically by Commit and
+  // otherwise discarded.  Reads given the batch see its writes.  A batch nested in another adds its
+  // writes to the outer one on Commit; if destroyed without committing, it fails the outer batch,
+  // whose Commit then throws.  A batch is used by one thread at a time, and doesn't affect the
+  // writes made through 'data_base' other than by passing it.
+  class Batch {
+   public:
+    explicit Batch(VaultDataBase& data_base);
+    explicit Batch(Batch& outer);
+    Batch(const Batch&) = delete;
+    Batch& operator=(const Batch&) = delete;
+    ~Batch();
+    void Commit();
+
+   private:
+    friend class VaultDataBase;
+
+    VaultDataBase& data_base_;
+    Batch* const outer_;
+    KeyValueBackend::WriteBatch writes_;
+    bool open_, failed_;
+  };
+
   explicit VaultDataBase(const boost::filesystem::path& db_path);
+  VaultDataBase(const boost::filesystem::path& db_path, KeyValueBackendType backend_type);
 
   void Put(const KEY& key, const VALUE& value);
+  // Leaves 'value' unchanged if 'key' isn't present.
   void Get(const KEY& key, VALUE& value);
   void Delete(const KEY& key);
-  bool SeekNext(std::pair<KEY, VALUE>& result);
+  // These write into, or read through, 'batch', which must be open and made on this database.
+  void Put(const KEY& key, const VALUE& value, Batch& batch);
+  void Get(const KEY& key, VALUE& value, const Batch& batch);
+  void Delete(const KEY& key, Batch& batch);
+  // See KeyValueBackend::Scan.  Doesn't see the writes of an uncommitted batch.
+  void Scan(const KEY& begin, const KEY& end, const ScanFunctor& functor);
+  // Scans the entries whose keys start with 'prefix', seeking straight to them.
+  void ScanPrefix(const KEY& prefix, const ScanFunctor& functor);
+  std::unique_ptr<KeyValueBackend::Snapshot> GetSnapshot();
+  // See KeyValueBackend::SetGroupCommitWindow.  Disabled by default.
+  void SetGroupCommitWindow(std::chrono::milliseconds max_delay, int max_writes);
 
  private:
-  void CheckPoint();
+  void CheckBatch(const Batch& batch) const;
 
-  std::unique_ptr<sqlite::Database> data_base_;
-  std::unique_ptr<sqlite::Statement> seeking_statement_;
-  int write_operations_;
+  std::unique_ptr<KeyValueBackend> backend_;
 };
 
 }  // namespace vault
@@ -52,4 +92,3 @@ class VaultDataBase {
 }  // namespace maidsafe
 
 #endif  // MAIDSAFE_VAULT_DATABASE_OPERATIONS_H_
-
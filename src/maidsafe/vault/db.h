@@ -19,6 +19,10 @@
 #ifndef MAIDSAFE_VAULT_DB_H_
 #define MAIDSAFE_VAULT_DB_H_
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -34,6 +38,8 @@
 #include "maidsafe/vault/config.h"
 #include "maidsafe/vault/types.h"
 #include "maidsafe/vault/database_operations.h"
+#include "maidsafe/vault/holder_index.h"
+#include "maidsafe/vault/parameters.h"
 
 
 namespace maidsafe {
@@ -45,15 +51,26 @@ class Db {
  public:
   typedef std::pair<Key, Value> KvPair;
   typedef std::map<NodeId, std::vector<KvPair>> TransferInfo;
+  typedef std::function<detail::DbAction(std::unique_ptr<Value>& value)> CommitFunctor;
+  typedef std::vector<std::pair<Key, CommitFunctor>> CommitList;
 
   explicit Db(const boost::filesystem::path& db_path);
   ~Db();
 
   Value Get(const Key& key);
   // if functor returns DbAction::kDelete, the value is deleted from db
-  std::unique_ptr<Value> Commit(
-      const Key& key, std::function<detail::DbAction(std::unique_ptr<Value>& value)> functor);
+  std::unique_ptr<Value> Commit(const Key& key, CommitFunctor functor);
+  // Commits each entry in order, as above, making all their writes in a single batch.  An error
+  // from an entry is returned in its future and doesn't affect the others.  If writing the batch
+  // fails, none of the writes are made and the error is thrown.
+  std::vector<std::future<std::unique_ptr<Value>>> Commit(const CommitList& commit_list);
+  // See VaultDataBase::SetGroupCommitWindow.
+  void SetGroupCommitWindow(std::chrono::milliseconds max_delay, int max_writes);
+  // Scans a snapshot of the db, so other users can proceed meanwhile, and then deletes the entries
+  // out of range in batches of at most Parameters::prune_batch_size.
   TransferInfo GetTransferInfo(std::shared_ptr<routing::CloseNodesChange> close_nodes_change);
+  // Returns the keys of the entries held by 'pmid_node' (see detail::HolderTraits), from an index
+  // built by the first call and kept up to date from then on.
   std::vector<Key> GetTargets(const PmidName& pmid_node);
   void HandleTransfer(const std::vector<KvPair>& contents);
 
@@ -62,17 +79,32 @@ class Db {
   Db& operator=(const Db&);
   Db(Db&&);
   Db& operator=(Db&&);
-  void Delete(const Key& key);
-  void Put(const KvPair& key_value_pair);
+  std::unique_ptr<Value> DoCommit(const Key& key, const CommitFunctor& functor,
+                                  VaultDataBase::Batch& batch);
+  Value Get(const Key& key, const VaultDataBase::Batch& batch);
+  static Value ParseValue(const std::string& value_string);
+  void Delete(const Key& key, VaultDataBase::Batch& batch);
+  void Put(const KvPair& key_value_pair, VaultDataBase::Batch& batch);
+  // Deletes the entries with the given keys, as they are now, taking mutex_ for each batch.
+  void Prune(const std::vector<std::string>& key_strings);
+  // Empty if the holder index isn't built, and so needn't be updated.
+  std::vector<PmidName> Holders(const Value* value) const;
+  void UpdateHolderIndex(const Key& key, const std::vector<PmidName>& old_holders,
+                         const std::vector<PmidName>& new_holders);
+  // Commits 'batch', discarding the holder index if the batch's writes, which it already reflects,
+  // fail to be made.
+  void CommitBatch(VaultDataBase::Batch& batch);
 
   const boost::filesystem::path kDbPath_;
   mutable std::mutex mutex_;
   std::unique_ptr<VaultDataBase> sqlitedb_;
+  HolderIndex<Key> holder_index_;
+  bool holder_index_built_;
 };
 
 template <typename Key, typename Value>
 Db<Key, Value>::Db(const boost::filesystem::path& db_path)
-    : kDbPath_(db_path), mutex_(), sqlitedb_() {
+    : kDbPath_(db_path), mutex_(), sqlitedb_(), holder_index_(), holder_index_built_(false) {
   sqlitedb_.reset(new VaultDataBase(kDbPath_));
 #if defined(__GNUC__) && (!defined(MAIDSAFE_APPLE) && !(defined(_MSC_VER) && _MSC_VER == 1700))
   // Remove this assert if value needs to be copy constructible.
@@ -95,13 +127,47 @@ Db<Key, Value>::~Db() {
 }
 
 template <typename Key, typename Value>
-std::unique_ptr<Value> Db<Key, Value>::Commit(
-    const Key& key, std::function<detail::DbAction(std::unique_ptr<Value>& value)> functor) {
-  assert(functor);
+std::unique_ptr<Value> Db<Key, Value>::Commit(const Key& key, CommitFunctor functor) {
   std::lock_guard<std::mutex> lock(mutex_);
+  VaultDataBase::Batch batch(*sqlitedb_);
+  auto value(DoCommit(key, functor, batch));
+  CommitBatch(batch);
+  return value;
+}
+
+template <typename Key, typename Value>
+std::vector<std::future<std::unique_ptr<Value>>> Db<Key, Value>::Commit(
+    const CommitList& commit_list) {
+  std::vector<std::future<std::unique_ptr<Value>>> results;
+  results.reserve(commit_list.size());
+  std::lock_guard<std::mutex> lock(mutex_);
+  VaultDataBase::Batch batch(*sqlitedb_);
+  for (const auto& entry : commit_list) {
+    std::promise<std::unique_ptr<Value>> result;
+    try {
+      result.set_value(DoCommit(entry.first, entry.second, batch));
+    }
+    catch (...) {
+      result.set_exception(std::current_exception());
+    }
+    results.push_back(result.get_future());
+  }
+  CommitBatch(batch);
+  return results;
+}
+
+template <typename Key, typename Value>
+void Db<Key, Value>::SetGroupCommitWindow(std::chrono::milliseconds max_delay, int max_writes) {
+  sqlitedb_->SetGroupCommitWindow(max_delay, max_writes);
+}
+
+template <typename Key, typename Value>
+std::unique_ptr<Value> Db<Key, Value>::DoCommit(const Key& key, const CommitFunctor& functor,
+                                                VaultDataBase::Batch& batch) {
+  assert(functor);
   std::unique_ptr<Value> value;
   try {
-    value.reset(new Value(Get(key)));
+    value.reset(new Value(Get(key, batch)));
   }
   catch (const maidsafe_error& error) {
     if (error.code() != make_error_code(VaultErrors::no_such_account)) {
@@ -110,17 +176,21 @@ std::unique_ptr<Value> Db<Key, Value>::Commit(
       throw;
     }
   }
+  auto old_holders(Holders(value.get()));
   if (detail::DbAction::kPut == functor(value)) {
     assert(value);
     if (!value)
       BOOST_THROW_EXCEPTION(MakeError(CommonErrors::null_pointer));
 
     LOG(kInfo) << "Db<Key, Value>::Commit putting entry";
-    Put(KvPair(key, Value(std::move(*value))));
+    auto new_holders(Holders(value.get()));
+    Put(KvPair(key, Value(std::move(*value))), batch);
+    UpdateHolderIndex(key, old_holders, new_holders);
   } else {
     LOG(kInfo) << "Db<Key, Value>::Commit deleting entry";
     assert(value);
-    Delete(key);
+    Delete(key, batch);
+    UpdateHolderIndex(key, old_holders, std::vector<PmidName>());
     return value;
   }
   return nullptr;
@@ -131,80 +201,136 @@ std::unique_ptr<Value> Db<Key, Value>::Commit(
 template <typename Key, typename Value>
 typename Db<Key, Value>::TransferInfo Db<Key, Value>::GetTransferInfo(
     std::shared_ptr<routing::CloseNodesChange> close_nodes_change) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_ptr<KeyValueBackend::Snapshot> snapshot;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    snapshot = sqlitedb_->GetSnapshot();
+  }
   std::vector<std::string> prune_vector;
   TransferInfo transfer_info;
   LOG(kVerbose) << "Db::GetTransferInfo";
-  std::pair<std::string, std::string> db_iter;
-  while (sqlitedb_->SeekNext(db_iter)) {
-    Key key(typename Key::FixedWidthString(db_iter.first));
+  snapshot->Scan(std::string(), std::string(),
+                 [&](const std::string& key_string, const std::string& value_string) {
+    Key key((typename Key::FixedWidthString(key_string)));
     auto check_holder_result = close_nodes_change->CheckHolders(NodeId(key.name.string()));
     if (check_holder_result.proximity_status == routing::GroupRangeStatus::kInRange) {
       LOG(kVerbose) << "Db::GetTransferInfo in range";
       if (check_holder_result.new_holder == NodeId())
-        continue;
+        return true;
       LOG(kVerbose) << "Db::GetTransferInfo having new holder " << check_holder_result.new_holder;
       auto found_itr = transfer_info.find(check_holder_result.new_holder);
       if (found_itr != transfer_info.end()) {
         LOG(kInfo) << "Db::GetTransferInfo add into transfering account "
                    << HexSubstr(key.name.string()) << " to " << check_holder_result.new_holder;
-        found_itr->second.push_back(std::make_pair(key, Value(db_iter.second)));
+        found_itr->second.push_back(std::make_pair(key, Value(value_string)));
       } else {  // create
         LOG(kInfo) << "Db::GetTransferInfo create transfering account "
                    << HexSubstr(key.name.string()) << " to " << check_holder_result.new_holder;
         std::vector<KvPair> kv_pair;
-        kv_pair.push_back(std::make_pair(key, Value(db_iter.second)));
+        kv_pair.push_back(std::make_pair(key, Value(value_string)));
         transfer_info.insert(std::make_pair(check_holder_result.new_holder, std::move(kv_pair)));
       }
     } else {
       VLOG(VisualiserAction::kRemoveAccount, key.name);
-      prune_vector.push_back(db_iter.first);
+      prune_vector.push_back(key_string);
     }
-  }
-
-  for (const auto& key_string : prune_vector)
-    sqlitedb_->Delete(key_string);  // Ignore Delete failure here ?
+    return true;
+  });
+  snapshot.reset();
+  Prune(prune_vector);
   return transfer_info;
 }
 
+template <typename Key, typename Value>
+void Db<Key, Value>::Prune(const std::vector<std::string>& key_strings) {
+  const size_t kBatchSize(std::max<size_t>(detail::Parameters::prune_batch_size, 1));
+  for (size_t begin(0); begin < key_strings.size(); begin += kBatchSize) {
+    size_t end(std::min(begin + kBatchSize, key_strings.size()));
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The entries' holders are taken from their current values, which may have changed since the
+    // snapshot was scanned.
+    std::vector<std::pair<Key, std::vector<PmidName>>> pruned_holders;
+    VaultDataBase::Batch batch(*sqlitedb_);
+    for (size_t i(begin); i != end; ++i) {
+      if (holder_index_built_) {
+        std::string value_string;
+        sqlitedb_->Get(key_strings[i], value_string, batch);
+        if (!value_string.empty()) {
+          Value value(value_string);
+          pruned_holders.push_back(std::make_pair(
+              Key(typename Key::FixedWidthString(key_strings[i])), Holders(&value)));
+        }
+      }
+      sqlitedb_->Delete(key_strings[i], batch);  // Ignore Delete failure here ?
+    }
+    CommitBatch(batch);
+    for (const auto& pruned : pruned_holders)
+      UpdateHolderIndex(pruned.first, pruned.second, std::vector<PmidName>());
+  }
+}
+
 template <typename Key, typename Value>
 std::vector<Key> Db<Key, Value>::GetTargets(const PmidName& pmid_name) {
   std::lock_guard<std::mutex> lock(mutex_);
-  std::vector<Key> result;
-  std::pair<std::string, std::string> db_iter;
-  while (sqlitedb_->SeekNext(db_iter)) {
-    Value value(db_iter.second);
-    if (value.HasTarget(pmid_name)) {
-      Key key(typename Key::FixedWidthString(db_iter.first));
-      result.push_back(std::move(key));
-    }
+  if (!holder_index_built_) {
+    holder_index_.Clear();
+    sqlitedb_->Scan(std::string(), std::string(),
+                    [&](const std::string& key_string, const std::string& value_string) {
+      Key key((typename Key::FixedWidthString(key_string)));
+      holder_index_.Update(key, std::vector<PmidName>(),
+                           detail::HolderTraits<Value>::Holders(Value(value_string)));
+      return true;
+    });
+    holder_index_built_ = true;
   }
-  return result;
+  return holder_index_.Get(pmid_name);
 }
 
 // Ignores values which are already in db
 template <typename Key, typename Value>
 void Db<Key, Value>::HandleTransfer(const std::vector<std::pair<Key, Value>>& contents) {
   std::lock_guard<std::mutex> lock(mutex_);
-  for (const auto& kv_pair : contents) {
-    try {
-      Get(kv_pair.first);
-    }
-    catch (const maidsafe_error& error) {
-      LOG(kInfo) << error.what();
-      if ((error.code() != make_error_code(CommonErrors::no_such_element)) &&
-          (error.code() != make_error_code(VaultErrors::no_such_account)))
-        throw;
-      else
-        Put(kv_pair);
+  VaultDataBase::Batch batch(*sqlitedb_);
+  try {
+    for (const auto& kv_pair : contents) {
+      try {
+        Get(kv_pair.first, batch);
+      }
+      catch (const maidsafe_error& error) {
+        LOG(kInfo) << error.what();
+        if ((error.code() != make_error_code(CommonErrors::no_such_element)) &&
+            (error.code() != make_error_code(VaultErrors::no_such_account)))
+          throw;
+        Put(kv_pair, batch);
+        UpdateHolderIndex(kv_pair.first, std::vector<PmidName>(), Holders(&kv_pair.second));
+      }
     }
   }
+  catch (...) {
+    // The batch is discarded, along with the writes which the index reflects.
+    holder_index_.Clear();
+    holder_index_built_ = false;
+    throw;
+  }
+  CommitBatch(batch);
 }
 
 template <typename Key, typename Value>
 Value Db<Key, Value>::Get(const Key& key) {
   std::string value_string;
   sqlitedb_->Get(key.ToFixedWidthString().string(), value_string);
+  return ParseValue(value_string);
+}
+
+template <typename Key, typename Value>
+Value Db<Key, Value>::Get(const Key& key, const VaultDataBase::Batch& batch) {
+  std::string value_string;
+  sqlitedb_->Get(key.ToFixedWidthString().string(), value_string, batch);
+  return ParseValue(value_string);
+}
+
+template <typename Key, typename Value>
+Value Db<Key, Value>::ParseValue(const std::string& value_string) {
   if (value_string.empty()) {
     BOOST_THROW_EXCEPTION(MakeError(VaultErrors::no_such_account));
   }
@@ -212,14 +338,40 @@ Value Db<Key, Value>::Get(const Key& key) {
 }
 
 template <typename Key, typename Value>
-void Db<Key, Value>::Put(const KvPair& key_value_pair) {
+void Db<Key, Value>::Put(const KvPair& key_value_pair, VaultDataBase::Batch& batch) {
   sqlitedb_->Put(key_value_pair.first.ToFixedWidthString().string(),
-                 key_value_pair.second.Serialise());
+                 key_value_pair.second.Serialise(), batch);
+}
+
+template <typename Key, typename Value>
+void Db<Key, Value>::Delete(const Key& key, VaultDataBase::Batch& batch) {
+  sqlitedb_->Delete(key.ToFixedWidthString().string(), batch);
+}
+
+template <typename Key, typename Value>
+std::vector<PmidName> Db<Key, Value>::Holders(const Value* value) const {
+  if (!holder_index_built_ || !value)
+    return std::vector<PmidName>();
+  return detail::HolderTraits<Value>::Holders(*value);
 }
 
 template <typename Key, typename Value>
-void Db<Key, Value>::Delete(const Key& key) {
-  sqlitedb_->Delete(key.ToFixedWidthString().string());
+void Db<Key, Value>::UpdateHolderIndex(const Key& key, const std::vector<PmidName>& old_holders,
+                                       const std::vector<PmidName>& new_holders) {
+  if (holder_index_built_)
+    holder_index_.Update(key, old_holders, new_holders);
+}
+
+template <typename Key, typename Value>
+void Db<Key, Value>::CommitBatch(VaultDataBase::Batch& batch) {
+  try {
+    batch.Commit();
+  }
+  catch (...) {
+    holder_index_.Clear();
+    holder_index_built_ = false;
+    throw;
+  }
 }
 
 }  // namespace vault
@@ -0,0 +1,102 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/frequency_sketch.h"
+
+#include <algorithm>
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace {
+
+const uint64_t kSeeds[] = {0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL,
+                           0xcbf29ce484222325ULL};
+
+size_t CounterIndex(size_t hash, unsigned int i, size_t mask) {
+  uint64_t mixed((static_cast<uint64_t>(hash) + kSeeds[i]) * kSeeds[i]);
+  mixed ^= mixed >> 32;
+  return static_cast<size_t>(mixed) & mask;
+}
+
+size_t CounterCount(size_t expected_entries) {
+  // Sixteen counters per expected entry, i.e. four keys' worth, and at least one whole word.
+  size_t count(16);
+  while (count < 16 * expected_entries)
+    count <<= 1;
+  return count;
+}
+
+}  // unnamed namespace
+
+const unsigned int FrequencySketch::kCountersPerKey_;
+const uint64_t FrequencySketch::kMaxCount_;
+
+FrequencySketch::FrequencySketch(size_t expected_entries)
+    : kCounterMask_(CounterCount(expected_entries) - 1),
+      kSampleSize_(10 * static_cast<uint64_t>(std::max<size_t>(expected_entries, 1))),
+      table_(new std::atomic<uint64_t>[CounterCount(expected_entries) / 16]),
+      samples_(0) {
+  for (size_t i(0); i != CounterCount(expected_entries) / 16; ++i)
+    table_[i].store(0, std::memory_order_relaxed);
+}
+
+void FrequencySketch::Increment(size_t hash) {
+  for (unsigned int i(0); i != kCountersPerKey_; ++i) {
+    size_t index(CounterIndex(hash, i, kCounterMask_));
+    std::atomic<uint64_t>& word(table_[index / 16]);
+    const unsigned int kShift(static_cast<unsigned int>(index % 16) * 4);
+    uint64_t value(word.load(std::memory_order_relaxed));
+    while (((value >> kShift) & kMaxCount_) != kMaxCount_ &&
+           !word.compare_exchange_weak(value, value + (uint64_t(1) << kShift),
+                                       std::memory_order_relaxed)) {
+    }
+  }
+  if (samples_.fetch_add(1, std::memory_order_relaxed) + 1 == kSampleSize_) {
+    Halve();
+    samples_.fetch_sub(kSampleSize_ / 2, std::memory_order_relaxed);
+  }
+}
+
+unsigned int FrequencySketch::Frequency(size_t hash) const {
+  uint64_t frequency(kMaxCount_);
+  for (unsigned int i(0); i != kCountersPerKey_; ++i) {
+    size_t index(CounterIndex(hash, i, kCounterMask_));
+    uint64_t value(table_[index / 16].load(std::memory_order_relaxed));
+    frequency = std::min(frequency, (value >> ((index % 16) * 4)) & kMaxCount_);
+  }
+  return static_cast<unsigned int>(frequency);
+}
+
+bool FrequencySketch::Admit(size_t candidate_hash, size_t victim_hash) const {
+  return Frequency(candidate_hash) > Frequency(victim_hash);
+}
+
+void FrequencySketch::Halve() {
+  for (size_t i(0); i <= kCounterMask_ / 16; ++i) {
+    uint64_t value(table_[i].load(std::memory_order_relaxed));
+    while (!table_[i].compare_exchange_weak(value, (value >> 1) & 0x7777777777777777ULL,
+                                            std::memory_order_relaxed)) {
+    }
+  }
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,69 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_FREQUENCY_SKETCH_H_
+#define MAIDSAFE_VAULT_FREQUENCY_SKETCH_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace maidsafe {
+
+namespace vault {
+
+// Approximate count of recent accesses per key, for cache admission (TinyLFU): a new entry only
+// displaces an eviction candidate if it has been accessed more often recently.
+//
+// A count-min sketch of 4-bit counters, four per key, packed sixteen to a word.  The estimate is
+// the smallest of a key's counters, so is never below its true count (up to the maximum of 15).
+// Once the number of recorded accesses reaches ten times the expected number of entries, every
+// counter is halved, so the counts reflect recent popularity rather than all-time.
+//
+// Keys are identified by a hash, e.g. from detail::DataNameVariantHash.  All functions are
+// thread-safe; counters are updated with atomic operations, so an increment racing with halving
+// can be lost, which only makes the estimate slightly less precise.
+class FrequencySketch {
+ public:
+  explicit FrequencySketch(size_t expected_entries);
+  FrequencySketch(const FrequencySketch&) = delete;
+  FrequencySketch& operator=(const FrequencySketch&) = delete;
+
+  void Increment(size_t hash);
+  unsigned int Frequency(size_t hash) const;
+  // True if a candidate with 'candidate_hash' should replace the eviction candidate with
+  // 'victim_hash'.
+  bool Admit(size_t candidate_hash, size_t victim_hash) const;
+
+ private:
+  void Halve();
+
+  static const unsigned int kCountersPerKey_ = 4;
+  static const uint64_t kMaxCount_ = 15;
+
+  const size_t kCounterMask_;
+  const uint64_t kSampleSize_;
+  std::unique_ptr<std::atomic<uint64_t>[]> table_;
+  std::atomic<uint64_t> samples_;
+};
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_FREQUENCY_SKETCH_H_
@@ -20,8 +20,10 @@
 #define MAIDSAFE_VAULT_GROUP_DB_H_
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <functional>
+#include <future>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -42,6 +44,7 @@
 #include "maidsafe/vault/config.h"
 #include "maidsafe/vault/pmid_manager/pmid_manager.h"
 #include "maidsafe/vault/database_operations.h"
+#include "maidsafe/vault/parameters.h"
 
 namespace maidsafe {
 
@@ -58,6 +61,9 @@ class GroupDb {
   typedef std::pair<Key, Value> KvPair;
   struct Contents;
   typedef std::map<NodeId, std::vector<Contents>> TransferInfo;
+  typedef std::function<detail::DbAction(Metadata& metadata, std::unique_ptr<Value>& value)>
+      CommitFunctor;
+  typedef std::vector<std::pair<Key, CommitFunctor>> CommitList;
 
   struct Contents {
     Contents() : group_name(), metadata(), kv_pairs() {}
@@ -86,9 +92,15 @@ class GroupDb {
   // For atomically updating metadata only
   void Commit(const GroupName& group_name, std::function<void(Metadata& metadata)> functor);
   // For atomically updating metadata and value
-  std::unique_ptr<Value> Commit(
-      const Key& key,
-      std::function<detail::DbAction(Metadata& metadata, std::unique_ptr<Value>& value)> functor);
+  std::unique_ptr<Value> Commit(const Key& key, CommitFunctor functor);
+  // Commits each entry in order, as above, making all their writes in a single batch.  An error
+  // from an entry is returned in its future and doesn't affect the others.  If writing the batch
+  // fails, none of the writes are made and the error is thrown.
+  std::vector<std::future<std::unique_ptr<Value>>> Commit(const CommitList& commit_list);
+  // See VaultDataBase::SetGroupCommitWindow.
+  void SetGroupCommitWindow(std::chrono::milliseconds max_delay, int max_writes);
+  // Scans a snapshot of the db, so other users can proceed meanwhile, and then deletes the groups
+  // out of range, each in batches of at most Parameters::prune_batch_size entries.
   TransferInfo GetTransferInfo(std::shared_ptr<routing::CloseNodesChange> close_nodes_change);
   void HandleTransfer(const Contents& content);
 
@@ -109,17 +121,25 @@ class GroupDb {
 
   typename GroupMap::iterator AddGroupToMap(const GroupName& group_name, const Metadata& metadata);
   void UpdateGroup(typename GroupMap::iterator itr);
+  std::unique_ptr<Value> DoCommit(const Key& key, const CommitFunctor& functor,
+                                  VaultDataBase::Batch& batch);
 
   void DeleteGroupEntries(const GroupName& group_name);
   void DeleteGroupEntries(typename GroupMap::iterator itr);
   Contents GetContents(typename GroupMap::iterator it);
+  Contents GetContents(const GroupName& group_name, GroupId group_id, const Metadata& metadata,
+                       KeyValueBackend::Snapshot& snapshot);
+  // Removes the group from the map at once, and then deletes its entries taking mutex_ for each
+  // batch.  Its id isn't reused until they're all deleted.
+  void PruneGroup(const GroupName& group_name);
   void ApplyTransfer(const Contents& /*contents*/);
   Value Get(const Key& key, const GroupId& group_id);
-  void Put(const KvPair& key_value_pair, const GroupId& group_id);
-  void Delete(const Key& key, const GroupId& group_id);
+  Value Get(const Key& key, const GroupId& group_id, const VaultDataBase::Batch& batch);
+  Value ParseValue(const Key& key, const GroupId& group_id, const std::string& value_string);
+  void Put(const KvPair& key_value_pair, const GroupId& group_id, VaultDataBase::Batch& batch);
+  void Delete(const Key& key, const GroupId& group_id, VaultDataBase::Batch& batch);
   std::string MakeSqliteDbKey(const GroupId& group_id, const Key& key);
   Key MakeKey(const GroupName group_name, const VaultDataBase::KEY& sqlite_db_key);
-  uint32_t GetGroupId(const VaultDataBase::KEY& sqlite_db_key) const;
   typename GroupMap::iterator FindGroup(const GroupName& group_name);
   typename GroupMap::iterator FindOrCreateGroup(const GroupName& group_name);
 
@@ -128,6 +148,7 @@ class GroupDb {
   std::mutex mutex_;
   std::unique_ptr<VaultDataBase> sqlitedb_;
   GroupMap group_map_;
+  std::set<GroupId> pruning_group_ids_;
 };
 
 template <typename Persona>
@@ -163,7 +184,7 @@ std::string GroupDb<Persona>::Print() const {
 
 template <typename Persona>
 GroupDb<Persona>::GroupDb(const boost::filesystem::path& db_path)
-    : kDbPath_(db_path), mutex_(), sqlitedb_(), group_map_() {
+    : kDbPath_(db_path), mutex_(), sqlitedb_(), group_map_(), pruning_group_ids_() {
   sqlitedb_.reset(new VaultDataBase(kDbPath_));
 #if defined(__GNUC__) && (!defined(MAIDSAFE_APPLE) && !(defined(_MSC_VER) && _MSC_VER == 1700))
   // Remove this assert if value needs to be copy constructible.
@@ -199,14 +220,14 @@ template <typename Persona>
 typename GroupDb<Persona>::GroupMap::iterator GroupDb<Persona>::AddGroupToMap(
     const GroupName& group_name, const Metadata& metadata) {
   static const uint64_t kGroupsLimit(static_cast<GroupId>(std::pow(256, kPrefixWidth_)));
-  if (group_map_.size() == kGroupsLimit - 1)
+  if (group_map_.size() + pruning_group_ids_.size() == kGroupsLimit - 1)
     BOOST_THROW_EXCEPTION(MakeError(VaultErrors::failed_to_handle_request));
   GroupId group_id(RandomInt32() % kGroupsLimit);
   while (
       std::any_of(std::begin(group_map_), std::end(group_map_),
                   [&group_id](const std::pair<GroupName, std::pair<GroupId, Metadata>>& element) {
         return group_id == element.second.first;
-      })) {
+      }) || pruning_group_ids_.count(group_id) != 0) {
     group_id = RandomInt32() % kGroupsLimit;
   }
   LOG(kVerbose) << "GroupDb<Persona>::AddGroupToMap size of group_map_ " << group_map_.size()
@@ -239,18 +260,54 @@ void GroupDb<Persona>::Commit(const GroupName& group_name,
 }
 
 template <typename Persona>
-std::unique_ptr<typename Persona::Value> GroupDb<Persona>::Commit(
-    const Key& key,
-    std::function<detail::DbAction(Metadata& metadata, std::unique_ptr<Value>& value)> functor) {
+std::unique_ptr<typename Persona::Value> GroupDb<Persona>::Commit(const Key& key,
+                                                                  CommitFunctor functor) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  VaultDataBase::Batch batch(*sqlitedb_);
+  auto value(DoCommit(key, functor, batch));
+  batch.Commit();
+  return value;
+}
+
+template <typename Persona>
+std::vector<std::future<std::unique_ptr<typename Persona::Value>>> GroupDb<Persona>::Commit(
+    const CommitList& commit_list) {
+  std::vector<std::future<std::unique_ptr<Value>>> results;
+  results.reserve(commit_list.size());
+  std::lock_guard<std::mutex> lock(mutex_);
+  VaultDataBase::Batch batch(*sqlitedb_);
+  for (const auto& entry : commit_list) {
+    std::promise<std::unique_ptr<Value>> result;
+    try {
+      result.set_value(DoCommit(entry.first, entry.second, batch));
+    }
+    catch (...) {
+      result.set_exception(std::current_exception());
+    }
+    results.push_back(result.get_future());
+  }
+  batch.Commit();
+  return results;
+}
+
+template <typename Persona>
+void GroupDb<Persona>::SetGroupCommitWindow(std::chrono::milliseconds max_delay,
+                                            int max_writes) {
+  sqlitedb_->SetGroupCommitWindow(max_delay, max_writes);
+}
+
+template <typename Persona>
+std::unique_ptr<typename Persona::Value> GroupDb<Persona>::DoCommit(const Key& key,
+                                                                    const CommitFunctor& functor,
+                                                                    VaultDataBase::Batch& batch) {
   LOG(kVerbose) << "GroupDb<Persona>::Commit update metadata and value for account "
                 << HexSubstr(key.group_name()->string());
   assert(functor);
-  std::lock_guard<std::mutex> lock(mutex_);
   const auto it(FindOrCreateGroup(key.group_name()));
   on_scope_exit update_group([it, this]() { UpdateGroup(it); });
   std::unique_ptr<Value> value;
   try {
-    value.reset(new Value(Get(key, it->second.first)));
+    value.reset(new Value(Get(key, it->second.first, batch)));
   }
   catch (const maidsafe_error& error) {
     if (error.code() != make_error_code(CommonErrors::no_such_element)) {
@@ -266,11 +323,11 @@ std::unique_ptr<typename Persona::Value> GroupDb<Persona>::Commit(
       assert(value);
       if (!value)
         BOOST_THROW_EXCEPTION(MakeError(CommonErrors::null_pointer));
-      Put(std::make_pair(key, std::move(*value)), it->second.first);
+      Put(std::make_pair(key, std::move(*value)), it->second.first, batch);
     } else {
       LOG(kInfo) << "detail::DbAction::kDelete";
       if (value) {
-        Delete(key, it->second.first);
+        Delete(key, it->second.first, batch);
         return value;
       } else {
         LOG(kError) << "value is not initialised";
@@ -301,28 +358,33 @@ typename GroupDb<Persona>::Contents GroupDb<Persona>::GetContents(typename Group
   contents.group_name = it->first;
   contents.metadata = it->second.second;
   // get db entry
-  std::pair<std::string, std::string> db_iter;
-  const auto group_id = it->second.first;
-  while (sqlitedb_->SeekNext(db_iter)) {
-    if (GetGroupId(db_iter.first) == group_id)
-      contents.kv_pairs.push_back(
-          std::make_pair(MakeKey(contents.group_name, db_iter.first), Value(db_iter.second)));
-  }
+  sqlitedb_->ScanPrefix(detail::ToFixedWidthString<kPrefixWidth_>(it->second.first),
+                        [&](const std::string& key_string, const std::string& value_string) {
+    contents.kv_pairs.push_back(
+        std::make_pair(MakeKey(contents.group_name, key_string), Value(value_string)));
+    return true;
+  });
   return contents;
 }
 
 template <typename Persona>
 typename GroupDb<Persona>::TransferInfo GroupDb<Persona>::GetTransferInfo(
     std::shared_ptr<routing::CloseNodesChange> close_nodes_change) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  std::vector<GroupName> prune_vector;
-  TransferInfo transfer_info;
+  std::vector<std::pair<GroupName, std::pair<GroupId, Metadata>>> groups;
+  std::unique_ptr<KeyValueBackend::Snapshot> snapshot;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
 #ifdef TESTING
-  LOG(kVerbose) << "GroupDb<Persona>::GetTransferInfo group_map_.size() " << group_map_.size()
-                << " containing following entries : " << Print();
+    LOG(kVerbose) << "GroupDb<Persona>::GetTransferInfo group_map_.size() " << group_map_.size()
+                  << " containing following entries : " << Print();
 #endif
-  for (auto group_itr(group_map_.begin()); group_itr != group_map_.end(); ++group_itr) {
-    auto check_holder_result = close_nodes_change->CheckHolders(NodeId(group_itr->first->string()));
+    groups.assign(group_map_.begin(), group_map_.end());
+    snapshot = sqlitedb_->GetSnapshot();
+  }
+  std::vector<GroupName> prune_vector;
+  TransferInfo transfer_info;
+  for (const auto& group : groups) {
+    auto check_holder_result = close_nodes_change->CheckHolders(NodeId(group.first->string()));
     if (check_holder_result.proximity_status == routing::GroupRangeStatus::kInRange) {
       LOG(kVerbose) << "GroupDb<Persona>::GetTransferInfo in range ";
       if (check_holder_result.new_holder != NodeId()) {
@@ -331,29 +393,80 @@ typename GroupDb<Persona>::TransferInfo GroupDb<Persona>::GetTransferInfo(
         auto found_itr = transfer_info.find(check_holder_result.new_holder);
         if (found_itr != transfer_info.end()) {  // Add to map
           LOG(kVerbose) << "GroupDb<Persona>::GetTransferInfo add into transfering account "
-                        << HexSubstr(group_itr->first->string()) << " to "
+                        << HexSubstr(group.first->string()) << " to "
                         << DebugId(check_holder_result.new_holder);
-          found_itr->second.push_back(GetContents(group_itr));
+          found_itr->second.push_back(
+              GetContents(group.first, group.second.first, group.second.second, *snapshot));
         } else {  // create contents add to map
           LOG(kVerbose) << "GroupDb<Persona>::GetTransferInfo create transfering account "
-                        << HexSubstr(group_itr->first->string()) << " to "
+                        << HexSubstr(group.first->string()) << " to "
                         << DebugId(check_holder_result.new_holder);
           std::vector<Contents> contents_vector;
-          contents_vector.push_back(std::move(GetContents(group_itr)));
+          contents_vector.push_back(
+              GetContents(group.first, group.second.first, group.second.second, *snapshot));
           transfer_info[check_holder_result.new_holder] = std::move(contents_vector);
         }
       }
     } else {  // Prune group
-      VLOG(VisualiserAction::kRemoveAccount, Identity{group_itr->first->string()});
-      prune_vector.push_back(group_itr->first);
+      VLOG(VisualiserAction::kRemoveAccount, Identity{group.first->string()});
+      prune_vector.push_back(group.first);
     }
   }
+  snapshot.reset();
   LOG(kVerbose) << "GroupDb<Persona>::GetTransferInfo prune_vector.size() " << prune_vector.size();
-  for (const auto& i : prune_vector)
-    DeleteGroupEntries(i);
+  for (const auto& group_name : prune_vector)
+    PruneGroup(group_name);
   return transfer_info;
 }
 
+template <typename Persona>
+typename GroupDb<Persona>::Contents GroupDb<Persona>::GetContents(
+    const GroupName& group_name, GroupId group_id, const Metadata& metadata,
+    KeyValueBackend::Snapshot& snapshot) {
+  Contents contents;
+  contents.group_name = group_name;
+  contents.metadata = metadata;
+  snapshot.ScanPrefix(detail::ToFixedWidthString<kPrefixWidth_>(group_id),
+                      [&](const std::string& key_string, const std::string& value_string) {
+    contents.kv_pairs.push_back(
+        std::make_pair(MakeKey(contents.group_name, key_string), Value(value_string)));
+    return true;
+  });
+  return contents;
+}
+
+template <typename Persona>
+void GroupDb<Persona>::PruneGroup(const GroupName& group_name) {
+  GroupId group_id(0);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr(group_map_.find(group_name));
+    if (itr == group_map_.end())
+      return;
+    group_id = itr->second.first;
+    group_map_.erase(itr);
+    pruning_group_ids_.insert(group_id);
+  }
+  const size_t kBatchSize(std::max<size_t>(detail::Parameters::prune_batch_size, 1));
+  for (;;) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> group_db_keys;
+    sqlitedb_->ScanPrefix(detail::ToFixedWidthString<kPrefixWidth_>(group_id),
+                          [&](const std::string& key_string, const std::string& /*value_string*/) {
+      group_db_keys.push_back(key_string);
+      return group_db_keys.size() < kBatchSize;
+    });
+    if (group_db_keys.empty()) {
+      pruning_group_ids_.erase(group_id);
+      return;
+    }
+    VaultDataBase::Batch batch(*sqlitedb_);
+    for (const auto& key : group_db_keys)
+      sqlitedb_->Delete(key, batch);
+    batch.Commit();
+  }
+}
+
 // FIXME (Prakash)
 template <typename Persona>
 void GroupDb<Persona>::HandleTransfer(const Contents& content) {
@@ -379,14 +492,16 @@ void GroupDb<Persona>::ApplyTransfer(const Contents& contents) {
     LOG(kInfo) << "Creating a new account";
     itr = AddGroupToMap(contents.group_name, contents.metadata);
   }
+  VaultDataBase::Batch batch(*sqlitedb_);
   for (const auto& kv_pair : contents.kv_pairs) {
     try {
-      Put(kv_pair, itr->second.first);
+      Put(kv_pair, itr->second.first, batch);
     }
     catch (...) {
       LOG(kError) << "trying to re-insert an existing entry";
     }
   }
+  batch.Commit();
 }
 
 template <typename Persona>
@@ -419,15 +534,16 @@ template <typename Persona>
 void GroupDb<Persona>::DeleteGroupEntries(typename GroupMap::iterator it) {
   assert(it != group_map_.end());
   std::vector<std::string> group_db_keys;
-  std::pair<std::string, std::string> db_iter;
-  const auto group_id = it->second.first;
-  while (sqlitedb_->SeekNext(db_iter)) {
-    if (GetGroupId(db_iter.first) == group_id)
-      group_db_keys.push_back(db_iter.first);
-  }
+  sqlitedb_->ScanPrefix(detail::ToFixedWidthString<kPrefixWidth_>(it->second.first),
+                        [&](const std::string& key_string, const std::string& /*value_string*/) {
+    group_db_keys.push_back(key_string);
+    return true;
+  });
 
+  VaultDataBase::Batch batch(*sqlitedb_);
   for (const auto& key : group_db_keys)
-    sqlitedb_->Delete(key);
+    sqlitedb_->Delete(key, batch);
+  batch.Commit();
 
   group_map_.erase(it);
 }
@@ -440,6 +556,21 @@ typename GroupDb<Persona>::Value GroupDb<Persona>::Get(const Key& key, const Gro
                 << " name : " << DebugId(key.name);
   std::string value_string;
   sqlitedb_->Get(MakeSqliteDbKey(group_id, key), value_string);
+  return ParseValue(key, group_id, value_string);
+}
+
+template <typename Persona>
+typename GroupDb<Persona>::Value GroupDb<Persona>::Get(const Key& key, const GroupId& group_id,
+                                                       const VaultDataBase::Batch& batch) {
+  std::string value_string;
+  sqlitedb_->Get(MakeSqliteDbKey(group_id, key), value_string, batch);
+  return ParseValue(key, group_id, value_string);
+}
+
+template <typename Persona>
+typename GroupDb<Persona>::Value GroupDb<Persona>::ParseValue(const Key& key,
+                                                              const GroupId& group_id,
+                                                              const std::string& value_string) {
   if (value_string.empty()) {
     LOG(kError) << "cann't find such element for get, group_id : " << group_id
                 << " group_name : " << HexSubstr(key.group_name()->string())
@@ -450,17 +581,19 @@ typename GroupDb<Persona>::Value GroupDb<Persona>::Get(const Key& key, const Gro
 }
 
 template <typename Persona>
-void GroupDb<Persona>::Put(const KvPair& key_value_pair, const GroupId& group_id) {
+void GroupDb<Persona>::Put(const KvPair& key_value_pair, const GroupId& group_id,
+                           VaultDataBase::Batch& batch) {
   LOG(kVerbose) << "GroupDb<Persona>::Put group_id : " << group_id
                 << " group_name : " << HexSubstr(key_value_pair.first.group_name()->string())
                 << " name : " << DebugId(key_value_pair.first.name);
   sqlitedb_->Put(MakeSqliteDbKey(group_id, key_value_pair.first),
-                 key_value_pair.second.Serialise());
+                 key_value_pair.second.Serialise(), batch);
 }
 
 template <typename Persona>
-void GroupDb<Persona>::Delete(const Key& key, const GroupId& group_id) {
-  sqlitedb_->Delete(MakeSqliteDbKey(group_id, key));
+void GroupDb<Persona>::Delete(const Key& key, const GroupId& group_id,
+                              VaultDataBase::Batch& batch) {
+  sqlitedb_->Delete(MakeSqliteDbKey(group_id, key), batch);
 }
 
 template <typename Persona>
@@ -475,11 +608,6 @@ typename Persona::Key GroupDb<Persona>::MakeKey(const GroupName group_name,
              typename Persona::Key::FixedWidthString(sqlite_db_key.substr(kPrefixWidth_)));
 }
 
-template <typename Persona>
-uint32_t GroupDb<Persona>::GetGroupId(const VaultDataBase::KEY& sqlite_db_key) const {
-  return detail::FromFixedWidthString<kPrefixWidth_>(sqlite_db_key.substr(0, kPrefixWidth_));
-}
-
 // throws
 template <typename Persona>
 typename GroupDb<Persona>::GroupMap::iterator GroupDb<Persona>::FindGroup(
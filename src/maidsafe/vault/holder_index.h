@@ -0,0 +1,101 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_HOLDER_INDEX_H_
+#define MAIDSAFE_VAULT_HOLDER_INDEX_H_
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "maidsafe/vault/types.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Gives the PmidNodes holding the chunk described by a database value.  Specialised for the values
+// which record their holders; the entries of other values are held by none.
+template <typename Value>
+struct HolderTraits {
+  static std::vector<PmidName> Holders(const Value& /*value*/) { return std::vector<PmidName>(); }
+};
+
+}  // namespace detail
+
+// An in-memory inverted index from each PmidNode to the keys of the entries it holds, so that the
+// chunks held by a departed node can be found without deserialising every value in the database.
+// Kept in step with the database by its owner, under the owner's lock.  Not thread-safe.
+template <typename Key>
+class HolderIndex {
+ public:
+  HolderIndex() : keys_() {}
+
+  // Records that the entry for 'key', previously held by 'old_holders' (empty if it didn't exist),
+  // is now held by 'new_holders' (empty if it has been deleted).
+  void Update(const Key& key, std::vector<PmidName> old_holders,
+              std::vector<PmidName> new_holders);
+  std::vector<Key> Get(const PmidName& holder) const;
+  void Clear() { keys_.clear(); }
+
+ private:
+  HolderIndex(const HolderIndex&);
+  HolderIndex& operator=(const HolderIndex&);
+
+  std::map<PmidName, std::set<Key>> keys_;
+};
+
+template <typename Key>
+void HolderIndex<Key>::Update(const Key& key, std::vector<PmidName> old_holders,
+                              std::vector<PmidName> new_holders) {
+  std::sort(old_holders.begin(), old_holders.end());
+  std::sort(new_holders.begin(), new_holders.end());
+  std::vector<PmidName> removed, added;
+  std::set_difference(old_holders.begin(), old_holders.end(), new_holders.begin(),
+                      new_holders.end(), std::back_inserter(removed));
+  std::set_difference(new_holders.begin(), new_holders.end(), old_holders.begin(),
+                      old_holders.end(), std::back_inserter(added));
+  for (const auto& holder : removed) {
+    auto itr(keys_.find(holder));
+    if (itr == keys_.end())
+      continue;
+    itr->second.erase(key);
+    if (itr->second.empty())
+      keys_.erase(itr);
+  }
+  for (const auto& holder : added)
+    keys_[holder].insert(key);
+}
+
+template <typename Key>
+std::vector<Key> HolderIndex<Key>::Get(const PmidName& holder) const {
+  auto itr(keys_.find(holder));
+  if (itr == keys_.end())
+    return std::vector<Key>();
+  return std::vector<Key>(itr->second.begin(), itr->second.end());
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_HOLDER_INDEX_H_
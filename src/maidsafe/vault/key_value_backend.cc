@@ -0,0 +1,62 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/key_value_backend.h"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/vault/lsm_backend.h"
+#include "maidsafe/vault/memory_backend.h"
+#include "maidsafe/vault/sqlite_backend.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+void KeyValueBackend::Snapshot::ScanPrefix(const std::string& prefix, const ScanFunctor& functor) {
+  Scan(prefix, PrefixEnd(prefix), functor);
+}
+
+std::string PrefixEnd(const std::string& prefix) {
+  std::string end(prefix);
+  while (!end.empty() && static_cast<unsigned char>(end.back()) == 0xff)
+    end.pop_back();
+  if (!end.empty())
+    end.back() = static_cast<char>(static_cast<unsigned char>(end.back()) + 1);
+  return end;
+}
+
+std::unique_ptr<KeyValueBackend> MakeKeyValueBackend(KeyValueBackendType type,
+                                                     const boost::filesystem::path& path) {
+  switch (type) {
+    case KeyValueBackendType::kSqlite:
+      return std::unique_ptr<KeyValueBackend>(new SqliteBackend(path));
+    case KeyValueBackendType::kMemory:
+      return std::unique_ptr<KeyValueBackend>(new MemoryBackend);
+    case KeyValueBackendType::kLsm:
+      return std::unique_ptr<KeyValueBackend>(new LsmBackend(path));
+    default:
+      LOG(kError) << "Unknown backend type " << static_cast<int>(type);
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
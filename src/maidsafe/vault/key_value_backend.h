@@ -0,0 +1,89 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_KEY_VALUE_BACKEND_H_
+#define MAIDSAFE_VAULT_KEY_VALUE_BACKEND_H_
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "boost/filesystem/path.hpp"
+#include "boost/optional.hpp"
+
+#include "maidsafe/vault/store_types.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+// An ordered store of binary keys and values, on which the persona databases are built.  Keys are
+// compared bytewise.  All members are thread-safe.
+class KeyValueBackend {
+ public:
+  // Writes to be applied atomically, in which a key mapped to none is deleted.
+  typedef std::map<std::string, boost::optional<std::string>> WriteBatch;
+  // Called for each entry of a scan, in key order, until it returns false.  It mustn't call back
+  // into the backend being scanned.
+  typedef std::function<bool(const std::string& key, const std::string& value)> ScanFunctor;
+
+  // A consistent read-only view of the store as it was when taken, unaffected by later writes.
+  class Snapshot {
+   public:
+    virtual ~Snapshot() {}
+    virtual bool Get(const std::string& key, std::string& value) = 0;
+    virtual void Scan(const std::string& begin, const std::string& end,
+                      const ScanFunctor& functor) = 0;
+    // Scans the entries whose keys start with 'prefix'.
+    void ScanPrefix(const std::string& prefix, const ScanFunctor& functor);
+  };
+
+  virtual ~KeyValueBackend() {}
+
+  // Returns false if 'key' isn't present.
+  virtual bool Get(const std::string& key, std::string& value) = 0;
+  virtual void Put(const std::string& key, const std::string& value) = 0;
+  // Has no effect if 'key' isn't present.
+  virtual void Delete(const std::string& key) = 0;
+  // Scans the entries with keys in [begin, end), where an empty 'end' leaves the range unbounded.
+  virtual void Scan(const std::string& begin, const std::string& end,
+                    const ScanFunctor& functor) = 0;
+  virtual void Write(const WriteBatch& batch) = 0;
+  virtual std::unique_ptr<Snapshot> GetSnapshot() = 0;
+  // Lets successive writes become durable together, once 'max_writes' are pending or the oldest
+  // has waited for 'max_delay'.  A zero delay (the default) makes each write durable on return.
+  // Ignored by a backend which isn't durable.
+  virtual void SetGroupCommitWindow(std::chrono::milliseconds max_delay, int max_writes) = 0;
+};
+
+// The end of the range of keys starting with 'prefix', i.e. the prefix with trailing 0xff bytes
+// dropped and its last byte incremented.  Empty, so unbounded, if the prefix is only 0xff bytes (or
+// is empty).
+std::string PrefixEnd(const std::string& prefix);
+
+// 'path' is the backend's file or directory, which is created if it doesn't exist.
+std::unique_ptr<KeyValueBackend> MakeKeyValueBackend(KeyValueBackendType type,
+                                                     const boost::filesystem::path& path);
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_KEY_VALUE_BACKEND_H_
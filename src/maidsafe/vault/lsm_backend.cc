@@ -0,0 +1,945 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/lsm_backend.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <limits>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "boost/crc.hpp"
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace {
+
+typedef std::map<std::string, boost::optional<std::string>> MemTable;
+
+const size_t kBlockRecords(64);
+const uint32_t kTombstone(std::numeric_limits<uint32_t>::max());
+const uint32_t kTableMagic(0x4d534c54);
+const size_t kFooterSize(32);
+const uint64_t kEntryOverhead(64);
+
+void PutFixed(std::string& output, uint64_t value, size_t size) {
+  for (size_t i(0); i != size; ++i)
+    output.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+uint64_t GetFixed(const char* input, size_t size) {
+  uint64_t value(0);
+  for (size_t i(0); i != size; ++i)
+    value |= static_cast<uint64_t>(static_cast<unsigned char>(input[i])) << (8 * i);
+  return value;
+}
+
+uint32_t Checksum(const std::string& data) {
+  boost::crc_32_type crc;
+  crc.process_bytes(data.data(), data.size());
+  return crc.checksum();
+}
+
+void FlushFile(std::FILE* file) {
+  if (std::fflush(file) != 0)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+}
+
+// Syncs only what has already been flushed from the file's buffer, so may run alongside writes.
+void SyncFlushedFile(std::FILE* file) {
+#ifdef _WIN32
+  if (_commit(_fileno(file)) != 0)
+#else
+  if (fsync(fileno(file)) != 0)
+#endif
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+}
+
+void SyncFile(std::FILE* file) {
+  FlushFile(file);
+  SyncFlushedFile(file);
+}
+
+std::string EncodeBatch(const KeyValueBackend::WriteBatch& batch) {
+  std::string record;
+  for (const auto& write : batch) {
+    record.push_back(write.second ? 1 : 0);
+    PutFixed(record, write.first.size(), 4);
+    record += write.first;
+    if (write.second) {
+      PutFixed(record, write.second->size(), 4);
+      record += *write.second;
+    }
+  }
+  return record;
+}
+
+void DecodeBatch(const std::string& record, MemTable& memtable) {
+  size_t position(0);
+  auto read([&](size_t size) -> std::string {
+    if (record.size() - position < size)
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+    position += size;
+    return record.substr(position - size, size);
+  });
+  while (position != record.size()) {
+    bool put(read(1)[0] != 0);
+    std::string key(read(static_cast<size_t>(GetFixed(read(4).data(), 4))));
+    if (put)
+      memtable[key] = read(static_cast<size_t>(GetFixed(read(4).data(), 4)));
+    else
+      memtable[key] = boost::none;
+  }
+}
+
+}  // unnamed namespace
+
+namespace detail {
+
+LogFile::LogFile(const fs::path& path) : file_(std::fopen(path.string().c_str(), "ab")) {
+  if (!file_) {
+    LOG(kError) << "Failed to open log " << path;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+}
+
+LogFile::~LogFile() { std::fclose(file_); }
+
+void LogFile::Append(const std::string& record) {
+  std::string header;
+  PutFixed(header, record.size(), 4);
+  PutFixed(header, Checksum(record), 4);
+  if (std::fwrite(header.data(), 1, header.size(), file_) != header.size() ||
+      std::fwrite(record.data(), 1, record.size(), file_) != record.size()) {
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+}
+
+void LogFile::Flush() { FlushFile(file_); }
+
+void LogFile::SyncFlushed() { SyncFlushedFile(file_); }
+
+std::vector<std::string> LogFile::Read(const fs::path& path) {
+  std::ifstream file(path.string(), std::ios::binary);
+  std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  std::vector<std::string> records;
+  size_t position(0);
+  while (contents.size() - position >= 8) {
+    size_t size(static_cast<size_t>(GetFixed(contents.data() + position, 4)));
+    uint32_t checksum(static_cast<uint32_t>(GetFixed(contents.data() + position + 4, 4)));
+    if (contents.size() - position - 8 < size)
+      break;
+    std::string record(contents.substr(position + 8, size));
+    if (Checksum(record) != checksum)
+      break;
+    records.push_back(std::move(record));
+    position += 8 + size;
+  }
+  if (position != contents.size())
+    LOG(kWarning) << "Ignoring " << contents.size() - position << " torn bytes at the end of "
+                  << path;
+  return records;
+}
+
+// An immutable sorted run of entries.  The values come first, followed by the index of fixed-size
+// records (key padded to the table's key width, key length, value offset and value length), the
+// fence keys which start each block of kBlockRecords records, and a footer locating these.
+class SortedTable {
+ public:
+  struct Record {
+    std::string key;
+    uint64_t offset;
+    uint32_t length;
+  };
+  // Sets the next entry, returning false once there are no more.
+  typedef std::function<bool(std::string& key, boost::optional<std::string>& value)> Source;
+
+  static void Write(const fs::path& path, uint32_t key_width, const Source& source);
+
+  SortedTable(const fs::path& path, uint64_t min_sequence, uint64_t max_sequence);
+  SortedTable(const SortedTable&) = delete;
+  SortedTable& operator=(const SortedTable&) = delete;
+  ~SortedTable();
+
+  // Returns false if the table doesn't hold 'key', or sets 'value' to none if it was deleted.
+  bool Find(const std::string& key, boost::optional<std::string>& value);
+  // The block in which 'key' would be, or the first one.
+  size_t FindBlock(const std::string& key) const;
+  size_t BlockCount() const { return fences_.size(); }
+  void ReadBlock(size_t block, std::vector<Record>& records);
+  boost::optional<std::string> ReadValue(const Record& record);
+
+  uint32_t key_width() const { return key_width_; }
+  uint64_t min_sequence() const { return kMinSequence_; }
+  uint64_t max_sequence() const { return kMaxSequence_; }
+  // The file is removed once the last reference to the table goes.
+  void MarkObsolete() { obsolete_ = true; }
+
+ private:
+  std::string Read(uint64_t offset, size_t size);
+
+  const fs::path kPath_;
+  const uint64_t kMinSequence_, kMaxSequence_;
+  std::mutex mutex_;
+  std::ifstream file_;
+  uint64_t count_, index_offset_;
+  uint32_t key_width_;
+  std::vector<std::string> fences_;
+  std::atomic<bool> obsolete_;
+};
+
+void SortedTable::Write(const fs::path& path, uint32_t key_width, const Source& source) {
+  const fs::path index_path(path.string() + ".index");
+  std::ofstream file(path.string(), std::ios::binary | std::ios::trunc);
+  std::ofstream index(index_path.string(), std::ios::binary | std::ios::trunc);
+  std::string key, record, fences;
+  boost::optional<std::string> value;
+  uint64_t offset(0), count(0);
+  while (source(key, value)) {
+    if (key.size() > key_width)
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+    if (count++ % kBlockRecords == 0) {
+      PutFixed(fences, key.size(), 4);
+      fences += key;
+    }
+    record = key;
+    record.resize(key_width, '\0');
+    PutFixed(record, key.size(), 2);
+    PutFixed(record, offset, 8);
+    PutFixed(record, value ? value->size() : kTombstone, 4);
+    index.write(record.data(), record.size());
+    if (value) {
+      file.write(value->data(), value->size());
+      offset += value->size();
+    }
+  }
+  index.close();
+  if (count != 0) {
+    std::ifstream index_input(index_path.string(), std::ios::binary);
+    file << index_input.rdbuf();
+  }
+  std::string footer;
+  PutFixed(footer, offset, 8);
+  PutFixed(footer, count, 8);
+  PutFixed(footer, offset + count * (key_width + 14), 8);
+  PutFixed(footer, key_width, 4);
+  PutFixed(footer, kTableMagic, 4);
+  file.write(fences.data(), fences.size());
+  file.write(footer.data(), footer.size());
+  file.close();
+  if (!file || !index) {
+    LOG(kError) << "Failed to write table " << path;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  fs::remove(index_path);
+  std::FILE* written(std::fopen(path.string().c_str(), "ab"));
+  if (!written)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  try {
+    SyncFile(written);
+  }
+  catch (...) {
+    std::fclose(written);
+    throw;
+  }
+  std::fclose(written);
+}
+
+SortedTable::SortedTable(const fs::path& path, uint64_t min_sequence, uint64_t max_sequence)
+    : kPath_(path),
+      kMinSequence_(min_sequence),
+      kMaxSequence_(max_sequence),
+      mutex_(),
+      file_(path.string(), std::ios::binary),
+      count_(0),
+      index_offset_(0),
+      key_width_(0),
+      fences_(),
+      obsolete_(false) {
+  uint64_t file_size(fs::file_size(kPath_));
+  if (file_size < kFooterSize)
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  std::string footer(Read(file_size - kFooterSize, kFooterSize));
+  index_offset_ = GetFixed(footer.data(), 8);
+  count_ = GetFixed(footer.data() + 8, 8);
+  uint64_t fence_offset(GetFixed(footer.data() + 16, 8));
+  key_width_ = static_cast<uint32_t>(GetFixed(footer.data() + 24, 4));
+  if (GetFixed(footer.data() + 28, 4) != kTableMagic || fence_offset > file_size - kFooterSize) {
+    LOG(kError) << "Corrupt table " << kPath_;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::parsing_error));
+  }
+  std::string fences(Read(fence_offset, static_cast<size_t>(file_size - kFooterSize -
+                                                            fence_offset)));
+  for (size_t position(0); position + 4 <= fences.size();) {
+    size_t size(static_cast<size_t>(GetFixed(fences.data() + position, 4)));
+    fences_.push_back(fences.substr(position + 4, size));
+    position += 4 + size;
+  }
+}
+
+SortedTable::~SortedTable() {
+  file_.close();
+  if (obsolete_) {
+    boost::system::error_code error_code;
+    fs::remove(kPath_, error_code);
+  }
+}
+
+bool SortedTable::Find(const std::string& key, boost::optional<std::string>& value) {
+  if (key.size() > key_width_)
+    return false;
+  auto fence(std::upper_bound(fences_.begin(), fences_.end(), key));
+  if (fence == fences_.begin())
+    return false;
+  std::vector<Record> records;
+  ReadBlock(fence - fences_.begin() - 1, records);
+  auto itr(std::lower_bound(records.begin(), records.end(), key,
+                            [](const Record& record, const std::string& key) {
+                              return record.key < key;
+                            }));
+  if (itr == records.end() || itr->key != key)
+    return false;
+  value = ReadValue(*itr);
+  return true;
+}
+
+size_t SortedTable::FindBlock(const std::string& key) const {
+  auto fence(std::upper_bound(fences_.begin(), fences_.end(), key));
+  return fence == fences_.begin() ? 0 : fence - fences_.begin() - 1;
+}
+
+void SortedTable::ReadBlock(size_t block, std::vector<Record>& records) {
+  const uint64_t kRecordSize(key_width_ + 14);
+  uint64_t first(block * kBlockRecords);
+  size_t count(static_cast<size_t>(std::min<uint64_t>(kBlockRecords, count_ - first)));
+  std::string data(Read(index_offset_ + first * kRecordSize,
+                        static_cast<size_t>(count * kRecordSize)));
+  records.clear();
+  records.reserve(count);
+  for (const char* record(data.data()); record != data.data() + data.size();
+       record += kRecordSize) {
+    Record decoded = {std::string(record, static_cast<size_t>(GetFixed(record + key_width_, 2))),
+                      GetFixed(record + key_width_ + 2, 8),
+                      static_cast<uint32_t>(GetFixed(record + key_width_ + 10, 4))};
+    records.push_back(std::move(decoded));
+  }
+}
+
+boost::optional<std::string> SortedTable::ReadValue(const Record& record) {
+  if (record.length == kTombstone)
+    return boost::none;
+  return Read(record.offset, record.length);
+}
+
+std::string SortedTable::Read(uint64_t offset, size_t size) {
+  std::string data(size, '\0');
+  std::lock_guard<std::mutex> lock(mutex_);
+  file_.clear();
+  file_.seekg(offset);
+  file_.read(&data[0], size);
+  if (static_cast<size_t>(file_.gcount()) != size) {
+    LOG(kError) << "Failed to read " << size << " bytes at " << offset << " of " << kPath_;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  return data;
+}
+
+}  // namespace detail
+
+namespace {
+
+class EntryIterator {
+ public:
+  virtual ~EntryIterator() {}
+  virtual bool Valid() const = 0;
+  virtual const std::string& Key() const = 0;
+  virtual boost::optional<std::string> Value() = 0;
+  virtual void Next() = 0;
+};
+
+class MemTableIterator : public EntryIterator {
+ public:
+  MemTableIterator(const MemTable& memtable, const std::string& begin)
+      : itr_(memtable.lower_bound(begin)), end_(memtable.end()) {}
+  bool Valid() const override { return itr_ != end_; }
+  const std::string& Key() const override { return itr_->first; }
+  boost::optional<std::string> Value() override { return itr_->second; }
+  void Next() override { ++itr_; }
+
+ private:
+  MemTable::const_iterator itr_, end_;
+};
+
+class TableIterator : public EntryIterator {
+ public:
+  TableIterator(std::shared_ptr<detail::SortedTable> table, const std::string& begin)
+      : table_(std::move(table)), block_(table_->FindBlock(begin)), records_(), position_(0) {
+    Load();
+    position_ = std::lower_bound(records_.begin(), records_.end(), begin,
+                                 [](const detail::SortedTable::Record& record,
+                                    const std::string& key) { return record.key < key; }) -
+                records_.begin();
+    if (position_ == records_.size() && !records_.empty()) {
+      ++block_;
+      Load();
+    }
+  }
+  bool Valid() const override { return position_ < records_.size(); }
+  const std::string& Key() const override { return records_[position_].key; }
+  boost::optional<std::string> Value() override { return table_->ReadValue(records_[position_]); }
+  void Next() override {
+    if (++position_ == records_.size()) {
+      ++block_;
+      Load();
+    }
+  }
+
+ private:
+  void Load() {
+    position_ = 0;
+    if (block_ < table_->BlockCount())
+      table_->ReadBlock(block_, records_);
+    else
+      records_.clear();
+  }
+
+  std::shared_ptr<detail::SortedTable> table_;
+  size_t block_;
+  std::vector<detail::SortedTable::Record> records_;
+  size_t position_;
+};
+
+// Merges sources ordered newest first, so that for a key held by several the newest entry wins.
+class MergingIterator {
+ public:
+  MergingIterator(const MemTable* memtable, const MemTable* immutable,
+                  const std::vector<std::shared_ptr<detail::SortedTable>>& tables,
+                  const std::string& begin)
+      : sources_() {
+    if (memtable)
+      sources_.emplace_back(new MemTableIterator(*memtable, begin));
+    if (immutable)
+      sources_.emplace_back(new MemTableIterator(*immutable, begin));
+    for (const auto& table : tables)
+      sources_.emplace_back(new TableIterator(table, begin));
+  }
+
+  // Returns false once there are no more entries.
+  bool Next(std::string& key, boost::optional<std::string>& value) {
+    EntryIterator* newest(nullptr);
+    for (const auto& source : sources_) {
+      if (source->Valid() && (!newest || source->Key() < newest->Key()))
+        newest = source.get();
+    }
+    if (!newest)
+      return false;
+    key = newest->Key();
+    value = newest->Value();
+    for (const auto& source : sources_) {
+      if (source->Valid() && source->Key() == key)
+        source->Next();
+    }
+    return true;
+  }
+
+ private:
+  std::vector<std::unique_ptr<EntryIterator>> sources_;
+};
+
+bool Lookup(const MemTable& memtable, const std::string& key, std::string& value, bool& found) {
+  auto itr(memtable.find(key));
+  if (itr == memtable.end())
+    return false;
+  found = static_cast<bool>(itr->second);
+  if (found)
+    value = *itr->second;
+  return true;
+}
+
+bool LookupTables(const std::vector<std::shared_ptr<detail::SortedTable>>& tables,
+                  const std::string& key, std::string& value) {
+  boost::optional<std::string> found;
+  for (const auto& table : tables) {
+    if (table->Find(key, found)) {
+      if (found)
+        value = *found;
+      return static_cast<bool>(found);
+    }
+  }
+  return false;
+}
+
+void ScanSources(const MemTable* memtable, const MemTable* immutable,
+                 const std::vector<std::shared_ptr<detail::SortedTable>>& tables,
+                 const std::string& begin, const std::string& end,
+                 const KeyValueBackend::ScanFunctor& functor) {
+  if (!end.empty() && end <= begin)
+    return;
+  MergingIterator merged(memtable, immutable, tables, begin);
+  std::string key;
+  boost::optional<std::string> value;
+  while (merged.Next(key, value)) {
+    if (!end.empty() && key >= end)
+      return;
+    if (value && !functor(key, *value))
+      return;
+  }
+}
+
+}  // unnamed namespace
+
+class LsmBackend::LsmSnapshot : public KeyValueBackend::Snapshot {
+ public:
+  LsmSnapshot(std::shared_ptr<const MemTable> memtable, std::shared_ptr<const MemTable> immutable,
+              Tables tables)
+      : memtable_(std::move(memtable)),
+        immutable_(std::move(immutable)),
+        tables_(std::move(tables)) {}
+
+  bool Get(const std::string& key, std::string& value) override {
+    bool found(false);
+    if (Lookup(*memtable_, key, value, found) || (immutable_ && Lookup(*immutable_, key, value,
+                                                                       found))) {
+      return found;
+    }
+    return LookupTables(tables_, key, value);
+  }
+
+  void Scan(const std::string& begin, const std::string& end,
+            const ScanFunctor& functor) override {
+    ScanSources(memtable_.get(), immutable_.get(), tables_, begin, end, functor);
+  }
+
+ private:
+  const std::shared_ptr<const MemTable> memtable_, immutable_;
+  const Tables tables_;
+};
+
+LsmBackend::LsmBackend(const fs::path& directory, uint64_t memtable_size,
+                       size_t max_table_count)
+    : kDirectory_(directory),
+      kMemTableSize_(memtable_size),
+      kMaxTableCount_(std::max<size_t>(max_table_count, 1)),
+      mutex_(),
+      worker_condition_(),
+      writer_condition_(),
+      memtable_(std::make_shared<MemTable>()),
+      memtable_size_(0),
+      memtable_first_log_(0),
+      immutable_(),
+      immutable_first_log_(0),
+      immutable_last_log_(0),
+      tables_(),
+      log_(),
+      rotated_log_(),
+      log_sequence_(0),
+      write_count_(0),
+      max_delay_(0),
+      max_writes_(1),
+      unsynced_writes_(0),
+      first_unsynced_(),
+      sync_mutex_(),
+      synced_count_(0),
+      compacting_(false),
+      compact_requested_(false),
+      stop_(false),
+      worker_() {
+  Recover();
+  worker_ = std::thread([this] { Run(); });
+}
+
+LsmBackend::~LsmBackend() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  worker_condition_.notify_one();
+  worker_.join();
+  try {
+    SyncLog(write_count_);
+  }
+  catch (const std::exception& e) {
+    LOG(kError) << "Failed to sync log: " << boost::diagnostic_information(e);
+  }
+}
+
+bool LsmBackend::Get(const std::string& key, std::string& value) {
+  Tables tables;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool found(false);
+    if (Lookup(*memtable_, key, value, found) || (immutable_ && Lookup(*immutable_, key, value,
+                                                                       found))) {
+      return found;
+    }
+    tables = tables_;
+  }
+  return LookupTables(tables, key, value);
+}
+
+void LsmBackend::Put(const std::string& key, const std::string& value) {
+  WriteBatch batch;
+  batch[key] = value;
+  Write(batch);
+}
+
+void LsmBackend::Delete(const std::string& key) {
+  WriteBatch batch;
+  batch[key] = boost::none;
+  Write(batch);
+}
+
+void LsmBackend::Scan(const std::string& begin, const std::string& end,
+                      const ScanFunctor& functor) {
+  // Copies only the in-memory entries in range, rather than sharing the whole table as a snapshot
+  // does, which would make the next write copy it.
+  MemTable memtable;
+  std::shared_ptr<const MemTable> immutable;
+  Tables tables;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!end.empty() && end <= begin)
+      return;
+    memtable.insert(memtable_->lower_bound(begin),
+                    end.empty() ? memtable_->end() : memtable_->lower_bound(end));
+    immutable = immutable_;
+    tables = tables_;
+  }
+  ScanSources(&memtable, immutable.get(), tables, begin, end, functor);
+}
+
+void LsmBackend::Write(const WriteBatch& batch) {
+  if (batch.empty())
+    return;
+  std::string record(EncodeBatch(batch));
+  uint64_t write_number(0);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (memtable_size_ >= kMemTableSize_)
+      RotateMemTable(lock);
+    log_->Append(record);
+    MemTable& memtable(MutableMemTable());
+    for (const auto& write : batch) {
+      memtable[write.first] = write.second;
+      memtable_size_ += write.first.size() + (write.second ? write.second->size() : 0) +
+                        kEntryOverhead;
+    }
+    write_number = ++write_count_;
+    if (max_delay_ != std::chrono::milliseconds(0)) {
+      if (unsynced_writes_ == 0)
+        first_unsynced_ = std::chrono::steady_clock::now();
+      unsynced_writes_ += static_cast<int>(batch.size());
+      if (unsynced_writes_ < max_writes_) {
+        worker_condition_.notify_one();
+        return;
+      }
+    }
+  }
+  // Readers and other writers carry on while this waits for the disk.
+  SyncLog(write_number);
+}
+
+std::unique_ptr<KeyValueBackend::Snapshot> LsmBackend::GetSnapshot() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return std::unique_ptr<Snapshot>(new LsmSnapshot(memtable_, immutable_, tables_));
+}
+
+void LsmBackend::SetGroupCommitWindow(std::chrono::milliseconds max_delay, int max_writes) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  max_delay_ = std::max(max_delay, std::chrono::milliseconds(0));
+  max_writes_ = std::max(max_writes, 1);
+  worker_condition_.notify_one();
+  if (max_delay_ == std::chrono::milliseconds(0)) {
+    uint64_t write_count(write_count_);
+    lock.unlock();
+    SyncLog(write_count);
+  }
+}
+
+void LsmBackend::Compact() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!memtable_->empty())
+    RotateMemTable(lock);
+  compact_requested_ = true;
+  worker_condition_.notify_one();
+  writer_condition_.wait(lock, [this] {
+    return !immutable_ && !compacting_ && (!compact_requested_ || tables_.size() <= 1);
+  });
+}
+
+size_t LsmBackend::TableCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tables_.size();
+}
+
+void LsmBackend::Recover() {
+  fs::create_directories(kDirectory_);
+  struct TableFile {
+    uint64_t min_sequence, max_sequence;
+    fs::path path;
+  };
+  std::vector<TableFile> table_files;
+  std::map<uint64_t, fs::path> log_files;
+  for (fs::directory_iterator itr(kDirectory_), end; itr != end; ++itr) {
+    const fs::path& path(itr->path());
+    std::string stem(path.stem().string());
+    if (path.extension() == ".log") {
+      log_files[std::stoull(stem)] = path;
+    } else if (path.extension() == ".sst") {
+      TableFile table_file = {std::stoull(stem.substr(0, stem.find('-'))),
+                              std::stoull(stem.substr(stem.find('-') + 1)), path};
+      table_files.push_back(table_file);
+    } else {
+      // Left by a table write or merge which didn't complete.
+      fs::remove(path);
+    }
+  }
+
+  // A merge which didn't remove its inputs leaves tables covered by its output.
+  uint64_t persisted(0);
+  for (const auto& table_file : table_files) {
+    bool covered(std::any_of(table_files.begin(), table_files.end(),
+                             [&](const TableFile& other) {
+      return other.min_sequence <= table_file.min_sequence &&
+             table_file.max_sequence <= other.max_sequence &&
+             (other.min_sequence != table_file.min_sequence ||
+              other.max_sequence != table_file.max_sequence);
+    }));
+    if (covered) {
+      fs::remove(table_file.path);
+      continue;
+    }
+    tables_.push_back(std::make_shared<detail::SortedTable>(
+        table_file.path, table_file.min_sequence, table_file.max_sequence));
+    persisted = std::max(persisted, table_file.max_sequence);
+  }
+  std::sort(tables_.begin(), tables_.end(),
+            [](const std::shared_ptr<detail::SortedTable>& lhs,
+               const std::shared_ptr<detail::SortedTable>& rhs) {
+    return lhs->max_sequence() > rhs->max_sequence();
+  });
+
+  // Logs not yet written out to a table are replayed into the in-memory table.
+  log_sequence_ = persisted;
+  for (const auto& log_file : log_files) {
+    log_sequence_ = std::max(log_sequence_, log_file.first);
+    if (log_file.first <= persisted) {
+      fs::remove(log_file.second);
+      continue;
+    }
+    if (memtable_->empty())
+      memtable_first_log_ = log_file.first;
+    for (const auto& record : detail::LogFile::Read(log_file.second))
+      DecodeBatch(record, *memtable_);
+  }
+  for (const auto& entry : *memtable_)
+    memtable_size_ += entry.first.size() + (entry.second ? entry.second->size() : 0) +
+                      kEntryOverhead;
+  log_.reset(new detail::LogFile(LogPath(++log_sequence_)));
+  if (memtable_->empty())
+    memtable_first_log_ = log_sequence_;
+}
+
+LsmBackend::MemTable& LsmBackend::MutableMemTable() {
+  // Shared with a snapshot.
+  if (memtable_.use_count() != 1)
+    memtable_ = std::make_shared<MemTable>(*memtable_);
+  return *memtable_;
+}
+
+void LsmBackend::RotateMemTable(std::unique_lock<std::mutex>& lock) {
+  // Writers wait while the previous table is still being written out.
+  writer_condition_.wait(lock, [this] { return !immutable_; });
+  // Any rotated log before this one is covered by the table just written, so needs no sync.
+  log_->Flush();
+  rotated_log_ = log_;
+  immutable_ = memtable_;
+  immutable_first_log_ = memtable_first_log_;
+  immutable_last_log_ = log_sequence_;
+  memtable_ = std::make_shared<MemTable>();
+  memtable_size_ = 0;
+  log_.reset(new detail::LogFile(LogPath(++log_sequence_)));
+  memtable_first_log_ = log_sequence_;
+  worker_condition_.notify_one();
+}
+
+void LsmBackend::SyncLog(uint64_t write_number) {
+  std::lock_guard<std::mutex> sync_lock(sync_mutex_);
+  if (synced_count_ >= write_number)
+    return;
+  std::shared_ptr<detail::LogFile> log, rotated_log;
+  uint64_t write_count(0);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    log_->Flush();
+    log = log_;
+    rotated_log.swap(rotated_log_);
+    write_count = write_count_;
+    unsynced_writes_ = 0;
+  }
+  if (rotated_log)
+    rotated_log->SyncFlushed();
+  log->SyncFlushed();
+  synced_count_ = write_count;
+}
+
+fs::path LsmBackend::LogPath(uint64_t sequence) const {
+  return kDirectory_ / (std::to_string(sequence) + ".log");
+}
+
+fs::path LsmBackend::TablePath(uint64_t min_sequence, uint64_t max_sequence) const {
+  return kDirectory_ / (std::to_string(min_sequence) + "-" + std::to_string(max_sequence) + ".sst");
+}
+
+void LsmBackend::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    try {
+      if (immutable_) {
+        std::shared_ptr<const MemTable> immutable(immutable_);
+        uint64_t first_log(immutable_first_log_), last_log(immutable_last_log_);
+        lock.unlock();
+        auto table(WriteTable(*immutable, first_log, last_log));
+        lock.lock();
+        tables_.insert(tables_.begin(), table);
+        immutable_.reset();
+        for (uint64_t sequence(first_log); sequence <= last_log; ++sequence) {
+          boost::system::error_code error_code;
+          fs::remove(LogPath(sequence), error_code);
+        }
+        writer_condition_.notify_all();
+        continue;
+      }
+      if (!stop_ && (tables_.size() > kMaxTableCount_ ||
+                     (compact_requested_ && tables_.size() > 1))) {
+        // Tables written out meanwhile are newer than all of these, and stay at the front.
+        Tables tables(tables_);
+        compacting_ = true;
+        lock.unlock();
+        auto merged(MergeTables(tables));
+        lock.lock();
+        tables_.resize(tables_.size() - tables.size());
+        tables_.push_back(merged);
+        for (const auto& table : tables)
+          table->MarkObsolete();
+        compacting_ = false;
+        compact_requested_ = false;
+        writer_condition_.notify_all();
+        continue;
+      }
+      if (compact_requested_) {
+        compact_requested_ = false;
+        writer_condition_.notify_all();
+      }
+      if (unsynced_writes_ != 0 && max_delay_ != std::chrono::milliseconds(0)) {
+        auto due(first_unsynced_ + max_delay_);
+        if (std::chrono::steady_clock::now() >= due) {
+          uint64_t write_count(write_count_);
+          lock.unlock();
+          SyncLog(write_count);
+          lock.lock();
+          continue;
+        }
+        if (stop_)
+          return;
+        worker_condition_.wait_until(lock, due);
+        continue;
+      }
+      if (stop_)
+        return;
+      worker_condition_.wait(lock);
+    }
+    catch (const std::exception& e) {
+      LOG(kError) << "Failed to maintain " << kDirectory_ << ": "
+                  << boost::diagnostic_information(e);
+      if (!lock.owns_lock())
+        lock.lock();
+      compacting_ = false;
+      compact_requested_ = false;
+      writer_condition_.notify_all();
+      if (stop_)
+        return;
+      worker_condition_.wait_for(lock, std::chrono::seconds(1));
+    }
+  }
+}
+
+std::shared_ptr<detail::SortedTable> LsmBackend::WriteTable(const MemTable& memtable,
+                                                            uint64_t min_sequence,
+                                                            uint64_t max_sequence) {
+  uint32_t key_width(0);
+  for (const auto& entry : memtable)
+    key_width = std::max(key_width, static_cast<uint32_t>(entry.first.size()));
+  const fs::path path(TablePath(min_sequence, max_sequence));
+  const fs::path temp_path(path.string() + ".tmp");
+  auto itr(memtable.begin());
+  detail::SortedTable::Write(temp_path, key_width,
+                             [&](std::string& key, boost::optional<std::string>& value) {
+    if (itr == memtable.end())
+      return false;
+    key = itr->first;
+    value = itr->second;
+    ++itr;
+    return true;
+  });
+  fs::rename(temp_path, path);
+  return std::make_shared<detail::SortedTable>(path, min_sequence, max_sequence);
+}
+
+std::shared_ptr<detail::SortedTable> LsmBackend::MergeTables(const Tables& tables) {
+  uint32_t key_width(0);
+  uint64_t min_sequence(std::numeric_limits<uint64_t>::max()), max_sequence(0);
+  for (const auto& table : tables) {
+    key_width = std::max(key_width, table->key_width());
+    min_sequence = std::min(min_sequence, table->min_sequence());
+    max_sequence = std::max(max_sequence, table->max_sequence());
+  }
+  const fs::path path(TablePath(min_sequence, max_sequence));
+  const fs::path temp_path(path.string() + ".tmp");
+  // Every older table is being merged, so deletions need no longer be recorded.
+  MergingIterator merged(nullptr, nullptr, tables, std::string());
+  detail::SortedTable::Write(temp_path, key_width,
+                             [&](std::string& key, boost::optional<std::string>& value) {
+    while (merged.Next(key, value)) {
+      if (value)
+        return true;
+    }
+    return false;
+  });
+  fs::rename(temp_path, path);
+  return std::make_shared<detail::SortedTable>(path, min_sequence, max_sequence);
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,144 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_LSM_BACKEND_H_
+#define MAIDSAFE_VAULT_LSM_BACKEND_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/filesystem/path.hpp"
+#include "boost/optional.hpp"
+
+#include "maidsafe/vault/key_value_backend.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+class SortedTable;
+
+// Appends records to a file, each with its length and checksum so that a torn final record can be
+// detected on reading.  Only SyncFlushed may run concurrently with the other calls.
+class LogFile {
+ public:
+  explicit LogFile(const boost::filesystem::path& path);
+  LogFile(const LogFile&) = delete;
+  LogFile& operator=(const LogFile&) = delete;
+  ~LogFile();
+
+  void Append(const std::string& record);
+  // Passes the appended records to the OS.
+  void Flush();
+  // Returns once the flushed records are on disk.
+  void SyncFlushed();
+  // Returns the intact records of the file at 'path', in order.
+  static std::vector<std::string> Read(const boost::filesystem::path& path);
+
+ private:
+  std::FILE* file_;
+};
+
+}  // namespace detail
+
+// A log-structured merge tree, tuned for the persona databases' fixed-width binary keys.  Writes
+// go to a write-ahead log and an in-memory table.  Once that holds 'memtable_size' bytes, a
+// background thread writes it out as an immutable sorted table, and merges all the sorted tables
+// into one whenever there are more than 'max_table_count'.  A sorted table pads its keys to a fixed
+// width to index them with equal-sized records, so a lookup needs one binary search of the fence
+// keys it holds in memory and a single read of the block of records which they identify.
+class LsmBackend : public KeyValueBackend {
+ public:
+  LsmBackend(const boost::filesystem::path& directory, uint64_t memtable_size = 4 * 1024 * 1024,
+             size_t max_table_count = 4);
+  LsmBackend(const LsmBackend&) = delete;
+  LsmBackend& operator=(const LsmBackend&) = delete;
+  ~LsmBackend();
+
+  bool Get(const std::string& key, std::string& value) override;
+  void Put(const std::string& key, const std::string& value) override;
+  void Delete(const std::string& key) override;
+  void Scan(const std::string& begin, const std::string& end,
+            const ScanFunctor& functor) override;
+  void Write(const WriteBatch& batch) override;
+  std::unique_ptr<Snapshot> GetSnapshot() override;
+  void SetGroupCommitWindow(std::chrono::milliseconds max_delay, int max_writes) override;
+
+  // Writes out the in-memory table and merges all the sorted tables into one, returning once done.
+  void Compact();
+  size_t TableCount();
+
+ private:
+  // Maps a key to none where it has been deleted, hiding any value in the older tables.
+  typedef std::map<std::string, boost::optional<std::string>> MemTable;
+  typedef std::vector<std::shared_ptr<detail::SortedTable>> Tables;
+  class LsmSnapshot;
+
+  void Recover();
+  // These require mutex_ to be held.
+  MemTable& MutableMemTable();
+  void RotateMemTable(std::unique_lock<std::mutex>& lock);
+  boost::filesystem::path LogPath(uint64_t sequence) const;
+  boost::filesystem::path TablePath(uint64_t min_sequence, uint64_t max_sequence) const;
+
+  // Returns once the write numbered 'write_number' and all before it are on disk.  Requires mutex_
+  // not to be held, as it is only taken to flush the log; the fsync runs without it.
+  void SyncLog(uint64_t write_number);
+  void Run();
+  std::shared_ptr<detail::SortedTable> WriteTable(const MemTable& memtable,
+                                                  uint64_t min_sequence, uint64_t max_sequence);
+  std::shared_ptr<detail::SortedTable> MergeTables(const Tables& tables);
+
+  const boost::filesystem::path kDirectory_;
+  const uint64_t kMemTableSize_;
+  const size_t kMaxTableCount_;
+  std::mutex mutex_;
+  std::condition_variable worker_condition_, writer_condition_;
+  std::shared_ptr<MemTable> memtable_;
+  uint64_t memtable_size_, memtable_first_log_;
+  std::shared_ptr<const MemTable> immutable_;
+  uint64_t immutable_first_log_, immutable_last_log_;
+  Tables tables_;  // Newest first.
+  // A rotated log stays open until its flushed records are synced, by whichever thread syncs next.
+  std::shared_ptr<detail::LogFile> log_, rotated_log_;
+  uint64_t log_sequence_, write_count_;
+  std::chrono::milliseconds max_delay_;
+  int max_writes_, unsynced_writes_;
+  std::chrono::steady_clock::time_point first_unsynced_;
+  // Held by the one thread syncing the log; any waiting find their writes covered by its sync.
+  std::mutex sync_mutex_;
+  uint64_t synced_count_;
+  bool compacting_, compact_requested_, stop_;
+  std::thread worker_;
+};
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_LSM_BACKEND_H_
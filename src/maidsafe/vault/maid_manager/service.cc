@@ -51,10 +51,12 @@ inline bool ForThisPersona(const Message& message) {
 
 MaidManagerService::MaidManagerService(const passport::Pmid& pmid, routing::Routing& routing,
                                        nfs_client::DataGetter& data_getter,
-                                       const boost::filesystem::path& /*vault_root_dir*/)
+                                       const boost::filesystem::path& /*vault_root_dir*/,
+                                       AsioService& asio_service)
     : routing_(routing),
       data_getter_(data_getter),
       accounts_(),
+      close_nodes_tracker_(NodeId(pmid.name()->string())),
       accumulator_mutex_(),
       mutex_(),
       nfs_accumulator_(),
@@ -65,6 +67,10 @@ MaidManagerService::MaidManagerService(const passport::Pmid& pmid, routing::Rout
       sync_puts_(NodeId(pmid.name()->string())),
       sync_deletes_(NodeId(pmid.name()->string())),
       account_transfer_(),
+      paged_account_transfer_(asio_service.service(), SerialiseAccount,
+                              [this](const NodeId& peer, const std::string& serialised_transfer) {
+                                dispatcher_.SendAccountTransfer(peer, serialised_transfer);
+                              }),
       pending_account_mutex_(),
       pending_account_map_() {}
 
@@ -276,8 +282,11 @@ void MaidManagerService::HandleChurnEvent(
     //    VLOG(VisualiserAction::kConnectionMap, close_nodes_change->ReportConnection());
     LOG(kVerbose) << "MaidManager HandleChurnEvent processing accounts_ holding "
                   << accounts_.size() << " accounts";
-     TransferInfo transfer_info(detail::GetTransferInfo<Key, Value, TransferInfo>(
-        close_nodes_change, accounts_));
+    TransferInfo transfer_info(detail::GetTransferInfo<Key, Value, TransferInfo>(
+        close_nodes_change, accounts_,
+        close_nodes_tracker_.Update(close_nodes_change->lost_node(),
+                                    close_nodes_change->new_node(),
+                                    close_nodes_change->new_close_nodes())));
     LOG(kVerbose) << "MaidManager HandleChurnEvent transferring " << transfer_info.size()
                   << " accounts";
      for (const auto& transfer : transfer_info)
@@ -291,23 +300,22 @@ void MaidManagerService::HandleChurnEvent(
 void MaidManagerService::TransferAccount(const NodeId& destination,
                                          const std::vector<AccountType>& accounts) {
   assert(!accounts.empty());
-  protobuf::AccountTransfer account_transfer_proto;
-  {
-//    std::lock_guard<std::mutex> lock(mutex_);
-    for (auto& account : accounts) {
-      VLOG(nfs::Persona::kMaidManager, VisualiserAction::kAccountTransfer, account.first.value,
-        Identity{ destination.string() });
-      protobuf::MaidManagerKeyValuePair kv_pair;
-      kv_pair.set_key(account.first.value.string());
-      kv_pair.set_value(account.second.Serialise());
-      account_transfer_proto.add_serialised_accounts(kv_pair.SerializeAsString());
-      LOG(kVerbose) << "MaidManager send account " << DebugId(account.first.value)
-        << " to " << HexSubstr(destination.string())
-        << " with value " << account.second.Print();
-    }
+  for (auto& account : accounts) {
+    VLOG(nfs::Persona::kMaidManager, VisualiserAction::kAccountTransfer, account.first.value,
+      Identity{ destination.string() });
+    LOG(kVerbose) << "MaidManager send account " << DebugId(account.first.value)
+      << " to " << HexSubstr(destination.string())
+      << " with value " << account.second.Print();
   }
   LOG(kVerbose) << "MaidManagerService::TransferAccount send account transfer";
-  dispatcher_.SendAccountTransfer(destination, account_transfer_proto.SerializeAsString());
+  paged_account_transfer_.Transfer(destination, accounts);
+}
+
+std::string MaidManagerService::SerialiseAccount(const AccountType& account) {
+  protobuf::MaidManagerKeyValuePair kv_pair;
+  kv_pair.set_key(account.first.value.string());
+  kv_pair.set_value(account.second.Serialise());
+  return kv_pair.SerializeAsString();
 }
 
 template <>
@@ -316,13 +324,10 @@ void MaidManagerService::HandleMessage(
   const typename AccountTransferFromMaidManagerToMaidManager::Sender& sender,
   const typename AccountTransferFromMaidManagerToMaidManager::Receiver& /*receiver*/) {
   LOG(kInfo) << "MaidManager received account from " << DebugId(sender.sender_id);
-  protobuf::AccountTransfer account_transfer_proto;
-  if (!account_transfer_proto.ParseFromString(message.contents->data)) {
-    LOG(kError) << "Failed to parse account transfer ";
-  }
-  for (const auto& serialised_account : account_transfer_proto.serialised_accounts()) {
-    HandleAccountTransferEntry(serialised_account, sender);
-  }
+  paged_account_transfer_.Receive(sender.sender_id.data, message.contents->data,
+                                  [&](const std::string& serialised_account) {
+                                    HandleAccountTransferEntry(serialised_account, sender);
+                                  });
 }
 
 template <>
@@ -31,6 +31,7 @@
 #include "boost/mpl/insert_range.hpp"
 #include "boost/mpl/end.hpp"
 
+#include "maidsafe/common/asio_service.h"
 #include "maidsafe/common/error.h"
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/on_scope_exit.h"
@@ -47,6 +48,7 @@
 
 #include "maidsafe/vault/account_transfer_handler.h"
 #include "maidsafe/vault/accumulator.h"
+#include "maidsafe/vault/close_nodes_tracker.h"
 #include "maidsafe/vault/message_types.h"
 #include "maidsafe/vault/types.h"
 #include "maidsafe/vault/unresolved_action.h"
@@ -59,6 +61,7 @@
 #include "maidsafe/vault/maid_manager/value.h"
 #include "maidsafe/vault/maid_manager/maid_manager.pb.h"
 #include "maidsafe/vault/operation_visitors.h"
+#include "maidsafe/vault/paged_account_transfer.h"
 #include "maidsafe/vault/sync.h"
 #include "maidsafe/vault/account_transfer.pb.h"
 
@@ -85,9 +88,10 @@ class MaidManagerService {
   using AccountType = MaidManager::AccountType;
   using TransferInfo = MaidManager::TransferInfo;
 
+  // 'asio_service' runs the paged account transfers' timer.
   MaidManagerService(const passport::Pmid& pmid, routing::Routing& routing,
                      nfs_client::DataGetter& data_getter,
-                     const boost::filesystem::path& vault_root_dir);
+                     const boost::filesystem::path& vault_root_dir, AsioService& asio_service);
 
   template <typename MessageType>
   void HandleMessage(const MessageType& message, const typename MessageType::Sender& sender,
@@ -172,7 +176,9 @@ class MaidManagerService {
                                    const StructuredDataVersions::VersionName& version,
                                    nfs::MessageId message_id);
 
+  // Sends the accounts in pages, paced by the receiver's acknowledgements.
   void TransferAccount(const NodeId& dest, const std::vector<AccountType>& accounts);
+  static std::string SerialiseAccount(const AccountType& account);
 
   // Only Maid and Anmaid can create account; for all others this is a no-op.
   typedef std::true_type AllowedAccountCreationType;
@@ -233,6 +239,7 @@ class MaidManagerService {
   routing::Routing& routing_;
   nfs_client::DataGetter& data_getter_;
   std::map<MaidManager::Key, MaidManager::Value> accounts_;
+  CloseNodesTracker close_nodes_tracker_;
   std::mutex accumulator_mutex_, mutex_;
   bool stopped_;
   NfsAccumulator nfs_accumulator_;
@@ -243,6 +250,7 @@ class MaidManagerService {
   Sync<MaidManager::UnresolvedPut> sync_puts_;
   Sync<MaidManager::UnresolvedDelete> sync_deletes_;
   AccountTransferHandler<MaidManager> account_transfer_;
+  PagedAccountTransfer<AccountType> paged_account_transfer_;
   std::mutex pending_account_mutex_;
   std::map<nfs::MessageId, MaidAccountCreationStatus> pending_account_map_;
 };
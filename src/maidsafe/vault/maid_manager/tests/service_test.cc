@@ -36,7 +36,8 @@ namespace test {
 class MaidManagerServiceTest : public testing::Test {
  public:
   MaidManagerServiceTest()
-      : anmaid_(),
+      : asio_service_(2),
+        anmaid_(),
         maid_(anmaid_),
         anpmid_(),
         pmid_(anpmid_),
@@ -46,8 +47,7 @@ class MaidManagerServiceTest : public testing::Test {
         vault_root_dir_(*kTestRoot_),
         routing_(pmid_),
         data_getter_(asio_service_, routing_),
-        maid_manager_service_(pmid_, routing_, data_getter_, vault_root_dir_),
-        asio_service_(2) {}
+        maid_manager_service_(pmid_, routing_, data_getter_, vault_root_dir_, asio_service_) {}
 
   NodeId MaidNodeId() { return NodeId(maid_.name()->string()); }
 
@@ -90,6 +90,8 @@ class MaidManagerServiceTest : public testing::Test {
   }
 
  protected:
+  // Used by data_getter_ and maid_manager_service_, so constructed first.
+  AsioService asio_service_;
   passport::Anmaid anmaid_;
   passport::Maid maid_;
   passport::Anpmid anpmid_;
@@ -101,7 +103,6 @@ class MaidManagerServiceTest : public testing::Test {
   routing::Routing routing_;
   nfs_client::DataGetter data_getter_;
   MaidManagerService maid_manager_service_;
-  AsioService asio_service_;
 };
 
 template <typename UnresolvedActionType>
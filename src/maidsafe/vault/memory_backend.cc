@@ -0,0 +1,110 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/memory_backend.h"
+
+#include <utility>
+
+namespace maidsafe {
+
+namespace vault {
+
+class MemoryBackend::MemorySnapshot : public KeyValueBackend::Snapshot {
+ public:
+  explicit MemorySnapshot(std::shared_ptr<const Entries> entries) : entries_(std::move(entries)) {}
+
+  bool Get(const std::string& key, std::string& value) override {
+    auto itr(entries_->find(key));
+    if (itr == entries_->end())
+      return false;
+    value = itr->second;
+    return true;
+  }
+
+  void Scan(const std::string& begin, const std::string& end,
+            const ScanFunctor& functor) override {
+    ScanEntries(*entries_, begin, end, functor);
+  }
+
+ private:
+  const std::shared_ptr<const Entries> entries_;
+};
+
+MemoryBackend::MemoryBackend() : mutex_(), entries_(std::make_shared<Entries>()) {}
+
+bool MemoryBackend::Get(const std::string& key, std::string& value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(entries_->find(key));
+  if (itr == entries_->end())
+    return false;
+  value = itr->second;
+  return true;
+}
+
+void MemoryBackend::Put(const std::string& key, const std::string& value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  MutableEntries()[key] = value;
+}
+
+void MemoryBackend::Delete(const std::string& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  MutableEntries().erase(key);
+}
+
+void MemoryBackend::Scan(const std::string& begin, const std::string& end,
+                         const ScanFunctor& functor) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ScanEntries(*entries_, begin, end, functor);
+}
+
+void MemoryBackend::Write(const WriteBatch& batch) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entries& entries(MutableEntries());
+  for (const auto& write : batch) {
+    if (write.second)
+      entries[write.first] = *write.second;
+    else
+      entries.erase(write.first);
+  }
+}
+
+std::unique_ptr<KeyValueBackend::Snapshot> MemoryBackend::GetSnapshot() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return std::unique_ptr<Snapshot>(new MemorySnapshot(entries_));
+}
+
+void MemoryBackend::ScanEntries(const Entries& entries, const std::string& begin,
+                                const std::string& end, const ScanFunctor& functor) {
+  if (!end.empty() && end <= begin)
+    return;
+  auto last(end.empty() ? entries.end() : entries.lower_bound(end));
+  for (auto itr(entries.lower_bound(begin)); itr != last; ++itr) {
+    if (!functor(itr->first, itr->second))
+      return;
+  }
+}
+
+MemoryBackend::Entries& MemoryBackend::MutableEntries() {
+  if (entries_.use_count() != 1)
+    entries_ = std::make_shared<Entries>(*entries_);
+  return *entries_;
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
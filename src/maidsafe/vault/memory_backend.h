@@ -0,0 +1,69 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MEMORY_BACKEND_H_
+#define MAIDSAFE_VAULT_MEMORY_BACKEND_H_
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "maidsafe/vault/key_value_backend.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+// Holds the entries in memory only, for tests and benchmarks.  A snapshot shares the entries until
+// the next write, which copies them.
+class MemoryBackend : public KeyValueBackend {
+ public:
+  MemoryBackend();
+  MemoryBackend(const MemoryBackend&) = delete;
+  MemoryBackend& operator=(const MemoryBackend&) = delete;
+
+  bool Get(const std::string& key, std::string& value) override;
+  void Put(const std::string& key, const std::string& value) override;
+  void Delete(const std::string& key) override;
+  void Scan(const std::string& begin, const std::string& end,
+            const ScanFunctor& functor) override;
+  void Write(const WriteBatch& batch) override;
+  std::unique_ptr<Snapshot> GetSnapshot() override;
+  void SetGroupCommitWindow(std::chrono::milliseconds /*max_delay*/,
+                            int /*max_writes*/) override {}
+
+ private:
+  typedef std::map<std::string, std::string> Entries;
+  class MemorySnapshot;
+
+  static void ScanEntries(const Entries& entries, const std::string& begin, const std::string& end,
+                          const ScanFunctor& functor);
+  // Requires mutex_ to be held.
+  Entries& MutableEntries();
+
+  std::mutex mutex_;
+  std::shared_ptr<Entries> entries_;
+};
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MEMORY_BACKEND_H_
@@ -0,0 +1,122 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/memory_cache.h"
+
+#include <string>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+namespace {
+
+// Unlike GetIdentityVisitor, doesn't copy the identity.
+struct IdentityAddressVisitor : public boost::static_visitor<const Identity*> {
+  template <typename Name>
+  result_type operator()(const Name& name) const {
+    return &name.value;
+  }
+};
+
+}  // unnamed namespace
+
+size_t DataNameVariantHash::operator()(const DataNameVariant& name) const {
+  // The variant's type index stands in for the tag.
+  return std::hash<std::string>()(boost::apply_visitor(IdentityAddressVisitor(), name)->string()) ^
+         static_cast<size_t>(name.which());
+}
+
+}  // namespace detail
+
+MemoryCache::MemoryCache(MemoryUsage max_memory_usage)
+    : kMaxMemoryUsage_(max_memory_usage.data),
+      current_memory_usage_(0),
+      entries_(),
+      index_(),
+      mutex_() {}
+
+void MemoryCache::Store(const KeyType& key, const NonEmptyString& value) {
+  Store(key, ChunkBuffer(value));
+}
+
+void MemoryCache::Store(const KeyType& key, const ChunkBuffer& value) {
+  if (value.size() > kMaxMemoryUsage_) {
+    LOG(kWarning) << "Not caching "
+                  << HexSubstr(boost::apply_visitor(GetIdentityVisitor(), key).string())
+                  << " of " << value.size() << " bytes, which exceeds the capacity of "
+                  << kMaxMemoryUsage_ << " bytes.";
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(index_.find(key));
+  if (itr != index_.end())
+    EraseEntry(itr->second);
+  while (current_memory_usage_ + value.size() > kMaxMemoryUsage_)
+    EraseEntry(std::prev(entries_.end()));
+  entries_.push_front(std::make_pair(key, value));
+  index_.insert(std::make_pair(key, entries_.begin()));
+  current_memory_usage_ += value.size();
+}
+
+NonEmptyString MemoryCache::Get(const KeyType& key) { return GetBuffer(key).value(); }
+
+ChunkBuffer MemoryCache::GetBuffer(const KeyType& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(index_.find(key));
+  if (itr == index_.end())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+  entries_.splice(entries_.begin(), entries_, itr->second);
+  return itr->second->second;
+}
+
+void MemoryCache::Delete(const KeyType& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(index_.find(key));
+  if (itr == index_.end())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+  EraseEntry(itr->second);
+}
+
+MemoryUsage MemoryCache::GetMaxMemoryUsage() const { return MemoryUsage(kMaxMemoryUsage_); }
+
+MemoryUsage MemoryCache::GetCurrentMemoryUsage() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return MemoryUsage(current_memory_usage_);
+}
+
+size_t MemoryCache::Size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return index_.size();
+}
+
+void MemoryCache::EraseEntry(EntryList::iterator itr) {
+  current_memory_usage_ -= itr->second.size();
+  index_.erase(itr->first);
+  entries_.erase(itr);
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
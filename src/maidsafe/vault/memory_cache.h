@@ -0,0 +1,88 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_MEMORY_CACHE_H_
+#define MAIDSAFE_VAULT_MEMORY_CACHE_H_
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/data_types/data_name_variant.h"
+
+#include "maidsafe/vault/chunk_buffer.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Hashes a data name by its tag and identity, for unordered containers keyed by DataNameVariant.
+struct DataNameVariantHash {
+  size_t operator()(const DataNameVariant& name) const;
+};
+
+}  // namespace detail
+
+// In-memory chunk cache bounded by the total size of the values held.  Lookups are O(1) through a
+// hash index, and the least recently stored or retrieved entries are evicted to make room.  The
+// interface matches MemoryFIFO's, but the capacity is in bytes rather than elements.
+class MemoryCache {
+ public:
+  typedef DataNameVariant KeyType;
+
+  explicit MemoryCache(MemoryUsage max_memory_usage);
+  MemoryCache(const MemoryCache&) = delete;
+  MemoryCache& operator=(const MemoryCache&) = delete;
+  ~MemoryCache() = default;
+
+  // A value larger than the whole capacity isn't stored (and replaces no existing value).
+  void Store(const KeyType& key, const NonEmptyString& value);
+  void Store(const KeyType& key, const ChunkBuffer& value);
+  // Throw no_such_element if 'key' isn't held.
+  NonEmptyString Get(const KeyType& key);
+  ChunkBuffer GetBuffer(const KeyType& key);
+  void Delete(const KeyType& key);
+
+  MemoryUsage GetMaxMemoryUsage() const;
+  MemoryUsage GetCurrentMemoryUsage() const;
+  size_t Size() const;
+
+ private:
+  typedef std::list<std::pair<KeyType, ChunkBuffer>> EntryList;
+
+  void EraseEntry(EntryList::iterator itr);
+
+  const uint64_t kMaxMemoryUsage_;
+  uint64_t current_memory_usage_;
+  // Most recently used first.
+  EntryList entries_;
+  std::unordered_map<KeyType, EntryList::iterator, detail::DataNameVariantHash> index_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_MEMORY_CACHE_H_
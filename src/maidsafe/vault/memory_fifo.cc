@@ -26,6 +26,10 @@ MemoryFIFO::MemoryFIFO(MemoryUsage max_memory_usage)
     : memory_fifo_(static_cast<uint32_t>(max_memory_usage.data)), mutex_() {}
 
 void MemoryFIFO::Store(const KeyType& key, const NonEmptyString& value) {
+  Store(key, ChunkBuffer(value));
+}
+
+void MemoryFIFO::Store(const KeyType& key, const ChunkBuffer& value) {
   std::lock_guard<std::mutex> lock(mutex_);
   auto itr(Find(key));
   if (itr != memory_fifo_.end())
@@ -33,12 +37,14 @@ void MemoryFIFO::Store(const KeyType& key, const NonEmptyString& value) {
   memory_fifo_.push_back(std::make_pair(key, value));
 }
 
-NonEmptyString MemoryFIFO::Get(const KeyType& key) {
+NonEmptyString MemoryFIFO::Get(const KeyType& key) { return GetBuffer(key).value(); }
+
+ChunkBuffer MemoryFIFO::GetBuffer(const KeyType& key) {
   std::lock_guard<std::mutex> lock(mutex_);
   auto itr(Find(key));
   if (itr == std::end(memory_fifo_))
     BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
-  auto result = *itr;
+  auto result(std::move(*itr));
   memory_fifo_.erase(itr);
   memory_fifo_.push_back(result);  // last out
   return result.second;
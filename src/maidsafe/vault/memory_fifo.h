@@ -28,6 +28,8 @@
 #include "maidsafe/common/types.h"
 #include "maidsafe/common/data_types/data_name_variant.h"
 
+#include "maidsafe/vault/chunk_buffer.h"
+
 namespace maidsafe {
 
 namespace vault {
@@ -38,10 +40,12 @@ class MemoryFIFOTest;
 
 }  // namespace test
 
+// Values are held as ChunkBuffers, so storing a buffer or retrieving one through GetBuffer shares
+// the content instead of copying it.
 class MemoryFIFO {
  public:
   typedef DataNameVariant KeyType;
-  typedef boost::circular_buffer<std::pair<KeyType, NonEmptyString>> MemoryFIFOType;
+  typedef boost::circular_buffer<std::pair<KeyType, ChunkBuffer>> MemoryFIFOType;
 
   explicit MemoryFIFO(MemoryUsage max_memory_usage);
   MemoryFIFO(const MemoryFIFO&) = delete;
@@ -49,7 +53,9 @@ class MemoryFIFO {
   ~MemoryFIFO() = default;
 
   void Store(const KeyType& key, const NonEmptyString& value);
+  void Store(const KeyType& key, const ChunkBuffer& value);
   NonEmptyString Get(const KeyType& key);
+  ChunkBuffer GetBuffer(const KeyType& key);
   void Delete(const KeyType& key);
 
  private:
@@ -27,6 +27,7 @@
 #include "maidsafe/common/node_id.h"
 #include "maidsafe/nfs/types.h"
 
+#include "maidsafe/vault/chunk_buffer.h"
 #include "maidsafe/vault/types.h"
 #include "maidsafe/vault/utils.h"
 #include "maidsafe/vault/key.h"
@@ -95,20 +96,20 @@ template <typename ServiceHandlerType>
 class DataManagerSendPutRequestVisitor : public boost::static_visitor<> {
  public:
   DataManagerSendPutRequestVisitor(ServiceHandlerType* const service, const PmidName& pmid_name,
-                                   const NonEmptyString& data, nfs::MessageId message_id)
+                                   const ChunkBuffer& data, nfs::MessageId message_id)
       : kService_(service), kPmidName_(pmid_name), kData_(data), kMessageId_(message_id) {}
 
   template<typename DataName>
   void operator()(const DataName& name) {
     using Data = typename DataName::data_type;
     kService_->template HandleSendPutRequest<Data>(
-        kPmidName_, Data(name, typename Data::serialised_type(kData_)), kMessageId_);
+        kPmidName_, Data(name, typename Data::serialised_type(kData_.value())), kMessageId_);
   }
 
  private:
   ServiceHandlerType* const kService_;
   const PmidName kPmidName_;
-  const NonEmptyString kData_;
+  const ChunkBuffer kData_;
   const nfs::MessageId kMessageId_;
 };
 
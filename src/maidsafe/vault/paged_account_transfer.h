@@ -0,0 +1,465 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_PAGED_ACCOUNT_TRANSFER_H_
+#define MAIDSAFE_VAULT_PAGED_ACCOUNT_TRANSFER_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/optional.hpp"
+#include "boost/asio/io_service.hpp"
+#include "boost/asio/steady_timer.hpp"
+#include "boost/system/error_code.hpp"
+
+#include "maidsafe/common/clock.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/vault/parameters.h"
+#include "maidsafe/vault/account_transfer.pb.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+// Sends the accounts transferred to a peer as a stream of pages, and receives such streams.  Each
+// page is acknowledged by its receiver, and a sender keeps at most
+// Parameters::account_transfer_window pages unacknowledged, so is paced by its receiver and never
+// has more than that many serialised at once.  A transfer to a peer waits for any earlier one to
+// it to finish.  A timer on the given io_service resends the unacknowledged pages of a transfer
+// which has made no progress for Parameters::account_transfer_page_timeout, and abandons it after
+// Parameters::account_transfer_page_retries resends.
+template <typename Account>
+class PagedAccountTransfer {
+ public:
+  typedef std::function<std::string(const Account& account)> SerialiseFunctor;
+  typedef std::function<void(const NodeId& peer, const std::string& serialised_transfer)>
+      SendFunctor;
+  typedef std::function<void(const std::string& serialised_account)> IngestFunctor;
+
+  // 'send' is called without the internal lock held, on the caller's thread or, for resends, on
+  // one of 'io_service''s.
+  PagedAccountTransfer(boost::asio::io_service& io_service, SerialiseFunctor serialise,
+                       SendFunctor send);
+  // Waits for a running resend to finish; none are sent once this returns.
+  ~PagedAccountTransfer();
+
+  void Transfer(const NodeId& destination, std::vector<Account> accounts);
+  // Handles a serialised protobuf::AccountTransfer from 'sender', passing each account it brings
+  // to 'ingest', which is called without the internal lock held.  A page is acknowledged once its
+  // accounts are ingested, or at once if it has been received before.  If 'ingest' throws, the
+  // page isn't acknowledged, so is resent.  An acknowledgement lets further pages to 'sender' be
+  // sent.  The accounts of a transfer sent whole are ingested with nothing acknowledged.
+  void Receive(const NodeId& sender, const std::string& serialised_transfer,
+               const IngestFunctor& ingest);
+
+  // The number of transfers queued or in progress to all destinations.
+  size_t OutgoingCount() const;
+
+  PagedAccountTransfer(const PagedAccountTransfer&) = delete;
+  PagedAccountTransfer& operator=(const PagedAccountTransfer&) = delete;
+  PagedAccountTransfer(PagedAccountTransfer&&) = delete;
+  PagedAccountTransfer& operator=(PagedAccountTransfer&&) = delete;
+
+ private:
+  typedef std::vector<std::pair<NodeId, std::string>> Messages;
+
+  // Outlives the object while the timer's handler is pending, so the handler can tell whether the
+  // object has been destroyed.
+  struct TimerState {
+    TimerState() : mutex(), stopped(false) {}
+    std::mutex mutex;
+    bool stopped;
+  };
+
+  struct Outgoing {
+    explicit Outgoing(uint64_t transfer_id_in)
+        : transfer_id(transfer_id_in), accounts(), next_account(0), next_sequence(0),
+          unacknowledged(), last_progress(common::Clock::now()), resends(0) {}
+    uint64_t transfer_id;
+    std::vector<Account> accounts;
+    // The first account not yet sent, and the sequence number of the page to start with it.
+    size_t next_account;
+    uint32_t next_sequence;
+    // The accounts [first, second) of each page sent but not yet acknowledged.
+    std::map<uint32_t, std::pair<size_t, size_t>> unacknowledged;
+    common::Clock::time_point last_progress;
+    int resends;
+  };
+
+  struct Incoming {
+    Incoming()
+        : next_sequence(0), received(), last_sequence(), update_time(common::Clock::now()) {}
+    // All pages before this one have been received, as have those in 'received'.
+    uint32_t next_sequence;
+    std::set<uint32_t> received;
+    boost::optional<uint32_t> last_sequence;
+    common::Clock::time_point update_time;
+  };
+
+  // These require mutex_ to be held.
+  void SendPages(const NodeId& destination, Outgoing& transfer, Messages& messages);
+  void ResendPage(const NodeId& destination, const Outgoing& transfer, uint32_t sequence_number,
+                  Messages& messages);
+  // Completes the page's header and queues it.
+  void SendPage(const NodeId& destination, const Outgoing& transfer, uint32_t sequence_number,
+                protobuf::AccountTransfer& proto, Messages& messages);
+  void HandleAcknowledgement(const NodeId& sender, const protobuf::AccountTransfer& proto,
+                             Messages& messages);
+  bool PageReceived(const NodeId& sender, const protobuf::AccountTransfer& proto) const;
+  void RecordPage(const NodeId& sender, const protobuf::AccountTransfer& proto);
+  // Moves on to the next transfer to 'destination' if the current one is done.
+  void Advance(const NodeId& destination, Messages& messages);
+  void ResendStalled(Messages& messages);
+  void PruneIncoming();
+  // Arms the timer for the earliest time a transfer could stall, unless it's already armed or
+  // there's nothing outgoing.
+  void ScheduleResendCheck();
+
+  // Invoked by the timer, with its state's mutex held.
+  void CheckStalled();
+
+  void Send(const Messages& messages) const;
+
+  const SerialiseFunctor kSerialise_;
+  const SendFunctor kSend_;
+  uint64_t next_transfer_id_;
+  // Only the front transfer to each destination is in progress.
+  std::map<NodeId, std::deque<Outgoing>> outgoing_;
+  // Completed transfers are remembered until Parameters::account_transfer_life has passed, so that
+  // resent pages are recognised.
+  std::map<std::pair<NodeId, uint64_t>, Incoming> incoming_;
+  mutable std::mutex mutex_;
+  // Guarded by mutex_, except in the destructor.
+  boost::asio::steady_timer timer_;
+  bool timer_armed_;
+  std::shared_ptr<TimerState> timer_state_;
+};
+
+// ==================== Implementation =============================================================
+
+template <typename Account>
+PagedAccountTransfer<Account>::PagedAccountTransfer(boost::asio::io_service& io_service,
+                                                    SerialiseFunctor serialise, SendFunctor send)
+    : kSerialise_(serialise),
+      kSend_(send),
+      next_transfer_id_((static_cast<uint64_t>(RandomUint32()) << 32) | RandomUint32()),
+      outgoing_(),
+      incoming_(),
+      mutex_(),
+      timer_(io_service),
+      timer_armed_(false),
+      timer_state_(std::make_shared<TimerState>()) {}
+
+template <typename Account>
+PagedAccountTransfer<Account>::~PagedAccountTransfer() {
+  std::lock_guard<std::mutex> state_lock(timer_state_->mutex);
+  timer_state_->stopped = true;
+  std::lock_guard<std::mutex> lock(mutex_);
+  boost::system::error_code error;
+  timer_.cancel(error);
+}
+
+template <typename Account>
+void PagedAccountTransfer<Account>::Transfer(const NodeId& destination,
+                                             std::vector<Account> accounts) {
+  if (accounts.empty())
+    return;
+  Messages messages;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::deque<Outgoing>& queue(outgoing_[destination]);
+    queue.push_back(Outgoing(next_transfer_id_++));
+    queue.back().accounts.swap(accounts);
+    if (queue.size() == 1)
+      SendPages(destination, queue.front(), messages);
+    else
+      LOG(kVerbose) << "Queued account transfer to " << DebugId(destination) << " behind "
+                    << queue.size() - 1 << " others";
+    ScheduleResendCheck();
+  }
+  Send(messages);
+}
+
+template <typename Account>
+void PagedAccountTransfer<Account>::Receive(const NodeId& sender,
+                                            const std::string& serialised_transfer,
+                                            const IngestFunctor& ingest) {
+  protobuf::AccountTransfer proto;
+  if (!proto.ParseFromString(serialised_transfer)) {
+    LOG(kError) << "Failed to parse account transfer from " << DebugId(sender);
+    return;
+  }
+  if (!proto.has_transfer_id()) {
+    for (const auto& serialised_account : proto.serialised_accounts())
+      ingest(serialised_account);
+    return;
+  }
+
+  Messages messages;
+  bool received(false);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (proto.acknowledgement())
+      HandleAcknowledgement(sender, proto, messages);
+    else
+      received = PageReceived(sender, proto);
+  }
+  Send(messages);
+  if (proto.acknowledgement())
+    return;
+
+  if (received) {
+    LOG(kVerbose) << "Already received page " << proto.sequence_number()
+                  << " of account transfer " << proto.transfer_id() << " from "
+                  << DebugId(sender);
+  } else {
+    for (const auto& serialised_account : proto.serialised_accounts())
+      ingest(serialised_account);
+    std::lock_guard<std::mutex> lock(mutex_);
+    RecordPage(sender, proto);
+  }
+  protobuf::AccountTransfer acknowledgement;
+  acknowledgement.set_transfer_id(proto.transfer_id());
+  acknowledgement.set_sequence_number(proto.sequence_number());
+  acknowledgement.set_acknowledgement(true);
+  kSend_(sender, acknowledgement.SerializeAsString());
+}
+
+template <typename Account>
+size_t PagedAccountTransfer<Account>::OutgoingCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t count(0);
+  for (const auto& queue : outgoing_)
+    count += queue.second.size();
+  return count;
+}
+
+template <typename Account>
+void PagedAccountTransfer<Account>::SendPages(const NodeId& destination, Outgoing& transfer,
+                                              Messages& messages) {
+  // The account which didn't fit on the last page, if any.
+  std::string serialised_account;
+  while (transfer.next_account < transfer.accounts.size() &&
+         transfer.unacknowledged.size() < detail::Parameters::account_transfer_window) {
+    // Takes accounts while they fit, but always at least one.
+    protobuf::AccountTransfer proto;
+    size_t begin(transfer.next_account), end(begin), page_size(0);
+    while (end < transfer.accounts.size()) {
+      if (serialised_account.empty())
+        serialised_account = kSerialise_(transfer.accounts[end]);
+      if (end != begin &&
+          page_size + serialised_account.size() > detail::Parameters::account_transfer_page_size)
+        break;
+      page_size += serialised_account.size();
+      proto.add_serialised_accounts()->swap(serialised_account);
+      serialised_account.clear();
+      ++end;
+    }
+    uint32_t sequence_number(transfer.next_sequence++);
+    transfer.unacknowledged.insert(std::make_pair(sequence_number, std::make_pair(begin, end)));
+    transfer.next_account = end;
+    SendPage(destination, transfer, sequence_number, proto, messages);
+  }
+}
+
+template <typename Account>
+void PagedAccountTransfer<Account>::ResendPage(const NodeId& destination,
+                                               const Outgoing& transfer,
+                                               uint32_t sequence_number, Messages& messages) {
+  const std::pair<size_t, size_t>& range(transfer.unacknowledged.at(sequence_number));
+  protobuf::AccountTransfer proto;
+  for (size_t index(range.first); index != range.second; ++index)
+    proto.add_serialised_accounts(kSerialise_(transfer.accounts[index]));
+  SendPage(destination, transfer, sequence_number, proto, messages);
+}
+
+template <typename Account>
+void PagedAccountTransfer<Account>::SendPage(const NodeId& destination, const Outgoing& transfer,
+                                             uint32_t sequence_number,
+                                             protobuf::AccountTransfer& proto,
+                                             Messages& messages) {
+  proto.set_transfer_id(transfer.transfer_id);
+  proto.set_sequence_number(sequence_number);
+  if (transfer.unacknowledged.at(sequence_number).second == transfer.accounts.size())
+    proto.set_last_page(true);
+  LOG(kVerbose) << "Sending page " << sequence_number << " of account transfer "
+                << transfer.transfer_id << " to " << DebugId(destination) << " holding "
+                << proto.serialised_accounts_size() << " accounts";
+  messages.push_back(std::make_pair(destination, proto.SerializeAsString()));
+}
+
+template <typename Account>
+void PagedAccountTransfer<Account>::HandleAcknowledgement(const NodeId& sender,
+                                                          const protobuf::AccountTransfer& proto,
+                                                          Messages& messages) {
+  auto queue(outgoing_.find(sender));
+  if (queue == outgoing_.end() || queue->second.front().transfer_id != proto.transfer_id()) {
+    LOG(kVerbose) << "Ignoring acknowledgement for account transfer " << proto.transfer_id()
+                  << " from " << DebugId(sender);
+    return;
+  }
+  Outgoing& transfer(queue->second.front());
+  if (transfer.unacknowledged.erase(proto.sequence_number()) == 0)
+    return;
+  transfer.last_progress = common::Clock::now();
+  transfer.resends = 0;
+  SendPages(sender, transfer, messages);
+  Advance(sender, messages);
+}
+
+template <typename Account>
+bool PagedAccountTransfer<Account>::PageReceived(const NodeId& sender,
+                                                 const protobuf::AccountTransfer& proto) const {
+  auto itr(incoming_.find(std::make_pair(sender, proto.transfer_id())));
+  return itr != incoming_.end() && (proto.sequence_number() < itr->second.next_sequence ||
+                                    itr->second.received.count(proto.sequence_number()) != 0);
+}
+
+template <typename Account>
+void PagedAccountTransfer<Account>::RecordPage(const NodeId& sender,
+                                               const protobuf::AccountTransfer& proto) {
+  PruneIncoming();
+  Incoming& incoming(incoming_[std::make_pair(sender, proto.transfer_id())]);
+  incoming.update_time = common::Clock::now();
+  if (proto.last_page())
+    incoming.last_sequence = proto.sequence_number();
+  if (proto.sequence_number() >= incoming.next_sequence)
+    incoming.received.insert(proto.sequence_number());
+  while (incoming.received.erase(incoming.next_sequence) != 0)
+    ++incoming.next_sequence;
+  if (incoming.last_sequence && incoming.next_sequence > *incoming.last_sequence) {
+    LOG(kVerbose) << "Received all " << incoming.next_sequence << " pages of account transfer "
+                  << proto.transfer_id() << " from " << DebugId(sender);
+  }
+}
+
+template <typename Account>
+void PagedAccountTransfer<Account>::Advance(const NodeId& destination, Messages& messages) {
+  auto queue(outgoing_.find(destination));
+  while (queue != outgoing_.end()) {
+    const Outgoing& transfer(queue->second.front());
+    if (transfer.next_account != transfer.accounts.size() || !transfer.unacknowledged.empty())
+      return;
+    LOG(kVerbose) << "Completed account transfer " << transfer.transfer_id << " to "
+                  << DebugId(destination);
+    queue->second.pop_front();
+    if (queue->second.empty()) {
+      outgoing_.erase(queue);
+      return;
+    }
+    queue->second.front().last_progress = common::Clock::now();
+    SendPages(destination, queue->second.front(), messages);
+  }
+}
+
+template <typename Account>
+void PagedAccountTransfer<Account>::ResendStalled(Messages& messages) {
+  auto now(common::Clock::now());
+  std::vector<NodeId> abandoned;
+  for (auto& queue : outgoing_) {
+    Outgoing& transfer(queue.second.front());
+    if (now - transfer.last_progress < detail::Parameters::account_transfer_page_timeout)
+      continue;
+    if (transfer.resends++ == detail::Parameters::account_transfer_page_retries) {
+      abandoned.push_back(queue.first);
+      continue;
+    }
+    transfer.last_progress = now;
+    for (const auto& page : transfer.unacknowledged)
+      ResendPage(queue.first, transfer, page.first, messages);
+  }
+  for (const auto& destination : abandoned) {
+    std::deque<Outgoing>& queue(outgoing_[destination]);
+    LOG(kWarning) << "Abandoning account transfer " << queue.front().transfer_id << " to "
+                  << DebugId(destination) << " after "
+                  << detail::Parameters::account_transfer_page_retries << " resends";
+    // Marks it done, so that Advance starts the next.
+    queue.front().next_account = queue.front().accounts.size();
+    queue.front().unacknowledged.clear();
+    Advance(destination, messages);
+  }
+}
+
+template <typename Account>
+void PagedAccountTransfer<Account>::PruneIncoming() {
+  auto now(common::Clock::now());
+  for (auto itr(incoming_.begin()); itr != incoming_.end();) {
+    if (now - itr->second.update_time > detail::Parameters::account_transfer_life)
+      itr = incoming_.erase(itr);
+    else
+      ++itr;
+  }
+}
+
+template <typename Account>
+void PagedAccountTransfer<Account>::ScheduleResendCheck() {
+  if (timer_armed_ || outgoing_.empty())
+    return;
+  auto last_progress(outgoing_.begin()->second.front().last_progress);
+  for (const auto& queue : outgoing_)
+    last_progress = std::min(last_progress, queue.second.front().last_progress);
+  auto deadline(last_progress + detail::Parameters::account_transfer_page_timeout);
+  timer_.expires_from_now(
+      std::chrono::duration_cast<std::chrono::milliseconds>(deadline - common::Clock::now()));
+  timer_armed_ = true;
+  std::shared_ptr<TimerState> state(timer_state_);
+  timer_.async_wait([this, state](const boost::system::error_code& error) {
+    if (error == boost::asio::error::operation_aborted)
+      return;
+    std::lock_guard<std::mutex> state_lock(state->mutex);
+    if (!state->stopped)
+      CheckStalled();
+  });
+}
+
+template <typename Account>
+void PagedAccountTransfer<Account>::CheckStalled() {
+  Messages messages;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timer_armed_ = false;
+    ResendStalled(messages);
+    ScheduleResendCheck();
+  }
+  Send(messages);
+}
+
+template <typename Account>
+void PagedAccountTransfer<Account>::Send(const Messages& messages) const {
+  for (const auto& message : messages)
+    kSend_(message.first, message.second);
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_PAGED_ACCOUNT_TRANSFER_H_
@@ -38,9 +38,28 @@ int Parameters::integrity_check_string_size(64);
 const std::chrono::milliseconds Parameters::kDefaultTimeout(10000);
 unsigned int Parameters::account_transfer_cleanup_factor(100);
 std::chrono::seconds Parameters::account_transfer_life(60);
-MemoryUsage Parameters::temp_store_size(100);
+size_t Parameters::account_transfer_page_size(64 * 1024);
+unsigned int Parameters::account_transfer_window(4);
+std::chrono::milliseconds Parameters::account_transfer_page_timeout(10000);
+int Parameters::account_transfer_page_retries(3);
+MemoryUsage Parameters::temp_store_size(100 * 1024 * 1024);
 unsigned int Parameters::max_replication_factor(routing::Parameters::closest_nodes_size / 2);
 unsigned int Parameters::min_replication_factor(routing::Parameters::group_size);
+unsigned int Parameters::chunk_store_io_thread_count(8);
+size_t Parameters::chunk_store_path_cache_size(10000);
+unsigned int Parameters::disk_cache_high_watermark(95);
+unsigned int Parameters::disk_cache_low_watermark(85);
+unsigned int Parameters::cache_memory_percentage(5);
+unsigned int Parameters::cache_disk_percentage(10);
+MemoryUsage Parameters::cache_store_queue_size(32 * 1024 * 1024);
+std::chrono::milliseconds Parameters::data_manager_group_commit_delay(0);
+int Parameters::data_manager_group_commit_size(256);
+size_t Parameters::data_manager_value_cache_size(10000);
+unsigned int Parameters::data_manager_transfer_scan_threads(0);
+KeyValueBackendType Parameters::metadata_backend(KeyValueBackendType::kSqlite);
+ChunkStoreLayout Parameters::chunk_store_layout(ChunkStoreLayout::kFilePerChunk);
+size_t Parameters::prune_batch_size(256);
+int Parameters::churn_full_scan_interval(16);
 
 }  // namespace detail
 
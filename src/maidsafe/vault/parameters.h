@@ -24,6 +24,8 @@
 
 #include "maidsafe/common/types.h"
 
+#include "maidsafe/vault/store_types.h"
+
 namespace maidsafe {
 
 namespace vault {
@@ -46,12 +48,55 @@ struct Parameters {
   static unsigned int account_transfer_cleanup_factor;
   // Removes entries which have been longer than below factor
   static std::chrono::seconds account_transfer_life;
-  // Maximum number of chunks stored in data manager temporary store
+  // Accounts are transferred in pages of at most this many bytes (or of one larger account), with
+  // at most the window of them awaiting acknowledgement by the receiver at a time
+  static size_t account_transfer_page_size;
+  static unsigned int account_transfer_window;
+  // Unacknowledged pages are resent once a transfer has made no progress for the timeout, and
+  // the transfer abandoned after this many resends without progress
+  static std::chrono::milliseconds account_transfer_page_timeout;
+  static int account_transfer_page_retries;
+  // Maximum total size in bytes of the chunks held in data manager temporary store
   static MemoryUsage temp_store_size;
   // Maximum number of pmids storing a chunk
   static unsigned int max_replication_factor;
   // Minimum required number of online pmids for a chunk
   static unsigned int min_replication_factor;
+  // Number of threads performing disk I/O for each asynchronous chunk store
+  static unsigned int chunk_store_io_thread_count;
+  // Maximum number of resolved chunk names and file paths cached by each chunk store
+  static size_t chunk_store_path_cache_size;
+  // A caching chunk store's background trimmer starts evicting once disk usage exceeds the high
+  // watermark, and stops once it's down to the low one (both percentages of the maximum usage)
+  static unsigned int disk_cache_high_watermark;
+  static unsigned int disk_cache_low_watermark;
+  // The cache handler's memory tier is sized as a percentage of the physical memory, and its disk
+  // tier as a percentage of the vault's maximum disk usage
+  static unsigned int cache_memory_percentage;
+  static unsigned int cache_disk_percentage;
+  // Maximum total size in bytes of the cacheable messages waiting to be stored in the cache
+  static MemoryUsage cache_store_queue_size;
+  // The data manager's account writes may be made durable together, once this many are pending or
+  // the oldest has waited for the delay.  The default delay of zero makes each durable on its own,
+  // before it's acknowledged; a window trades the last writes before a crash for throughput
+  static std::chrono::milliseconds data_manager_group_commit_delay;
+  static int data_manager_group_commit_size;
+  // Maximum number of decoded accounts cached by the data manager's database (zero disables it)
+  static size_t data_manager_value_cache_size;
+  // Number of threads, each reading its own snapshot, scanning the data manager's database for
+  // accounts to transfer after churn (zero for one per hardware thread)
+  static unsigned int data_manager_transfer_scan_threads;
+  // The store under the persona databases
+  static KeyValueBackendType metadata_backend;
+  // How a persistent ChunkStore lays its chunks out on disk.  Changing it doesn't migrate the
+  // chunks already stored under the other layout.
+  static ChunkStoreLayout chunk_store_layout;
+  // Maximum number of entries a persona database deletes at once when pruning accounts after
+  // churn, releasing it to other users between each such batch
+  static size_t prune_batch_size;
+  // The maid and pmid managers check only the accounts a churn event can affect, except on every
+  // this many events, when they check them all
+  static int churn_full_scan_interval;
 
  private:
   Parameters();
@@ -45,14 +45,20 @@ inline bool ForThisPersona(const Message& message) {
 
 }  // namespace detail
 
-PmidManagerService::PmidManagerService(const passport::Pmid& pmid, routing::Routing& routing)
-    : routing_(routing), accounts_(), accumulator_mutex_(), mutex_(),
+PmidManagerService::PmidManagerService(const passport::Pmid& pmid, routing::Routing& routing,
+                                       AsioService& vault_asio_service)
+    : routing_(routing), accounts_(), close_nodes_tracker_(NodeId(pmid.name()->string())),
+      accumulator_mutex_(), mutex_(),
       stopped_(false), accumulator_(), dispatcher_(routing_), asio_service_(2),
       get_health_timer_(asio_service_), sync_puts_(NodeId(pmid.name()->string())),
       sync_deletes_(NodeId(pmid.name()->string())),
       sync_create_account_(NodeId(pmid.name()->string())),
       sync_update_account_(NodeId(pmid.name()->string())),
-      account_transfer_() {
+      account_transfer_(),
+      paged_account_transfer_(vault_asio_service.service(), SerialiseAccount,
+                              [this](const NodeId& peer, const std::string& serialised_transfer) {
+                                dispatcher_.SendAccountTransfer(peer, serialised_transfer);
+                              }) {
 }
 
 void PmidManagerService::HandleSyncedPut(
@@ -319,7 +325,10 @@ void PmidManagerService::HandleChurnEvent(
     LOG(kVerbose) << "PmidManager HandleChurnEvent processing account transfer";
     const auto transfer_info(
         detail::GetTransferInfo<PmidManager::Key, PmidManager::Value, PmidManager::TransferInfo>(
-            close_nodes_change, accounts_));
+            close_nodes_change, accounts_,
+            close_nodes_tracker_.Update(close_nodes_change->lost_node(),
+                                        close_nodes_change->new_node(),
+                                        close_nodes_change->new_close_nodes())));
     LOG(kVerbose) << "PmidManager HandleChurnEvent transferring " << transfer_info.size()
                   << " accounts";
     for (auto& transfer : transfer_info)
@@ -354,24 +363,23 @@ void PmidManagerService::HandleChurnEvent(
 void PmidManagerService::TransferAccount(const NodeId& peer,
                                          const std::vector<PmidManager::KvPair>& accounts) {
   assert(!accounts.empty());
-  protobuf::AccountTransfer account_transfer_proto;
-  {
-//    std::lock_guard<std::mutex> lock(mutex_);
-    for (auto& account : accounts) {
-      VLOG(nfs::Persona::kPmidManager, VisualiserAction::kAccountTransfer,
-           account.first, Identity{ peer.string() });
-      protobuf::PmidManagerKeyValuePair kv_pair;
-      MetadataKey<PmidName> key(account.first);
-      kv_pair.set_key(key.Serialise());
-      kv_pair.set_value(account.second.Serialise());
-      account_transfer_proto.add_serialised_accounts(kv_pair.SerializeAsString());
-      LOG(kVerbose) << "PmidManager send account " << HexSubstr(account.first->string())
-                    << " to " << HexSubstr(peer.string())
-                    << " with value " << account.second.Print();
-    }
+  for (auto& account : accounts) {
+    VLOG(nfs::Persona::kPmidManager, VisualiserAction::kAccountTransfer,
+         account.first, Identity{ peer.string() });
+    LOG(kVerbose) << "PmidManager send account " << HexSubstr(account.first->string())
+                  << " to " << HexSubstr(peer.string())
+                  << " with value " << account.second.Print();
   }
   LOG(kVerbose) << "PmidManagerService::TransferAccount send account transfer";
-  dispatcher_.SendAccountTransfer(peer, account_transfer_proto.SerializeAsString());
+  paged_account_transfer_.Transfer(peer, accounts);
+}
+
+std::string PmidManagerService::SerialiseAccount(const AccountType& account) {
+  protobuf::PmidManagerKeyValuePair kv_pair;
+  MetadataKey<PmidName> key(account.first);
+  kv_pair.set_key(key.Serialise());
+  kv_pair.set_value(account.second.Serialise());
+  return kv_pair.SerializeAsString();
 }
 
 template <>
@@ -380,12 +388,10 @@ void PmidManagerService::HandleMessage(
     const typename AccountTransferFromPmidManagerToPmidManager::Sender& sender,
     const typename AccountTransferFromPmidManagerToPmidManager::Receiver& /*receiver*/) {
   LOG(kInfo) << "PmidManager received account from " << sender.data;
-  protobuf::AccountTransfer account_transfer_proto;
-  if (!account_transfer_proto.ParseFromString(message.contents->data)) {
-    LOG(kError) << "Failed to parse account transfer ";
-  }
-  for (const auto& serialised_account : account_transfer_proto.serialised_accounts())
-    HandleAccountTransferEntry(serialised_account, sender);
+  paged_account_transfer_.Receive(sender.data, message.contents->data,
+                                  [&](const std::string& serialised_account) {
+                                    HandleAccountTransferEntry(serialised_account, sender);
+                                  });
 }
 
 void PmidManagerService::HandleAccountTransfer(const AccountType& account) {
@@ -27,6 +27,7 @@
 
 #include "boost/filesystem/path.hpp"
 
+#include "maidsafe/common/asio_service.h"
 #include "maidsafe/common/rsa.h"
 #include "maidsafe/passport/types.h"
 #include "maidsafe/routing/routing_api.h"
@@ -36,6 +37,7 @@
 
 #include "maidsafe/vault/account_transfer_handler.h"
 #include "maidsafe/vault/accumulator.h"
+#include "maidsafe/vault/close_nodes_tracker.h"
 #include "maidsafe/vault/message_types.h"
 #include "maidsafe/vault/types.h"
 #include "maidsafe/vault/pmid_manager/action_delete.h"
@@ -44,6 +46,7 @@
 #include "maidsafe/vault/pmid_manager/pmid_manager.h"
 #include "maidsafe/vault/pmid_manager/value.h"
 #include "maidsafe/vault/operation_visitors.h"
+#include "maidsafe/vault/paged_account_transfer.h"
 
 namespace maidsafe {
 namespace vault {
@@ -62,7 +65,9 @@ class PmidManagerService {
   using HandleMessageReturnType = void;
   using AccountType = PmidManager::KvPair;
 
-  PmidManagerService(const passport::Pmid& pmid, routing::Routing& routing);
+  // 'vault_asio_service' runs the paged account transfers' timer.
+  PmidManagerService(const passport::Pmid& pmid, routing::Routing& routing,
+                     AsioService& vault_asio_service);
 
   template <typename MessageType>
   void HandleMessage(const MessageType& message, const typename MessageType::Sender& sender,
@@ -134,7 +139,9 @@ class PmidManagerService {
       std::unique_ptr<PmidManager::UnresolvedCreateAccount>&& synced_action);
   void HandleSyncedUpdateAccount(
       std::unique_ptr<PmidManager::UnresolvedUpdateAccount>&& synced_action);
+  // Sends the accounts in pages, paced by the receiver's acknowledgements.
   void TransferAccount(const NodeId& dest, const std::vector<PmidManager::KvPair>& accounts);
+  static std::string SerialiseAccount(const AccountType& account);
   void HandleAccountTransfer(const AccountType& account);
   void HandleAccountTransferEntry(const std::string& serialised_account,
                                   const routing::SingleSource& sender);
@@ -143,6 +150,7 @@ class PmidManagerService {
 
   routing::Routing& routing_;
   std::map<PmidManager::Key, PmidManager::Value> accounts_;
+  CloseNodesTracker close_nodes_tracker_;
   std::mutex accumulator_mutex_, mutex_;
   bool stopped_;
   Accumulator<Messages> accumulator_;
@@ -154,6 +162,7 @@ class PmidManagerService {
   Sync<PmidManager::UnresolvedCreateAccount> sync_create_account_;
   Sync<PmidManager::UnresolvedUpdateAccount> sync_update_account_;
   AccountTransferHandler<nfs::PersonaTypes<nfs::Persona::kPmidManager>> account_transfer_;
+  PagedAccountTransfer<AccountType> paged_account_transfer_;
 };
 
 // ============================= Handle Message Specialisations ===================================
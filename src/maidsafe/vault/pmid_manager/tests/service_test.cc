@@ -34,11 +34,12 @@ namespace test {
 class PmidManagerServiceTest : public testing::Test {
  public:
   PmidManagerServiceTest()
-      : pmid_(passport::CreatePmidAndSigner().first),
+      : asio_service_(2),
+        pmid_(passport::CreatePmidAndSigner().first),
         kTestRoot_(maidsafe::test::CreateTestPath("MaidSafe_Test_Vault")),
         vault_root_dir_(*kTestRoot_),
         routing_(pmid_),
-        pmid_manager_service_(pmid_, routing_) {}
+        pmid_manager_service_(pmid_, routing_, asio_service_) {}
 
   template <typename UnresolvedActionType>
   std::vector<std::unique_ptr<UnresolvedActionType>> GetUnresolvedActions();
@@ -62,6 +63,7 @@ class PmidManagerServiceTest : public testing::Test {
                 const std::vector<routing::GroupSource>& group_source);
 
  protected:
+  AsioService asio_service_;
   passport::Pmid pmid_;
   const maidsafe::test::TestPath kTestRoot_;
   boost::filesystem::path vault_root_dir_;
@@ -19,13 +19,16 @@
 #ifndef MAIDSAFE_VAULT_PMID_NODE_HANDLER_H_
 #define MAIDSAFE_VAULT_PMID_NODE_HANDLER_H_
 
+#include <exception>
+#include <functional>
+#include <future>
 #include <string>
 #include <vector>
 #include "boost/filesystem.hpp"
 
 #include "maidsafe/common/visualiser_log.h"
 #include "maidsafe/vault/memory_fifo.h"
-#include "maidsafe/vault/chunk_store.h"
+#include "maidsafe/vault/async_chunk_store.h"
 #include "maidsafe/common/data_types/data_name_variant.h"
 #include "maidsafe/nfs/types.h"
 #include "maidsafe/vault/types.h"
@@ -44,6 +47,14 @@ class PmidNodeHandler {
   template <typename Data>
   void Put(const Data& data);
 
+  // Asynchronous variants, performed on the chunk store's I/O threads.  'functor' is invoked on
+  // one of those threads with a ready future, whose get() rethrows any error.
+  template <typename Data>
+  void Get(const typename Data::Name& data_name, std::function<void(std::future<Data>)> functor);
+
+  template <typename Data>
+  void Put(const Data& data, AsyncChunkStore::PutFunctor functor);
+
   template <typename DataName>
   void Delete(const DataName& data_name);
 
@@ -55,27 +66,49 @@ class PmidNodeHandler {
   boost::filesystem::space_info space_info_;
   DiskUsage disk_total_;
   DiskUsage permanent_size_;
-  ChunkStore chunk_store_;
+  AsyncChunkStore chunk_store_;
 };
 
 template <typename Data>
 Data PmidNodeHandler::Get(const typename Data::Name& data_name) {
   DataNameVariant data_name_variant(data_name);
-  Data data(data_name,
-            typename Data::serialised_type(chunk_store_.Get(data_name_variant)));
+  auto content(chunk_store_.GetBuffer(data_name_variant).get());
+  Data data(data_name, typename Data::serialised_type(content.value()));
   return data;
 }
 
+template <typename Data>
+void PmidNodeHandler::Get(const typename Data::Name& data_name,
+                          std::function<void(std::future<Data>)> functor) {
+  chunk_store_.GetBuffer(DataNameVariant(data_name),
+                         [data_name, functor](std::future<ChunkBuffer> content) {
+    std::promise<Data> promise;
+    try {
+      promise.set_value(Data(data_name, typename Data::serialised_type(content.get().value())));
+    }
+    catch (...) {
+      promise.set_exception(std::current_exception());
+    }
+    functor(promise.get_future());
+  });
+}
+
 
 template <typename Data>
 void PmidNodeHandler::Put(const Data& data) {
   VLOG(nfs::Persona::kPmidNode, VisualiserAction::kStoreChunk, data.name().value);
-  chunk_store_.Put(DataNameVariant(data.name()), data.Serialise().data);
+  chunk_store_.Put(DataNameVariant(data.name()), ChunkBuffer(data.Serialise().data)).get();
+}
+
+template <typename Data>
+void PmidNodeHandler::Put(const Data& data, AsyncChunkStore::PutFunctor functor) {
+  VLOG(nfs::Persona::kPmidNode, VisualiserAction::kStoreChunk, data.name().value);
+  chunk_store_.Put(DataNameVariant(data.name()), ChunkBuffer(data.Serialise().data), functor);
 }
 
 template <typename DataName>
 void PmidNodeHandler::Delete(const DataName& data_name) {
-  chunk_store_.Delete(DataNameVariant(data_name));
+  chunk_store_.Delete(DataNameVariant(data_name)).get();
 }
 
 }  // namespace vault
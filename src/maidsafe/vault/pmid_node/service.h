@@ -25,6 +25,7 @@
 #include <vector>
 #include <string>
 #include <functional>
+#include <future>
 
 #include "boost/filesystem/operations.hpp"
 #include "boost/filesystem/path.hpp"
@@ -243,62 +244,68 @@ void PmidNodeService::HandleMessage(
     const typename DeleteRequestFromPmidManagerToPmidNode::Receiver& receiver);
 
 // ============================== Get implementation =============================================
+// The chunk is read on the handler's I/O threads; the response is sent from there once it's ready.
 template <typename Data>
 void PmidNodeService::HandleGet(const typename Data::Name& data_name,
                                 const NodeId& data_manager_node_id,
                                 nfs::MessageId message_id) {
-  try {
-    auto data(handler_.Get<Data>(data_name));
+  handler_.Get<Data>(data_name, [=](std::future<Data> result) {
+    try {
+      auto data(result.get());
 #ifdef USE_MAL_BEHAVIOUR
-    LOG(kVerbose) << "PmidNodeService::HandleGet malfunc_behaviour_seed_ is "
-                  << malfunc_behaviour_seed_;
-    if ((malfunc_behaviour_seed_ % 4) == 0) {
-      LOG(kVerbose) << "PmidNodeService::HandleGet generating an incorrect get response";
-      IntegrityCheckData integrity_check_data(RandomString(64), data.Serialise());
-      nfs_vault::DataNameAndContentOrCheckResult data_or_check_result(
-          Data::Name::data_type::Tag::kValue, data.name().value, integrity_check_data.result());
+      LOG(kVerbose) << "PmidNodeService::HandleGet malfunc_behaviour_seed_ is "
+                    << malfunc_behaviour_seed_;
+      if ((malfunc_behaviour_seed_ % 4) == 0) {
+        LOG(kVerbose) << "PmidNodeService::HandleGet generating an incorrect get response";
+        IntegrityCheckData integrity_check_data(RandomString(64), data.Serialise());
+        nfs_vault::DataNameAndContentOrCheckResult data_or_check_result(
+            Data::Name::data_type::Tag::kValue, data.name().value, integrity_check_data.result());
+        dispatcher_.SendGetOrIntegrityCheckResponse(data_or_check_result, data_manager_node_id,
+                                                    message_id);
+        return;
+      }
+#else
+      nfs_vault::DataNameAndContentOrCheckResult
+          data_or_check_result(Data::Name::data_type::Tag::kValue,
+                               data.name().value, data.Serialise());
+      LOG(kVerbose) << "PmidNodeService::HandleGet got " << HexSubstr(data.name().value)
+                    << " with content " << HexSubstr(data.Serialise().data);
       dispatcher_.SendGetOrIntegrityCheckResponse(data_or_check_result, data_manager_node_id,
                                                   message_id);
-      return;
-    }
-#else
-    nfs_vault::DataNameAndContentOrCheckResult
-        data_or_check_result(Data::Name::data_type::Tag::kValue,
-                             data.name().value, data.Serialise());
-    LOG(kVerbose) << "PmidNodeService::HandleGet got " << HexSubstr(data.name().value)
-                  << " with content " << HexSubstr(data.Serialise().data);
-    dispatcher_.SendGetOrIntegrityCheckResponse(data_or_check_result, data_manager_node_id,
-                                                message_id);
 #endif
-  } catch (const maidsafe_error& error) {
-    // Not sending error here as timeout will happen anyway at Datamanager.
-    // This case should be least frequent.
-    LOG(kError) << "Failed to get data : " << DebugId(data_name.value) << " , "
-                << boost::diagnostic_information(error);
-  } catch (const std::exception& e) {
-    LOG(kError) << "Failed to get data : " << DebugId(data_name.value) << " , "
-                << boost::diagnostic_information(e);
-  }
+    } catch (const maidsafe_error& error) {
+      // Not sending error here as timeout will happen anyway at Datamanager.
+      // This case should be least frequent.
+      LOG(kError) << "Failed to get data : " << DebugId(data_name.value) << " , "
+                  << boost::diagnostic_information(error);
+    } catch (const std::exception& e) {
+      LOG(kError) << "Failed to get data : " << DebugId(data_name.value) << " , "
+                  << boost::diagnostic_information(e);
+    }
+  });
 }
 
 // ============================== Put implementation =============================================
 template <typename Data>
 void PmidNodeService::HandlePut(const Data& data, const uint64_t size, nfs::MessageId message_id) {
-  try {
-    LOG(kVerbose) << "PmidNodeService::HandlePut put " << HexSubstr(data.name().value)
-                  << " with message_id " << message_id.data;
-    handler_.Put(data);
-  } catch (const maidsafe_error& error) {
-    LOG(kWarning) << "PmidNodeService::HandlePut send put failure " << HexSubstr(data.name().value)
-                  << " of size " << size
-                  << " with AvailableSpace " << handler_.AvailableSpace()
-                  << " and error " << boost::diagnostic_information(error);
-    dispatcher_.SendPutFailure<Data>(data.name(), size,
-                                     handler_.AvailableSpace(), error, message_id);
-  } catch (const std::exception& e) {
-    LOG(kError) << "Failed to put data : " << HexSubstr(data.name().value) << " , "
-                << boost::diagnostic_information(e);
-  }
+  LOG(kVerbose) << "PmidNodeService::HandlePut put " << HexSubstr(data.name().value)
+                << " with message_id " << message_id.data;
+  auto data_name(data.name());
+  handler_.Put(data, [=](std::future<void> result) {
+    try {
+      result.get();
+    } catch (const maidsafe_error& error) {
+      LOG(kWarning) << "PmidNodeService::HandlePut send put failure " << HexSubstr(data_name.value)
+                    << " of size " << size
+                    << " with AvailableSpace " << handler_.AvailableSpace()
+                    << " and error " << boost::diagnostic_information(error);
+      dispatcher_.SendPutFailure<Data>(data_name, size,
+                                       handler_.AvailableSpace(), error, message_id);
+    } catch (const std::exception& e) {
+      LOG(kError) << "Failed to put data : " << HexSubstr(data_name.value) << " , "
+                  << boost::diagnostic_information(e);
+    }
+  });
 }
 
 template <typename Data>
@@ -320,31 +327,36 @@ void PmidNodeService::HandleIntegrityCheck(const typename Data::Name& data_name,
                                            const NonEmptyString& random_string,
                                            const NodeId& data_manager_node_id,
                                            nfs::MessageId message_id) {
-  try {
-    auto data(handler_.Get<Data>(data_name));
-    std::string random_seed(random_string.string());
+  handler_.Get<Data>(data_name, [=](std::future<Data> result) {
+    try {
+      auto data(result.get());
+      std::string random_seed(random_string.string());
 #ifdef USE_MAL_BEHAVIOUR
-    LOG(kVerbose) << "PmidNodeService::HandleIntegrityCheck malfunc_behaviour_seed_ is "
-                  << malfunc_behaviour_seed_;
-    if ((malfunc_behaviour_seed_ % 4) == 0) {
-      LOG(kVerbose) << "PmidNodeService::HandleIntegrityCheck generating an incorrect response";
-      random_seed = RandomString(64);
-    }
+      LOG(kVerbose) << "PmidNodeService::HandleIntegrityCheck malfunc_behaviour_seed_ is "
+                    << malfunc_behaviour_seed_;
+      if ((malfunc_behaviour_seed_ % 4) == 0) {
+        LOG(kVerbose) << "PmidNodeService::HandleIntegrityCheck generating an incorrect response";
+        random_seed = RandomString(64);
+      }
 #endif
-    IntegrityCheckData integrity_check_data(random_seed, data.Serialise());
-    nfs_vault::DataNameAndContentOrCheckResult
-        data_or_check_result(Data::Name::data_type::Tag::kValue, data.name().value,
-                                 integrity_check_data.result());
-    LOG(kVerbose) << "PmidNodeService::HandleIntegrityCheck send back integrity_check_data for "
-                  << HexSubstr(data.name().value);
-    dispatcher_.SendGetOrIntegrityCheckResponse(data_or_check_result, data_manager_node_id,
-                                                message_id);
-  } catch (const maidsafe_error& error) {
-    // Not sending error here as timeout will happen anyway at Datamanager.
-    // This case should be least frequent.
-    LOG(kError) << "Failed to do integrity check for data : " << DebugId(data_name.value) << " , "
-                << boost::diagnostic_information(error);
-  }
+      IntegrityCheckData integrity_check_data(random_seed, data.Serialise());
+      nfs_vault::DataNameAndContentOrCheckResult
+          data_or_check_result(Data::Name::data_type::Tag::kValue, data.name().value,
+                                   integrity_check_data.result());
+      LOG(kVerbose) << "PmidNodeService::HandleIntegrityCheck send back integrity_check_data for "
+                    << HexSubstr(data.name().value);
+      dispatcher_.SendGetOrIntegrityCheckResponse(data_or_check_result, data_manager_node_id,
+                                                  message_id);
+    } catch (const maidsafe_error& error) {
+      // Not sending error here as timeout will happen anyway at Datamanager.
+      // This case should be least frequent.
+      LOG(kError) << "Failed to do integrity check for data : " << DebugId(data_name.value)
+                  << " , " << boost::diagnostic_information(error);
+    } catch (const std::exception& e) {
+      LOG(kError) << "Failed to do integrity check for data : " << DebugId(data_name.value)
+                  << " , " << boost::diagnostic_information(e);
+    }
+  });
 }
 
 /*
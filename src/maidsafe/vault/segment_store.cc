@@ -0,0 +1,564 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/segment_store.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/lexical_cast.hpp"
+
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/vault/chunk_obfuscation.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace {
+
+// Record layout: magic (4) | type (1) | data tag (4) | name size (4) | value size (4) | name | value
+// All integers are little-endian.
+const uint32_t kRecordMagic(0x4D534547);
+const uint64_t kRecordHeaderSize(17);
+const char kSegmentPrefix[] = "segment_";
+// A sealed segment is compacted once at least this percentage of it is garbage.
+const uint64_t kCompactionThresholdPercent(50);
+const std::chrono::seconds kCompactionInterval(10);
+
+void AppendUint32(std::string& buffer, uint32_t value) {
+  for (int i(0); i != 4; ++i)
+    buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+uint32_t ParseUint32(const char* buffer) {
+  uint32_t value(0);
+  for (int i(0); i != 4; ++i)
+    value |= static_cast<uint32_t>(static_cast<unsigned char>(buffer[i])) << (8 * i);
+  return value;
+}
+
+bool ParseSegmentId(const fs::path& path, uint32_t& segment_id) {
+  const std::string prefix(kSegmentPrefix), file_name(path.filename().string());
+  if (file_name.size() <= prefix.size() || file_name.compare(0, prefix.size(), prefix) != 0)
+    return false;
+  try {
+    segment_id = boost::lexical_cast<uint32_t>(file_name.substr(prefix.size()));
+  }
+  catch (const boost::bad_lexical_cast&) {
+    return false;
+  }
+  return segment_id != 0;
+}
+
+}  // unnamed namespace
+
+const uint64_t SegmentStore::kDefaultMaxSegmentSize(64 * 1024 * 1024);
+
+SegmentStore::SegmentStore(const fs::path& disk_path, DiskUsage max_disk_usage,
+                           uint64_t max_segment_size)
+    : kDiskPath_(disk_path),
+      kMaxSegmentSize_(max_segment_size),
+      max_disk_usage_(std::move(max_disk_usage)),
+      current_disk_usage_(0),
+      garbage_bytes_(0),
+      reclaim_below_(0),
+      index_(),
+      segments_(),
+      active_segment_id_(0),
+      active_segment_(),
+      active_segment_size_(0),
+      append_mutex_(),
+      mutex_(),
+      compaction_condition_(),
+      stop_compaction_(false),
+      compaction_thread_() {
+  boost::system::error_code error_code;
+  if (!fs::exists(kDiskPath_, error_code)) {
+    if (!fs::create_directories(kDiskPath_, error_code)) {
+      LOG(kError) << "Can't create disk root at " << kDiskPath_ << ": " << error_code.message();
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+    }
+  } else if (!fs::is_directory(kDiskPath_, error_code)) {
+    LOG(kError) << "Disk root " << kDiskPath_ << " is not a directory";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::uninitialised));
+  }
+
+  Replay();
+  if (current_disk_usage_ > max_disk_usage_) {
+    LOG(kError) << "current disk usage " << current_disk_usage_
+                << " is greater than max disk usage " << max_disk_usage_;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::cannot_exceed_limit));
+  }
+  // Never append to a segment left by a previous run, since its tail may have been torn.
+  {
+    std::lock_guard<std::mutex> append_lock(append_mutex_);
+    OpenActiveSegment(segments_.empty() ? 1 : segments_.rbegin()->first + 1);
+  }
+  compaction_thread_ = std::thread([this] { CompactionLoop(); });
+}
+
+SegmentStore::~SegmentStore() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_compaction_ = true;
+  }
+  compaction_condition_.notify_one();
+  if (compaction_thread_.joinable())
+    compaction_thread_.join();
+
+  active_segment_.close();
+  if (segments_[active_segment_id_].size == 0) {
+    boost::system::error_code error_code;
+    fs::remove(SegmentPath(active_segment_id_), error_code);
+  }
+}
+
+void SegmentStore::Put(const KeyType& key, const NonEmptyString& value) {
+  auto key_tag_and_id(boost::apply_visitor(GetTagValueAndIdentityVisitor(), key));
+  auto content(ObfuscateChunk(key_tag_and_id.second, value));
+  uint64_t value_size(content.size());
+
+  // The index can't change while append_mutex_ is held, other than for the garbage accounted.
+  std::lock_guard<std::mutex> append_lock(append_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Any existing record only becomes garbage, so the new one needs room of its own.
+    if (!HasDiskSpace(value_size)) {
+      LOG(kError) << "Cannot store " << HexSubstr(key_tag_and_id.second.string())
+                  << " since the addition of " << value_size << " bytes to "
+                  << current_disk_usage_.data << " live and " << garbage_bytes_
+                  << " garbage bytes exceeds max of " << max_disk_usage_ << " bytes.";
+      if (garbage_bytes_ != 0) {
+        reclaim_below_ = active_segment_id_ + 1;
+        compaction_condition_.notify_one();
+      }
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::cannot_exceed_limit));
+    }
+  }
+
+  auto location(Append(key, RecordType::kPut, content));
+  std::lock_guard<std::mutex> lock(mutex_);
+  Appended(location);
+  auto itr(index_.find(key));
+  if (itr != index_.end()) {
+    MarkDead(itr->second);
+    current_disk_usage_.data -= itr->second.value_size;
+    itr->second = location;
+  } else {
+    index_.insert(std::make_pair(key, location));
+  }
+  current_disk_usage_.data += value_size;
+}
+
+void SegmentStore::Delete(const KeyType& key) {
+  std::lock_guard<std::mutex> append_lock(append_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.find(key) == index_.end()) {
+      LOG(kError) << "SegmentStore::Delete can't find "
+                  << HexSubstr(boost::apply_visitor(GetIdentityVisitor(), key).string());
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+    }
+  }
+  auto tombstone(Append(key, RecordType::kDelete, std::string()));
+  std::lock_guard<std::mutex> lock(mutex_);
+  Appended(tombstone);
+  // The tombstone itself is garbage as far as compaction is concerned.
+  segments_[tombstone.segment_id].dead_bytes += tombstone.record_size;
+  auto itr(index_.find(key));
+  MarkDead(itr->second);
+  current_disk_usage_.data -= itr->second.value_size;
+  index_.erase(itr);
+}
+
+NonEmptyString SegmentStore::Get(const KeyType& key) const {
+  auto key_tag_and_id(boost::apply_visitor(GetTagValueAndIdentityVisitor(), key));
+  std::string content;
+  for (int attempt(0);; ++attempt) {
+    Location location;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto itr(index_.find(key));
+      if (itr == index_.end()) {
+        LOG(kWarning) << "SegmentStore::Get can't find "
+                      << HexSubstr(key_tag_and_id.second.string());
+        BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+      }
+      location = itr->second;
+    }
+    std::ifstream segment_stream(SegmentPath(location.segment_id).string(), std::ios::binary);
+    content.resize(location.value_size);
+    segment_stream.seekg(location.offset + location.record_size - location.value_size);
+    if (segment_stream.read(&content[0], location.value_size))
+      break;
+
+    // The segment may have been compacted and removed meanwhile, moving the record elsewhere.
+    bool moved(false);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto itr(index_.find(key));
+      moved = itr == index_.end() || itr->second.segment_id != location.segment_id ||
+              itr->second.offset != location.offset;
+    }
+    if (!moved || attempt == 2) {
+      LOG(kError) << "Failed to read " << HexSubstr(key_tag_and_id.second.string())
+                  << " from segment " << location.segment_id;
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+    }
+  }
+  DeobfuscateChunk(key_tag_and_id.second, content);
+  return NonEmptyString(std::move(content));
+}
+
+std::vector<SegmentStore::KeyType> SegmentStore::ElementsToStore(std::set<KeyType> element_list) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<KeyType> to_store;
+  for (const auto& element : element_list) {
+    if (index_.find(element) == index_.end())
+      to_store.push_back(element);
+  }
+  return to_store;
+}
+
+void SegmentStore::SetMaxDiskUsage(DiskUsage max_disk_usage) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (current_disk_usage_ > max_disk_usage) {
+    LOG(kError) << "current_disk_usage_ " << current_disk_usage_.data
+                << " exceeds target max_disk_usage " << max_disk_usage.data;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::invalid_parameter));
+  }
+  max_disk_usage_ = max_disk_usage;
+}
+
+DiskUsage SegmentStore::GetMaxDiskUsage() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return max_disk_usage_;
+}
+
+DiskUsage SegmentStore::GetCurrentDiskUsage() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return current_disk_usage_;
+}
+
+std::vector<SegmentStore::KeyType> SegmentStore::GetKeys() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<KeyType> keys;
+  keys.reserve(index_.size());
+  for (const auto& entry : index_)
+    keys.push_back(entry.first);
+  return keys;
+}
+
+void SegmentStore::Replay() {
+  std::vector<uint32_t> segment_ids;
+  for (fs::directory_iterator itr(kDiskPath_); itr != fs::directory_iterator(); ++itr) {
+    uint32_t segment_id(0);
+    if (fs::is_regular_file(itr->status()) && ParseSegmentId(itr->path(), segment_id))
+      segment_ids.push_back(segment_id);
+  }
+  std::sort(std::begin(segment_ids), std::end(segment_ids));
+
+  for (const auto& segment_id : segment_ids) {
+    const fs::path segment_path(SegmentPath(segment_id));
+    const uint64_t segment_size(fs::file_size(segment_path));
+    std::ifstream segment_stream(segment_path.string(), std::ios::binary);
+    if (!segment_stream) {
+      LOG(kError) << "Failed to open " << segment_path;
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+    }
+
+    segments_[segment_id];
+    uint64_t offset(0), record_size(0);
+    Record record;
+    while (offset < segment_size &&
+           ReadRecord(segment_stream, segment_size, offset, record, record_size)) {
+      auto itr(index_.find(record.key));
+      if (itr != index_.end()) {
+        MarkDead(itr->second);
+        current_disk_usage_.data -= itr->second.value_size;
+        index_.erase(itr);
+      }
+      if (record.type == RecordType::kPut) {
+        auto value_size(static_cast<uint32_t>(record.value.size()));
+        index_.insert(std::make_pair(record.key,
+                                     Location(segment_id, offset, record_size, value_size)));
+        current_disk_usage_.data += value_size;
+      } else {
+        segments_[segment_id].dead_bytes += record_size;
+      }
+      offset += record_size;
+    }
+    segments_[segment_id].size = offset;
+
+    if (offset < segment_size) {
+      LOG(kWarning) << "Discarding " << segment_size - offset << " bytes of incomplete record at "
+                    << "the end of " << segment_path;
+      segment_stream.close();
+      fs::resize_file(segment_path, offset);
+    }
+  }
+}
+
+bool SegmentStore::ReadRecord(std::ifstream& segment_stream, uint64_t segment_size,
+                              uint64_t offset, Record& record, uint64_t& record_size) const {
+  if (offset + kRecordHeaderSize > segment_size)
+    return false;
+  char header[kRecordHeaderSize];
+  segment_stream.clear();
+  segment_stream.seekg(offset);
+  if (!segment_stream.read(header, kRecordHeaderSize))
+    return false;
+  if (ParseUint32(header) != kRecordMagic || static_cast<uint8_t>(header[4]) > 1)
+    return false;
+
+  const uint32_t name_size(ParseUint32(header + 9)), value_size(ParseUint32(header + 13));
+  record_size = kRecordHeaderSize + name_size + value_size;
+  if (offset + record_size > segment_size)
+    return false;
+
+  std::string name(name_size, 0);
+  record.value.assign(value_size, 0);
+  if (name_size != 0 && !segment_stream.read(&name[0], name_size))
+    return false;
+  if (value_size != 0 && !segment_stream.read(&record.value[0], value_size))
+    return false;
+
+  record.type = static_cast<RecordType>(header[4]);
+  try {
+    record.key = GetDataNameVariant(static_cast<DataTagValue>(ParseUint32(header + 5)),
+                                    Identity(name));
+  }
+  catch (const std::exception& e) {
+    LOG(kError) << "Invalid key in segment record: " << boost::diagnostic_information(e);
+    return false;
+  }
+  return record.type == RecordType::kDelete || value_size != 0;
+}
+
+SegmentStore::Location SegmentStore::Append(const KeyType& key, RecordType type,
+                                            const std::string& value) {
+  auto key_tag_and_id(boost::apply_visitor(GetTagValueAndIdentityVisitor(), key));
+  const std::string& name(key_tag_and_id.second.string());
+  std::string record;
+  record.reserve(kRecordHeaderSize + name.size() + value.size());
+  AppendUint32(record, kRecordMagic);
+  record.push_back(static_cast<char>(type));
+  AppendUint32(record, static_cast<uint32_t>(key_tag_and_id.first));
+  AppendUint32(record, static_cast<uint32_t>(name.size()));
+  AppendUint32(record, static_cast<uint32_t>(value.size()));
+  record += name;
+  record += value;
+
+  if (active_segment_size_ != 0 && active_segment_size_ + record.size() > kMaxSegmentSize_)
+    OpenActiveSegment(active_segment_id_ + 1);
+
+  Location location(active_segment_id_, active_segment_size_, record.size(),
+                    static_cast<uint32_t>(value.size()));
+  active_segment_.write(record.data(), record.size());
+  active_segment_.flush();
+  active_segment_size_ += record.size();
+  if (!active_segment_) {
+    LOG(kError) << "Failed to append to segment " << active_segment_id_;
+    // The segment may now end in a partial record, so seal it; replay will discard the tail.
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      Appended(location);
+      segments_[location.segment_id].dead_bytes += location.record_size;
+      segments_[location.segment_id].dead_chunk_bytes += location.value_size;
+      garbage_bytes_ += location.value_size;
+    }
+    OpenActiveSegment(active_segment_id_ + 1);
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  return location;
+}
+
+void SegmentStore::OpenActiveSegment(uint32_t segment_id) {
+  const fs::path segment_path(SegmentPath(segment_id));
+  active_segment_.close();
+  active_segment_.clear();
+  active_segment_.open(segment_path.string(), std::ios::binary | std::ios::out | std::ios::app);
+  if (!active_segment_) {
+    LOG(kError) << "Failed to open " << segment_path << " for writing";
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  active_segment_size_ = fs::file_size(segment_path);
+  std::lock_guard<std::mutex> lock(mutex_);
+  active_segment_id_ = segment_id;
+  segments_[active_segment_id_].size = active_segment_size_;
+}
+
+void SegmentStore::Appended(const Location& location) {
+  Segment& segment(segments_[location.segment_id]);
+  segment.size = std::max(segment.size, location.offset + location.record_size);
+}
+
+void SegmentStore::MarkDead(const Location& location) {
+  auto itr(segments_.find(location.segment_id));
+  if (itr == segments_.end())
+    return;
+  Segment& segment(itr->second);
+  segment.dead_bytes += location.record_size;
+  segment.dead_chunk_bytes += location.value_size;
+  garbage_bytes_ += location.value_size;
+  if (location.segment_id != active_segment_id_ &&
+      segment.dead_bytes * 100 >= segment.size * kCompactionThresholdPercent)
+    compaction_condition_.notify_one();
+}
+
+fs::path SegmentStore::SegmentPath(uint32_t segment_id) const {
+  std::string id(std::to_string(segment_id));
+  return kDiskPath_ / (kSegmentPrefix + std::string(id.size() < 8 ? 8 - id.size() : 0, '0') + id);
+}
+
+bool SegmentStore::HasDiskSpace(uint64_t required_space) const {
+  return current_disk_usage_.data + garbage_bytes_ + required_space <= max_disk_usage_.data;
+}
+
+void SegmentStore::CompactionLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_compaction_) {
+    compaction_condition_.wait_for(lock, kCompactionInterval);
+    if (stop_compaction_)
+      break;
+    lock.unlock();
+    try {
+      while (CompactOnce()) {}
+    }
+    catch (const std::exception& e) {
+      LOG(kError) << "SegmentStore compaction failed: " << boost::diagnostic_information(e);
+    }
+    lock.lock();
+  }
+}
+
+bool SegmentStore::CompactOnce() {
+  uint32_t segment_id(0);
+  uint64_t segment_size(0);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stop_compaction_)
+      return false;
+    segment_id = SelectSegmentToCompact();
+    if (segment_id == 0 && active_segment_id_ < reclaim_below_ &&
+        segments_[active_segment_id_].dead_chunk_bytes != 0) {
+      // The garbage blocking Puts is all in the active segment, so it's sealed to be compacted.
+      lock.unlock();
+      {
+        std::lock_guard<std::mutex> append_lock(append_mutex_);
+        OpenActiveSegment(active_segment_id_ + 1);
+      }
+      lock.lock();
+      segment_id = SelectSegmentToCompact();
+    }
+    if (segment_id == 0) {
+      reclaim_below_ = 0;
+      return false;
+    }
+    segments_[segment_id].compacting = true;
+    segment_size = segments_[segment_id].size;
+  }
+
+  // Sealed segments are immutable, so they can be scanned without holding a lock.  Each record is
+  // only copied if the index still points at it, which can't change while append_mutex_ is held.
+  const fs::path segment_path(SegmentPath(segment_id));
+  std::ifstream segment_stream(segment_path.string(), std::ios::binary);
+  if (!segment_stream && segment_size != 0) {
+    LOG(kError) << "Failed to open " << segment_path << " for compaction";
+    std::lock_guard<std::mutex> lock(mutex_);
+    segments_[segment_id].compacting = false;
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+  }
+  uint64_t offset(0), record_size(0);
+  Record record;
+  while (offset < segment_size &&
+         ReadRecord(segment_stream, segment_size, offset, record, record_size)) {
+    std::lock_guard<std::mutex> append_lock(append_mutex_);
+    bool copy(false), keep_tombstone(false);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stop_compaction_) {
+        segments_[segment_id].compacting = false;
+        return false;
+      }
+      auto itr(index_.find(record.key));
+      if (record.type == RecordType::kPut) {
+        copy = itr != index_.end() && itr->second.segment_id == segment_id &&
+               itr->second.offset == offset;
+      } else {
+        // An older segment may still hold a superseded put for this key; keep the tombstone alive
+        // so that it isn't resurrected on replay.
+        keep_tombstone = itr == index_.end() && segments_.begin()->first < segment_id;
+      }
+    }
+    if (copy) {
+      auto location(Append(record.key, RecordType::kPut, record.value));
+      std::lock_guard<std::mutex> lock(mutex_);
+      Appended(location);
+      index_[record.key] = location;
+    } else if (keep_tombstone) {
+      auto tombstone(Append(record.key, RecordType::kDelete, std::string()));
+      std::lock_guard<std::mutex> lock(mutex_);
+      Appended(tombstone);
+      segments_[tombstone.segment_id].dead_bytes += tombstone.record_size;
+    }
+    offset += record_size;
+  }
+  segment_stream.close();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  garbage_bytes_ -= segments_[segment_id].dead_chunk_bytes;
+  segments_.erase(segment_id);
+  boost::system::error_code error_code;
+  fs::remove(segment_path, error_code);
+  if (error_code)
+    LOG(kWarning) << "Failed to remove compacted segment " << segment_path << ": "
+                  << error_code.message();
+  return true;
+}
+
+uint32_t SegmentStore::SelectSegmentToCompact() const {
+  uint32_t selected(0);
+  uint64_t selected_dead_percent(0);
+  for (const auto& segment : segments_) {
+    if (segment.first == active_segment_id_ || segment.second.compacting)
+      continue;
+    uint64_t dead_percent(segment.second.size == 0 ?
+                          100 : segment.second.dead_bytes * 100 / segment.second.size);
+    const bool worth_it(dead_percent >= kCompactionThresholdPercent ||
+                        (segment.first < reclaim_below_ && segment.second.dead_chunk_bytes != 0));
+    if (worth_it && dead_percent >= selected_dead_percent) {
+      selected = segment.first;
+      selected_dead_percent = dead_percent;
+    }
+  }
+  return selected;
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,162 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_SEGMENT_STORE_H_
+#define MAIDSAFE_VAULT_SEGMENT_STORE_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/data_types/data_name_variant.h"
+
+#include "maidsafe/vault/store_types.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+class SegmentStoreTest;
+}
+
+// Log-structured alternative to ChunkStore with the same public interface, used by ChunkStore when
+// configured for ChunkStoreLayout::kSegments.  Chunks are appended to a small number of large
+// segment files rather than one file per chunk, and an in-memory index maps each key to its record.
+// Deletes and overwrites append a new record and leave the old one as garbage, which a background
+// thread reclaims by copying the live records of mostly-dead segments into the active segment.  As
+// with ChunkStore, the current disk usage counts live chunk bytes only, but garbage awaiting
+// compaction counts against the maximum too.
+//
+// Writers are serialised against each other, and hold the index lock only to look up and update
+// it; reads copy a record's location out under the lock, and read the segment without it.
+class SegmentStore {
+ public:
+  typedef DataNameVariant KeyType;
+
+  static const uint64_t kDefaultMaxSegmentSize;
+
+  SegmentStore(const boost::filesystem::path& disk_path, DiskUsage max_disk_usage,
+               uint64_t max_segment_size = kDefaultMaxSegmentSize);
+  ~SegmentStore();
+  SegmentStore(const SegmentStore&) = delete;
+  SegmentStore& operator=(const SegmentStore&) = delete;
+
+  void Put(const KeyType& key, const NonEmptyString& value);
+  void Delete(const KeyType& key);
+  NonEmptyString Get(const KeyType& key) const;
+
+  // Return list of elements that should have but not exists yet
+  std::vector<KeyType> ElementsToStore(std::set<KeyType> element_list);
+
+  void SetMaxDiskUsage(DiskUsage max_disk_usage);
+
+  DiskUsage GetMaxDiskUsage() const;
+  DiskUsage GetCurrentDiskUsage() const;
+  boost::filesystem::path GetDiskPath() const { return kDiskPath_; }
+  std::vector<KeyType> GetKeys() const;
+
+  friend class test::SegmentStoreTest;
+
+ private:
+  enum class RecordType : uint8_t {
+    kPut = 0,
+    kDelete = 1
+  };
+
+  struct Location {
+    Location() : segment_id(0), offset(0), record_size(0), value_size(0) {}
+    Location(uint32_t segment_id_in, uint64_t offset_in, uint64_t record_size_in,
+             uint32_t value_size_in)
+        : segment_id(segment_id_in), offset(offset_in), record_size(record_size_in),
+          value_size(value_size_in) {}
+    uint32_t segment_id;
+    uint64_t offset, record_size;
+    uint32_t value_size;
+  };
+
+  struct Segment {
+    Segment() : size(0), dead_bytes(0), dead_chunk_bytes(0), compacting(false) {}
+    // 'dead_bytes' counts whole records, tombstones included; 'dead_chunk_bytes' their chunks.
+    uint64_t size, dead_bytes, dead_chunk_bytes;
+    bool compacting;
+  };
+
+  struct Record {
+    Record() : type(RecordType::kPut), key(), value() {}
+    RecordType type;
+    KeyType key;
+    std::string value;
+  };
+
+  void Replay();
+  bool ReadRecord(std::ifstream& segment_stream, uint64_t segment_size, uint64_t offset,
+                  Record& record, uint64_t& record_size) const;
+  // These require append_mutex_ to be held, and mutex_ not to be.  Append writes the record, which
+  // Appended then accounts for, with mutex_ held.
+  Location Append(const KeyType& key, RecordType type, const std::string& value);
+  void OpenActiveSegment(uint32_t segment_id);
+  // These require mutex_ to be held.
+  void Appended(const Location& location);
+  void MarkDead(const Location& location);
+  boost::filesystem::path SegmentPath(uint32_t segment_id) const;
+  bool HasDiskSpace(uint64_t required_space) const;
+
+  void CompactionLoop();
+  // Rewrites the live records of the sealed segment with the most garbage (if any exceeds the
+  // threshold) and removes it.  Returns false if there was nothing worth compacting.  Once a Put
+  // has been refused for want of space, any segment older than reclaim_below_ with garbage at all
+  // is worth compacting, including the active one, which is sealed for the purpose.
+  bool CompactOnce();
+  uint32_t SelectSegmentToCompact() const;
+
+  const boost::filesystem::path kDiskPath_;
+  const uint64_t kMaxSegmentSize_;
+  DiskUsage max_disk_usage_, current_disk_usage_;
+  // Chunk bytes of the records which are no longer live, counted as for current_disk_usage_.
+  uint64_t garbage_bytes_;
+  // Zero unless a Put has been refused while there was garbage to reclaim.
+  uint32_t reclaim_below_;
+  std::map<KeyType, Location> index_;
+  std::map<uint32_t, Segment> segments_;
+  // Changed with both mutexes held.
+  uint32_t active_segment_id_;
+  // Guarded by append_mutex_, which is taken before mutex_ by any thread needing both.
+  std::ofstream active_segment_;
+  uint64_t active_segment_size_;
+  std::mutex append_mutex_;
+  mutable std::mutex mutex_;
+  std::condition_variable compaction_condition_;
+  bool stop_compaction_;
+  std::thread compaction_thread_;
+};
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_SEGMENT_STORE_H_
@@ -0,0 +1,121 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/segmented_lru.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+SegmentedLru::SegmentedLru(uint64_t capacity, unsigned int protected_percentage)
+    : kProtectedPercentage_(protected_percentage),
+      protected_capacity_(capacity * protected_percentage / 100),
+      protected_size_(0),
+      probation_(),
+      protected_(),
+      entries_(),
+      mutex_() {}
+
+void SegmentedLru::Insert(const KeyType& key, uint64_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(entries_.find(key));
+  if (itr == entries_.end()) {
+    probation_.push_front(key);
+    entries_.insert(std::make_pair(key, Entry(size, Segment::kProbation, probation_.begin())));
+    return;
+  }
+  if (itr->second.segment == Segment::kProtected)
+    protected_size_ = protected_size_ - itr->second.size + size;
+  itr->second.size = size;
+  Promote(itr->second);
+}
+
+void SegmentedLru::Touch(const KeyType& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(entries_.find(key));
+  if (itr != entries_.end())
+    Promote(itr->second);
+}
+
+void SegmentedLru::Erase(const KeyType& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(entries_.find(key));
+  if (itr == entries_.end())
+    return;
+  if (itr->second.segment == Segment::kProtected) {
+    protected_size_ -= itr->second.size;
+    protected_.erase(itr->second.position);
+  } else {
+    probation_.erase(itr->second.position);
+  }
+  entries_.erase(itr);
+}
+
+boost::optional<SegmentedLru::KeyType> SegmentedLru::Victim() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!probation_.empty())
+    return probation_.back();
+  if (!protected_.empty())
+    return protected_.back();
+  return boost::none;
+}
+
+void SegmentedLru::SetCapacity(uint64_t capacity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  protected_capacity_ = capacity * kProtectedPercentage_ / 100;
+  Rebalance();
+}
+
+size_t SegmentedLru::Size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+uint64_t SegmentedLru::ProtectedSize() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return protected_size_;
+}
+
+void SegmentedLru::Promote(Entry& entry) {
+  if (entry.segment == Segment::kProtected) {
+    protected_.splice(protected_.begin(), protected_, entry.position);
+    return;
+  }
+  protected_.splice(protected_.begin(), probation_, entry.position);
+  entry.segment = Segment::kProtected;
+  protected_size_ += entry.size;
+  Rebalance();
+}
+
+void SegmentedLru::Rebalance() {
+  // The most recently promoted entry stays protected even if it alone exceeds the capacity.
+  while (protected_size_ > protected_capacity_ && protected_.size() > 1) {
+    auto& demoted(entries_.at(protected_.back()));
+    probation_.splice(probation_.begin(), protected_, demoted.position);
+    demoted.segment = Segment::kProbation;
+    protected_size_ -= demoted.size;
+  }
+}
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
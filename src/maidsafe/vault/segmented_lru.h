@@ -0,0 +1,95 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_SEGMENTED_LRU_H_
+#define MAIDSAFE_VAULT_SEGMENTED_LRU_H_
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+
+#include "boost/optional/optional.hpp"
+
+#include "maidsafe/common/data_types/data_name_variant.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Eviction order for a size-bounded cache, by segmented LRU.  New entries join a probationary
+// segment and move to a protected one when accessed again.  Victims are taken from the least
+// recently used end of the probationary segment first, so entries used once are evicted before
+// those used repeatedly.  When the protected segment outgrows its share of the capacity, its least
+// recently used entries are demoted to probation.
+//
+// Only the order and sizes are held; the entries themselves live elsewhere.  All functions are
+// thread-safe.
+class SegmentedLru {
+ public:
+  typedef DataNameVariant KeyType;
+
+  // Up to 'protected_percentage' of 'capacity' bytes are held in the protected segment.
+  SegmentedLru(uint64_t capacity, unsigned int protected_percentage = 80);
+  SegmentedLru(const SegmentedLru&) = delete;
+  SegmentedLru& operator=(const SegmentedLru&) = delete;
+
+  // Adds 'key' as most recently used in probation, or if already present updates its size and
+  // treats this as an access.
+  void Insert(const KeyType& key, uint64_t size);
+  // Records an access; does nothing if 'key' isn't present.
+  void Touch(const KeyType& key);
+  void Erase(const KeyType& key);
+  // The entry to evict next, without removing it.
+  boost::optional<KeyType> Victim() const;
+
+  void SetCapacity(uint64_t capacity);
+  size_t Size() const;
+  uint64_t ProtectedSize() const;
+
+ private:
+  enum class Segment { kProbation, kProtected };
+  struct Entry {
+    Entry(uint64_t size_in, Segment segment_in, std::list<KeyType>::iterator position_in)
+        : size(size_in), segment(segment_in), position(position_in) {}
+    uint64_t size;
+    Segment segment;
+    std::list<KeyType>::iterator position;
+  };
+
+  // These require 'mutex_' to be held.
+  void Promote(Entry& entry);
+  void Rebalance();
+
+  const unsigned int kProtectedPercentage_;
+  uint64_t protected_capacity_, protected_size_;
+  // Most recently used first.
+  std::list<KeyType> probation_, protected_;
+  std::map<KeyType, Entry> entries_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace detail
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_SEGMENTED_LRU_H_
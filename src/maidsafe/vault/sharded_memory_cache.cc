@@ -0,0 +1,265 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/sharded_memory_cache.h"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+const uint32_t SharedSpinMutex::kWriter, SharedSpinMutex::kWriterWaiting, SharedSpinMutex::kReader;
+
+void SharedSpinMutex::lock() {
+  for (;;) {
+    uint32_t state(state_.load(std::memory_order_relaxed));
+    if ((state & ~kWriterWaiting) == 0) {
+      if (state_.compare_exchange_weak(state, kWriter, std::memory_order_acquire))
+        return;
+      continue;
+    }
+    if ((state & kWriterWaiting) == 0)
+      state_.fetch_or(kWriterWaiting, std::memory_order_relaxed);
+    std::this_thread::yield();
+  }
+}
+
+void SharedSpinMutex::unlock() { state_.fetch_and(~kWriter, std::memory_order_release); }
+
+void SharedSpinMutex::lock_shared() {
+  for (;;) {
+    if ((state_.fetch_add(kReader, std::memory_order_acquire) & (kWriter | kWriterWaiting)) == 0)
+      return;
+    state_.fetch_sub(kReader, std::memory_order_relaxed);
+    while ((state_.load(std::memory_order_relaxed) & (kWriter | kWriterWaiting)) != 0)
+      std::this_thread::yield();
+  }
+}
+
+void SharedSpinMutex::unlock_shared() { state_.fetch_sub(kReader, std::memory_order_release); }
+
+}  // namespace detail
+
+namespace {
+
+class SharedLock {
+ public:
+  explicit SharedLock(detail::SharedSpinMutex& mutex) : mutex_(mutex) { mutex_.lock_shared(); }
+  SharedLock(const SharedLock&) = delete;
+  SharedLock& operator=(const SharedLock&) = delete;
+  ~SharedLock() { mutex_.unlock_shared(); }
+
+ private:
+  detail::SharedSpinMutex& mutex_;
+};
+
+// An automatically chosen shard count leaves each shard room for at least a full-size chunk.
+const uint64_t kMinAutoShardMemoryUsage(1024 * 1024);
+
+size_t ShardCountFor(size_t requested, uint64_t max_memory_usage) {
+  // More shards reduce contention, but each gets a smaller share of the capacity to hold chunks in.
+  bool automatic(requested == 0);
+  if (automatic)
+    requested = std::min(4 * std::max(std::thread::hardware_concurrency(), 1U), 16U);
+  size_t shard_count(1);
+  while (shard_count < requested)
+    shard_count <<= 1;
+  while (automatic && shard_count > 1 && max_memory_usage / shard_count < kMinAutoShardMemoryUsage)
+    shard_count >>= 1;
+  return shard_count;
+}
+
+}  // unnamed namespace
+
+ShardedMemoryCache::ShardedMemoryCache(MemoryUsage max_memory_usage, size_t shard_count,
+                                       FrequencySketch* frequency_sketch,
+                                       EvictionFunctor on_eviction)
+    : kMaxMemoryUsage_(max_memory_usage.data),
+      kShardMemoryUsage_(kMaxMemoryUsage_ / ShardCountFor(shard_count, kMaxMemoryUsage_)),
+      kHash_(),
+      frequency_sketch_(frequency_sketch),
+      on_eviction_(on_eviction),
+      shards_() {
+  for (size_t i(0); i != ShardCountFor(shard_count, kMaxMemoryUsage_); ++i)
+    shards_.push_back(std::unique_ptr<Shard>(new Shard));
+}
+
+bool ShardedMemoryCache::Store(const KeyType& key, const NonEmptyString& value, bool demote) {
+  return Store(key, ChunkBuffer(value), demote);
+}
+
+bool ShardedMemoryCache::Store(const KeyType& key, const ChunkBuffer& value, bool demote) {
+  HashedKey hashed_key(Hash(key));
+  if (frequency_sketch_)
+    frequency_sketch_->Increment(hashed_key.hash);
+  if (value.size() > kShardMemoryUsage_) {
+    LOG(kWarning) << "Not caching "
+                  << HexSubstr(boost::apply_visitor(GetIdentityVisitor(), key).string())
+                  << " of " << value.size() << " bytes, which exceeds the shard capacity of "
+                  << kShardMemoryUsage_ << " bytes.";
+    return false;
+  }
+  Shard& shard(GetShard(hashed_key));
+  std::vector<std::pair<KeyType, ChunkBuffer>> demoted;
+  {
+    std::lock_guard<detail::SharedSpinMutex> lock(shard.mutex);
+    auto itr(shard.index.find(hashed_key));
+    if (itr != shard.index.end()) {
+      Erase(shard, itr->second);
+    } else if (frequency_sketch_ && !shard.entries.empty() &&
+               shard.current_memory_usage + value.size() > kShardMemoryUsage_ &&
+               !frequency_sketch_->Admit(hashed_key.hash, NextVictim(shard)->hash)) {
+      shard.counters.Rejected();
+      return false;
+    }
+    Evict(shard, value.size(), demoted);
+    shard.counters.Admitted(value.size());
+    auto entry(shard.entries.emplace(shard.hand, key, hashed_key.hash, value, demote));
+    hashed_key.key = &entry->key;
+    shard.index.insert(std::make_pair(hashed_key, entry));
+    shard.current_memory_usage += value.size();
+  }
+  for (const auto& entry : demoted)
+    on_eviction_(entry.first, entry.second);
+  return true;
+}
+
+NonEmptyString ShardedMemoryCache::Get(const KeyType& key) { return GetBuffer(key).value(); }
+
+ChunkBuffer ShardedMemoryCache::GetBuffer(const KeyType& key) {
+  ChunkBuffer value;
+  if (!Lookup(key, value))
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+  return value;
+}
+
+boost::optional<ChunkBuffer> ShardedMemoryCache::Find(const KeyType& key) {
+  boost::optional<ChunkBuffer> value(ChunkBuffer{});
+  if (!Lookup(key, *value))
+    value = boost::none;
+  return value;
+}
+
+void ShardedMemoryCache::Delete(const KeyType& key) {
+  HashedKey hashed_key(Hash(key));
+  Shard& shard(GetShard(hashed_key));
+  std::lock_guard<detail::SharedSpinMutex> lock(shard.mutex);
+  auto itr(shard.index.find(hashed_key));
+  if (itr == shard.index.end())
+    BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+  Erase(shard, itr->second);
+}
+
+MemoryUsage ShardedMemoryCache::GetMaxMemoryUsage() const { return MemoryUsage(kMaxMemoryUsage_); }
+
+MemoryUsage ShardedMemoryCache::GetCurrentMemoryUsage() const {
+  uint64_t usage(0);
+  for (const auto& shard : shards_) {
+    SharedLock lock(shard->mutex);
+    usage += shard->current_memory_usage;
+  }
+  return MemoryUsage(usage);
+}
+
+CacheStatistics ShardedMemoryCache::GetStatistics() const {
+  CacheStatistics statistics;
+  for (const auto& shard : shards_)
+    statistics += shard->counters.Get();
+  return statistics;
+}
+
+size_t ShardedMemoryCache::Size() const {
+  size_t size(0);
+  for (const auto& shard : shards_) {
+    SharedLock lock(shard->mutex);
+    size += shard->index.size();
+  }
+  return size;
+}
+
+ShardedMemoryCache::HashedKey ShardedMemoryCache::Hash(const KeyType& key) const {
+  HashedKey hashed_key = {kHash_(key), &key};
+  return hashed_key;
+}
+
+ShardedMemoryCache::Shard& ShardedMemoryCache::GetShard(const HashedKey& hashed_key) {
+  // The shard's unordered_map picks buckets from the same hash, so shard on its higher bits.
+  return *shards_[(hashed_key.hash >> 17) & (shards_.size() - 1)];
+}
+
+bool ShardedMemoryCache::Lookup(const KeyType& key, ChunkBuffer& value) {
+  HashedKey hashed_key(Hash(key));
+  if (frequency_sketch_)
+    frequency_sketch_->Increment(hashed_key.hash);
+  Shard& shard(GetShard(hashed_key));
+  SharedLock lock(shard.mutex);
+  auto itr(shard.index.find(hashed_key));
+  if (itr == shard.index.end()) {
+    shard.counters.Miss();
+    return false;
+  }
+  shard.counters.Hit(itr->second->value.size());
+  // Only written if clear, to avoid bouncing the cache line between readers of a hot entry.
+  if (!itr->second->referenced.load(std::memory_order_relaxed))
+    itr->second->referenced.store(true, std::memory_order_relaxed);
+  value = itr->second->value;
+  return true;
+}
+
+std::list<ShardedMemoryCache::Entry>::iterator ShardedMemoryCache::NextVictim(Shard& shard) {
+  for (;;) {
+    if (shard.hand == shard.entries.end())
+      shard.hand = shard.entries.begin();
+    if (!shard.hand->referenced.load(std::memory_order_relaxed))
+      return shard.hand;
+    shard.hand->referenced.store(false, std::memory_order_relaxed);
+    ++shard.hand;
+  }
+}
+
+void ShardedMemoryCache::Evict(Shard& shard, uint64_t required,
+                               std::vector<std::pair<KeyType, ChunkBuffer>>& demoted) {
+  while (shard.current_memory_usage + required > kShardMemoryUsage_) {
+    auto victim(NextVictim(shard));
+    if (victim->demote && on_eviction_)
+      demoted.push_back(std::make_pair(victim->key, victim->value));
+    Erase(shard, victim);
+  }
+}
+
+void ShardedMemoryCache::Erase(Shard& shard, std::list<Entry>::iterator itr) {
+  if (itr == shard.hand)
+    ++shard.hand;
+  shard.current_memory_usage -= itr->value.size();
+  HashedKey hashed_key = {itr->hash, &itr->key};
+  shard.index.erase(hashed_key);
+  shard.entries.erase(itr);
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,177 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_SHARDED_MEMORY_CACHE_H_
+#define MAIDSAFE_VAULT_SHARDED_MEMORY_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "boost/optional/optional.hpp"
+
+#include "maidsafe/common/types.h"
+#include "maidsafe/common/data_types/data_name_variant.h"
+
+#include "maidsafe/vault/cache_statistics.h"
+#include "maidsafe/vault/chunk_buffer.h"
+#include "maidsafe/vault/frequency_sketch.h"
+#include "maidsafe/vault/memory_cache.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Reader-writer spinlock for short critical sections.  Taking it shared is a single atomic add
+// when there's no writer, so readers never wait for each other.  A waiting writer holds off new
+// readers, so it can't be starved by them.  Meets the SharedMutex requirements.
+class SharedSpinMutex {
+ public:
+  SharedSpinMutex() : state_(0) {}
+  SharedSpinMutex(const SharedSpinMutex&) = delete;
+  SharedSpinMutex& operator=(const SharedSpinMutex&) = delete;
+
+  void lock();
+  void unlock();
+  void lock_shared();
+  void unlock_shared();
+
+ private:
+  static const uint32_t kWriter = 1, kWriterWaiting = 2, kReader = 4;
+  std::atomic<uint32_t> state_;
+};
+
+}  // namespace detail
+
+// In-memory chunk cache for lookups from many threads at once, bounded (like MemoryCache) by the
+// total size of the values held.
+//
+// Keys are spread over a number of shards, each with its own lock and an equal share of the
+// capacity.  Lookups take a shard's lock shared (see detail::SharedSpinMutex), so concurrent
+// lookups never wait for each other; only stores and deletes take it exclusively.  Since a lookup
+// can't reorder a recency list under a shared lock, eviction uses the CLOCK approximation of LRU: a
+// lookup just sets the entry's reference bit, and the eviction hand gives referenced entries a
+// second chance.
+//
+// If given a FrequencySketch, every lookup and store is recorded in it, and a new entry which
+// requires an eviction is only admitted if it has been accessed more often than the entry the
+// hand would evict.  This stops a scan of chunks each seen once from pushing out popular ones.
+//
+// Entries stored with 'demote' set are passed to the eviction functor, if any, when evicted to
+// make room, so that they can be moved to a lower tier rather than dropped.
+class ShardedMemoryCache {
+ public:
+  typedef DataNameVariant KeyType;
+  typedef std::function<void(const KeyType&, const ChunkBuffer&)> EvictionFunctor;
+
+  // 'shard_count' is rounded up to a power of two.  Zero selects a count (at most 16) from the
+  // number of hardware threads, reduced if need be to give each shard at least 1Mb.
+  // 'frequency_sketch', if not null, must outlive the cache.  'on_eviction' is invoked on the
+  // storing thread, after the shard's lock has been released.
+  explicit ShardedMemoryCache(MemoryUsage max_memory_usage, size_t shard_count = 0,
+                              FrequencySketch* frequency_sketch = nullptr,
+                              EvictionFunctor on_eviction = EvictionFunctor());
+  ShardedMemoryCache(const ShardedMemoryCache&) = delete;
+  ShardedMemoryCache& operator=(const ShardedMemoryCache&) = delete;
+  ~ShardedMemoryCache() = default;
+
+  // A value larger than a shard's capacity, or refused admission, isn't stored (and replaces no
+  // existing value).  Returns whether the value was stored.
+  bool Store(const KeyType& key, const NonEmptyString& value, bool demote = false);
+  bool Store(const KeyType& key, const ChunkBuffer& value, bool demote = false);
+  // Throw no_such_element if 'key' isn't held.
+  NonEmptyString Get(const KeyType& key);
+  ChunkBuffer GetBuffer(const KeyType& key);
+  void Delete(const KeyType& key);
+  // As GetBuffer, but reports a miss without throwing.
+  boost::optional<ChunkBuffer> Find(const KeyType& key);
+
+  MemoryUsage GetMaxMemoryUsage() const;
+  MemoryUsage GetCurrentMemoryUsage() const;
+  size_t Size() const;
+  size_t ShardCount() const { return shards_.size(); }
+  CacheStatistics GetStatistics() const;
+
+ private:
+  struct Entry {
+    Entry(const KeyType& key_in, size_t hash_in, const ChunkBuffer& value_in, bool demote_in)
+        : key(key_in), hash(hash_in), value(value_in), demote(demote_in), referenced(false) {}
+    const KeyType key;
+    const size_t hash;
+    ChunkBuffer value;
+    const bool demote;
+    std::atomic<bool> referenced;
+  };
+
+  // Index key referring to the key held in the entry, so each lookup hashes the key only once
+  // (for both the shard and the bucket) and the index holds no copy of it.
+  struct HashedKey {
+    size_t hash;
+    const KeyType* key;
+  };
+  struct HashedKeyHash {
+    size_t operator()(const HashedKey& hashed_key) const { return hashed_key.hash; }
+  };
+  struct HashedKeyEqual {
+    bool operator()(const HashedKey& lhs, const HashedKey& rhs) const {
+      return lhs.hash == rhs.hash && *lhs.key == *rhs.key;
+    }
+  };
+
+  struct Shard {
+    Shard()
+        : mutex(), current_memory_usage(0), entries(), index(), hand(entries.end()), counters() {}
+    mutable detail::SharedSpinMutex mutex;
+    uint64_t current_memory_usage;
+    // In CLOCK order; new entries are inserted just behind 'hand', so are the last considered.
+    std::list<Entry> entries;
+    std::unordered_map<HashedKey, std::list<Entry>::iterator, HashedKeyHash, HashedKeyEqual> index;
+    std::list<Entry>::iterator hand;
+    CacheCounters counters;
+  };
+
+  HashedKey Hash(const KeyType& key) const;
+  Shard& GetShard(const HashedKey& hashed_key);
+  bool Lookup(const KeyType& key, ChunkBuffer& value);
+  // These require the shard's lock to be held exclusively.  NextVictim advances the hand to the
+  // next entry to be evicted, clearing the reference bits it passes; 'shard' mustn't be empty.
+  std::list<Entry>::iterator NextVictim(Shard& shard);
+  // Appends the evicted entries to be demoted to 'demoted'.
+  void Evict(Shard& shard, uint64_t required,
+             std::vector<std::pair<KeyType, ChunkBuffer>>& demoted);
+  void Erase(Shard& shard, std::list<Entry>::iterator itr);
+
+  const uint64_t kMaxMemoryUsage_, kShardMemoryUsage_;
+  const detail::DataNameVariantHash kHash_;
+  FrequencySketch* const frequency_sketch_;
+  const EvictionFunctor on_eviction_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_SHARDED_MEMORY_CACHE_H_
@@ -0,0 +1,359 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/sqlite_backend.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+StatementCache::Handle StatementCache::Get(const std::string& query) {
+  auto& statement(statements_[query]);
+  if (!statement)
+    statement.reset(new sqlite::Statement(data_base_, query));
+  return Handle(statement.get());
+}
+
+namespace {
+
+const int kCheckPointInterval(1000);
+
+}  // unnamed namespace
+
+WriteBatcher::WriteBatcher(sqlite::Database& data_base, std::mutex& mutex, WriteFunctor write)
+    : data_base_(data_base),
+      mutex_(mutex),
+      kWrite_(write),
+      transaction_(),
+      opened_(),
+      window_(),
+      pending_writes_(0),
+      writes_since_checkpoint_(0),
+      error_(),
+      max_delay_(0),
+      max_writes_(1),
+      stop_(false),
+      condition_(),
+      flusher_() {}
+
+WriteBatcher::~WriteBatcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    try {
+      Flush();
+    }
+    catch (const std::exception& e) {
+      LOG(kError) << "Failed to commit pending writes: " << boost::diagnostic_information(e);
+    }
+  }
+  condition_.notify_one();
+  if (flusher_.joinable())
+    flusher_.join();
+}
+
+void WriteBatcher::SetWindow(std::chrono::milliseconds max_delay, int max_writes) {
+  max_delay_ = std::max(max_delay, std::chrono::milliseconds(0));
+  max_writes_ = std::max(max_writes, 1);
+  if (max_delay_ == std::chrono::milliseconds(0))
+    return Flush();
+  if (!flusher_.joinable())
+    flusher_ = std::thread([this] { Run(); });
+  condition_.notify_one();
+}
+
+void WriteBatcher::Flush() {
+  if (transaction_)
+    Commit();
+  ThrowIfFailed();
+}
+
+void WriteBatcher::Begin(bool atomic) {
+  ThrowIfFailed();
+  if (!transaction_ && (atomic || max_delay_ != std::chrono::milliseconds(0))) {
+    transaction_.reset(new sqlite::Transaction(data_base_));
+    opened_ = std::chrono::steady_clock::now();
+    pending_writes_ = 0;
+  }
+}
+
+void WriteBatcher::End(const KeyValueBackend::WriteBatch& writes) {
+  writes_since_checkpoint_ += static_cast<int>(writes.size());
+  if (!transaction_) {
+    if (writes_since_checkpoint_ > kCheckPointInterval) {
+      data_base_.CheckPoint();
+      writes_since_checkpoint_ = 0;
+    }
+    return;
+  }
+  window_.push_back(writes);
+  pending_writes_ += static_cast<int>(writes.size());
+  if (max_delay_ == std::chrono::milliseconds(0) || pending_writes_ >= max_writes_)
+    Commit();
+  else
+    condition_.notify_one();
+}
+
+void WriteBatcher::Abort() {
+  // Rolls back the earlier writes in the window too, so they're made again.
+  transaction_.reset();
+  std::vector<KeyValueBackend::WriteBatch> window;
+  window.swap(window_);
+  try {
+    Rewrite(window);
+  }
+  catch (const std::exception& e) {
+    LOG(kError) << "Failed to rewrite " << window.size() << " writes after a failed write: "
+                << boost::diagnostic_information(e);
+    if (!error_)
+      error_ = std::current_exception();
+  }
+}
+
+void WriteBatcher::Commit() {
+  std::unique_ptr<sqlite::Transaction> transaction(std::move(transaction_));
+  std::vector<KeyValueBackend::WriteBatch> window;
+  window.swap(window_);
+  try {
+    transaction->Commit();
+  }
+  catch (const std::exception& e) {
+    LOG(kWarning) << "Failed to commit " << window.size() << " writes together, so making each "
+                  << "on its own: " << boost::diagnostic_information(e);
+    transaction.reset();
+    Rewrite(window);
+  }
+  if (writes_since_checkpoint_ > kCheckPointInterval) {
+    data_base_.CheckPoint();
+    writes_since_checkpoint_ = 0;
+  }
+}
+
+void WriteBatcher::Rewrite(const std::vector<KeyValueBackend::WriteBatch>& window) {
+  std::exception_ptr error;
+  for (const auto& writes : window) {
+    try {
+      kWrite_(writes);
+    }
+    catch (const std::exception&) {
+      if (!error)
+        error = std::current_exception();
+    }
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
+void WriteBatcher::ThrowIfFailed() {
+  if (!error_)
+    return;
+  std::exception_ptr error(error_);
+  error_ = std::exception_ptr();
+  std::rethrow_exception(error);
+}
+
+void WriteBatcher::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    if (!transaction_ || max_delay_ == std::chrono::milliseconds(0)) {
+      condition_.wait(lock);
+      continue;
+    }
+    auto due(opened_ + max_delay_);
+    if (std::chrono::steady_clock::now() < due) {
+      condition_.wait_until(lock, due);
+      continue;
+    }
+    try {
+      Commit();
+    }
+    catch (const std::exception& e) {
+      LOG(kError) << "Failed to commit writes of an expired window, which will be reported to the "
+                  << "next writer: " << boost::diagnostic_information(e);
+      if (!error_)
+        error_ = std::current_exception();
+    }
+  }
+}
+
+}  // namespace detail
+
+class SqliteBackend::SqliteSnapshot : public KeyValueBackend::Snapshot {
+ public:
+  explicit SqliteSnapshot(const boost::filesystem::path& db_path)
+      : data_base_(db_path, sqlite::Mode::kReadWrite), statements_(data_base_) {
+    // A deferred transaction only takes its snapshot on the first read.
+    data_base_.Execute("BEGIN TRANSACTION");
+    statements_.Get("SELECT 1 FROM KeyValuePairs LIMIT 1")->Step();
+  }
+
+  ~SqliteSnapshot() {
+    try {
+      data_base_.Execute("ROLLBACK TRANSACTION");
+    }
+    catch (const std::exception& e) {
+      LOG(kWarning) << "Failed to end snapshot: " << boost::diagnostic_information(e);
+    }
+  }
+
+  bool Get(const std::string& key, std::string& value) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return GetValue(statements_, key, value);
+  }
+
+  void Scan(const std::string& begin, const std::string& end,
+            const ScanFunctor& functor) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ScanRange(statements_, begin, end, functor);
+  }
+
+  static bool GetValue(detail::StatementCache& statements, const std::string& key,
+                       std::string& value) {
+    auto statement(statements.Get("SELECT VALUE FROM KeyValuePairs WHERE KEY=?"));
+    statement->BindText(1, key);
+    if (statement->Step() != sqlite::StepResult::kSqliteRow)
+      return false;
+    value = statement->ColumnText(0);
+    return true;
+  }
+
+  static void ScanRange(detail::StatementCache& statements, const std::string& begin,
+                        const std::string& end, const ScanFunctor& functor) {
+    auto statement(end.empty() ?
+        statements.Get("SELECT KEY, VALUE FROM KeyValuePairs WHERE KEY>=? ORDER BY KEY") :
+        statements.Get(
+            "SELECT KEY, VALUE FROM KeyValuePairs WHERE KEY>=? AND KEY<? ORDER BY KEY"));
+    statement->BindText(1, begin);
+    if (!end.empty())
+      statement->BindText(2, end);
+    while (statement->Step() == sqlite::StepResult::kSqliteRow) {
+      if (!functor(statement->ColumnText(0), statement->ColumnText(1)))
+        return;
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  sqlite::Database data_base_;
+  detail::StatementCache statements_;
+};
+
+SqliteBackend::SqliteBackend(const boost::filesystem::path& db_path)
+    : kDbPath_(db_path), mutex_(), data_base_(), statements_(), batcher_() {
+  data_base_.reset(new sqlite::Database(kDbPath_, sqlite::Mode::kReadWriteCreate));
+  std::string query(
+      "CREATE TABLE IF NOT EXISTS KeyValuePairs ("
+      "KEY TEXT  PRIMARY KEY NOT NULL, VALUE TEXT NOT NULL);");
+  sqlite::Transaction transaction{*data_base_};
+  sqlite::Statement statement{*data_base_, query};
+  statement.Step();
+  transaction.Commit();
+  statements_.reset(new detail::StatementCache(*data_base_));
+  batcher_.reset(new detail::WriteBatcher(*data_base_, mutex_,
+                                          [this](const WriteBatch& batch) { WriteNow(batch); }));
+}
+
+SqliteBackend::~SqliteBackend() {
+  // The batcher commits any writes pending in the group-commit window, and so must go first.
+  batcher_.reset();
+  statements_.reset();
+}
+
+bool SqliteBackend::Get(const std::string& key, std::string& value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return SqliteSnapshot::GetValue(*statements_, key, value);
+}
+
+void SqliteBackend::Put(const std::string& key, const std::string& value) {
+  WriteBatch batch;
+  batch.insert(std::make_pair(key, boost::optional<std::string>(value)));
+  Write(batch);
+}
+
+void SqliteBackend::Delete(const std::string& key) {
+  WriteBatch batch;
+  batch.insert(std::make_pair(key, boost::optional<std::string>()));
+  Write(batch);
+}
+
+void SqliteBackend::Scan(const std::string& begin, const std::string& end,
+                         const ScanFunctor& functor) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  SqliteSnapshot::ScanRange(*statements_, begin, end, functor);
+}
+
+// Outside a group-commit window, single statements run in SQLite's autocommit mode, which makes
+// each atomic without the cost of separate BEGIN and COMMIT statements.
+void SqliteBackend::Write(const WriteBatch& batch) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  detail::WriteBatcher::Scope scope(*batcher_, batch.size() > 1);
+  Apply(batch);
+  scope.Close(batch);
+}
+
+std::unique_ptr<KeyValueBackend::Snapshot> SqliteBackend::GetSnapshot() {
+  {
+    // Writes pending in the group-commit window aren't visible to another connection.
+    std::lock_guard<std::mutex> lock(mutex_);
+    batcher_->Flush();
+  }
+  return std::unique_ptr<Snapshot>(new SqliteSnapshot(kDbPath_));
+}
+
+void SqliteBackend::SetGroupCommitWindow(std::chrono::milliseconds max_delay, int max_writes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  batcher_->SetWindow(max_delay, max_writes);
+}
+
+void SqliteBackend::Apply(const WriteBatch& batch) {
+  for (const auto& write : batch) {
+    if (write.second) {
+      auto statement(statements_->Get(
+          "INSERT OR REPLACE INTO KeyValuePairs (KEY, VALUE) VALUES (?, ?)"));
+      statement->BindText(1, write.first);
+      statement->BindText(2, *write.second);
+      statement->Step();
+    } else {
+      auto statement(statements_->Get("DELETE FROM KeyValuePairs WHERE KEY=?"));
+      statement->BindText(1, write.first);
+      statement->Step();
+    }
+  }
+}
+
+void SqliteBackend::WriteNow(const WriteBatch& batch) {
+  if (batch.size() < 2)
+    return Apply(batch);
+  sqlite::Transaction transaction(*data_base_);
+  Apply(batch);
+  transaction.Commit();
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,187 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_SQLITE_BACKEND_H_
+#define MAIDSAFE_VAULT_SQLITE_BACKEND_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/sqlite3_wrapper.h"
+
+#include "maidsafe/vault/key_value_backend.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace detail {
+
+// Prepared statements of one connection, keyed by their SQL, so that each is compiled only once
+// rather than on every use.  Not thread-safe.
+class StatementCache {
+  struct Resetter {
+    void operator()(sqlite::Statement* statement) const { statement->Reset(); }
+  };
+
+ public:
+  // Resets rather than destroys the statement when it goes out of scope, releasing any lock held by
+  // a query which wasn't stepped to completion.  The next use rebinds its parameters.
+  typedef std::unique_ptr<sqlite::Statement, Resetter> Handle;
+
+  explicit StatementCache(sqlite::Database& data_base) : data_base_(data_base), statements_() {}
+  StatementCache(const StatementCache&) = delete;
+  StatementCache& operator=(const StatementCache&) = delete;
+
+  // 'data_base' must outlive the returned handle, and only one handle for a given query may be
+  // held at a time.
+  Handle Get(const std::string& query);
+
+ private:
+  sqlite::Database& data_base_;
+  std::map<std::string, std::unique_ptr<sqlite::Statement>> statements_;
+};
+
+// Groups the writes made on one connection into transactions, and checkpoints the connection's
+// write-ahead log between them.  A single-statement write runs in SQLite's autocommit mode unless
+// a group-commit window is set, in which case successive writes accumulate in one transaction,
+// committed once it holds 'max_writes' writes or has been open for 'max_delay'.
+//
+// The writes in an open window are kept, so that if its transaction fails to commit, or is rolled
+// back by a failed write, they're made again each on its own through 'write'.  If any of those
+// fail too, the error is thrown to the writer whose write caused the commit, or if the window
+// expired, to the next writer or caller of Flush.
+//
+// 'mutex' guards the connection; it must be held by the caller of every member other than the
+// constructor and destructor, and is taken by the thread which commits an expired window.
+class WriteBatcher {
+ public:
+  // Makes the writes atomically, without a window.  Called with 'mutex' held.
+  typedef std::function<void(const KeyValueBackend::WriteBatch& writes)> WriteFunctor;
+
+  // Marks the extent of a write, which is 'atomic' if it may run several statements.  Unless Close
+  // is called, the write is rolled back on destruction.
+  class Scope {
+   public:
+    explicit Scope(WriteBatcher& batcher, bool atomic = false) : batcher_(batcher), closed_(false) {
+      batcher_.Begin(atomic);
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    ~Scope() {
+      if (!closed_)
+        batcher_.Abort();
+    }
+    void Close(const KeyValueBackend::WriteBatch& writes) {
+      closed_ = true;
+      batcher_.End(writes);
+    }
+
+   private:
+    WriteBatcher& batcher_;
+    bool closed_;
+  };
+
+  WriteBatcher(sqlite::Database& data_base, std::mutex& mutex, WriteFunctor write);
+  WriteBatcher(const WriteBatcher&) = delete;
+  WriteBatcher& operator=(const WriteBatcher&) = delete;
+  // Commits any writes pending in the window.  'mutex' must not be held.
+  ~WriteBatcher();
+
+  // A zero 'max_delay' disables the window, first committing any writes pending in it.
+  void SetWindow(std::chrono::milliseconds max_delay, int max_writes);
+  // Commits any writes pending in the window.  Throws the error of an expired window's failed
+  // commit, if not yet thrown.
+  void Flush();
+
+ private:
+  void Begin(bool atomic);
+  void End(const KeyValueBackend::WriteBatch& writes);
+  void Abort();
+  void Commit();
+  // Makes each of the window's writes on its own, throwing the first error once all are tried.
+  void Rewrite(const std::vector<KeyValueBackend::WriteBatch>& window);
+  void ThrowIfFailed();
+  void Run();
+
+  sqlite::Database& data_base_;
+  std::mutex& mutex_;
+  const WriteFunctor kWrite_;
+  std::unique_ptr<sqlite::Transaction> transaction_;
+  std::chrono::steady_clock::time_point opened_;
+  std::vector<KeyValueBackend::WriteBatch> window_;
+  int pending_writes_, writes_since_checkpoint_;
+  std::exception_ptr error_;
+  std::chrono::milliseconds max_delay_;
+  int max_writes_;
+  bool stop_;
+  std::condition_variable condition_;
+  std::thread flusher_;
+};
+
+}  // namespace detail
+
+// Stores the entries in a single table of an SQLite database in write-ahead logging mode.  Each
+// snapshot holds a read transaction open on a connection of its own.
+class SqliteBackend : public KeyValueBackend {
+ public:
+  explicit SqliteBackend(const boost::filesystem::path& db_path);
+  SqliteBackend(const SqliteBackend&) = delete;
+  SqliteBackend& operator=(const SqliteBackend&) = delete;
+  ~SqliteBackend();
+
+  bool Get(const std::string& key, std::string& value) override;
+  void Put(const std::string& key, const std::string& value) override;
+  void Delete(const std::string& key) override;
+  void Scan(const std::string& begin, const std::string& end,
+            const ScanFunctor& functor) override;
+  void Write(const WriteBatch& batch) override;
+  std::unique_ptr<Snapshot> GetSnapshot() override;
+  void SetGroupCommitWindow(std::chrono::milliseconds max_delay, int max_writes) override;
+
+ private:
+  class SqliteSnapshot;
+
+  // These require mutex_ to be held.
+  void Apply(const WriteBatch& batch);
+  // Makes the writes atomically, outside any group-commit window.
+  void WriteNow(const WriteBatch& batch);
+
+  const boost::filesystem::path kDbPath_;
+  std::mutex mutex_;
+  std::unique_ptr<sqlite::Database> data_base_;
+  std::unique_ptr<detail::StatementCache> statements_;
+  std::unique_ptr<detail::WriteBatcher> batcher_;
+};
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_SQLITE_BACKEND_H_
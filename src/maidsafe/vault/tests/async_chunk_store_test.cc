@@ -0,0 +1,182 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/async_chunk_store.h"
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "boost/filesystem/path.hpp"
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/vault/tests/chunk_store_test_utils.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+const uint64_t OneKB(1024);
+
+class AsyncChunkStoreTest : public testing::Test {
+ public:
+  typedef AsyncChunkStore::KeyType KeyType;
+  typedef std::vector<std::pair<KeyType, NonEmptyString>> KeyValueContainer;
+
+ protected:
+  AsyncChunkStoreTest()
+      : test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_AsyncChunkStore")),
+        chunk_store_path_(*test_path / "async_chunk_store"),
+        chunk_store_(new AsyncChunkStore(chunk_store_path_, DiskUsage(1000 * OneKB), 4)) {}
+
+  maidsafe::test::TestPath test_path;
+  fs::path chunk_store_path_;
+  std::unique_ptr<AsyncChunkStore> chunk_store_;
+};
+
+TEST_F(AsyncChunkStoreTest, BEH_PutGetDelete) {
+  KeyValueContainer key_value_pairs;
+  AddRandomKeyValuePairs(key_value_pairs, 1, OneKB);
+  const KeyType& key(key_value_pairs.front().first);
+  const NonEmptyString& value(key_value_pairs.front().second);
+
+  EXPECT_THROW(chunk_store_->Get(key).get(), std::exception);
+  ASSERT_NO_THROW(chunk_store_->Put(key, value).get());
+  NonEmptyString recovered;
+  ASSERT_NO_THROW(recovered = chunk_store_->Get(key).get());
+  EXPECT_TRUE(recovered == value);
+  EXPECT_EQ(OneKB, chunk_store_->GetCurrentDiskUsage().data);
+  ASSERT_NO_THROW(chunk_store_->Delete(key).get());
+  EXPECT_THROW(chunk_store_->Get(key).get(), std::exception);
+  EXPECT_EQ(0U, chunk_store_->GetCurrentDiskUsage().data);
+
+  // Failures are reported through the future, not thrown on submission.
+  std::future<void> result;
+  EXPECT_NO_THROW(result = chunk_store_->Put(key, NonEmptyString(std::string(1001 * OneKB, 'a'))));
+  EXPECT_THROW(result.get(), std::exception);
+}
+
+TEST_F(AsyncChunkStoreTest, BEH_PutGetBuffer) {
+  KeyValueContainer key_value_pairs;
+  AddRandomKeyValuePairs(key_value_pairs, 1, OneKB);
+  const KeyType& key(key_value_pairs.front().first);
+  ChunkBuffer value(key_value_pairs.front().second);
+
+  EXPECT_THROW(chunk_store_->GetBuffer(key).get(), std::exception);
+  ASSERT_NO_THROW(chunk_store_->Put(key, value).get());
+  ChunkBuffer recovered;
+  ASSERT_NO_THROW(recovered = chunk_store_->GetBuffer(key).get());
+  EXPECT_TRUE(recovered == value);
+  EXPECT_TRUE(chunk_store_->Get(key).get() == value.value());
+  EXPECT_EQ(OneKB, chunk_store_->GetCurrentDiskUsage().data);
+
+  // Buffer and string puts of the same key are interchangeable.
+  NonEmptyString other_value(RandomAlphaNumericString(OneKB / 2));
+  ASSERT_NO_THROW(chunk_store_->Put(key, other_value).get());
+  EXPECT_TRUE(chunk_store_->GetBuffer(key).get().value() == other_value);
+  EXPECT_EQ(OneKB / 2, chunk_store_->GetCurrentDiskUsage().data);
+  EXPECT_TRUE(recovered == value);
+}
+
+TEST_F(AsyncChunkStoreTest, BEH_OrderedPerKey) {
+  KeyValueContainer key_value_pairs;
+  AddRandomKeyValuePairs(key_value_pairs, 1, OneKB);
+  const KeyType& key(key_value_pairs.front().first);
+
+  // Operations on one key, submitted without waiting, must be applied in submission order.
+  std::vector<NonEmptyString> values;
+  std::vector<std::future<NonEmptyString>> gets;
+  for (int i(0); i != 50; ++i) {
+    values.push_back(NonEmptyString(RandomAlphaNumericString((RandomUint32() % 100) + 1)));
+    chunk_store_->Put(key, values.back(), [](std::future<void> result) { result.get(); });
+    gets.push_back(chunk_store_->Get(key));
+  }
+  for (size_t i(0); i != gets.size(); ++i)
+    EXPECT_TRUE(gets[i].get() == values[i]);
+
+  chunk_store_->Delete(key, [](std::future<void> result) { result.get(); });
+  EXPECT_THROW(chunk_store_->Get(key).get(), std::exception);
+}
+
+TEST_F(AsyncChunkStoreTest, BEH_Batch) {
+  KeyValueContainer key_value_pairs;
+  AddRandomKeyValuePairs(key_value_pairs, 100, OneKB);
+
+  std::promise<std::vector<std::future<void>>> put_promise;
+  chunk_store_->Put(key_value_pairs, [&put_promise](std::vector<std::future<void>> results) {
+    put_promise.set_value(std::move(results));
+  });
+  auto put_results(put_promise.get_future().get());
+  ASSERT_EQ(key_value_pairs.size(), put_results.size());
+  for (auto& result : put_results)
+    EXPECT_NO_THROW(result.get());
+  EXPECT_EQ(key_value_pairs.size() * OneKB, chunk_store_->GetCurrentDiskUsage().data);
+
+  std::vector<KeyType> keys;
+  for (const auto& key_value : key_value_pairs)
+    keys.push_back(key_value.first);
+  keys.push_back(GetRandomDataNameType());
+  std::promise<std::vector<std::future<NonEmptyString>>> get_promise;
+  chunk_store_->Get(keys, [&get_promise](std::vector<std::future<NonEmptyString>> results) {
+    get_promise.set_value(std::move(results));
+  });
+  auto get_results(get_promise.get_future().get());
+  ASSERT_EQ(keys.size(), get_results.size());
+  for (size_t i(0); i != key_value_pairs.size(); ++i)
+    EXPECT_TRUE(get_results[i].get() == key_value_pairs[i].second);
+  EXPECT_THROW(get_results.back().get(), std::exception);
+
+  std::promise<size_t> empty_promise;
+  chunk_store_->Get(std::vector<KeyType>(),
+                    [&empty_promise](std::vector<std::future<NonEmptyString>> results) {
+                      empty_promise.set_value(results.size());
+                    });
+  EXPECT_EQ(0U, empty_promise.get_future().get());
+}
+
+TEST_F(AsyncChunkStoreTest, BEH_DestructorWaitsForQueuedOperations) {
+  KeyValueContainer key_value_pairs;
+  AddRandomKeyValuePairs(key_value_pairs, 100, OneKB);
+  std::atomic<size_t> completed(0);
+  for (const auto& key_value : key_value_pairs) {
+    chunk_store_->Put(key_value.first, key_value.second, [&completed](std::future<void> result) {
+      result.get();
+      ++completed;
+    });
+  }
+  chunk_store_.reset();
+  EXPECT_EQ(key_value_pairs.size(), completed);
+
+  chunk_store_.reset(new AsyncChunkStore(chunk_store_path_, DiskUsage(1000 * OneKB), 4));
+  EXPECT_EQ(key_value_pairs.size() * OneKB, chunk_store_->GetCurrentDiskUsage().data);
+  EXPECT_EQ(key_value_pairs.size(), chunk_store_->GetKeys().size());
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
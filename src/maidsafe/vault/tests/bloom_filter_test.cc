@@ -0,0 +1,70 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/vault/bloom_filter.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+TEST(BloomFilterTest, BEH_AddAndQuery) {
+  BloomFilter filter(1000, 0.01);
+  std::string item(RandomString(64));
+  EXPECT_FALSE(filter.MayContain(item));
+  EXPECT_TRUE(filter.Add(item));
+  EXPECT_TRUE(filter.MayContain(item));
+  // Adding an item again changes nothing.
+  EXPECT_FALSE(filter.Add(item));
+  EXPECT_EQ(1U, filter.size());
+  filter.Clear();
+  EXPECT_FALSE(filter.MayContain(item));
+  EXPECT_EQ(0U, filter.size());
+}
+
+TEST(BloomFilterTest, BEH_FalsePositiveRate) {
+  const size_t kCapacity(10000);
+  BloomFilter filter(kCapacity, 0.01);
+  std::vector<std::string> items;
+  for (size_t i(0); i != kCapacity; ++i) {
+    items.push_back(RandomString(64));
+    filter.Add(items.back());
+  }
+  for (const auto& item : items)
+    ASSERT_TRUE(filter.MayContain(item));
+
+  size_t false_positives(0);
+  for (size_t i(0); i != kCapacity; ++i) {
+    if (filter.MayContain(RandomString(64)))
+      ++false_positives;
+  }
+  EXPECT_LT(false_positives, kCapacity * 3 / 100);
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
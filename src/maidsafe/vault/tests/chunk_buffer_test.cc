@@ -0,0 +1,65 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/chunk_buffer.h"
+
+#include <string>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+TEST(ChunkBufferTest, BEH_OwnedContent) {
+  ChunkBuffer empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(0U, empty.size());
+  EXPECT_THROW(empty.value(), maidsafe_error);
+
+  NonEmptyString content(RandomString(1024));
+  ChunkBuffer buffer(content);
+  EXPECT_FALSE(buffer.empty());
+  ASSERT_EQ(content.string().size(), buffer.size());
+  EXPECT_TRUE(buffer.value() == content);
+  EXPECT_EQ(content.string(), std::string(buffer.data(), buffer.size()));
+
+  // Copies share the same bytes.
+  ChunkBuffer copy(buffer);
+  EXPECT_EQ(buffer.data(), copy.data());
+  EXPECT_EQ(&buffer.value(), &copy.value());
+  EXPECT_TRUE(buffer == copy);
+
+  // Content moved in isn't copied.
+  std::string moved_content(RandomString(1024));
+  const char* original_data(moved_content.data());
+  ChunkBuffer moved(NonEmptyString(std::move(moved_content)));
+  EXPECT_EQ(original_data, moved.data());
+  EXPECT_TRUE(moved != buffer);
+  EXPECT_TRUE(empty != buffer);
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,171 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/chunk_obfuscation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+namespace {
+
+const uint32_t kSizes[] = {1, 7, 16, 31, 64, 65, 4095, 4096, 4097, 65536 + 13};
+// Up to the largest chunk a vault stores.
+const uint32_t kChunkSizes[] = {63, 64, 65, 10000, 256 * 1024 + 1, 1024 * 1024 - 1, 1024 * 1024};
+
+std::string ApplyInPieces(const Identity& name, const std::string& input) {
+  std::string output(input.size(), 0);
+  ChunkObfuscator obfuscator(name, input.size());
+  size_t offset(0);
+  while (offset != input.size()) {
+    size_t piece(std::min<size_t>(input.size() - offset, (RandomUint32() % 5000) + 1));
+    obfuscator.Apply(input.data() + offset, piece, &output[offset]);
+    offset += piece;
+  }
+  return output;
+}
+
+}  // unnamed namespace
+
+TEST(ChunkObfuscationTest, BEH_XorFunctions) {
+  auto functions(detail::GetSupportedXorFunctions());
+  ASSERT_FALSE(functions.empty());
+  EXPECT_EQ(functions.back().second, detail::GetXorFunction());
+  for (auto size : kSizes) {
+    // Offsets misalign the buffers relative to each other and to the vector width.
+    std::string input(RandomString(size + 3)), keystream(RandomString(size + 5));
+    std::string expected(size, 0);
+    for (uint32_t i(0); i != size; ++i)
+      expected[i] = input[i + 3] ^ keystream[i + 5];
+    for (const auto& function : functions) {
+      std::string output(size + 1, 0);
+      function.second(input.data() + 3, keystream.data() + 5, &output[1], size);
+      EXPECT_EQ(expected, output.substr(1)) << function.first << " failed for size " << size;
+      // In place.
+      std::string in_place(input.substr(3));
+      function.second(in_place.data(), keystream.data() + 5, &in_place[0], size);
+      EXPECT_EQ(expected, in_place) << function.first << " failed in place for size " << size;
+    }
+  }
+}
+
+TEST(ChunkObfuscationTest, BEH_MatchesCrypto) {
+  for (int i(0); i != 4; ++i) {
+    Identity name(RandomString(64));
+    for (auto size : kSizes) {
+      NonEmptyString content(RandomString(size));
+      std::string expected(crypto::ObfuscateData(name, content).data.string());
+      std::string obfuscated(ObfuscateChunk(name, content));
+      ASSERT_EQ(expected, obfuscated) << "size " << size;
+      ASSERT_EQ(expected, ApplyInPieces(name, content.string()));
+
+      DeobfuscateChunk(name, obfuscated);
+      EXPECT_EQ(content.string(), obfuscated);
+      EXPECT_TRUE(crypto::DeobfuscateData(name, crypto::CipherText(NonEmptyString(expected))) ==
+                  content);
+    }
+  }
+}
+
+TEST(ChunkObfuscationTest, BEH_MatchesCryptoWholeChunks) {
+  for (auto size : kChunkSizes) {
+    Identity name(RandomString(64));
+    NonEmptyString content(RandomString(size));
+    std::string expected(crypto::ObfuscateData(name, content).data.string());
+    ASSERT_EQ(expected, ObfuscateChunk(name, content)) << "size " << size;
+    ASSERT_EQ(expected, ApplyInPieces(name, content.string())) << "size " << size;
+    std::string deobfuscated(expected);
+    DeobfuscateChunk(name, deobfuscated);
+    EXPECT_EQ(content.string(), deobfuscated) << "size " << size;
+  }
+}
+
+TEST(ChunkObfuscationTest, BEH_Apply) {
+  Identity name(RandomString(64));
+  for (auto size : kSizes) {
+    std::string content(RandomString(size)), whole(size, 0);
+    ChunkObfuscator(name, size).Apply(content.data(), size, &whole[0]);
+    if (size >= 16)
+      EXPECT_NE(content, whole);
+    EXPECT_EQ(whole, ApplyInPieces(name, content));
+    EXPECT_EQ(content, ApplyInPieces(name, whole));
+  }
+  ChunkObfuscator obfuscator(name, 10);
+  std::string buffer(11, 'a');
+  obfuscator.Apply(buffer.data(), 6, &buffer[0]);
+  EXPECT_THROW(obfuscator.Apply(buffer.data(), 5, &buffer[0]), maidsafe_error);
+  EXPECT_NO_THROW(obfuscator.Apply(buffer.data(), 4, &buffer[0]));
+}
+
+TEST(ChunkObfuscationTest, FUNC_Throughput) {
+  const size_t kChunkSize(1024 * 1024);
+  const int kIterations(200);
+  // As in ChunkObfuscator, the keystream is applied a cache-resident block at a time.
+  const size_t kBlockSize(4096);
+  std::string input(RandomString(kChunkSize)), keystream(RandomString(kBlockSize));
+  std::string output(input);
+  auto report([&](const std::string& name, std::chrono::steady_clock::duration duration) {
+    double seconds(std::chrono::duration<double>(duration).count());
+    std::cout << name << ": " << (kChunkSize * kIterations) / seconds / (1024 * 1024 * 1024)
+              << " GB/s" << std::endl;
+  });
+
+  for (const auto& function : detail::GetSupportedXorFunctions()) {
+    auto start(std::chrono::steady_clock::now());
+    for (int i(0); i != kIterations; ++i) {
+      for (size_t offset(0); offset != kChunkSize; offset += kBlockSize)
+        function.second(&output[offset], keystream.data(), &output[offset], kBlockSize);
+    }
+    report("XOR kernel " + function.first, std::chrono::steady_clock::now() - start);
+  }
+
+  NonEmptyString content(input);
+  Identity name(RandomString(64));
+  auto start(std::chrono::steady_clock::now());
+  for (int i(0); i != kIterations; ++i)
+    output = crypto::ObfuscateData(name, content).data.string();
+  report("crypto::ObfuscateData", std::chrono::steady_clock::now() - start);
+
+  start = std::chrono::steady_clock::now();
+  for (int i(0); i != kIterations; ++i)
+    output = ObfuscateChunk(name, content);
+  report("ObfuscateChunk", std::chrono::steady_clock::now() - start);
+
+  start = std::chrono::steady_clock::now();
+  for (int i(0); i != kIterations; ++i)
+    DeobfuscateChunk(name, output);
+  report("DeobfuscateChunk in place", std::chrono::steady_clock::now() - start);
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
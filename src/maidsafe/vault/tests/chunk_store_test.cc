@@ -18,7 +18,16 @@
 
 #include "maidsafe/vault/chunk_store.h"
 
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "boost/filesystem/path.hpp"
 #include "boost/filesystem/operations.hpp"
@@ -124,6 +133,21 @@ class ChunkStoreTest : public testing::Test {
     return boost::apply_visitor(generate_key_value_pair_, key);
   }
 
+  KeyType StoredName(const KeyType& key) const { return chunk_store_->StoredName(key); }
+
+  fs::path StoredFilePath(const KeyType& key) const {
+    return chunk_store_->KeyToFilePath(chunk_store_->StoredName(key));
+  }
+
+  // Returns whether a background snapshot was taken, and written.
+  bool WaitForSnapshot() {
+    if (!chunk_store_->snapshotter_.joinable())
+      return false;
+    chunk_store_->snapshotter_.join();
+    std::lock_guard<std::mutex> lock(chunk_store_->journal_mutex_);
+    return !chunk_store_->previous_journal_;
+  }
+
   void PrintResult(const pt::ptime& start_time, const pt::ptime& stop_time) {
     uint64_t duration = (stop_time - start_time).total_microseconds();
     if (duration == 0)
@@ -170,10 +194,12 @@ TEST_F(ChunkStoreTest, BEH_RemoveDiskStore) {
   EXPECT_THROW(chunk_store_->Put(key, small_value), std::exception);
   EXPECT_THROW(chunk_store_->Get(key), std::exception);
   EXPECT_THROW(chunk_store_->Delete(key), std::exception);
+  // Failed reads and deletes don't recreate any directories.
+  EXPECT_FALSE(fs::exists(chunk_store_path, error_code));
   chunk_store_.reset(new ChunkStore(chunk_store_path, DiskUsage(kDiskSize)));
   ASSERT_NO_THROW(chunk_store_->Put(key1, large_value));
   ASSERT_NO_THROW(chunk_store_->Delete(key1));
-  EXPECT_TRUE(6 != fs::remove_all(chunk_store_path, error_code));
+  EXPECT_TRUE(6 == fs::remove_all(chunk_store_path, error_code));
   ASSERT_FALSE(fs::exists(chunk_store_path, error_code));
   EXPECT_THROW(chunk_store_->Put(key, small_value), std::exception);
   EXPECT_THROW(chunk_store_->Get(key), std::exception);
@@ -233,6 +259,322 @@ TEST_F(ChunkStoreTest, BEH_RepeatedlyStoreUsingSameKey) {
   EXPECT_TRUE(last_value.string().size() == chunk_store_->GetCurrentDiskUsage().data);
 }
 
+TEST_F(ChunkStoreTest, BEH_OnDiskFormat) {
+  // Chunks must be stored exactly as crypto::ObfuscateData produces them, whatever their size.
+  for (uint32_t size : {1, 15, 64, 65, 1000, 3 * 1024 + 7}) {
+    KeyType key(GetRandomDataNameType());
+    NonEmptyString value(GenerateKeyValueData(key, size)), recovered;
+    Identity name(boost::apply_visitor(GetIdentityVisitor(), key));
+    ASSERT_NO_THROW(chunk_store_->Put(key, value));
+    std::string stored;
+    ASSERT_TRUE(ReadFile(StoredFilePath(key), &stored));
+    EXPECT_TRUE(crypto::ObfuscateData(name, value).data.string() == stored);
+
+    // And chunks written that way must be read back.
+    NonEmptyString other_value(RandomString(size));
+    ASSERT_TRUE(WriteFile(StoredFilePath(key),
+                          crypto::ObfuscateData(name, other_value).data.string()));
+    ASSERT_NO_THROW(recovered = chunk_store_->Get(key));
+    EXPECT_TRUE(other_value == recovered);
+    ASSERT_NO_THROW(chunk_store_->Delete(key));
+  }
+}
+
+TEST_F(ChunkStoreTest, BEH_DirectoryCreation) {
+  auto count_entries([this]() {
+    return std::distance(fs::recursive_directory_iterator(chunk_store_path_),
+                         fs::recursive_directory_iterator());
+  });
+  KeyType key(GetRandomDataNameType());
+  NonEmptyString value(GenerateKeyValueData(key, OneKB)), recovered;
+
+  // Reads and deletes of absent chunks mustn't create their directories.
+  auto initial_count(count_entries());
+  EXPECT_THROW(chunk_store_->Get(key), std::exception);
+  EXPECT_THROW(chunk_store_->Delete(key), std::exception);
+  EXPECT_EQ(initial_count, count_entries());
+
+  // Put recreates the directories if they've gone since the path was cached.
+  ASSERT_NO_THROW(chunk_store_->Put(key, value));
+  ASSERT_NO_THROW(chunk_store_->Delete(key));
+  ASSERT_TRUE(DeleteDirectory(chunk_store_path_));
+  ASSERT_NO_THROW(chunk_store_->Put(key, value));
+  ASSERT_NO_THROW(recovered = chunk_store_->Get(key));
+  EXPECT_TRUE(value == recovered);
+}
+
+TEST_F(ChunkStoreTest, BEH_PathCacheSizes) {
+  for (size_t cache_size : {0, 1, 3}) {
+    maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_ChunkStore"));
+    chunk_store_.reset(new ChunkStore(*test_path / "store", DiskUsage(20 * OneKB), cache_size));
+    KeyValueContainer key_value_pairs;
+    AddRandomKeyValuePairs(key_value_pairs, 10, OneKB);
+    for (int pass(0); pass != 2; ++pass) {
+      for (const auto& key_value : key_value_pairs) {
+        NonEmptyString recovered;
+        ASSERT_NO_THROW(chunk_store_->Put(key_value.first, key_value.second));
+        ASSERT_NO_THROW(recovered = chunk_store_->Get(key_value.first));
+        EXPECT_TRUE(key_value.second == recovered);
+      }
+    }
+    EXPECT_EQ(key_value_pairs.size() * OneKB, chunk_store_->GetCurrentDiskUsage().data);
+    for (const auto& key_value : key_value_pairs)
+      ASSERT_NO_THROW(chunk_store_->Delete(key_value.first));
+    EXPECT_EQ(0U, chunk_store_->GetCurrentDiskUsage().data);
+    chunk_store_.reset();
+  }
+}
+
+TEST_F(ChunkStoreTest, BEH_RestartFromManifest) {
+  KeyValueContainer key_value_pairs(PopulateChunkStore(100, 100, chunk_store_path_));
+  for (size_t i(0); i < key_value_pairs.size(); i += 2)
+    ASSERT_NO_THROW(chunk_store_->Delete(key_value_pairs[i].first));
+  DiskUsage disk_usage(chunk_store_->GetCurrentDiskUsage());
+  std::set<KeyType> all_keys;
+  for (const auto& key_value : key_value_pairs)
+    all_keys.insert(key_value.first);
+
+  chunk_store_.reset();
+  fs::path manifest_path(chunk_store_path_.string() + ".manifest");
+  EXPECT_TRUE(fs::exists(manifest_path));
+  chunk_store_.reset(new ChunkStore(chunk_store_path_, DiskUsage(100 * OneKB)));
+  EXPECT_EQ(disk_usage.data, chunk_store_->GetCurrentDiskUsage().data);
+  EXPECT_EQ(key_value_pairs.size() / 2, chunk_store_->GetKeys().size());
+  EXPECT_EQ(key_value_pairs.size() / 2, chunk_store_->ElementsToStore(all_keys).size());
+
+  // Without a manifest the index is rebuilt by scanning the disk root.
+  chunk_store_.reset();
+  EXPECT_TRUE(WriteFile(manifest_path, "corrupt"));
+  chunk_store_.reset(new ChunkStore(chunk_store_path_, DiskUsage(100 * OneKB)));
+  EXPECT_EQ(disk_usage.data, chunk_store_->GetCurrentDiskUsage().data);
+  EXPECT_EQ(key_value_pairs.size() / 2, chunk_store_->GetKeys().size());
+  for (size_t i(1); i < key_value_pairs.size(); i += 2) {
+    NonEmptyString recovered;
+    ASSERT_NO_THROW(recovered = chunk_store_->Get(key_value_pairs[i].first));
+    EXPECT_TRUE(key_value_pairs[i].second == recovered);
+  }
+}
+
+TEST_F(ChunkStoreTest, BEH_ManifestCheckedAgainstDisk) {
+  KeyValueContainer key_value_pairs(PopulateChunkStore(20, 20, chunk_store_path_));
+  // The manifest's own total is consistent, but a chunk has gone from the disk since.
+  fs::path removed_path(StoredFilePath(key_value_pairs[0].first));
+  chunk_store_.reset();
+  ASSERT_TRUE(fs::remove(removed_path));
+  chunk_store_.reset(new ChunkStore(chunk_store_path_, DiskUsage(20 * OneKB)));
+  EXPECT_EQ(19U, chunk_store_->GetKeys().size());
+  EXPECT_EQ(19 * OneKB, chunk_store_->GetCurrentDiskUsage().data);
+  EXPECT_THROW(chunk_store_->Get(key_value_pairs[0].first), maidsafe_error);
+}
+
+TEST_F(ChunkStoreTest, BEH_SegmentLayout) {
+  chunk_store_.reset();
+  detail::Parameters::chunk_store_layout = ChunkStoreLayout::kSegments;
+  fs::path segments_path(*test_path / "segment_store");
+  chunk_store_.reset(new ChunkStore(segments_path, DiskUsage(100 * OneKB)));
+  detail::Parameters::chunk_store_layout = ChunkStoreLayout::kFilePerChunk;
+
+  KeyValueContainer key_value_pairs;
+  AddRandomKeyValuePairs(key_value_pairs, 10, OneKB);
+  std::set<KeyType> all_keys;
+  for (const auto& key_value : key_value_pairs) {
+    ASSERT_NO_THROW(chunk_store_->Put(key_value.first, key_value.second));
+    all_keys.insert(key_value.first);
+  }
+  ASSERT_NO_THROW(chunk_store_->Delete(key_value_pairs[0].first));
+  EXPECT_EQ(9 * OneKB, chunk_store_->GetCurrentDiskUsage().data);
+  EXPECT_EQ(100 * OneKB, chunk_store_->GetMaxDiskUsage().data);
+  EXPECT_EQ(1U, chunk_store_->ElementsToStore(all_keys).size());
+  // As for the other layout, the keys are the names the chunks are stored under.
+  auto keys(chunk_store_->GetKeys());
+  EXPECT_EQ(9U, keys.size());
+  EXPECT_TRUE(std::find(keys.begin(), keys.end(),
+                        StoredName(key_value_pairs[1].first)) != keys.end());
+  for (size_t i(1); i < key_value_pairs.size(); ++i) {
+    NonEmptyString recovered;
+    ASSERT_NO_THROW(recovered = chunk_store_->Get(key_value_pairs[i].first));
+    EXPECT_TRUE(key_value_pairs[i].second == recovered);
+  }
+  EXPECT_THROW(chunk_store_->Get(key_value_pairs[0].first), maidsafe_error);
+
+  // The chunks are in segment files, rather than a file each, and there's no manifest.
+  fs::path file_path(StoredFilePath(key_value_pairs[1].first));
+  chunk_store_.reset();
+  EXPECT_FALSE(fs::exists(file_path));
+  EXPECT_FALSE(fs::exists(segments_path.string() + ".manifest"));
+  detail::Parameters::chunk_store_layout = ChunkStoreLayout::kSegments;
+  chunk_store_.reset(new ChunkStore(segments_path, DiskUsage(100 * OneKB)));
+  detail::Parameters::chunk_store_layout = ChunkStoreLayout::kFilePerChunk;
+  EXPECT_EQ(9 * OneKB, chunk_store_->GetCurrentDiskUsage().data);
+  NonEmptyString recovered;
+  ASSERT_NO_THROW(recovered = chunk_store_->Get(key_value_pairs[1].first));
+  EXPECT_TRUE(key_value_pairs[1].second == recovered);
+}
+
+TEST_F(ChunkStoreTest, BEH_CacheModeEviction) {
+  const uint64_t kCapacity(20);
+  fs::path cache_path(*test_path / "cache_store");
+  ASSERT_TRUE(fs::create_directories(cache_path));
+  ChunkStore cache_store(cache_path, DiskUsage(kCapacity * OneKB), ChunkStore::Mode::kCache);
+  KeyValueContainer popular, once;
+  AddRandomKeyValuePairs(popular, 5, OneKB);
+  AddRandomKeyValuePairs(once, 5, OneKB);
+  for (const auto& key_value : popular)
+    ASSERT_NO_THROW(cache_store.Put(key_value.first, key_value.second));
+  for (const auto& key_value : once)
+    ASSERT_NO_THROW(cache_store.Put(key_value.first, key_value.second));
+  for (const auto& key_value : popular)
+    ASSERT_NO_THROW(cache_store.Get(key_value.first));
+  EXPECT_EQ(0U, cache_store.GetEvictionCount());
+
+  // Filling the store evicts rather than failing, starting with the chunks only stored once.
+  KeyValueContainer more;
+  AddRandomKeyValuePairs(more, 2 * kCapacity, OneKB);
+  for (const auto& key_value : more) {
+    ASSERT_NO_THROW(cache_store.Put(key_value.first, key_value.second));
+    EXPECT_LE(cache_store.GetCurrentDiskUsage().data, kCapacity * OneKB);
+  }
+  EXPECT_GE(cache_store.GetEvictionCount(), kCapacity);
+  for (const auto& key_value : popular) {
+    NonEmptyString recovered;
+    ASSERT_NO_THROW(recovered = cache_store.Get(key_value.first));
+    EXPECT_TRUE(key_value.second == recovered);
+  }
+  for (const auto& key_value : once)
+    EXPECT_THROW(cache_store.Get(key_value.first), maidsafe_error);
+
+  // Once idle, usage is back below the high watermark.
+  const uint64_t kHighWatermark(kCapacity * OneKB *
+                                detail::Parameters::disk_cache_high_watermark / 100);
+  for (int i(0); i != 100 && cache_store.GetCurrentDiskUsage().data > kHighWatermark; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_LE(cache_store.GetCurrentDiskUsage().data, kHighWatermark);
+  EXPECT_EQ(cache_store.GetCurrentDiskUsage().data, cache_store.GetKeys().size() * OneKB);
+
+  // A chunk larger than the whole store still can't be stored.
+  KeyType key(GetRandomDataNameType());
+  NonEmptyString value(GenerateKeyValueData(key, static_cast<uint32_t>(kCapacity * OneKB + 1)));
+  EXPECT_THROW(cache_store.Put(key, value), maidsafe_error);
+}
+
+TEST_F(ChunkStoreTest, BEH_CacheModeShrink) {
+  fs::path cache_path(*test_path / "cache_store");
+  ASSERT_TRUE(fs::create_directories(cache_path));
+  KeyValueContainer key_value_pairs;
+  AddRandomKeyValuePairs(key_value_pairs, 10, OneKB);
+  {
+    ChunkStore cache_store(cache_path, DiskUsage(10 * OneKB), ChunkStore::Mode::kCache);
+    for (const auto& key_value : key_value_pairs)
+      ASSERT_NO_THROW(cache_store.Put(key_value.first, key_value.second));
+    // Shrinking the limit evicts instead of being refused.
+    EXPECT_NO_THROW(cache_store.SetMaxDiskUsage(DiskUsage(8 * OneKB)));
+    EXPECT_LE(cache_store.GetCurrentDiskUsage().data, 8 * OneKB);
+  }
+
+  // So does reopening with a smaller limit, where a persistent store would throw.
+  EXPECT_THROW(ChunkStore(cache_path, DiskUsage(4 * OneKB)), maidsafe_error);
+  {
+    ChunkStore cache_store(cache_path, DiskUsage(6 * OneKB), ChunkStore::Mode::kCache);
+    EXPECT_EQ(5 * OneKB, cache_store.GetCurrentDiskUsage().data);
+    EXPECT_EQ(5U, cache_store.GetKeys().size());
+  }
+
+  // Reopened above the high watermark but within the limit, the background trimmer evicts down to
+  // the low watermark.
+  const uint64_t kMaxDiskUsage(5 * OneKB * 100 / detail::Parameters::disk_cache_high_watermark);
+  ChunkStore cache_store(cache_path, DiskUsage(kMaxDiskUsage), ChunkStore::Mode::kCache);
+  const uint64_t kLowWatermark(kMaxDiskUsage * detail::Parameters::disk_cache_low_watermark / 100);
+  for (int i(0); i != 100 && cache_store.GetCurrentDiskUsage().data > kLowWatermark; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_LE(cache_store.GetCurrentDiskUsage().data, kLowWatermark);
+  EXPECT_EQ(4 * OneKB, cache_store.GetCurrentDiskUsage().data);
+  EXPECT_EQ(1U, cache_store.GetEvictionCount());
+}
+
+TEST_F(ChunkStoreTest, FUNC_ConcurrentAccess) {
+  const size_t kEntriesPerThread(200);
+  for (size_t thread_count(1); thread_count <= 16; thread_count *= 2) {
+    KeyValueContainer key_value_pairs;
+    AddRandomKeyValuePairs(key_value_pairs, static_cast<uint32_t>(thread_count * kEntriesPerThread),
+                           OneKB);
+    chunk_store_.reset(new ChunkStore(*test_path / ("concurrent_" + std::to_string(thread_count)),
+                                      DiskUsage(key_value_pairs.size() * OneKB)));
+
+    // Each thread stores, reads back, overwrites and finally deletes every other one of its chunks.
+    pt::ptime start_time(pt::microsec_clock::universal_time());
+    std::vector<std::future<void>> futures;
+    for (size_t thread_index(0); thread_index != thread_count; ++thread_index) {
+      futures.push_back(std::async(std::launch::async, [&, thread_index] {
+        auto begin(std::begin(key_value_pairs) + thread_index * kEntriesPerThread);
+        auto end(begin + kEntriesPerThread);
+        for (auto itr(begin); itr != end; ++itr)
+          chunk_store_->Put(itr->first, itr->second);
+        for (auto itr(begin); itr != end; ++itr) {
+          if (chunk_store_->Get(itr->first) != itr->second)
+            BOOST_THROW_EXCEPTION(MakeError(CommonErrors::unknown));
+          chunk_store_->Put(itr->first, itr->second);
+        }
+        for (auto itr(begin); itr != end; itr += 2)
+          chunk_store_->Delete(itr->first);
+      }));
+    }
+    for (auto& future : futures)
+      EXPECT_NO_THROW(future.get());
+    pt::ptime stop_time(pt::microsec_clock::universal_time());
+
+    uint64_t duration((stop_time - start_time).total_microseconds() + 1);
+    std::cout << thread_count << " thread(s): "
+              << (3.5 * key_value_pairs.size() * 1000000) / duration << " ops/sec" << std::endl;
+    EXPECT_EQ(key_value_pairs.size() * OneKB / 2, chunk_store_->GetCurrentDiskUsage().data);
+    EXPECT_EQ(key_value_pairs.size() / 2, chunk_store_->GetKeys().size());
+  }
+
+  // All threads contend on the same key; usage must match whichever value was written last.
+  chunk_store_.reset(new ChunkStore(*test_path / "contended", DiskUsage(OneKB)));
+  KeyType key(GetRandomDataNameType());
+  GenerateKeyValueData(key, 1);
+  std::vector<std::future<void>> futures;
+  for (int i(0); i != 8; ++i) {
+    futures.push_back(std::async(std::launch::async, [this, key] {
+      for (int j(0); j != 100; ++j)
+        chunk_store_->Put(key, NonEmptyString(RandomAlphaNumericString((RandomUint32() % 30) + 1)));
+    }));
+  }
+  for (auto& future : futures)
+    EXPECT_NO_THROW(future.get());
+  NonEmptyString recovered;
+  ASSERT_NO_THROW(recovered = chunk_store_->Get(key));
+  EXPECT_EQ(recovered.string().size(), chunk_store_->GetCurrentDiskUsage().data);
+}
+
+TEST_F(ChunkStoreTest, FUNC_BackgroundSnapshot) {
+  // Enough writes to fill the journal, which is then set aside while the manifest is rewritten.
+  const uint32_t kEntries(12000);
+  KeyValueContainer key_value_pairs;
+  AddRandomKeyValuePairs(key_value_pairs, kEntries, 16);
+  chunk_store_.reset(new ChunkStore(chunk_store_path_, DiskUsage(kEntries * OneKB)));
+  for (const auto& key_value : key_value_pairs)
+    ASSERT_NO_THROW(chunk_store_->Put(key_value.first, key_value.second));
+  DiskUsage disk_usage(chunk_store_->GetCurrentDiskUsage());
+
+  // Restarting without the clean shutdown's snapshot relies on the background one and the journal.
+  fs::path manifest_path(chunk_store_path_.string() + ".manifest");
+  fs::path journal_path(chunk_store_path_.string() + ".journal");
+  fs::path copied_manifest(manifest_path.string() + ".copy");
+  fs::path copied_journal(journal_path.string() + ".copy");
+  EXPECT_TRUE(WaitForSnapshot());
+  fs::copy_file(manifest_path, copied_manifest);
+  fs::copy_file(journal_path, copied_journal);
+  EXPECT_FALSE(fs::exists(chunk_store_path_.string() + ".journal.old"));
+  chunk_store_.reset();
+  fs::remove(manifest_path);
+  fs::rename(copied_manifest, manifest_path);
+  fs::rename(copied_journal, journal_path);
+  chunk_store_.reset(new ChunkStore(chunk_store_path_, DiskUsage(kEntries * OneKB)));
+  EXPECT_EQ(disk_usage.data, chunk_store_->GetCurrentDiskUsage().data);
+  EXPECT_EQ(kEntries, chunk_store_->GetKeys().size());
+}
+
 TEST_F(ChunkStoreTest, FUNC_Restart) {
   const size_t num_entries(10 * OneKB), disk_entries(1000 * OneKB);
   KeyValueContainer key_value_pairs(
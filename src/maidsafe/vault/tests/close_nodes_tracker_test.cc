@@ -0,0 +1,304 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/routing/close_nodes_change.h"
+#include "maidsafe/routing/parameters.h"
+
+#include "maidsafe/vault/close_nodes_tracker.h"
+#include "maidsafe/vault/parameters.h"
+#include "maidsafe/vault/types.h"
+#include "maidsafe/vault/utils.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+namespace {
+
+typedef std::map<PmidName, int> Accounts;
+typedef std::map<NodeId, std::vector<std::pair<PmidName, int>>> TransferInfo;
+
+// A random id sharing exactly 'common_bits' leading bits with 'id'.
+NodeId NearbyId(const NodeId& id, size_t common_bits) {
+  std::string id_string(id.string()), nearby(RandomString(NodeId::kSize));
+  if (common_bits >= id_string.size() * 8)
+    return id;
+  size_t byte(common_bits / 8);
+  unsigned char mask(static_cast<unsigned char>(0x80 >> (common_bits % 8)));
+  unsigned char high_bits(static_cast<unsigned char>(~((mask << 1) - 1)));
+  std::copy(id_string.begin(), id_string.begin() + byte, nearby.begin());
+  nearby[byte] = static_cast<char>(
+      (static_cast<unsigned char>(id_string[byte]) & high_bits) |
+      ((static_cast<unsigned char>(id_string[byte]) ^ mask) & mask) |
+      (static_cast<unsigned char>(nearby[byte]) & (mask - 1)));
+  return NodeId(nearby);
+}
+
+bool InRanges(const std::vector<IdRange>& ranges, const NodeId& id) {
+  return std::any_of(ranges.begin(), ranges.end(), [&id](const IdRange& range) {
+    return range.first <= id.string() && id.string() <= range.second;
+  });
+}
+
+bool SortedAndDisjoint(const std::vector<IdRange>& ranges) {
+  for (size_t i(0); i != ranges.size(); ++i) {
+    if (ranges[i].second < ranges[i].first || (i != 0 && ranges[i].first <= ranges[i - 1].second))
+      return false;
+  }
+  return true;
+}
+
+// The number of 'nodes' other than 'node' closer than it to 'target'.
+size_t CloserCount(const std::vector<NodeId>& nodes, const NodeId& node, const NodeId& target) {
+  return std::count_if(nodes.begin(), nodes.end(), [&](const NodeId& other) {
+    return other != node && NodeId::CloserToTarget(other, node, target);
+  });
+}
+
+// A close group of this node and 'close_nodes' in a region of the id space, and the accounts this
+// node holds in it, which churn events then change.
+class Network {
+ public:
+  Network(size_t close_node_count, size_t account_count)
+      : kThisNodeId_(RandomString(NodeId::kSize)), close_nodes_(), accounts_() {
+    for (size_t i(0); i != close_node_count; ++i)
+      close_nodes_.push_back(RandomInRegion());
+    std::vector<NodeId> nodes(AllNodes());
+    while (accounts_.size() != account_count) {
+      NodeId id(RandomInRegion());
+      if (CloserCount(nodes, kThisNodeId_, id) < routing::Parameters::group_size)
+        accounts_.insert(std::make_pair(PmidName(Identity(id.string())), 0));
+    }
+  }
+
+  // Returns a change in which a new node joins, or a random one leaves.
+  std::shared_ptr<routing::CloseNodesChange> Churn(NodeId& lost_node, NodeId& new_node) {
+    std::vector<NodeId> old_close_nodes(close_nodes_);
+    lost_node = new_node = NodeId();
+    if (close_nodes_.size() > routing::Parameters::closest_nodes_size && RandomUint32() % 2 == 0) {
+      auto itr(close_nodes_.begin() + RandomUint32() % close_nodes_.size());
+      lost_node = *itr;
+      close_nodes_.erase(itr);
+    } else {
+      new_node = RandomInRegion();
+      close_nodes_.push_back(new_node);
+    }
+    return std::make_shared<routing::CloseNodesChange>(kThisNodeId_, old_close_nodes,
+                                                       close_nodes_);
+  }
+
+  std::vector<NodeId> AllNodes() const {
+    std::vector<NodeId> nodes(close_nodes_);
+    nodes.push_back(kThisNodeId_);
+    return nodes;
+  }
+
+  NodeId RandomInRegion() const {
+    return NearbyId(kThisNodeId_, kRegionBits_ + RandomUint32() % 8);
+  }
+
+  static const size_t kRegionBits_ = 8;
+  const NodeId kThisNodeId_;
+  std::vector<NodeId> close_nodes_;
+  Accounts accounts_;
+};
+
+// Applies churn events to two copies of the network's accounts, one checked in full and the other
+// only in the ranges from a CloseNodesTracker, and checks both have the same outcome.  Unless
+// 'report_nodes', the tracker is only given each change's close nodes.  Returns the total time
+// taken by each.
+std::pair<std::chrono::nanoseconds, std::chrono::nanoseconds> CompareChurn(
+    Network& network, int event_count, bool report_nodes = true) {
+  CloseNodesTracker tracker(network.kThisNodeId_);
+  tracker.Update(NodeId(), NodeId(), network.close_nodes_);
+  Accounts full_accounts(network.accounts_), ranged_accounts(network.accounts_);
+  std::chrono::nanoseconds full_time(0), ranged_time(0);
+  for (int i(0); i != event_count; ++i) {
+    NodeId lost_node, new_node;
+    auto close_nodes_change(network.Churn(lost_node, new_node));
+
+    auto start(std::chrono::steady_clock::now());
+    auto full_transfer_info(detail::GetTransferInfo<PmidName, int, TransferInfo>(
+        close_nodes_change, full_accounts));
+    auto middle(std::chrono::steady_clock::now());
+    auto ranged_transfer_info(detail::GetTransferInfo<PmidName, int, TransferInfo>(
+        close_nodes_change, ranged_accounts,
+        report_nodes ? tracker.Update(lost_node, new_node, network.close_nodes_) :
+                       tracker.Update(NodeId(), NodeId(), network.close_nodes_)));
+    auto end(std::chrono::steady_clock::now());
+    full_time += middle - start;
+    ranged_time += end - middle;
+
+    EXPECT_TRUE(full_transfer_info == ranged_transfer_info);
+    EXPECT_TRUE(full_accounts == ranged_accounts);
+  }
+  return std::make_pair(full_time, ranged_time);
+}
+
+}  // unnamed namespace
+
+TEST(CloseNodesTrackerTest, BEH_RangesNear) {
+  const NodeId kThisNodeId(RandomString(NodeId::kSize));
+  CloseNodesTracker tracker(kThisNodeId);
+  std::vector<NodeId> nodes(1, kThisNodeId);
+  for (int i(0); i != 40; ++i) {
+    nodes.push_back(NearbyId(kThisNodeId, RandomUint32() % 16));
+    tracker.Update(NodeId(), nodes.back(), nodes);
+  }
+  EXPECT_EQ(40U, tracker.size());
+
+  size_t selected(0), total(0);
+  for (int i(0); i != 20; ++i) {
+    NodeId node(i % 2 == 0 ? nodes[RandomUint32() % nodes.size()]
+                           : NearbyId(kThisNodeId, RandomUint32() % 16));
+    auto ranges(tracker.RangesNear(node));
+    EXPECT_TRUE(InRanges(ranges, node));
+    for (int j(0); j != 500; ++j) {
+      NodeId target(NearbyId(j % 2 == 0 ? node : kThisNodeId, RandomUint32() % 24));
+      bool in_ranges(InRanges(ranges, target));
+      if (CloserCount(nodes, node, target) <= routing::Parameters::group_size)
+        ASSERT_TRUE(in_ranges);
+      if (in_ranges)
+        ++selected;
+      ++total;
+    }
+  }
+  EXPECT_LT(selected, total);
+}
+
+TEST(CloseNodesTrackerTest, BEH_Update) {
+  const int kFullScanInterval(detail::Parameters::churn_full_scan_interval);
+  detail::Parameters::churn_full_scan_interval = 1000;
+  const NodeId kThisNodeId(RandomString(NodeId::kSize));
+  CloseNodesTracker tracker(kThisNodeId);
+  std::vector<NodeId> nodes;
+  for (int i(0); i != 20; ++i) {
+    nodes.push_back(NearbyId(kThisNodeId, RandomUint32() % 16));
+    auto ranges(tracker.Update(NodeId(), nodes.back(), nodes));
+    EXPECT_TRUE(SortedAndDisjoint(ranges));
+    EXPECT_TRUE(InRanges(ranges, nodes.back()));
+  }
+  EXPECT_EQ(20U, tracker.size());
+  // This node is never amongst its own close nodes.
+  nodes.push_back(kThisNodeId);
+  tracker.Update(NodeId(), kThisNodeId, nodes);
+  nodes.pop_back();
+  EXPECT_EQ(20U, tracker.size());
+
+  NodeId new_node(NearbyId(kThisNodeId, 12));
+  NodeId lost_node(nodes.front());
+  nodes.front() = new_node;
+  auto ranges(tracker.Update(lost_node, new_node, nodes));
+  EXPECT_TRUE(SortedAndDisjoint(ranges));
+  EXPECT_TRUE(InRanges(ranges, lost_node));
+  EXPECT_TRUE(InRanges(ranges, new_node));
+  EXPECT_EQ(20U, tracker.size());
+  nodes.erase(nodes.begin());
+  tracker.Update(new_node, NodeId(), nodes);
+  EXPECT_EQ(19U, tracker.size());
+
+  detail::Parameters::churn_full_scan_interval = 1;
+  lost_node = nodes.back();
+  nodes.pop_back();
+  ranges = tracker.Update(lost_node, NodeId(), nodes);
+  ASSERT_EQ(1U, ranges.size());
+  EXPECT_EQ(WholeIdRange(), ranges.front());
+  detail::Parameters::churn_full_scan_interval = kFullScanInterval;
+}
+
+TEST(CloseNodesTrackerTest, BEH_SilentChanges) {
+  const int kFullScanInterval(detail::Parameters::churn_full_scan_interval);
+  detail::Parameters::churn_full_scan_interval = 1000;
+  const NodeId kThisNodeId(RandomString(NodeId::kSize));
+  CloseNodesTracker tracker(kThisNodeId);
+  std::vector<NodeId> nodes;
+  for (int i(0); i != 20; ++i)
+    nodes.push_back(NearbyId(kThisNodeId, RandomUint32() % 16));
+  tracker.Update(NodeId(), NodeId(), nodes);
+  EXPECT_EQ(20U, tracker.size());
+
+  // Two nodes leave without being reported, so are only missing from the close nodes of the next
+  // change, which reports a third node joining.
+  NodeId gone_node(nodes.back()), other_gone_node(nodes.front()),
+      new_node(NearbyId(kThisNodeId, 12));
+  nodes.pop_back();
+  nodes.front() = new_node;
+  auto ranges(tracker.Update(NodeId(), new_node, nodes));
+  EXPECT_TRUE(SortedAndDisjoint(ranges));
+  EXPECT_TRUE(InRanges(ranges, gone_node));
+  EXPECT_TRUE(InRanges(ranges, other_gone_node));
+  EXPECT_TRUE(InRanges(ranges, new_node));
+  EXPECT_EQ(19U, tracker.size());
+
+  // A node joining without being reported is found the same way.
+  NodeId unreported_node(NearbyId(kThisNodeId, 10));
+  nodes.push_back(unreported_node);
+  ranges = tracker.Update(NodeId(), NodeId(), nodes);
+  EXPECT_TRUE(InRanges(ranges, unreported_node));
+  EXPECT_EQ(20U, tracker.size());
+
+  Network network(routing::Parameters::closest_nodes_size, 2000);
+  CompareChurn(network, 50, false);
+  detail::Parameters::churn_full_scan_interval = kFullScanInterval;
+}
+
+TEST(CloseNodesTrackerTest, BEH_GetTransferInfo) {
+  const int kFullScanInterval(detail::Parameters::churn_full_scan_interval);
+  detail::Parameters::churn_full_scan_interval = 1000;
+  Network network(routing::Parameters::closest_nodes_size, 2000);
+  CompareChurn(network, 50);
+  detail::Parameters::churn_full_scan_interval = kFullScanInterval;
+}
+
+TEST(CloseNodesTrackerTest, FUNC_ChurnThroughput) {
+  const int kFullScanInterval(detail::Parameters::churn_full_scan_interval);
+  detail::Parameters::churn_full_scan_interval = 1000;
+  const int kEventCount(20);
+  for (size_t account_count(100000); account_count <= 1000000; account_count *= 10) {
+    Network network(routing::Parameters::closest_nodes_size, account_count);
+    auto times(CompareChurn(network, kEventCount));
+    std::cout << "Churn event with " << account_count << " accounts: checking all takes "
+              << std::chrono::duration_cast<std::chrono::microseconds>(times.first).count() /
+                     kEventCount
+              << " us, checking the affected ranges "
+              << std::chrono::duration_cast<std::chrono::microseconds>(times.second).count() /
+                     kEventCount
+              << " us" << std::endl;
+  }
+  detail::Parameters::churn_full_scan_interval = kFullScanInterval;
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,153 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/commit_queue.h"
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+namespace {
+
+// Applies each batch to a map of counters, optionally blocking in the first until released.
+class FakeDatabase {
+ public:
+  typedef std::function<int(int& value)> CommitFunctor;
+  typedef std::vector<std::pair<int, CommitFunctor>> CommitList;
+
+  FakeDatabase() : values(), batch_sizes(), fail(false), block_(false), release_(), blocked_(),
+                   blocked_future_(blocked_.get_future().share()) {}
+
+  // The first batch committed blocks until the returned promise is set.
+  std::promise<void> BlockFirstBatch() {
+    std::promise<void> release;
+    release_ = release.get_future().share();
+    block_ = true;
+    return release;
+  }
+
+  void WaitUntilBlocked() { blocked_future_.wait(); }
+
+  std::vector<std::future<int>> Commit(const CommitList& commit_list) {
+    batch_sizes.push_back(commit_list.size());
+    if (block_) {
+      block_ = false;
+      blocked_.set_value();
+      release_.wait();
+    }
+    if (fail)
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::filesystem_io_error));
+    std::vector<std::future<int>> results;
+    for (const auto& entry : commit_list) {
+      std::promise<int> result;
+      try {
+        result.set_value(entry.second(values[entry.first]));
+      }
+      catch (const std::exception&) {
+        result.set_exception(std::current_exception());
+      }
+      results.push_back(result.get_future());
+    }
+    return results;
+  }
+
+  std::map<int, int> values;
+  std::vector<size_t> batch_sizes;
+  bool fail;
+
+ private:
+  bool block_;
+  std::shared_future<void> release_;
+  std::promise<void> blocked_;
+  std::shared_future<void> blocked_future_;
+};
+
+int Increment(int& value) { return ++value; }
+
+}  // unnamed namespace
+
+TEST(CommitQueueTest, BEH_SingleCaller) {
+  FakeDatabase database;
+  CommitQueue<FakeDatabase> commit_queue(database);
+  EXPECT_EQ(1, commit_queue.Commit(0, Increment));
+  EXPECT_EQ(2, commit_queue.Commit(0, Increment));
+  EXPECT_THROW(commit_queue.Commit(1, [](int&) -> int {
+                 BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+               }), maidsafe_error);
+  EXPECT_EQ(3U, commit_queue.BatchCount());
+  EXPECT_EQ(3U, commit_queue.ActionCount());
+}
+
+TEST(CommitQueueTest, BEH_ConcurrentCallersShareABatch) {
+  FakeDatabase database;
+  CommitQueue<FakeDatabase> commit_queue(database);
+  auto release(database.BlockFirstBatch());
+  auto first(std::async(std::launch::async, [&] { return commit_queue.Commit(0, Increment); }));
+  database.WaitUntilBlocked();
+
+  // These queue behind the blocked batch, and are then committed together.
+  const int kCallers(8);
+  std::vector<std::future<int>> callers;
+  for (int i(0); i != kCallers; ++i) {
+    callers.push_back(std::async(std::launch::async, [&, i] {
+      return commit_queue.Commit(i % 2, Increment);
+    }));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  release.set_value();
+  EXPECT_EQ(1, first.get());
+  int total(0);
+  for (auto& caller : callers)
+    total += caller.get();
+  // Key 0 reaches 5 and key 1 reaches 4, each caller seeing those before it in the batch.
+  EXPECT_EQ((1 + 2 + 3 + 4 + 5) - 1 + (1 + 2 + 3 + 4), total);
+  ASSERT_EQ(2U, database.batch_sizes.size());
+  EXPECT_EQ(1U, database.batch_sizes[0]);
+  EXPECT_EQ(static_cast<size_t>(kCallers), database.batch_sizes[1]);
+  EXPECT_EQ(2U, commit_queue.BatchCount());
+  EXPECT_EQ(static_cast<uint64_t>(kCallers + 1), commit_queue.ActionCount());
+}
+
+TEST(CommitQueueTest, BEH_FailedBatch) {
+  FakeDatabase database;
+  database.fail = true;
+  CommitQueue<FakeDatabase> commit_queue(database);
+  EXPECT_THROW(commit_queue.Commit(0, Increment), maidsafe_error);
+  database.fail = false;
+  EXPECT_EQ(1, commit_queue.Commit(0, Increment));
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,379 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/database_operations.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+namespace {
+
+std::vector<std::pair<std::string, std::string>> GenerateKeyValues(size_t count) {
+  std::vector<std::pair<std::string, std::string>> key_values;
+  for (size_t i(0); i != count; ++i)
+    key_values.push_back(std::make_pair(RandomString(66), RandomAlphaNumericString(100)));
+  return key_values;
+}
+
+// Returns operations per second.
+template <typename Operation>
+double Measure(size_t count, Operation operation) {
+  auto start(std::chrono::steady_clock::now());
+  for (size_t i(0); i != count; ++i)
+    operation(i);
+  return count / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // unnamed namespace
+
+class VaultDataBaseTest : public testing::TestWithParam<KeyValueBackendType> {
+ protected:
+  VaultDataBaseTest()
+      : test_path_(maidsafe::test::CreateTestPath("MaidSafe_Test_VaultDataBase")),
+        data_base_(*test_path_ / "db", GetParam()) {}
+
+  const maidsafe::test::TestPath test_path_;
+  VaultDataBase data_base_;
+};
+
+TEST_P(VaultDataBaseTest, BEH_PutGetDelete) {
+  auto key_values(GenerateKeyValues(10));
+  for (const auto& key_value : key_values)
+    data_base_.Put(key_value.first, key_value.second);
+  for (const auto& key_value : key_values) {
+    std::string value;
+    data_base_.Get(key_value.first, value);
+    EXPECT_EQ(key_value.second, value);
+  }
+
+  data_base_.Put(key_values[0].first, "replaced");
+  std::string value;
+  data_base_.Get(key_values[0].first, value);
+  EXPECT_EQ("replaced", value);
+
+  for (const auto& key_value : key_values) {
+    data_base_.Delete(key_value.first);
+    value.clear();
+    data_base_.Get(key_value.first, value);
+    EXPECT_TRUE(value.empty());
+  }
+}
+
+TEST_P(VaultDataBaseTest, BEH_Scan) {
+  auto key_values(GenerateKeyValues(10));
+  for (const auto& key_value : key_values)
+    data_base_.Put(key_value.first, key_value.second);
+  std::sort(key_values.begin(), key_values.end());
+  std::vector<std::pair<std::string, std::string>> scanned;
+  auto collect([&scanned](const std::string& key, const std::string& value) {
+    scanned.push_back(std::make_pair(key, value));
+    return true;
+  });
+  data_base_.Scan(std::string(), std::string(), collect);
+  EXPECT_EQ(key_values, scanned);
+
+  // Bounded at both ends, then stopped by the functor.
+  scanned.clear();
+  data_base_.Scan(key_values[2].first, key_values[7].first, collect);
+  EXPECT_TRUE(std::equal(key_values.begin() + 2, key_values.begin() + 7, scanned.begin()));
+  EXPECT_EQ(5U, scanned.size());
+  scanned.clear();
+  data_base_.Scan(std::string(), std::string(),
+                  [&](const std::string& key, const std::string& value) {
+    scanned.push_back(std::make_pair(key, value));
+    return scanned.size() != 3;
+  });
+  EXPECT_EQ(3U, scanned.size());
+
+  // A scan doesn't see the writes of an uncommitted batch.
+  VaultDataBase::Batch batch(data_base_);
+  data_base_.Delete(key_values[0].first, batch);
+  data_base_.Put(key_values[1].first, "replaced", batch);
+  scanned.clear();
+  data_base_.Scan(std::string(), std::string(), collect);
+  EXPECT_EQ(key_values, scanned);
+}
+
+TEST_P(VaultDataBaseTest, BEH_ScanPrefix) {
+  // Two-byte group prefixes as used by GroupDb, including ones whose last bytes are 0xff.
+  std::vector<std::string> prefixes;
+  prefixes.push_back(std::string("\x00\x01", 2));
+  prefixes.push_back(std::string("\x00\xff", 2));
+  prefixes.push_back(std::string("\x01\x00", 2));
+  prefixes.push_back(std::string("\xff\xff", 2));
+  std::map<std::string, std::vector<std::string>> keys;
+  for (const auto& prefix : prefixes) {
+    for (int i(0); i != 20; ++i) {
+      std::string key(prefix + RandomString(64));
+      data_base_.Put(key, RandomAlphaNumericString(10));
+      keys[prefix].push_back(key);
+    }
+    std::sort(keys[prefix].begin(), keys[prefix].end());
+  }
+  data_base_.Delete(keys[prefixes[1]].back());
+  keys[prefixes[1]].pop_back();
+  for (const auto& prefix : prefixes) {
+    std::vector<std::string> scanned;
+    data_base_.ScanPrefix(prefix, [&scanned](const std::string& key, const std::string&) {
+      scanned.push_back(key);
+      return true;
+    });
+    EXPECT_EQ(keys[prefix], scanned);
+  }
+  size_t count(0);
+  data_base_.ScanPrefix(std::string(), [&count](const std::string&, const std::string&) {
+    return ++count != 0;
+  });
+  EXPECT_EQ(79U, count);
+}
+
+TEST_P(VaultDataBaseTest, BEH_Snapshot) {
+  auto key_values(GenerateKeyValues(3));
+  data_base_.Put(key_values[0].first, key_values[0].second);
+  data_base_.Put(key_values[1].first, key_values[1].second);
+  auto snapshot(data_base_.GetSnapshot());
+  data_base_.Delete(key_values[0].first);
+  data_base_.Put(key_values[1].first, "replaced");
+  data_base_.Put(key_values[2].first, key_values[2].second);
+
+  std::string value;
+  EXPECT_TRUE(snapshot->Get(key_values[0].first, value));
+  EXPECT_EQ(key_values[0].second, value);
+  EXPECT_TRUE(snapshot->Get(key_values[1].first, value));
+  EXPECT_EQ(key_values[1].second, value);
+  EXPECT_FALSE(snapshot->Get(key_values[2].first, value));
+  size_t count(0);
+  snapshot->Scan(std::string(), std::string(), [&count](const std::string&, const std::string&) {
+    ++count;
+    return true;
+  });
+  EXPECT_EQ(2U, count);
+}
+
+TEST_P(VaultDataBaseTest, BEH_ConcurrentAccess) {
+  const size_t kThreadCount(4);
+  std::vector<std::thread> threads;
+  for (size_t i(0); i != kThreadCount; ++i) {
+    threads.emplace_back([&] {
+      for (const auto& key_value : GenerateKeyValues(50)) {
+        data_base_.Put(key_value.first, key_value.second);
+        std::string value;
+        data_base_.Get(key_value.first, value);
+        EXPECT_EQ(key_value.second, value);
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+}
+
+TEST_P(VaultDataBaseTest, BEH_Batch) {
+  auto key_values(GenerateKeyValues(10));
+  {
+    VaultDataBase::Batch batch(data_base_);
+    for (size_t i(0); i != 5; ++i)
+      data_base_.Put(key_values[i].first, key_values[i].second, batch);
+    // Seen only by reads through the batch until it's committed.
+    std::string value;
+    data_base_.Get(key_values[0].first, value);
+    EXPECT_TRUE(value.empty());
+    data_base_.Get(key_values[0].first, value, batch);
+    EXPECT_EQ(key_values[0].second, value);
+    batch.Commit();
+  }
+  {
+    VaultDataBase::Batch batch(data_base_);
+    data_base_.Delete(key_values[0].first, batch);
+    for (size_t i(5); i != 10; ++i)
+      data_base_.Put(key_values[i].first, key_values[i].second, batch);
+    std::string value;
+    data_base_.Get(key_values[0].first, value, batch);
+    EXPECT_TRUE(value.empty());
+    // Destroyed without being committed.
+  }
+  for (size_t i(0); i != 10; ++i) {
+    std::string value;
+    data_base_.Get(key_values[i].first, value);
+    EXPECT_EQ(i < 5 ? key_values[i].second : std::string(), value);
+  }
+  VaultDataBase::Batch batch(data_base_);
+  batch.Commit();
+  EXPECT_THROW(batch.Commit(), maidsafe_error);
+  EXPECT_THROW(data_base_.Put(key_values[0].first, key_values[0].second, batch), maidsafe_error);
+}
+
+TEST_P(VaultDataBaseTest, BEH_NestedBatch) {
+  auto key_values(GenerateKeyValues(4));
+  {
+    VaultDataBase::Batch outer(data_base_);
+    data_base_.Put(key_values[0].first, key_values[0].second, outer);
+    {
+      VaultDataBase::Batch inner(outer);
+      data_base_.Put(key_values[1].first, key_values[1].second, inner);
+      // The inner batch sees the outer one's writes, but not the other way round until committed.
+      std::string value;
+      data_base_.Get(key_values[0].first, value, inner);
+      EXPECT_EQ(key_values[0].second, value);
+      value.clear();
+      data_base_.Get(key_values[1].first, value, outer);
+      EXPECT_TRUE(value.empty());
+      inner.Commit();
+    }
+    std::string value;
+    data_base_.Get(key_values[1].first, value);
+    EXPECT_TRUE(value.empty());
+    outer.Commit();
+  }
+  for (size_t i(0); i != 2; ++i) {
+    std::string value;
+    data_base_.Get(key_values[i].first, value);
+    EXPECT_EQ(key_values[i].second, value);
+  }
+
+  // An inner batch destroyed without committing fails the outer one.
+  VaultDataBase::Batch outer(data_base_);
+  data_base_.Put(key_values[2].first, key_values[2].second, outer);
+  {
+    VaultDataBase::Batch inner(outer);
+    data_base_.Put(key_values[3].first, key_values[3].second, inner);
+  }
+  EXPECT_THROW(outer.Commit(), maidsafe_error);
+  for (size_t i(2); i != 4; ++i) {
+    std::string value;
+    data_base_.Get(key_values[i].first, value);
+    EXPECT_TRUE(value.empty());
+  }
+}
+
+TEST_P(VaultDataBaseTest, BEH_BatchIsolation) {
+  auto key_values(GenerateKeyValues(2));
+  VaultDataBase::Batch batch(data_base_);
+  data_base_.Put(key_values[0].first, key_values[0].second, batch);
+  // Another thread's write isn't taken into the batch, and so survives its being discarded.
+  std::thread([&] { data_base_.Put(key_values[1].first, key_values[1].second); }).join();
+  std::string value;
+  data_base_.Get(key_values[1].first, value);
+  EXPECT_EQ(key_values[1].second, value);
+  {
+    VaultDataBase::Batch discarded(data_base_);
+    data_base_.Delete(key_values[1].first, discarded);
+  }
+  value.clear();
+  data_base_.Get(key_values[1].first, value, batch);
+  EXPECT_EQ(key_values[1].second, value);
+  batch.Commit();
+  value.clear();
+  data_base_.Get(key_values[0].first, value);
+  EXPECT_EQ(key_values[0].second, value);
+}
+
+// Only SQLite lets a second connection observe which writes have been committed.
+TEST(VaultDataBaseSqliteTest, BEH_GroupCommitWindow) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_VaultDataBase"));
+  VaultDataBase data_base(*test_path / "db", KeyValueBackendType::kSqlite);
+  VaultDataBase observer(*test_path / "db", KeyValueBackendType::kSqlite);
+  auto committed([&observer](const std::string& key) {
+    std::string value;
+    observer.Get(key, value);
+    return !value.empty();
+  });
+  auto key_values(GenerateKeyValues(5));
+
+  // Committed once the window holds three writes.
+  data_base.SetGroupCommitWindow(std::chrono::hours(1), 3);
+  data_base.Put(key_values[0].first, key_values[0].second);
+  data_base.Put(key_values[1].first, key_values[1].second);
+  std::string value;
+  data_base.Get(key_values[1].first, value);
+  EXPECT_EQ(key_values[1].second, value);
+  EXPECT_FALSE(committed(key_values[0].first));
+  data_base.Put(key_values[2].first, key_values[2].second);
+  EXPECT_TRUE(committed(key_values[0].first));
+  EXPECT_TRUE(committed(key_values[2].first));
+
+  // Committed on disabling the window.
+  data_base.Put(key_values[3].first, key_values[3].second);
+  EXPECT_FALSE(committed(key_values[3].first));
+  data_base.SetGroupCommitWindow(std::chrono::milliseconds(0), 0);
+  EXPECT_TRUE(committed(key_values[3].first));
+
+  // Committed once the delay expires.
+  data_base.SetGroupCommitWindow(std::chrono::milliseconds(100), 100);
+  auto put_time(std::chrono::steady_clock::now());
+  data_base.Put(key_values[4].first, key_values[4].second);
+  while (!committed(key_values[4].first) &&
+         std::chrono::steady_clock::now() < put_time + std::chrono::seconds(10)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_TRUE(committed(key_values[4].first));
+  EXPECT_GE(std::chrono::steady_clock::now() - put_time, std::chrono::milliseconds(100));
+}
+
+TEST_P(VaultDataBaseTest, FUNC_Throughput) {
+  const size_t kCount(5000);
+  auto key_values(GenerateKeyValues(kCount));
+  std::string value;
+  double puts(Measure(kCount, [&](size_t i) {
+    data_base_.Put(key_values[i].first, key_values[i].second);
+  }));
+  double gets(Measure(kCount, [&](size_t i) { data_base_.Get(key_values[i].first, value); }));
+  double deletes(Measure(kCount, [&](size_t i) { data_base_.Delete(key_values[i].first); }));
+  std::cout << "Operations per second: Put " << puts << ", Get " << gets << ", Delete "
+            << deletes << std::endl;
+
+  const size_t kBatchSize(100);
+  double batched_puts(Measure(kCount / kBatchSize, [&](size_t i) {
+    VaultDataBase::Batch batch(data_base_);
+    for (size_t j(i * kBatchSize); j != (i + 1) * kBatchSize; ++j)
+      data_base_.Put(key_values[j].first, key_values[j].second, batch);
+    batch.Commit();
+  }) * kBatchSize);
+  data_base_.SetGroupCommitWindow(std::chrono::milliseconds(10), 256);
+  double windowed_deletes(Measure(kCount, [&](size_t i) {
+    data_base_.Delete(key_values[i].first);
+  }));
+  std::cout << "Operations per second: Put in batches of " << kBatchSize << " " << batched_puts
+            << ", Delete in a group-commit window " << windowed_deletes << std::endl;
+}
+
+INSTANTIATE_TEST_CASE_P(Backends, VaultDataBaseTest,
+                        testing::Values(KeyValueBackendType::kSqlite, KeyValueBackendType::kMemory,
+                                        KeyValueBackendType::kLsm));
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
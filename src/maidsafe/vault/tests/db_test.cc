@@ -18,6 +18,9 @@
 
 #include "maidsafe/vault/db.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/test.h"
 #include "maidsafe/common/utils.h"
@@ -28,6 +31,7 @@
 #include "maidsafe/vault/key.h"
 #include "maidsafe/vault/version_handler/value.h"
 #include "maidsafe/vault/utils.h"
+#include "maidsafe/vault/tests/tests_utils.h"
 
 namespace maidsafe {
 
@@ -105,14 +109,22 @@ void DbTests(Db<Key, Value>& db, const Key& key) {
   EXPECT_THROW(db.Get(key), maidsafe_error);
 }
 
-TEST(DbTest, BEH_DbConstructor) {
+// Runs each test against every backend.
+class DbTest : public testing::TestWithParam<KeyValueBackendType> {
+ protected:
+  DbTest() : metadata_backend_(GetParam()) {}
+
+  const ScopedMetadataBackend metadata_backend_;
+};
+
+TEST_P(DbTest, BEH_DbConstructor) {
   maidsafe::test::TestPath test_path1(maidsafe::test::CreateTestPath("MaidSafe_Test_DbTest1"));
   Db<Key, DataManagerValue> data_manager_db(UniqueDbPath(*test_path1));
   maidsafe::test::TestPath test_path2(maidsafe::test::CreateTestPath("MaidSafe_Test_DbTest2"));
   Db<Key, VersionHandlerValue> version_handler_db(UniqueDbPath(*test_path2));
 }
 
-TEST(DbTest, BEH_DbCommit) {
+TEST_P(DbTest, BEH_DbCommit) {
   maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DbTest"));
   Db<Key, TestDbValue> db(UniqueDbPath(*test_path));
   Key key(Identity(NodeId(RandomString(NodeId::kSize)).string()), DataTagValue::kMaidValue);
@@ -126,7 +138,82 @@ TEST(DbTest, BEH_DbCommit) {
   }
 }
 
-TEST(DbTest, BEH_DbTransferInfo) {
+TEST_P(DbTest, BEH_DbBatchCommit) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DbTest"));
+  Db<Key, TestDbValue> db(UniqueDbPath(*test_path));
+  Key key(Identity(NodeId(RandomString(NodeId::kSize)).string()), DataTagValue::kMaidValue);
+  Key other_key(Identity(NodeId(RandomString(NodeId::kSize)).string()), DataTagValue::kMaidValue);
+  // Each entry sees the effect of those before it.
+  Db<Key, TestDbValue>::CommitList commit_list;
+  commit_list.push_back(std::make_pair(key, TestDbActionPutValue("new_value")));
+  commit_list.push_back(std::make_pair(key, TestDbActionModifyValue("modified_value")));
+  commit_list.push_back(std::make_pair(other_key, TestDbActionModifyValue("modified_value")));
+  commit_list.push_back(std::make_pair(other_key, TestDbActionPutValue("new_value")));
+  commit_list.push_back(std::make_pair(key, TestDbActionDeleteValue()));
+  auto results(db.Commit(commit_list));
+  ASSERT_EQ(commit_list.size(), results.size());
+  EXPECT_FALSE(results[0].get());
+  EXPECT_FALSE(results[1].get());
+  EXPECT_THROW(results[2].get(), maidsafe_error);
+  EXPECT_FALSE(results[3].get());
+  auto deleted(results[4].get());
+  ASSERT_TRUE(deleted);
+  EXPECT_EQ("modified_value", deleted->value);
+  EXPECT_THROW(db.Get(key), maidsafe_error);
+  EXPECT_EQ("new_value", db.Get(other_key).value);
+
+  db.SetGroupCommitWindow(std::chrono::milliseconds(10), 10);
+  for (auto i(0); i != 10; ++i)
+    DbTests(db, key);
+}
+
+TEST_P(DbTest, BEH_DbGetTargets) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_DbTest"));
+  Db<Key, DataManagerValue> db(UniqueDbPath(*test_path));
+  PmidName pmid_name(Identity(RandomString(64))), other_pmid_name(Identity(RandomString(64)));
+  auto add_pmid([](const PmidName& pmid) {
+    return [pmid](std::unique_ptr<DataManagerValue>& value) {
+      if (!value)
+        value.reset(new DataManagerValue(1024));
+      value->AddPmid(pmid);
+      return detail::DbAction::kPut;
+    };
+  });
+  auto sorted([](std::vector<Key> keys) {
+    std::sort(keys.begin(), keys.end());
+    return keys;
+  });
+
+  // Built from the entries present on first use, then kept up to date.
+  std::vector<Key> keys, other_keys;
+  for (int i(0); i != 10; ++i) {
+    Key key(Identity(NodeId(RandomString(NodeId::kSize)).string()), DataTagValue::kMaidValue);
+    db.Commit(key, add_pmid(i % 2 == 0 ? pmid_name : other_pmid_name));
+    (i % 2 == 0 ? keys : other_keys).push_back(key);
+  }
+  EXPECT_EQ(sorted(keys), sorted(db.GetTargets(pmid_name)));
+  db.Commit(other_keys[0], add_pmid(pmid_name));
+  keys.push_back(other_keys[0]);
+  db.Commit(keys[0], [&](std::unique_ptr<DataManagerValue>& value) {
+    value->RemovePmid(pmid_name);
+    return detail::DbAction::kPut;
+  });
+  keys.erase(keys.begin());
+  db.Commit(keys[0], [](std::unique_ptr<DataManagerValue>&) { return detail::DbAction::kDelete; });
+  keys.erase(keys.begin());
+  std::vector<std::pair<Key, DataManagerValue>> contents;
+  contents.push_back(std::make_pair(
+      Key(Identity(NodeId(RandomString(NodeId::kSize)).string()), DataTagValue::kMaidValue),
+      DataManagerValue(1024)));
+  contents.back().second.AddPmid(pmid_name);
+  db.HandleTransfer(contents);
+  keys.push_back(contents.back().first);
+  EXPECT_EQ(sorted(keys), sorted(db.GetTargets(pmid_name)));
+  EXPECT_EQ(sorted(other_keys), sorted(db.GetTargets(other_pmid_name)));
+  EXPECT_TRUE(db.GetTargets(PmidName(Identity(RandomString(64)))).empty());
+}
+
+TEST_P(DbTest, BEH_DbTransferInfo) {
   maidsafe::test::TestPath test_path1(maidsafe::test::CreateTestPath("MaidSafe_Test_DbTest1"));
   Db<Key, DataManagerValue> data_manager_db(UniqueDbPath(*test_path1));
   maidsafe::test::TestPath test_path2(maidsafe::test::CreateTestPath("MaidSafe_Test_DbTest2"));
@@ -136,6 +223,10 @@ TEST(DbTest, BEH_DbTransferInfo) {
   version_handler_db.GetTransferInfo(close_nodes_change);
 }
 
+INSTANTIATE_TEST_CASE_P(Backends, DbTest,
+                        testing::Values(KeyValueBackendType::kSqlite, KeyValueBackendType::kMemory,
+                                        KeyValueBackendType::kLsm));
+
 }  // namespace test
 
 }  // namespace vault
@@ -0,0 +1,98 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/frequency_sketch.h"
+
+#include <future>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+TEST(FrequencySketchTest, BEH_Estimates) {
+  FrequencySketch sketch(1000);
+  std::vector<size_t> hashes;
+  for (int i(0); i != 500; ++i)
+    hashes.push_back(static_cast<size_t>(RandomUint32()) << 32 | RandomUint32());
+
+  for (size_t i(0); i != hashes.size(); ++i) {
+    for (size_t j(0); j != i % 10; ++j)
+      sketch.Increment(hashes[i]);
+  }
+  // Never an underestimate, and rarely an overestimate at this load.
+  size_t exact(0);
+  for (size_t i(0); i != hashes.size(); ++i) {
+    ASSERT_GE(sketch.Frequency(hashes[i]), i % 10);
+    if (sketch.Frequency(hashes[i]) == i % 10)
+      ++exact;
+  }
+  EXPECT_GT(exact, hashes.size() * 9 / 10);
+
+  EXPECT_TRUE(sketch.Admit(hashes[9], hashes[0]));
+  EXPECT_FALSE(sketch.Admit(hashes[0], hashes[10]));
+
+  // Counts saturate.
+  for (int i(0); i != 100; ++i)
+    sketch.Increment(hashes[1]);
+  EXPECT_EQ(15U, sketch.Frequency(hashes[1]));
+}
+
+TEST(FrequencySketchTest, BEH_Aging) {
+  const size_t kExpectedEntries(16);
+  FrequencySketch sketch(kExpectedEntries);
+  const size_t kHash(RandomUint32()), kOtherHash(~kHash);
+  for (int i(0); i != 8; ++i)
+    sketch.Increment(kHash);
+  EXPECT_EQ(8U, sketch.Frequency(kHash));
+
+  // The tenfold sample size of accesses halves every count.
+  for (size_t i(8); i != 10 * kExpectedEntries; ++i)
+    sketch.Increment(kOtherHash);
+  EXPECT_EQ(4U, sketch.Frequency(kHash));
+  // The count of accesses is halved too, so the next halving is due sooner.
+  for (size_t i(0); i != 5 * kExpectedEntries; ++i)
+    sketch.Increment(kOtherHash);
+  EXPECT_EQ(2U, sketch.Frequency(kHash));
+}
+
+TEST(FrequencySketchTest, BEH_ConcurrentIncrements) {
+  FrequencySketch sketch(1 << 16);
+  const size_t kHash(RandomUint32());
+  std::vector<std::future<void>> futures;
+  for (int i(0); i != 4; ++i) {
+    futures.push_back(std::async(std::launch::async, [&] {
+      for (int j(0); j != 3; ++j)
+        sketch.Increment(kHash);
+    }));
+  }
+  for (auto& future : futures)
+    future.get();
+  EXPECT_GE(sketch.Frequency(kHash), 12U);
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
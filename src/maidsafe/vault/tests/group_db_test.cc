@@ -18,6 +18,12 @@
 
 #include "maidsafe/vault/group_db.h"
 
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/test.h"
 #include "maidsafe/common/utils.h"
@@ -339,6 +345,169 @@ TEST(GroupDbTest, BEH_TransferInfo) {
   pmid_group_db.GetTransferInfo(close_nodes_change);
 }*/
 
+// The metadata and values of the personas above no longer provide what GroupDb needs, so these
+// tests use a minimal persona of their own.
+struct TestGroupMetadata {
+  TestGroupMetadata() : count(0) {}
+  std::string Print() const { return std::to_string(count); }
+  int count;
+};
+
+bool operator==(const TestGroupMetadata& lhs, const TestGroupMetadata& rhs) {
+  return lhs.count == rhs.count;
+}
+
+struct TestGroupValue {
+  TestGroupValue() : value("original_value") {}
+  TestGroupValue(TestGroupValue&& other) : value(std::move(other.value)) {}
+  explicit TestGroupValue(const std::string& serialised_value) : value(serialised_value) {}
+  std::string Serialise() const { return value; }
+  std::string Print() const { return value; }
+  std::string value;
+
+ private:
+  TestGroupValue(const TestGroupValue&);
+};
+
+struct TestGroupPersona {
+  typedef PmidName GroupName;
+  typedef GroupKey<PmidName> Key;
+  typedef TestGroupValue Value;
+  typedef TestGroupMetadata Metadata;
+};
+
+typedef GroupDb<TestGroupPersona> TestGroupDb;
+
+// Counts the group's values in its metadata.
+TestGroupDb::CommitFunctor PutValue(const std::string& new_value) {
+  return [new_value](TestGroupMetadata& metadata, std::unique_ptr<TestGroupValue>& value) {
+    if (!value) {
+      value.reset(new TestGroupValue());
+      ++metadata.count;
+    }
+    value->value = new_value;
+    return detail::DbAction::kPut;
+  };
+}
+
+TestGroupDb::CommitFunctor DeleteValue() {
+  return [](TestGroupMetadata& metadata, std::unique_ptr<TestGroupValue>& value) {
+    if (!value)
+      BOOST_THROW_EXCEPTION(MakeError(CommonErrors::no_such_element));
+    --metadata.count;
+    return detail::DbAction::kDelete;
+  };
+}
+
+TestGroupPersona::Key MakeGroupKey(const PmidName& group_name) {
+  return TestGroupPersona::Key(group_name, Identity(RandomString(NodeId::kSize)),
+                               DataTagValue::kMaidValue);
+}
+
+// Runs each test against every backend.
+class GroupDbTest : public testing::TestWithParam<KeyValueBackendType> {
+ protected:
+  GroupDbTest()
+      : metadata_backend_(GetParam()),
+        test_path_(maidsafe::test::CreateTestPath("MaidSafe_Test_GroupDbTest")) {}
+
+  const ScopedMetadataBackend metadata_backend_;
+  const maidsafe::test::TestPath test_path_;
+};
+
+TEST_P(GroupDbTest, BEH_Commit) {
+  TestGroupDb db(UniqueDbPath(*test_path_));
+  PmidName group_name(Identity(RandomString(64)));
+  auto key(MakeGroupKey(group_name));
+  EXPECT_THROW(db.GetMetadata(group_name), maidsafe_error);
+  // Groups aren't created by a commit.
+  EXPECT_THROW(db.Commit(key, PutValue("new_value")), maidsafe_error);
+
+  db.AddGroup(group_name, TestGroupMetadata());
+  EXPECT_THROW(db.AddGroup(group_name, TestGroupMetadata()), maidsafe_error);
+  EXPECT_FALSE(db.Commit(key, PutValue("new_value")));
+  EXPECT_EQ("new_value", db.GetValue(key).value);
+  EXPECT_FALSE(db.Commit(key, PutValue("modified_value")));
+  EXPECT_EQ("modified_value", db.GetValue(key).value);
+  EXPECT_EQ(1, db.GetMetadata(group_name).count);
+  db.Commit(group_name, [](TestGroupMetadata& metadata) { metadata.count += 10; });
+  EXPECT_EQ(11, db.GetMetadata(group_name).count);
+
+  auto deleted(db.Commit(key, DeleteValue()));
+  ASSERT_TRUE(deleted != nullptr);
+  EXPECT_EQ("modified_value", deleted->value);
+  EXPECT_EQ(10, db.GetMetadata(group_name).count);
+  EXPECT_THROW(db.GetValue(key), maidsafe_error);
+  EXPECT_THROW(db.Commit(key, DeleteValue()), maidsafe_error);
+}
+
+TEST_P(GroupDbTest, BEH_BatchCommit) {
+  TestGroupDb db(UniqueDbPath(*test_path_));
+  PmidName group_name(Identity(RandomString(64)));
+  db.AddGroup(group_name, TestGroupMetadata());
+  auto key(MakeGroupKey(group_name)), other_key(MakeGroupKey(group_name));
+  // Each entry sees the effect of those before it.
+  TestGroupDb::CommitList commit_list;
+  commit_list.push_back(std::make_pair(key, PutValue("new_value")));
+  commit_list.push_back(std::make_pair(other_key, DeleteValue()));
+  commit_list.push_back(std::make_pair(other_key, PutValue("new_value")));
+  commit_list.push_back(std::make_pair(key, DeleteValue()));
+  commit_list.push_back(std::make_pair(MakeGroupKey(PmidName(Identity(RandomString(64)))),
+                                       PutValue("new_value")));
+  auto results(db.Commit(commit_list));
+  ASSERT_EQ(commit_list.size(), results.size());
+  EXPECT_FALSE(results[0].get());
+  EXPECT_THROW(results[1].get(), maidsafe_error);
+  EXPECT_FALSE(results[2].get());
+  auto deleted(results[3].get());
+  ASSERT_TRUE(deleted != nullptr);
+  EXPECT_EQ("new_value", deleted->value);
+  EXPECT_THROW(results[4].get(), maidsafe_error);
+  EXPECT_THROW(db.GetValue(key), maidsafe_error);
+  EXPECT_EQ("new_value", db.GetValue(other_key).value);
+  EXPECT_EQ(1, db.GetMetadata(group_name).count);
+}
+
+TEST_P(GroupDbTest, BEH_ContentsAndTransfer) {
+  TestGroupDb db(UniqueDbPath(*test_path_));
+  PmidName group_name(Identity(RandomString(64))), other_group_name(Identity(RandomString(64)));
+  db.AddGroup(group_name, TestGroupMetadata());
+  db.AddGroup(other_group_name, TestGroupMetadata());
+  std::vector<std::pair<TestGroupPersona::Key, std::string>> values;
+  std::map<std::string, std::string> values_by_name;
+  for (int i(0); i != 10; ++i) {
+    values.push_back(std::make_pair(MakeGroupKey(group_name), RandomAlphaNumericString(10)));
+    values_by_name[values.back().first.name.string()] = values.back().second;
+    db.Commit(values.back().first, PutValue(values.back().second));
+    db.Commit(MakeGroupKey(other_group_name), PutValue("other_value"));
+  }
+
+  // Only the group's own values are included.
+  auto contents(db.GetContents(group_name));
+  EXPECT_TRUE(contents.group_name == group_name);
+  EXPECT_EQ(10, contents.metadata.count);
+  ASSERT_EQ(values.size(), contents.kv_pairs.size());
+  for (const auto& kv_pair : contents.kv_pairs) {
+    EXPECT_TRUE(kv_pair.first.group_name() == group_name);
+    EXPECT_EQ(values_by_name[kv_pair.first.name.string()], kv_pair.second.value);
+  }
+
+  TestGroupDb transferred_db(UniqueDbPath(*test_path_));
+  transferred_db.HandleTransfer(contents);
+  EXPECT_EQ(10, transferred_db.GetMetadata(group_name).count);
+  for (const auto& value : values)
+    EXPECT_EQ(value.second, transferred_db.GetValue(value.first).value);
+
+  db.DeleteGroup(group_name);
+  EXPECT_THROW(db.GetContents(group_name), maidsafe_error);
+  EXPECT_THROW(db.GetValue(values.front().first), maidsafe_error);
+  EXPECT_EQ(10U, db.GetContents(other_group_name).kv_pairs.size());
+}
+
+INSTANTIATE_TEST_CASE_P(Backends, GroupDbTest,
+                        testing::Values(KeyValueBackendType::kSqlite, KeyValueBackendType::kMemory,
+                                        KeyValueBackendType::kLsm));
+
 }  // namespace test
 
 }  // namespace vault
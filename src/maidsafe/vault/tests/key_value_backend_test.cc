@@ -0,0 +1,319 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/key_value_backend.h"
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/vault/lsm_backend.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+namespace {
+
+typedef std::map<std::string, std::string> Entries;
+
+// Keys of the persona databases' fixed width.
+Entries GenerateEntries(size_t count) {
+  Entries entries;
+  while (entries.size() != count)
+    entries[RandomString(68)] = RandomAlphaNumericString(RandomUint32() % 200 + 1);
+  return entries;
+}
+
+Entries ScanAll(KeyValueBackend& backend) {
+  Entries entries;
+  backend.Scan(std::string(), std::string(),
+               [&entries](const std::string& key, const std::string& value) {
+    EXPECT_TRUE(entries.empty() || entries.rbegin()->first < key);
+    entries[key] = value;
+    return true;
+  });
+  return entries;
+}
+
+}  // unnamed namespace
+
+class KeyValueBackendTest : public testing::TestWithParam<KeyValueBackendType> {
+ protected:
+  KeyValueBackendTest()
+      : test_path_(maidsafe::test::CreateTestPath("MaidSafe_Test_KeyValueBackend")),
+        backend_(MakeKeyValueBackend(GetParam(), *test_path_ / "db")) {}
+
+  void Reopen() {
+    backend_.reset();
+    backend_ = MakeKeyValueBackend(GetParam(), *test_path_ / "db");
+  }
+
+  const maidsafe::test::TestPath test_path_;
+  std::unique_ptr<KeyValueBackend> backend_;
+};
+
+TEST_P(KeyValueBackendTest, BEH_PointOperations) {
+  std::string value;
+  EXPECT_FALSE(backend_->Get("key", value));
+  backend_->Delete("key");
+  backend_->Put("key", "value");
+  EXPECT_TRUE(backend_->Get("key", value));
+  EXPECT_EQ("value", value);
+  backend_->Put("key", "replaced");
+  EXPECT_TRUE(backend_->Get("key", value));
+  EXPECT_EQ("replaced", value);
+  backend_->Delete("key");
+  EXPECT_FALSE(backend_->Get("key", value));
+
+  // Keys and values are binary.
+  std::string binary_key("\0\xff\0", 3), binary_value("\0\x01", 2);
+  backend_->Put(binary_key, binary_value);
+  EXPECT_FALSE(backend_->Get(std::string("\0", 1), value));
+  EXPECT_TRUE(backend_->Get(binary_key, value));
+  EXPECT_EQ(binary_value, value);
+}
+
+TEST_P(KeyValueBackendTest, BEH_Scan) {
+  auto entries(GenerateEntries(100));
+  for (const auto& entry : entries)
+    backend_->Put(entry.first, entry.second);
+  EXPECT_EQ(entries, ScanAll(*backend_));
+
+  auto begin(std::next(entries.begin(), 10)), end(std::next(entries.begin(), 60));
+  Entries scanned;
+  backend_->Scan(begin->first, end->first,
+                 [&scanned](const std::string& key, const std::string& value) {
+    scanned[key] = value;
+    return true;
+  });
+  EXPECT_EQ(Entries(begin, end), scanned);
+
+  // Empty and reversed ranges.
+  size_t count(0);
+  auto counter([&count](const std::string&, const std::string&) { return ++count != 0; });
+  backend_->Scan(begin->first, begin->first, counter);
+  backend_->Scan(end->first, begin->first, counter);
+  backend_->Scan(entries.rbegin()->first + '\0', std::string(), counter);
+  EXPECT_EQ(0U, count);
+}
+
+TEST_P(KeyValueBackendTest, BEH_Write) {
+  auto entries(GenerateEntries(20));
+  KeyValueBackend::WriteBatch batch;
+  for (const auto& entry : entries)
+    batch[entry.first] = entry.second;
+  backend_->Write(batch);
+  EXPECT_EQ(entries, ScanAll(*backend_));
+
+  batch.clear();
+  batch[entries.begin()->first] = boost::none;
+  batch[entries.rbegin()->first] = std::string("replaced");
+  batch["absent"] = boost::none;
+  backend_->Write(batch);
+  entries.erase(entries.begin());
+  entries.rbegin()->second = "replaced";
+  EXPECT_EQ(entries, ScanAll(*backend_));
+  backend_->Write(KeyValueBackend::WriteBatch());
+}
+
+TEST_P(KeyValueBackendTest, BEH_Snapshot) {
+  auto entries(GenerateEntries(50));
+  for (const auto& entry : entries)
+    backend_->Put(entry.first, entry.second);
+  auto snapshot(backend_->GetSnapshot());
+  for (const auto& entry : GenerateEntries(50))
+    backend_->Put(entry.first, entry.second);
+  backend_->Delete(entries.begin()->first);
+  backend_->Put(entries.rbegin()->first, "replaced");
+
+  std::string value;
+  EXPECT_TRUE(snapshot->Get(entries.begin()->first, value));
+  EXPECT_EQ(entries.begin()->second, value);
+  EXPECT_TRUE(snapshot->Get(entries.rbegin()->first, value));
+  EXPECT_EQ(entries.rbegin()->second, value);
+  Entries scanned;
+  snapshot->Scan(std::string(), std::string(),
+                 [&scanned](const std::string& key, const std::string& value) {
+    scanned[key] = value;
+    return true;
+  });
+  EXPECT_EQ(entries, scanned);
+}
+
+TEST_P(KeyValueBackendTest, BEH_SnapshotScanPrefix) {
+  backend_->Put(std::string("a\xff", 2), "1");
+  backend_->Put(std::string("a\xff\x00", 3), "2");
+  backend_->Put(std::string("a\xff\xff", 3), "3");
+  backend_->Put("b", "4");
+  backend_->Put("a", "5");
+  auto snapshot(backend_->GetSnapshot());
+  backend_->Put(std::string("a\xff\x01", 3), "6");
+  std::vector<std::string> values;
+  snapshot->ScanPrefix(std::string("a\xff", 2),
+                       [&values](const std::string& /*key*/, const std::string& value) {
+    values.push_back(value);
+    return true;
+  });
+  ASSERT_EQ(3U, values.size());
+  EXPECT_EQ("1", values[0]);
+  EXPECT_EQ("2", values[1]);
+  EXPECT_EQ("3", values[2]);
+}
+
+TEST_P(KeyValueBackendTest, BEH_Reopen) {
+  if (GetParam() == KeyValueBackendType::kMemory)
+    return;
+  auto entries(GenerateEntries(50));
+  for (const auto& entry : entries)
+    backend_->Put(entry.first, entry.second);
+  backend_->Delete(entries.begin()->first);
+  entries.erase(entries.begin());
+  backend_->SetGroupCommitWindow(std::chrono::hours(1), 1000);
+  backend_->Put(entries.begin()->first, "replaced");
+  entries.begin()->second = "replaced";
+  // Pending writes are made durable on closing.
+  Reopen();
+  EXPECT_EQ(entries, ScanAll(*backend_));
+}
+
+INSTANTIATE_TEST_CASE_P(Backends, KeyValueBackendTest,
+                        testing::Values(KeyValueBackendType::kSqlite, KeyValueBackendType::kMemory,
+                                        KeyValueBackendType::kLsm));
+
+TEST(PrefixEndTest, BEH_PrefixEnd) {
+  EXPECT_EQ("b", PrefixEnd("a"));
+  EXPECT_EQ("b", PrefixEnd(std::string("a\xff\xff", 3)));
+  EXPECT_EQ(std::string("a\x01", 2), PrefixEnd(std::string("a\x00", 2)));
+  EXPECT_TRUE(PrefixEnd(std::string("\xff\xff", 2)).empty());
+  EXPECT_TRUE(PrefixEnd(std::string()).empty());
+}
+
+TEST(LsmBackendTest, BEH_FlushAndCompact) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_LsmBackend"));
+  Entries entries;
+  {
+    // A small in-memory table, so that the entries are spread across several sorted tables.
+    LsmBackend backend(*test_path / "db", 16 * 1024, 100);
+    for (int i(0); i != 10; ++i) {
+      auto batch_entries(GenerateEntries(100));
+      KeyValueBackend::WriteBatch batch;
+      for (const auto& entry : batch_entries)
+        batch[entry.first] = entry.second;
+      backend.Write(batch);
+      entries.insert(batch_entries.begin(), batch_entries.end());
+      // Overwrite and delete some of the entries in older tables.
+      auto itr(std::next(entries.begin(), RandomUint32() % entries.size()));
+      backend.Put(itr->first, "replaced");
+      itr->second = "replaced";
+      itr = std::next(entries.begin(), RandomUint32() % entries.size());
+      backend.Delete(itr->first);
+      entries.erase(itr);
+    }
+    auto snapshot(backend.GetSnapshot());
+    backend.Compact();
+    EXPECT_EQ(1U, backend.TableCount());
+    EXPECT_EQ(entries, ScanAll(backend));
+    for (const auto& entry : entries) {
+      std::string value;
+      EXPECT_TRUE(backend.Get(entry.first, value));
+      EXPECT_EQ(entry.second, value);
+      EXPECT_TRUE(snapshot->Get(entry.first, value));
+    }
+    // The snapshot keeps the merged tables readable.
+    EXPECT_EQ(entries, [&snapshot] {
+      Entries scanned;
+      snapshot->Scan(std::string(), std::string(),
+                     [&scanned](const std::string& key, const std::string& value) {
+        scanned[key] = value;
+        return true;
+      });
+      return scanned;
+    }());
+  }
+  LsmBackend backend(*test_path / "db", 16 * 1024, 100);
+  EXPECT_EQ(1U, backend.TableCount());
+  EXPECT_EQ(entries, ScanAll(backend));
+}
+
+TEST(LsmBackendTest, BEH_ConcurrentWriters) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_LsmBackend"));
+  std::vector<Entries> thread_entries;
+  for (int i(0); i != 4; ++i)
+    thread_entries.push_back(GenerateEntries(100));
+  {
+    // A small in-memory table, so that the log is rotated while others wait on a sync.
+    LsmBackend backend(*test_path / "db", 16 * 1024, 100);
+    std::vector<std::thread> threads;
+    for (const auto& entries : thread_entries) {
+      threads.push_back(std::thread([&backend, &entries] {
+        for (const auto& entry : entries) {
+          backend.Put(entry.first, entry.second);
+          std::string value;
+          EXPECT_TRUE(backend.Get(entry.first, value));
+          EXPECT_EQ(entry.second, value);
+        }
+      }));
+    }
+    for (auto& thread : threads)
+      thread.join();
+  }
+  Entries entries;
+  for (const auto& written : thread_entries)
+    entries.insert(written.begin(), written.end());
+  LsmBackend backend(*test_path / "db", 16 * 1024, 100);
+  EXPECT_EQ(entries, ScanAll(backend));
+}
+
+TEST(LsmBackendTest, BEH_TornLog) {
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_LsmBackend"));
+  auto entries(GenerateEntries(10));
+  {
+    LsmBackend backend(*test_path / "db");
+    for (const auto& entry : entries)
+      backend.Put(entry.first, entry.second);
+  }
+  // A final record only partly written before a crash is ignored.
+  fs::path log_path;
+  for (fs::directory_iterator itr(*test_path / "db"), end; itr != end; ++itr) {
+    if (itr->path().extension() == ".log" && fs::file_size(itr->path()) != 0)
+      log_path = itr->path();
+  }
+  ASSERT_FALSE(log_path.empty());
+  fs::resize_file(log_path, fs::file_size(log_path) - 1);
+  LsmBackend backend(*test_path / "db");
+  entries.erase(std::prev(entries.end()));
+  EXPECT_EQ(entries, ScanAll(backend));
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
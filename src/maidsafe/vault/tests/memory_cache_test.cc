@@ -0,0 +1,171 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/memory_cache.h"
+
+#include <future>
+#include <vector>
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/vault/tests/chunk_store_test_utils.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+namespace {
+
+const uint64_t kOneKB(1024);
+const uint64_t kMaxMemoryUsage(10 * kOneKB);
+
+struct SetName : public boost::static_visitor<> {
+  explicit SetName(const NonEmptyString& value) : value_(value) {}
+
+  template <typename T>
+  void operator()(T& key) const {
+    key.value = Identity(crypto::Hash<crypto::SHA512>(value_));
+  }
+
+  const NonEmptyString& value_;
+};
+
+}  // unnamed namespace
+
+class MemoryCacheTest : public testing::Test {
+ protected:
+  typedef MemoryCache::KeyType KeyType;
+
+  MemoryCacheTest() : memory_cache_(MemoryUsage(kMaxMemoryUsage)) {}
+
+  std::pair<KeyType, NonEmptyString> GenerateKeyValue(uint64_t size) {
+    KeyType key(GetRandomDataNameType());
+    NonEmptyString value(RandomAlphaNumericString(static_cast<size_t>(size)));
+    boost::apply_visitor(SetName(value), key);
+    return std::make_pair(key, value);
+  }
+
+  MemoryCache memory_cache_;
+};
+
+TEST_F(MemoryCacheTest, BEH_StoreGetDelete) {
+  auto entry(GenerateKeyValue(kOneKB));
+  EXPECT_THROW(memory_cache_.Get(entry.first), maidsafe_error);
+  EXPECT_THROW(memory_cache_.Delete(entry.first), maidsafe_error);
+
+  ASSERT_NO_THROW(memory_cache_.Store(entry.first, entry.second));
+  EXPECT_TRUE(memory_cache_.Get(entry.first) == entry.second);
+  EXPECT_EQ(1U, memory_cache_.Size());
+  EXPECT_EQ(kOneKB, memory_cache_.GetCurrentMemoryUsage().data);
+
+  // Storing under the same key replaces the value and its accounted size.
+  NonEmptyString replacement(RandomAlphaNumericString(100));
+  ASSERT_NO_THROW(memory_cache_.Store(entry.first, replacement));
+  EXPECT_TRUE(memory_cache_.Get(entry.first) == replacement);
+  EXPECT_EQ(1U, memory_cache_.Size());
+  EXPECT_EQ(100U, memory_cache_.GetCurrentMemoryUsage().data);
+
+  ASSERT_NO_THROW(memory_cache_.Delete(entry.first));
+  EXPECT_THROW(memory_cache_.Get(entry.first), maidsafe_error);
+  EXPECT_EQ(0U, memory_cache_.Size());
+  EXPECT_EQ(0U, memory_cache_.GetCurrentMemoryUsage().data);
+}
+
+TEST_F(MemoryCacheTest, BEH_EvictsLeastRecentlyUsed) {
+  std::vector<std::pair<KeyType, NonEmptyString>> entries;
+  for (uint64_t i(0); i != kMaxMemoryUsage / kOneKB; ++i) {
+    entries.push_back(GenerateKeyValue(kOneKB));
+    ASSERT_NO_THROW(memory_cache_.Store(entries.back().first, entries.back().second));
+  }
+  EXPECT_EQ(kMaxMemoryUsage, memory_cache_.GetCurrentMemoryUsage().data);
+
+  // Touch the oldest entry, so the second oldest is the first pushed out.
+  ASSERT_NO_THROW(memory_cache_.Get(entries[0].first));
+  auto extra(GenerateKeyValue(kOneKB));
+  ASSERT_NO_THROW(memory_cache_.Store(extra.first, extra.second));
+  EXPECT_NO_THROW(memory_cache_.Get(entries[0].first));
+  EXPECT_THROW(memory_cache_.Get(entries[1].first), maidsafe_error);
+  EXPECT_NO_THROW(memory_cache_.Get(entries[2].first));
+
+  // A large value pushes out as many of the least recently used as it needs to.
+  auto large(GenerateKeyValue(3 * kOneKB + 1));
+  ASSERT_NO_THROW(memory_cache_.Store(large.first, large.second));
+  EXPECT_TRUE(memory_cache_.Get(large.first) == large.second);
+  for (size_t i(3); i != 7; ++i)
+    EXPECT_THROW(memory_cache_.Get(entries[i].first), maidsafe_error) << i;
+  for (size_t i(7); i != entries.size(); ++i)
+    EXPECT_NO_THROW(memory_cache_.Get(entries[i].first)) << i;
+  EXPECT_LE(memory_cache_.GetCurrentMemoryUsage().data, kMaxMemoryUsage);
+
+  // A value larger than the capacity isn't held, and leaves the cache alone.
+  auto oversized(GenerateKeyValue(kMaxMemoryUsage + 1));
+  auto usage(memory_cache_.GetCurrentMemoryUsage());
+  ASSERT_NO_THROW(memory_cache_.Store(oversized.first, oversized.second));
+  EXPECT_THROW(memory_cache_.Get(oversized.first), maidsafe_error);
+  EXPECT_EQ(usage, memory_cache_.GetCurrentMemoryUsage());
+}
+
+TEST_F(MemoryCacheTest, BEH_SharedBuffers) {
+  auto entry(GenerateKeyValue(kOneKB));
+  ChunkBuffer value(entry.second), recovered;
+
+  ASSERT_NO_THROW(memory_cache_.Store(entry.first, value));
+  ASSERT_NO_THROW(recovered = memory_cache_.GetBuffer(entry.first));
+  EXPECT_EQ(value.data(), recovered.data());
+
+  // A buffer handed out stays valid after its entry is evicted.
+  for (uint64_t i(0); i != kMaxMemoryUsage / kOneKB; ++i) {
+    auto other(GenerateKeyValue(kOneKB));
+    ASSERT_NO_THROW(memory_cache_.Store(other.first, other.second));
+  }
+  EXPECT_THROW(memory_cache_.GetBuffer(entry.first), maidsafe_error);
+  EXPECT_TRUE(recovered.value() == entry.second);
+}
+
+TEST_F(MemoryCacheTest, BEH_ConcurrentAccess) {
+  const int kThreadCount(8), kOperationCount(200);
+  std::vector<std::future<void>> futures;
+  for (int i(0); i != kThreadCount; ++i) {
+    futures.push_back(std::async(std::launch::async, [&] {
+      for (int j(0); j != kOperationCount; ++j) {
+        auto entry(GenerateKeyValue((RandomUint32() % kOneKB) + 1));
+        memory_cache_.Store(entry.first, entry.second);
+        try {
+          EXPECT_TRUE(memory_cache_.Get(entry.first) == entry.second);
+          memory_cache_.Delete(entry.first);
+        }
+        catch (const maidsafe_error&) {
+          // Pushed out by the other threads.
+        }
+      }
+    }));
+  }
+  for (auto& future : futures)
+    EXPECT_NO_THROW(future.get());
+  EXPECT_LE(memory_cache_.GetCurrentMemoryUsage().data, kMaxMemoryUsage);
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
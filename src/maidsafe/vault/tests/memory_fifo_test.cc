@@ -186,6 +186,29 @@ TEST_F(MemoryFIFOTest, BEH_FifoRepeatedlyStoreUsingSameKey) {
   ASSERT_TRUE(last_value == recovered);
 }
 
+TEST_F(MemoryFIFOTest, BEH_SharedBuffers) {
+  KeyType key(GetRandomDataNameType());
+  ChunkBuffer value(GenerateKeyValueData(key, OneKB)), recovered;
+
+  // Storing and retrieving a buffer shares its content rather than copying it.
+  ASSERT_NO_THROW(memory_fifo_->Store(key, value));
+  ASSERT_NO_THROW(recovered = memory_fifo_->GetBuffer(key));
+  EXPECT_EQ(value.data(), recovered.data());
+  EXPECT_TRUE(memory_fifo_->Get(key) == value.value());
+
+  // A buffer handed out stays valid after its entry is deleted or pushed out.
+  ASSERT_NO_THROW(memory_fifo_->Delete(key));
+  EXPECT_THROW(memory_fifo_->GetBuffer(key), maidsafe_error);
+  EXPECT_TRUE(recovered == value);
+  ASSERT_NO_THROW(memory_fifo_->Store(key, value));
+  for (uint32_t i = 0; i != kDefaultMaxMemoryUsage; ++i) {
+    KeyType temp_key(GetRandomDataNameType());
+    ASSERT_NO_THROW(memory_fifo_->Store(temp_key, GenerateKeyValueData(temp_key, OneKB)));
+  }
+  EXPECT_THROW(memory_fifo_->GetBuffer(key), maidsafe_error);
+  EXPECT_TRUE(recovered == value);
+}
+
 TEST_F(MemoryFIFOTest, BEH_RandomAsync) {
   typedef KeyValueContainer::value_type value_type;
 
@@ -0,0 +1,276 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/paged_account_transfer.h"
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boost/asio/io_service.hpp"
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+typedef std::pair<std::string, std::string> Account;
+
+// Connects a sender and a receiver, holding the messages between them until delivered.  Their
+// timers only fire while the test runs io_service_.
+class PagedAccountTransferTest : public testing::Test {
+ protected:
+  struct Message {
+    Message(const NodeId& from_in, const NodeId& to_in, const std::string& contents_in)
+        : from(from_in), to(to_in), contents(contents_in) {}
+    NodeId from, to;
+    std::string contents;
+  };
+
+  PagedAccountTransferTest()
+      : kSenderId_(NodeId::IdType::kRandomId),
+        kReceiverId_(NodeId::IdType::kRandomId),
+        kPageSize_(detail::Parameters::account_transfer_page_size),
+        kWindow_(detail::Parameters::account_transfer_window),
+        kTimeout_(detail::Parameters::account_transfer_page_timeout),
+        io_service_(),
+        in_flight_(),
+        sender_(io_service_, Serialise, [this](const NodeId& peer, const std::string& contents) {
+                  in_flight_.push_back(Message(kSenderId_, peer, contents));
+                }),
+        receiver_(io_service_, Serialise, [this](const NodeId& peer, const std::string& contents) {
+                    in_flight_.push_back(Message(kReceiverId_, peer, contents));
+                  }) {
+    detail::Parameters::account_transfer_page_size = 1024;
+    detail::Parameters::account_transfer_window = 3;
+  }
+
+  ~PagedAccountTransferTest() {
+    detail::Parameters::account_transfer_page_size = kPageSize_;
+    detail::Parameters::account_transfer_window = kWindow_;
+    detail::Parameters::account_transfer_page_timeout = kTimeout_;
+  }
+
+  static std::string Serialise(const Account& account) { return account.first + account.second; }
+
+  static std::vector<Account> MakeAccounts(size_t count, size_t size) {
+    std::vector<Account> accounts;
+    for (size_t i(0); i != count; ++i)
+      accounts.push_back(std::make_pair(RandomString(size / 2), RandomString(size - size / 2)));
+    return accounts;
+  }
+
+  std::vector<std::string> Deliver(const Message& message) {
+    std::vector<std::string> ingested;
+    (message.to == kReceiverId_ ? receiver_ : sender_).Receive(
+        message.from, message.contents, [&](const std::string& serialised_account) {
+          ingested.push_back(serialised_account);
+        });
+    return ingested;
+  }
+
+  // Delivers everything in flight, including the messages sent in reply, returning the accounts
+  // the receiver ingests.
+  std::vector<std::string> DeliverAll() {
+    std::vector<std::string> received;
+    while (!in_flight_.empty()) {
+      Message message(in_flight_.front());
+      in_flight_.pop_front();
+      auto accounts(Deliver(message));
+      received.insert(received.end(), accounts.begin(), accounts.end());
+    }
+    return received;
+  }
+
+  size_t PagesInFlight() const {
+    size_t count(0);
+    for (const auto& message : in_flight_) {
+      protobuf::AccountTransfer proto;
+      EXPECT_TRUE(proto.ParseFromString(message.contents));
+      if (!proto.acknowledgement())
+        ++count;
+    }
+    return count;
+  }
+
+  const NodeId kSenderId_, kReceiverId_;
+  const size_t kPageSize_;
+  const unsigned int kWindow_;
+  const std::chrono::milliseconds kTimeout_;
+  boost::asio::io_service io_service_;
+  std::deque<Message> in_flight_;
+  PagedAccountTransfer<Account> sender_, receiver_;
+};
+
+TEST_F(PagedAccountTransferTest, BEH_PagedTransfer) {
+  auto accounts(MakeAccounts(1000, 100));
+  sender_.Transfer(kReceiverId_, accounts);
+  EXPECT_EQ(1U, sender_.OutgoingCount());
+  EXPECT_EQ(3U, PagesInFlight());
+
+  std::vector<std::string> received;
+  uint32_t expected_sequence(0);
+  while (!in_flight_.empty()) {
+    EXPECT_LE(PagesInFlight(), 3U);
+    Message message(in_flight_.front());
+    in_flight_.pop_front();
+    protobuf::AccountTransfer proto;
+    ASSERT_TRUE(proto.ParseFromString(message.contents));
+    if (!proto.acknowledgement()) {
+      EXPECT_EQ(expected_sequence++, proto.sequence_number());
+      size_t page_size(0);
+      for (const auto& account : proto.serialised_accounts())
+        page_size += account.size();
+      EXPECT_LE(page_size, 1024U);
+      EXPECT_EQ(received.size() + proto.serialised_accounts_size() == accounts.size(),
+                proto.last_page());
+    }
+    auto page(Deliver(message));
+    received.insert(received.end(), page.begin(), page.end());
+  }
+  // Ten 100 byte accounts fit on each page.
+  EXPECT_EQ(100U, expected_sequence);
+  ASSERT_EQ(accounts.size(), received.size());
+  for (size_t i(0); i != accounts.size(); ++i)
+    EXPECT_EQ(Serialise(accounts[i]), received[i]);
+  EXPECT_EQ(0U, sender_.OutgoingCount());
+}
+
+TEST_F(PagedAccountTransferTest, BEH_OversizedAccount) {
+  auto accounts(MakeAccounts(2, 100));
+  auto oversized(MakeAccounts(1, 5000));
+  accounts.insert(accounts.begin() + 1, oversized.front());
+  sender_.Transfer(kReceiverId_, accounts);
+  EXPECT_EQ(3U, PagesInFlight());
+  auto received(DeliverAll());
+  ASSERT_EQ(3U, received.size());
+  EXPECT_EQ(Serialise(oversized.front()), received[1]);
+  EXPECT_EQ(0U, sender_.OutgoingCount());
+}
+
+TEST_F(PagedAccountTransferTest, BEH_DuplicateAndReorderedPages) {
+  auto accounts(MakeAccounts(30, 100));
+  sender_.Transfer(kReceiverId_, accounts);
+  ASSERT_EQ(3U, in_flight_.size());
+  std::vector<Message> pages(in_flight_.rbegin(), in_flight_.rend());
+  in_flight_.clear();
+  std::vector<std::string> received;
+  for (const auto& page : pages) {
+    auto ingested(Deliver(page));
+    EXPECT_EQ(10U, ingested.size());
+    received.insert(received.end(), ingested.begin(), ingested.end());
+    EXPECT_TRUE(Deliver(page).empty());
+  }
+  EXPECT_EQ(accounts.size(), received.size());
+  // Both copies of each page are acknowledged, the second ignored by the sender.
+  EXPECT_EQ(6U, in_flight_.size());
+  EXPECT_TRUE(DeliverAll().empty());
+  EXPECT_EQ(0U, sender_.OutgoingCount());
+}
+
+TEST_F(PagedAccountTransferTest, BEH_FailedIngestion) {
+  auto accounts(MakeAccounts(5, 100));
+  sender_.Transfer(kReceiverId_, accounts);
+  ASSERT_EQ(1U, in_flight_.size());
+  Message page(in_flight_.front());
+  in_flight_.clear();
+  EXPECT_THROW(receiver_.Receive(kSenderId_, page.contents,
+                                 [](const std::string&) { throw std::exception(); }),
+               std::exception);
+  // Not acknowledged, nor recorded as received.
+  EXPECT_TRUE(in_flight_.empty());
+  EXPECT_EQ(accounts.size(), Deliver(page).size());
+  EXPECT_TRUE(DeliverAll().empty());
+  EXPECT_EQ(0U, sender_.OutgoingCount());
+}
+
+TEST_F(PagedAccountTransferTest, BEH_QueuedTransfers) {
+  auto first(MakeAccounts(40, 100)), second(MakeAccounts(5, 100));
+  sender_.Transfer(kReceiverId_, first);
+  sender_.Transfer(kReceiverId_, second);
+  EXPECT_EQ(2U, sender_.OutgoingCount());
+  EXPECT_EQ(3U, PagesInFlight());
+  auto received(DeliverAll());
+  ASSERT_EQ(first.size() + second.size(), received.size());
+  EXPECT_EQ(Serialise(first.back()), received[first.size() - 1]);
+  EXPECT_EQ(Serialise(second.front()), received[first.size()]);
+  EXPECT_EQ(0U, sender_.OutgoingCount());
+}
+
+TEST_F(PagedAccountTransferTest, BEH_UnpagedTransfer) {
+  protobuf::AccountTransfer proto;
+  proto.add_serialised_accounts("first");
+  proto.add_serialised_accounts("second");
+  auto received(Deliver(Message(kSenderId_, kReceiverId_, proto.SerializeAsString())));
+  ASSERT_EQ(2U, received.size());
+  EXPECT_EQ("second", received[1]);
+  EXPECT_TRUE(in_flight_.empty());
+  EXPECT_TRUE(Deliver(Message(kSenderId_, kReceiverId_, "Not a transfer")).empty());
+}
+
+TEST_F(PagedAccountTransferTest, BEH_ResendAndAbandon) {
+  detail::Parameters::account_transfer_page_timeout = std::chrono::milliseconds(100);
+  // Runs the timers until the sender sends something, which takes a timeout.
+  auto stall([&] {
+    auto start(std::chrono::steady_clock::now());
+    io_service_.reset();
+    while (in_flight_.empty())
+      ASSERT_NE(0U, io_service_.run_one());
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(90));
+  });
+
+  // The lost pages are resent.
+  sender_.Transfer(kReceiverId_, MakeAccounts(20, 100));
+  EXPECT_EQ(2U, PagesInFlight());
+  in_flight_.clear();
+  stall();
+  EXPECT_EQ(2U, PagesInFlight());
+  EXPECT_EQ(20U, DeliverAll().size());
+  EXPECT_EQ(0U, sender_.OutgoingCount());
+
+  // The transfer is abandoned once all the resends are lost too, and the next started.
+  auto next(MakeAccounts(1, 100));
+  sender_.Transfer(kReceiverId_, MakeAccounts(20, 100));
+  sender_.Transfer(kReceiverId_, next);
+  for (int i(0); i != detail::Parameters::account_transfer_page_retries; ++i) {
+    in_flight_.clear();
+    stall();
+    EXPECT_EQ(2U, PagesInFlight());
+  }
+  in_flight_.clear();
+  EXPECT_EQ(2U, sender_.OutgoingCount());
+  stall();
+  EXPECT_EQ(1U, sender_.OutgoingCount());
+  auto received(DeliverAll());
+  ASSERT_EQ(1U, received.size());
+  EXPECT_EQ(Serialise(next.front()), received.front());
+  EXPECT_EQ(0U, sender_.OutgoingCount());
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,217 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/segment_store.h"
+
+#include <memory>
+
+#include "boost/filesystem/path.hpp"
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+#include "maidsafe/vault/tests/chunk_store_test_utils.h"
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+const uint64_t kDefaultMaxDiskUsage(4 * 1024);
+const uint64_t OneKB(1024);
+
+class SegmentStoreTest : public testing::Test {
+ public:
+  typedef SegmentStore::KeyType KeyType;
+  typedef std::vector<std::pair<KeyType, NonEmptyString>> KeyValueContainer;
+
+  struct GenerateKeyValuePair : public boost::static_visitor<NonEmptyString> {
+    GenerateKeyValuePair() : size_(OneKB) {}
+    explicit GenerateKeyValuePair(uint32_t size) : size_(size) {}
+
+    template <typename T>
+    NonEmptyString operator()(T& key) {
+      NonEmptyString value = NonEmptyString(RandomAlphaNumericString(size_));
+      key.value = Identity(crypto::Hash<crypto::SHA512>(value));
+      return value;
+    }
+
+    uint32_t size_;
+  };
+
+ protected:
+  SegmentStoreTest()
+      : test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_SegmentStore")),
+        segment_store_path_(*test_path / "segment_store"),
+        segment_store_(new SegmentStore(segment_store_path_, DiskUsage(kDefaultMaxDiskUsage))) {}
+
+  NonEmptyString GenerateKeyValueData(KeyType& key, uint32_t size) {
+    GenerateKeyValuePair generate_key_value_pair_(size);
+    return boost::apply_visitor(generate_key_value_pair_, key);
+  }
+
+  bool CompactOnce() { return segment_store_->CompactOnce(); }
+
+  size_t SegmentCount() const {
+    size_t count(0);
+    for (fs::directory_iterator itr(segment_store_path_); itr != fs::directory_iterator(); ++itr)
+      ++count;
+    return count;
+  }
+
+  maidsafe::test::TestPath test_path;
+  fs::path segment_store_path_;
+  std::unique_ptr<SegmentStore> segment_store_;
+};
+
+TEST_F(SegmentStoreTest, BEH_Constructor) {
+  segment_store_.reset();
+  ASSERT_NO_THROW(SegmentStore(segment_store_path_, DiskUsage(0)));
+  ASSERT_NO_THROW(SegmentStore(segment_store_path_, DiskUsage(200000)));
+  maidsafe::test::TestPath test_path(maidsafe::test::CreateTestPath("MaidSafe_Test_SegmentStore"));
+  fs::path file_path(*test_path / "File");
+  EXPECT_TRUE(WriteFile(file_path, " "));
+  ASSERT_THROW(SegmentStore(file_path, DiskUsage(200000)), std::exception);
+  ASSERT_THROW(SegmentStore(file_path / "base", DiskUsage(200000)), std::exception);
+  fs::path directory_path(*test_path / "Directory");
+  ASSERT_NO_THROW(SegmentStore(directory_path, DiskUsage(1)));
+  EXPECT_TRUE(fs::exists(directory_path));
+}
+
+TEST_F(SegmentStoreTest, BEH_SuccessfulStore) {
+  KeyType key1(GetRandomDataNameType()), key2(GetRandomDataNameType());
+  NonEmptyString value1 = GenerateKeyValueData(key1, static_cast<uint32_t>(2 * OneKB)),
+                 value2 = GenerateKeyValueData(key2, static_cast<uint32_t>(2 * OneKB)), recovered;
+  ASSERT_NO_THROW(segment_store_->Put(key1, value1));
+  ASSERT_NO_THROW(segment_store_->Put(key2, value2));
+  ASSERT_NO_THROW(recovered = segment_store_->Get(key1));
+  EXPECT_TRUE(recovered == value1);
+  ASSERT_NO_THROW(recovered = segment_store_->Get(key2));
+  EXPECT_TRUE(recovered == value2);
+  EXPECT_EQ(4 * OneKB, segment_store_->GetCurrentDiskUsage().data);
+  EXPECT_EQ(2U, segment_store_->GetKeys().size());
+}
+
+TEST_F(SegmentStoreTest, BEH_UnsuccessfulStore) {
+  KeyType key(GetRandomDataNameType());
+  NonEmptyString value = GenerateKeyValueData(key, static_cast<uint32_t>(kDefaultMaxDiskUsage) + 1);
+  EXPECT_THROW(segment_store_->Put(key, value), std::exception);
+  EXPECT_THROW(segment_store_->Get(key), std::exception);
+  EXPECT_THROW(segment_store_->Delete(key), std::exception);
+}
+
+TEST_F(SegmentStoreTest, BEH_RepeatedlyStoreUsingSameKey) {
+  KeyType key(GetRandomDataNameType());
+  NonEmptyString value = GenerateKeyValueData(key, (RandomUint32() % 30) + 1), recovered,
+                 last_value;
+  ASSERT_NO_THROW(segment_store_->Put(key, value));
+  uint32_t events((RandomUint32() % 100) + 1);
+  for (uint32_t i = 0; i != events; ++i) {
+    last_value = NonEmptyString(RandomAlphaNumericString((RandomUint32() % 30) + 1));
+    ASSERT_NO_THROW(segment_store_->Put(key, last_value));
+  }
+  ASSERT_NO_THROW(recovered = segment_store_->Get(key));
+  EXPECT_TRUE(last_value == recovered);
+  EXPECT_TRUE(last_value.string().size() == segment_store_->GetCurrentDiskUsage().data);
+}
+
+TEST_F(SegmentStoreTest, BEH_GarbageCountsTowardsMax) {
+  KeyType key1(GetRandomDataNameType()), key2(GetRandomDataNameType());
+  NonEmptyString value1 = GenerateKeyValueData(key1, static_cast<uint32_t>(3 * OneKB)),
+                 value2 = GenerateKeyValueData(key2, static_cast<uint32_t>(2 * OneKB)), recovered;
+  ASSERT_NO_THROW(segment_store_->Put(key1, value1));
+  ASSERT_NO_THROW(segment_store_->Delete(key1));
+  EXPECT_EQ(0U, segment_store_->GetCurrentDiskUsage().data);
+  // The deleted chunk still takes room until its segment is compacted, which the refusal prompts
+  // even though it's the active segment and only a third garbage.
+  EXPECT_THROW(segment_store_->Put(key2, value2), maidsafe_error);
+  while (CompactOnce()) {}
+  ASSERT_NO_THROW(segment_store_->Put(key2, value2));
+  ASSERT_NO_THROW(recovered = segment_store_->Get(key2));
+  EXPECT_TRUE(recovered == value2);
+  EXPECT_THROW(segment_store_->Get(key1), maidsafe_error);
+}
+
+TEST_F(SegmentStoreTest, BEH_Restart) {
+  KeyValueContainer key_value_pairs;
+  AddRandomKeyValuePairs(key_value_pairs, 100, 100);
+  // Each instance is closed before the next opens, since its compaction could move records under
+  // the replay.
+  segment_store_.reset();
+  segment_store_.reset(new SegmentStore(segment_store_path_, DiskUsage(100 * OneKB)));
+  for (const auto& key_value : key_value_pairs)
+    ASSERT_NO_THROW(segment_store_->Put(key_value.first, key_value.second));
+  for (size_t i(0); i < key_value_pairs.size(); i += 2)
+    ASSERT_NO_THROW(segment_store_->Delete(key_value_pairs[i].first));
+  DiskUsage disk_usage(segment_store_->GetCurrentDiskUsage());
+
+  segment_store_.reset();
+  segment_store_.reset(new SegmentStore(segment_store_path_, DiskUsage(100 * OneKB)));
+  EXPECT_EQ(disk_usage.data, segment_store_->GetCurrentDiskUsage().data);
+  EXPECT_EQ(key_value_pairs.size() / 2, segment_store_->GetKeys().size());
+  for (size_t i(0); i < key_value_pairs.size(); ++i) {
+    if (i % 2 == 0) {
+      EXPECT_THROW(segment_store_->Get(key_value_pairs[i].first), std::exception);
+    } else {
+      NonEmptyString recovered;
+      ASSERT_NO_THROW(recovered = segment_store_->Get(key_value_pairs[i].first));
+      EXPECT_TRUE(recovered == key_value_pairs[i].second);
+    }
+  }
+}
+
+TEST_F(SegmentStoreTest, BEH_Compaction) {
+  KeyValueContainer key_value_pairs;
+  AddRandomKeyValuePairs(key_value_pairs, 64, OneKB);
+  segment_store_.reset();
+  segment_store_.reset(new SegmentStore(segment_store_path_, DiskUsage(100 * OneKB), 4 * OneKB));
+  for (const auto& key_value : key_value_pairs)
+    ASSERT_NO_THROW(segment_store_->Put(key_value.first, key_value.second));
+  size_t segment_count(SegmentCount());
+  EXPECT_GE(segment_count, 16U);
+
+  for (size_t i(0); i < key_value_pairs.size(); ++i) {
+    if (i % 4 != 0)
+      ASSERT_NO_THROW(segment_store_->Delete(key_value_pairs[i].first));
+  }
+  while (CompactOnce()) {}
+  EXPECT_LT(SegmentCount(), segment_count);
+
+  segment_store_.reset();
+  segment_store_.reset(new SegmentStore(segment_store_path_, DiskUsage(100 * OneKB), 4 * OneKB));
+  EXPECT_EQ(16 * OneKB, segment_store_->GetCurrentDiskUsage().data);
+  for (size_t i(0); i < key_value_pairs.size(); ++i) {
+    if (i % 4 != 0) {
+      EXPECT_THROW(segment_store_->Get(key_value_pairs[i].first), std::exception);
+    } else {
+      NonEmptyString recovered;
+      ASSERT_NO_THROW(recovered = segment_store_->Get(key_value_pairs[i].first));
+      EXPECT_TRUE(recovered == key_value_pairs[i].second);
+    }
+  }
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,102 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/segmented_lru.h"
+
+#include <vector>
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+namespace {
+
+std::vector<DataNameVariant> GenerateKeys(size_t count) {
+  std::vector<DataNameVariant> keys;
+  for (size_t i(0); i != count; ++i)
+    keys.push_back(GetDataNameVariant(DataTagValue::kImmutableDataValue,
+                                      Identity(crypto::Hash<crypto::SHA512>(RandomString(64)))));
+  return keys;
+}
+
+// Evicts every entry, returning them in eviction order.
+std::vector<DataNameVariant> Drain(detail::SegmentedLru& lru) {
+  std::vector<DataNameVariant> evicted;
+  while (auto victim = lru.Victim()) {
+    evicted.push_back(*victim);
+    lru.Erase(*victim);
+  }
+  return evicted;
+}
+
+}  // unnamed namespace
+
+TEST(SegmentedLruTest, BEH_Order) {
+  detail::SegmentedLru lru(100);
+  EXPECT_FALSE(lru.Victim());
+  auto keys(GenerateKeys(6));
+  for (const auto& key : keys)
+    lru.Insert(key, 10);
+  EXPECT_EQ(keys.size(), lru.Size());
+
+  // Accessed entries are protected, so are evicted after all those in probation.
+  lru.Touch(keys[1]);
+  lru.Touch(keys[0]);
+  lru.Insert(keys[4], 20);
+  lru.Touch(keys[1]);
+  lru.Touch(GenerateKeys(1)[0]);
+  EXPECT_EQ(40U, lru.ProtectedSize());
+  std::vector<DataNameVariant> expected = {keys[2], keys[3], keys[5], keys[0], keys[4], keys[1]};
+  EXPECT_TRUE(expected == Drain(lru));
+  EXPECT_EQ(0U, lru.ProtectedSize());
+}
+
+TEST(SegmentedLruTest, BEH_ProtectedCapacity) {
+  // Up to half of 100 bytes may be protected.
+  detail::SegmentedLru lru(100, 50);
+  auto keys(GenerateKeys(8));
+  for (const auto& key : keys) {
+    lru.Insert(key, 10);
+    lru.Touch(key);
+  }
+  // The least recently used of the protected entries were demoted as it filled up.
+  EXPECT_EQ(50U, lru.ProtectedSize());
+  std::vector<DataNameVariant> expected(keys.begin(), keys.end());
+  EXPECT_TRUE(expected == Drain(lru));
+
+  // Shrinking the capacity demotes too.
+  for (const auto& key : keys) {
+    lru.Insert(key, 10);
+    lru.Touch(key);
+  }
+  lru.SetCapacity(40);
+  EXPECT_EQ(20U, lru.ProtectedSize());
+  EXPECT_TRUE(keys[0] == *lru.Victim());
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
@@ -0,0 +1,334 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/sharded_memory_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/vault/memory_cache.h"
+#include "maidsafe/vault/tests/chunk_store_test_utils.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+namespace {
+
+typedef DataNameVariant KeyType;
+
+const uint64_t kOneKB(1024);
+
+struct SetName : public boost::static_visitor<> {
+  explicit SetName(const NonEmptyString& value) : value_(value) {}
+
+  template <typename T>
+  void operator()(T& key) const {
+    key.value = Identity(crypto::Hash<crypto::SHA512>(value_));
+  }
+
+  const NonEmptyString& value_;
+};
+
+std::pair<KeyType, NonEmptyString> GenerateKeyValue(uint64_t size) {
+  KeyType key(GetRandomDataNameType());
+  NonEmptyString value(RandomAlphaNumericString(static_cast<size_t>(size)));
+  boost::apply_visitor(SetName(value), key);
+  return std::make_pair(key, value);
+}
+
+// Runs 'thread_count' threads looking up entries of 'keys' (all present) for a fixed period and
+// returns the total number of lookups per second.
+template <typename Cache>
+double HitThroughput(Cache& cache, const std::vector<KeyType>& keys, unsigned int thread_count) {
+  const auto kDuration(std::chrono::milliseconds(500));
+  std::atomic<bool> start(false), stop(false);
+  std::atomic<uint64_t> total(0);
+  std::vector<std::thread> threads;
+  for (unsigned int i(0); i != thread_count; ++i) {
+    threads.emplace_back([&, i] {
+      uint64_t count(0);
+      size_t index(i * 7919);
+      while (!start)
+        std::this_thread::yield();
+      while (!stop) {
+        cache.GetBuffer(keys[index++ % keys.size()]);
+        ++count;
+      }
+      total += count;
+    });
+  }
+  start = true;
+  std::this_thread::sleep_for(kDuration);
+  stop = true;
+  for (auto& thread : threads)
+    thread.join();
+  return total / std::chrono::duration<double>(kDuration).count();
+}
+
+}  // unnamed namespace
+
+TEST(ShardedMemoryCacheTest, BEH_StoreGetDelete) {
+  ShardedMemoryCache cache(MemoryUsage(64 * kOneKB), 5);
+  EXPECT_EQ(8U, cache.ShardCount());
+  std::vector<std::pair<KeyType, NonEmptyString>> entries;
+  for (int i(0); i != 20; ++i) {
+    entries.push_back(GenerateKeyValue((RandomUint32() % kOneKB) + 1));
+    ASSERT_NO_THROW(cache.Store(entries.back().first, entries.back().second));
+  }
+  EXPECT_EQ(entries.size(), cache.Size());
+  for (const auto& entry : entries) {
+    EXPECT_TRUE(cache.Get(entry.first) == entry.second);
+    EXPECT_TRUE(cache.Find(entry.first)->value() == entry.second);
+  }
+
+  NonEmptyString replacement(RandomAlphaNumericString(10));
+  ASSERT_NO_THROW(cache.Store(entries[0].first, replacement));
+  EXPECT_TRUE(cache.Get(entries[0].first) == replacement);
+  EXPECT_EQ(entries.size(), cache.Size());
+
+  for (const auto& entry : entries) {
+    ASSERT_NO_THROW(cache.Delete(entry.first));
+    EXPECT_THROW(cache.Get(entry.first), maidsafe_error);
+    EXPECT_FALSE(cache.Find(entry.first));
+    EXPECT_THROW(cache.Delete(entry.first), maidsafe_error);
+  }
+  EXPECT_EQ(0U, cache.Size());
+  EXPECT_EQ(0U, cache.GetCurrentMemoryUsage().data);
+}
+
+TEST(ShardedMemoryCacheTest, BEH_SecondChanceEviction) {
+  const uint64_t kCapacity(8);
+  ShardedMemoryCache cache(MemoryUsage(kCapacity * kOneKB), 1);
+  std::vector<std::pair<KeyType, NonEmptyString>> entries;
+  for (uint64_t i(0); i != kCapacity; ++i) {
+    entries.push_back(GenerateKeyValue(kOneKB));
+    ASSERT_NO_THROW(cache.Store(entries.back().first, entries.back().second));
+  }
+
+  // Entries looked up since the hand last passed survive; the oldest unreferenced one goes.
+  ASSERT_NO_THROW(cache.Get(entries[0].first));
+  ASSERT_NO_THROW(cache.Get(entries[1].first));
+  auto extra(GenerateKeyValue(kOneKB));
+  ASSERT_NO_THROW(cache.Store(extra.first, extra.second));
+  EXPECT_NO_THROW(cache.Get(entries[0].first));
+  EXPECT_NO_THROW(cache.Get(entries[1].first));
+  EXPECT_THROW(cache.Get(entries[2].first), maidsafe_error);
+  EXPECT_NO_THROW(cache.Get(extra.first));
+  EXPECT_EQ(kCapacity, cache.Size());
+  EXPECT_EQ(kCapacity * kOneKB, cache.GetCurrentMemoryUsage().data);
+
+  // A value larger than the capacity isn't held, and leaves the cache alone.
+  auto oversized(GenerateKeyValue(kCapacity * kOneKB + 1));
+  ASSERT_NO_THROW(cache.Store(oversized.first, oversized.second));
+  EXPECT_FALSE(cache.Find(oversized.first));
+  EXPECT_EQ(kCapacity, cache.Size());
+
+  // A buffer handed out stays valid after its entry is evicted.
+  ChunkBuffer buffer(cache.GetBuffer(entries[3].first));
+  for (uint64_t i(0); i != 2 * kCapacity; ++i) {
+    auto other(GenerateKeyValue(kOneKB));
+    ASSERT_NO_THROW(cache.Store(other.first, other.second));
+  }
+  EXPECT_FALSE(cache.Find(entries[3].first));
+  EXPECT_TRUE(buffer.value() == entries[3].second);
+}
+
+TEST(ShardedMemoryCacheTest, BEH_Admission) {
+  const uint64_t kCapacity(8);
+  FrequencySketch sketch(64);
+  ShardedMemoryCache cache(MemoryUsage(kCapacity * kOneKB), 1, &sketch);
+  std::vector<std::pair<KeyType, NonEmptyString>> popular;
+  for (uint64_t i(0); i != kCapacity; ++i) {
+    popular.push_back(GenerateKeyValue(kOneKB));
+    ASSERT_NO_THROW(cache.Store(popular.back().first, popular.back().second));
+    for (int j(0); j != 3; ++j)
+      ASSERT_NO_THROW(cache.Get(popular.back().first));
+  }
+
+  // A scan of chunks each seen once doesn't displace the popular ones.
+  const uint64_t kScanSize(50);
+  for (uint64_t i(0); i != kScanSize; ++i) {
+    auto entry(GenerateKeyValue(kOneKB));
+    ASSERT_NO_THROW(cache.Store(entry.first, entry.second));
+  }
+  for (const auto& entry : popular)
+    EXPECT_TRUE(cache.Find(entry.first)) << "Popular entry pushed out by scan";
+  auto statistics(cache.GetStatistics());
+  EXPECT_EQ(kCapacity * 4, statistics.hits);
+  EXPECT_EQ(0U, statistics.misses);
+  EXPECT_EQ(kCapacity + kScanSize, statistics.admitted + statistics.rejected);
+  EXPECT_GE(statistics.rejected, kScanSize - 2);
+
+  // A chunk requested more often than the least popular entry is admitted.
+  auto entry(GenerateKeyValue(kOneKB));
+  for (int i(0); i != 8; ++i)
+    EXPECT_FALSE(cache.Find(entry.first));
+  ASSERT_NO_THROW(cache.Store(entry.first, entry.second));
+  EXPECT_TRUE(cache.Find(entry.first));
+  statistics = cache.GetStatistics();
+  EXPECT_EQ(8U, statistics.misses);
+  EXPECT_DOUBLE_EQ(static_cast<double>(statistics.hits) / (statistics.hits + 8),
+                   statistics.HitRatio());
+}
+
+TEST(ShardedMemoryCacheTest, BEH_Demotion) {
+  const uint64_t kCapacity(4);
+  std::vector<KeyType> demoted;
+  ShardedMemoryCache cache(MemoryUsage(kCapacity * kOneKB), 1, nullptr,
+                           [&](const KeyType& key, const ChunkBuffer& value) {
+                             EXPECT_EQ(kOneKB, value.size());
+                             demoted.push_back(key);
+                           });
+  std::vector<std::pair<KeyType, NonEmptyString>> entries;
+  for (uint64_t i(0); i != kCapacity; ++i) {
+    entries.push_back(GenerateKeyValue(kOneKB));
+    EXPECT_TRUE(cache.Store(entries.back().first, entries.back().second, i % 2 == 0));
+  }
+  auto oversized(GenerateKeyValue(kCapacity * kOneKB + 1));
+  EXPECT_FALSE(cache.Store(oversized.first, oversized.second, true));
+
+  // Only the entries stored for demotion are passed on when evicted.
+  for (uint64_t i(0); i != kCapacity; ++i) {
+    auto other(GenerateKeyValue(kOneKB));
+    EXPECT_TRUE(cache.Store(other.first, other.second));
+  }
+  ASSERT_EQ(2U, demoted.size());
+  EXPECT_TRUE(demoted[0] == entries[0].first);
+  EXPECT_TRUE(demoted[1] == entries[2].first);
+
+  // Nor are deleted or replaced ones.
+  auto extra(GenerateKeyValue(kOneKB));
+  EXPECT_TRUE(cache.Store(extra.first, extra.second, true));
+  EXPECT_TRUE(cache.Store(extra.first, extra.second, true));
+  cache.Delete(extra.first);
+  EXPECT_EQ(2U, demoted.size());
+}
+
+TEST(ShardedMemoryCacheTest, BEH_ConcurrentAccess) {
+  ShardedMemoryCache cache(MemoryUsage(64 * kOneKB), 4);
+  const int kThreadCount(8), kOperationCount(200);
+  std::vector<std::future<void>> futures;
+  for (int i(0); i != kThreadCount; ++i) {
+    futures.push_back(std::async(std::launch::async, [&] {
+      for (int j(0); j != kOperationCount; ++j) {
+        auto entry(GenerateKeyValue((RandomUint32() % kOneKB) + 1));
+        cache.Store(entry.first, entry.second);
+        auto found(cache.Find(entry.first));
+        if (found)
+          EXPECT_TRUE(found->value() == entry.second);
+        try {
+          cache.Delete(entry.first);
+        }
+        catch (const maidsafe_error&) {
+          // Pushed out by the other threads.
+        }
+      }
+    }));
+  }
+  for (auto& future : futures)
+    EXPECT_NO_THROW(future.get());
+  EXPECT_LE(cache.GetCurrentMemoryUsage().data, 64 * kOneKB);
+}
+
+TEST(ShardedMemoryCacheTest, FUNC_HitThroughput) {
+  const size_t kEntryCount(4096);
+  MemoryCache memory_cache(MemoryUsage(kEntryCount * kOneKB * 2));
+  ShardedMemoryCache sharded_cache(MemoryUsage(kEntryCount * kOneKB * 2));
+  std::vector<KeyType> keys;
+  for (size_t i(0); i != kEntryCount; ++i) {
+    auto entry(GenerateKeyValue(kOneKB));
+    keys.push_back(entry.first);
+    memory_cache.Store(entry.first, entry.second);
+    sharded_cache.Store(entry.first, entry.second);
+  }
+  ASSERT_EQ(kEntryCount, sharded_cache.Size());
+
+  unsigned int max_threads(std::max(2 * std::thread::hardware_concurrency(), 8U));
+  std::cout << "Lookups per second (" << sharded_cache.ShardCount() << " shards):\n";
+  for (unsigned int threads(1); threads <= max_threads; threads *= 2) {
+    std::cout << "  " << threads << " thread(s): MemoryCache "
+              << HitThroughput(memory_cache, keys, threads) << ", ShardedMemoryCache "
+              << HitThroughput(sharded_cache, keys, threads) << std::endl;
+  }
+}
+
+TEST(ShardedMemoryCacheTest, FUNC_HitRatio) {
+  // A skewed (Zipf) request stream over a key space ten times the cache's capacity, interleaved
+  // with scans of chunks which are never requested again.
+  const size_t kKeyCount(2000), kCapacity(kKeyCount / 10), kRequestCount(40000);
+  const double kSkew(0.9);
+  std::vector<KeyType> keys;
+  std::vector<double> cumulative;
+  double total(0);
+  for (size_t i(0); i != kKeyCount; ++i) {
+    keys.push_back(GenerateKeyValue(64).first);
+    total += 1.0 / std::pow(static_cast<double>(i + 1), kSkew);
+    cumulative.push_back(total);
+  }
+  std::vector<KeyType> trace;
+  for (size_t i(0); i != kRequestCount; ++i) {
+    if (i % 1000 < 250) {
+      trace.push_back(GenerateKeyValue(64).first);
+    } else {
+      double point(total * RandomUint32() / 4294967296.0);
+      trace.push_back(keys[std::lower_bound(cumulative.begin(), cumulative.end(), point) -
+                           cumulative.begin()]);
+    }
+  }
+
+  ChunkBuffer value(NonEmptyString(RandomString(static_cast<size_t>(kOneKB))));
+  auto replay([&](ShardedMemoryCache& cache) {
+    for (const auto& key : trace) {
+      if (!cache.Find(key))
+        cache.Store(key, value);
+    }
+    return cache.GetStatistics();
+  });
+
+  ShardedMemoryCache clock_cache(MemoryUsage(kCapacity * kOneKB), 1);
+  FrequencySketch sketch(kCapacity);
+  ShardedMemoryCache admission_cache(MemoryUsage(kCapacity * kOneKB), 1, &sketch);
+  auto clock_statistics(replay(clock_cache)), admission_statistics(replay(admission_cache));
+  std::cout << "Hit ratio with CLOCK only: " << clock_statistics.HitRatio()
+            << ", with TinyLFU admission: " << admission_statistics.HitRatio() << " ("
+            << admission_statistics.rejected << " of "
+            << admission_statistics.admitted + admission_statistics.rejected
+            << " stores refused)" << std::endl;
+  EXPECT_GT(admission_statistics.HitRatio(), clock_statistics.HitRatio());
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
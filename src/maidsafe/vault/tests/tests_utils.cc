@@ -26,6 +26,15 @@ namespace vault {
 
 namespace test {
 
+ScopedMetadataBackend::ScopedMetadataBackend(KeyValueBackendType backend)
+    : kDefaultBackend_(detail::Parameters::metadata_backend) {
+  detail::Parameters::metadata_backend = backend;
+}
+
+ScopedMetadataBackend::~ScopedMetadataBackend() {
+  detail::Parameters::metadata_backend = kDefaultBackend_;
+}
+
 routing::NodeInfo MakeNodeInfo(const passport::Pmid& pmid) {
   routing::NodeInfo node;
   node.id = NodeId(pmid.name()->string());
@@ -30,6 +30,7 @@
 #include "maidsafe/nfs/vault/messages.h"
 #include "maidsafe/nfs/client/messages.h"
 
+#include "maidsafe/vault/parameters.h"
 #include "maidsafe/vault/sync.h"
 #include "maidsafe/vault/sync.pb.h"
 #include "maidsafe/vault/utils.h"
@@ -45,6 +46,20 @@ namespace test {
 static const uint64_t kTestChunkSize = 1024 * 1024;
 static const uint64_t kAverageChunksStored = 1000;
 
+// Sets Parameters::metadata_backend for its lifetime, so that the persona databases constructed
+// meanwhile use 'backend'.  A fixture holds one as its first member to run against each backend.
+class ScopedMetadataBackend {
+ public:
+  explicit ScopedMetadataBackend(KeyValueBackendType backend);
+  ~ScopedMetadataBackend();
+
+ private:
+  ScopedMetadataBackend(const ScopedMetadataBackend&);
+  ScopedMetadataBackend& operator=(const ScopedMetadataBackend&);
+
+  const KeyValueBackendType kDefaultBackend_;
+};
+
 routing::NodeInfo MakeNodeInfo(const passport::Pmid& pmid);
 
 template <typename ContentType>
@@ -0,0 +1,120 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/write_behind_queue.h"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace test {
+
+namespace {
+
+typedef WriteBehindQueue::PushResult PushResult;
+
+// Blocks the queue's worker until the returned promise is set.
+std::promise<void> BlockWorker(WriteBehindQueue& queue, size_t key) {
+  std::promise<void> release, started;
+  auto release_future(std::make_shared<std::shared_future<void>>(release.get_future().share()));
+  auto started_future(started.get_future());
+  auto started_promise(std::make_shared<std::promise<void>>(std::move(started)));
+  EXPECT_EQ(PushResult::kQueued, queue.Push(key, 1, [=] {
+    started_promise->set_value();
+    release_future->wait();
+  }));
+  started_future.wait();
+  return release;
+}
+
+}  // unnamed namespace
+
+TEST(WriteBehindQueueTest, BEH_RunsInOrder) {
+  WriteBehindQueue queue(MemoryUsage(1024));
+  std::vector<int> results;
+  std::promise<void> done;
+  for (int i(0); i != 10; ++i)
+    EXPECT_EQ(PushResult::kQueued, queue.Push(i, 1, [&results, i] { results.push_back(i); }));
+  queue.Push(10, 1, [&done] { done.set_value(); });
+  done.get_future().wait();
+  ASSERT_EQ(10U, results.size());
+  for (int i(0); i != 10; ++i)
+    EXPECT_EQ(i, results[i]);
+  EXPECT_EQ(11U, queue.GetStatistics().queued);
+}
+
+TEST(WriteBehindQueueTest, BEH_MergeAndShed) {
+  WriteBehindQueue queue(MemoryUsage(10));
+  auto release(BlockWorker(queue, 0));
+  int first(0), second(0);
+  EXPECT_EQ(PushResult::kQueued, queue.Push(1, 4, [&first] { ++first; }));
+  EXPECT_EQ(PushResult::kMerged, queue.Push(1, 4, [&second] { ++second; }));
+  EXPECT_EQ(PushResult::kQueued, queue.Push(2, 6, [] {}));
+  EXPECT_EQ(PushResult::kShed, queue.Push(3, 1, [] {}));
+  EXPECT_FALSE(queue.HasRoomFor(1));
+  EXPECT_TRUE(queue.HasRoomFor(0));
+  EXPECT_EQ(2U, queue.Size());
+  EXPECT_EQ(10U, queue.GetQueuedSize().data);
+
+  // A key can be queued again once its task has started.
+  std::promise<void> done;
+  release.set_value();
+  while (queue.Size() != 0)
+    std::this_thread::yield();
+  EXPECT_EQ(PushResult::kQueued, queue.Push(1, 4, [&done] { done.set_value(); }));
+  done.get_future().wait();
+  EXPECT_EQ(1, first);
+  EXPECT_EQ(0, second);
+
+  auto statistics(queue.GetStatistics());
+  EXPECT_EQ(4U, statistics.queued);
+  EXPECT_EQ(1U, statistics.merged);
+  EXPECT_EQ(2U, statistics.shed);
+}
+
+TEST(WriteBehindQueueTest, BEH_Stop) {
+  std::unique_ptr<WriteBehindQueue> queue(new WriteBehindQueue(MemoryUsage(1024)));
+  auto release(BlockWorker(*queue, 0));
+  bool ran(false);
+  EXPECT_EQ(PushResult::kQueued, queue->Push(1, 1, [&ran] { ran = true; }));
+  std::thread releaser([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    release.set_value();
+  });
+  // Waits for the running task, and discards the pending one.
+  queue->Stop();
+  releaser.join();
+  EXPECT_FALSE(ran);
+  EXPECT_FALSE(queue->HasRoomFor(1));
+  EXPECT_EQ(PushResult::kShed, queue->Push(2, 1, [] {}));
+  queue.reset();
+}
+
+}  // namespace test
+
+}  // namespace vault
+
+}  // namespace maidsafe
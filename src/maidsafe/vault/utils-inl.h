@@ -88,35 +88,47 @@ template <typename Key, typename Value, typename TransferInfo>
 TransferInfo GetTransferInfo(
     std::shared_ptr<routing::CloseNodesChange> close_nodes_change,
     std::map<Key, Value>& accounts) {
+  return GetTransferInfo<Key, Value, TransferInfo>(close_nodes_change, accounts,
+                                                   std::vector<IdRange>(1, WholeIdRange()));
+}
+
+template <typename Key, typename Value, typename TransferInfo>
+TransferInfo GetTransferInfo(
+    std::shared_ptr<routing::CloseNodesChange> close_nodes_change,
+    std::map<Key, Value>& accounts, const std::vector<IdRange>& ranges) {
   std::vector<Key> prune_vector;
   TransferInfo transfer_info;
   LOG(kVerbose) << "GetTransferInfo";
-  for (auto& account : accounts) {
-    auto check_holder_result = close_nodes_change->CheckHolders(
-          NodeId(account.first->string()));
-    if (check_holder_result.proximity_status == routing::GroupRangeStatus::kInRange) {
-      LOG(kVerbose) << "GetTransferInfo in range";
-      if (check_holder_result.new_holder == NodeId())
-        continue;
-      LOG(kVerbose) << "GetTransferInfo having new holder "
-                    << check_holder_result.new_holder;
-      auto found_itr = transfer_info.find(check_holder_result.new_holder);
-      if (found_itr != transfer_info.end()) {
-        LOG(kInfo) << "GetTransferInfo add into transfering account "
-                   << HexSubstr(account.first->string())
-                   << " to " << check_holder_result.new_holder;
-        found_itr->second.push_back(account);
-      } else {  // create
-        LOG(kInfo) << "GetTransferInfo create transfering account "
-                   << HexSubstr(account.first->string())
-                   << " to " << check_holder_result.new_holder;
-        std::vector<std::pair<Key, Value>> kv_pair;
-        kv_pair.push_back(account);
-        transfer_info.insert(std::make_pair(check_holder_result.new_holder, std::move(kv_pair)));
+  for (const auto& range : ranges) {
+    auto range_end(accounts.upper_bound(Key(Identity(range.second))));
+    for (auto itr(accounts.lower_bound(Key(Identity(range.first)))); itr != range_end; ++itr) {
+      const auto& account(*itr);
+      auto check_holder_result = close_nodes_change->CheckHolders(
+            NodeId(account.first->string()));
+      if (check_holder_result.proximity_status == routing::GroupRangeStatus::kInRange) {
+        LOG(kVerbose) << "GetTransferInfo in range";
+        if (check_holder_result.new_holder == NodeId())
+          continue;
+        LOG(kVerbose) << "GetTransferInfo having new holder "
+                      << check_holder_result.new_holder;
+        auto found_itr = transfer_info.find(check_holder_result.new_holder);
+        if (found_itr != transfer_info.end()) {
+          LOG(kInfo) << "GetTransferInfo add into transfering account "
+                     << HexSubstr(account.first->string())
+                     << " to " << check_holder_result.new_holder;
+          found_itr->second.push_back(account);
+        } else {  // create
+          LOG(kInfo) << "GetTransferInfo create transfering account "
+                     << HexSubstr(account.first->string())
+                     << " to " << check_holder_result.new_holder;
+          std::vector<std::pair<Key, Value>> kv_pair;
+          kv_pair.push_back(account);
+          transfer_info.insert(std::make_pair(check_holder_result.new_holder, std::move(kv_pair)));
+        }
+      } else {
+//        VLOG(VisualiserAction::kRemoveAccount, account.first.name);
+        prune_vector.push_back(account.first);
       }
-    } else {
-//      VLOG(VisualiserAction::kRemoveAccount, account.first.name);
-      prune_vector.push_back(account.first);
     }
   }
 
@@ -28,6 +28,7 @@
 #include "maidsafe/common/data_types/data_name_variant.h"
 #include "maidsafe/routing/routing_api.h"
 
+#include "maidsafe/vault/close_nodes_tracker.h"
 #include "maidsafe/vault/key.h"
 #include "maidsafe/nfs/message_types.h"
 #include "maidsafe/vault/sync.h"
@@ -49,6 +50,13 @@ TransferInfo GetTransferInfo(
     std::shared_ptr<routing::CloseNodesChange> close_nodes_change,
     std::map<Key, Value>& accounts);
 
+// As above, but checks only the accounts with ids in 'ranges' (sorted and disjoint, as returned by
+// CloseNodesTracker::Update), so costs O(log(accounts) per range + accounts checked).
+template <typename Key, typename Value, typename TransferInfo>
+TransferInfo GetTransferInfo(
+    std::shared_ptr<routing::CloseNodesChange> close_nodes_change,
+    std::map<Key, Value>& accounts, const std::vector<IdRange>& ranges);
+
 boost::optional<PmidName> GetRandomCloseNode(
     routing::Routing& routing, const std::vector<PmidName> &exclude = std::vector<PmidName>());
 
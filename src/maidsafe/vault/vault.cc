@@ -42,19 +42,21 @@ Vault::Vault(const vault_manager::VaultConfig& vault_config)
       data_getter_(asio_service_, *routing_),
       public_pmid_helper_(),
       maid_manager_service_(std::move(std::unique_ptr<MaidManagerService>(new MaidManagerService(
-          vault_config.pmid, *routing_, data_getter_, vault_config.vault_dir)))),
+          vault_config.pmid, *routing_, data_getter_, vault_config.vault_dir, asio_service_)))),
       version_handler_service_(std::move(std::unique_ptr<VersionHandlerService>(
           new VersionHandlerService(vault_config.pmid, *routing_, vault_config.vault_dir)))),
       data_manager_service_(std::move(std::unique_ptr<DataManagerService>(new DataManagerService(
-          vault_config.pmid, *routing_, data_getter_, vault_config.vault_dir)))),
+          vault_config.pmid, *routing_, data_getter_, vault_config.vault_dir, asio_service_)))),
       pmid_manager_service_(std::move(std::unique_ptr<PmidManagerService>(
-          new PmidManagerService(vault_config.pmid, *routing_)))),
+          new PmidManagerService(vault_config.pmid, *routing_, asio_service_)))),
       pmid_node_service_(std::move(std::unique_ptr<PmidNodeService>(
           new PmidNodeService(vault_config.pmid, *routing_, data_getter_, vault_config.vault_dir,
                               vault_config.max_disk_usage)))),
       // FIXME need to specialise
       cache_service_(std::move(std::unique_ptr<CacheHandlerService>(
-          new CacheHandlerService(*routing_, vault_config.vault_dir)))),
+          new CacheHandlerService(*routing_, vault_config.vault_dir,
+                                  vault_config.max_disk_usage)))),
+      cache_store_queue_(detail::Parameters::cache_store_queue_size),
       demux_(maid_manager_service_, version_handler_service_, data_manager_service_,
              pmid_manager_service_, pmid_node_service_, data_getter_),
       getting_keys_()
@@ -83,6 +85,7 @@ Vault::~Vault() {
   Stop();
   asio_service_.Stop();
   routing_.reset();
+  cache_store_queue_.Stop();
 }
 
 #ifdef TESTING
@@ -171,6 +174,16 @@ void Vault::OnCloseNodesChange(std::shared_ptr<routing::CloseNodesChange> close_
   asio_service_.service().post([=] { pmid_manager_service_.HandleChurnEvent(close_nodes_change); });
 }
 
+size_t Vault::CacheStoreKey(const std::string& contents) {
+  // Covers the size and a fixed-size slice off the end of the message, which for a message
+  // carrying a chunk falls within the chunk's content, so its copies addressed to different
+  // requesters share a key.  Two different chunks sharing one only cost a cache store.
+  const size_t kSliceSize(128);
+  const size_t kOffset(contents.size() > kSliceSize ? contents.size() - kSliceSize : 0);
+  size_t key(std::hash<std::string>()(contents.substr(kOffset)));
+  return key ^ (std::hash<size_t>()(contents.size()) + 0x9e3779b9 + (key << 6) + (key >> 2));
+}
+
 }  // namespace vault
 
 }  // namespace maidsafe
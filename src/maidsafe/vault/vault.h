@@ -22,6 +22,8 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 
 #include "boost/filesystem/path.hpp"
@@ -42,6 +44,8 @@
 #include "maidsafe/vault/cache_handler/service.h"
 #include "maidsafe/vault/db.h"
 #include "maidsafe/vault/demultiplexer.h"
+#include "maidsafe/vault/parameters.h"
+#include "maidsafe/vault/write_behind_queue.h"
 
 
 namespace maidsafe {
@@ -87,6 +91,8 @@ class Vault {
   bool OnGetFromCache(const T& message);
   template <typename T>
   void OnStoreInCache(const T& message);
+  // Cheap digest of a cacheable message's serialised contents, identifying the chunk it carries.
+  static size_t CacheStoreKey(const std::string& contents);
   template <typename Sender, typename Receiver>
   bool HandleGetFromCache(const nfs::TypeErasedMessageWrapper message, const Sender& sender,
                           const Receiver& receiver);
@@ -105,6 +111,8 @@ class Vault {
   nfs::Service<PmidManagerService> pmid_manager_service_;
   nfs::Service<PmidNodeService> pmid_node_service_;
   nfs::Service<CacheHandlerService> cache_service_;
+  // Stores cacheable messages into cache_service_, so must be stopped before it's destroyed.
+  WriteBehindQueue cache_store_queue_;
   Demultiplexer demux_;
   std::vector<std::future<void>> getting_keys_;
 #ifdef TESTING
@@ -128,16 +136,32 @@ CacheHandlerService::HandleMessageReturnType Vault::OnGetFromCache(const T& mess
   return cache_service_.HandleMessage(wrapper_tuple, message.sender, message.receiver);
 }
 
+// Invoked on a routing thread for every cacheable message passing through, so does as little as
+// possible there: a message for which the queue has no room is dropped before it's copied, and the
+// message is only parsed by the queued task, on cache_store_queue_'s low-priority thread.  It's
+// keyed on a digest of its raw contents, so that copies of the same chunk (e.g. responses to
+// several requesters) can be coalesced while queued.
 template <typename T>
 void Vault::OnStoreInCache(const T& message) {
-  // TODO(Team): To investigate the cost of running in new thread (as below) versus allowing
-  //             the operation to continue on caller (routing) thread.
   LOG(kVerbose) << "Vault::OnStoreInCache: ";
-  asio_service_.service().post([=] {
-    LOG(kVerbose) << "Vault::OnStoreInCache2: ";
-    auto wrapper_tuple(nfs::ParseMessageWrapper(message.contents));
-    cache_service_.HandleMessage(wrapper_tuple, message.sender, message.receiver);
-  });
+  if (!cache_store_queue_.HasRoomFor(message.contents.size())) {
+    LOG(kInfo) << "Cache store queue is full; not caching message.";
+    return;
+  }
+  auto contents(std::make_shared<std::string>(message.contents));
+  auto sender(message.sender);
+  auto receiver(message.receiver);
+  auto result(cache_store_queue_.Push(
+      CacheStoreKey(*contents), contents->size(),
+      [this, contents, sender, receiver] {
+        auto wrapper_tuple(nfs::ParseMessageWrapper(*contents));
+        static_assert(std::is_same<decltype(std::get<4>(wrapper_tuple)), std::string&>::value,
+                      "The value retrieved from the tuple isn't the serialised payload, but "
+                      "should be.");
+        cache_service_.HandleMessage(wrapper_tuple, sender, receiver);
+      }));
+  if (result == WriteBehindQueue::PushResult::kShed)
+    LOG(kInfo) << "Cache store queue is full; not caching message.";
 }
 
 }  // namespace vault
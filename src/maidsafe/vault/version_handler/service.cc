@@ -69,6 +69,7 @@ VersionHandlerService::VersionHandlerService(const passport::Pmid& pmid,
       accumulator_(),
       close_nodes_change_(),
       db_(UniqueDbPath(vault_root_dir)),
+      resolved_commits_(db_),
       kThisNodeId_(routing_.kNodeId()),
       sync_create_version_tree_(NodeId(pmid.name()->string())),
       sync_put_versions_(NodeId(pmid.name()->string())),
@@ -200,7 +201,7 @@ void VersionHandlerService::HandleMessage(
       if (resolved_action) {
         try {
           LOG(kInfo) << "VersionHandlerSync -- CreateVersionTree -Commit: " << message.id;
-          db_.Commit(resolved_action->key, resolved_action->action);
+          resolved_commits_.Commit(resolved_action->key, resolved_action->action);
           dispatcher_.SendCreateVersionTreeResponse(
               resolved_action->action.originator, resolved_action->key,
               maidsafe_error(CommonErrors::success), resolved_action->action.message_id);
@@ -224,7 +225,7 @@ void VersionHandlerService::HandleMessage(
       if (resolved_action) {
         try {
           LOG(kInfo) << "VersionHandlerSyncPut-Commit: " << message.id;
-          db_.Commit(resolved_action->key, resolved_action->action);
+          resolved_commits_.Commit(resolved_action->key, resolved_action->action);
           StructuredDataVersions::VersionName tip_of_tree;
           if (resolved_action->action.tip_of_tree) {
             tip_of_tree = *resolved_action->action.tip_of_tree;
@@ -249,7 +250,7 @@ void VersionHandlerService::HandleMessage(
       auto resolved_action(sync_delete_branch_until_fork_.AddUnresolvedAction(unresolved_action));
       if (resolved_action) {
         try {
-          db_.Commit(resolved_action->key, resolved_action->action);
+          resolved_commits_.Commit(resolved_action->key, resolved_action->action);
           // BEFORE_RELEASE DOES IT NEED RESPONSE?
         }
         catch (const maidsafe_error& /*error*/) {
@@ -37,6 +37,7 @@
 
 #include "maidsafe/vault/account_transfer.h"
 #include "maidsafe/vault/accumulator.h"
+#include "maidsafe/vault/commit_queue.h"
 #include "maidsafe/vault/db.h"
 #include "maidsafe/vault/sync.h"
 #include "maidsafe/vault/sync.pb.h"
@@ -157,6 +158,8 @@ class VersionHandlerService {
   Accumulator<Messages> accumulator_;
   routing::CloseNodesChange close_nodes_change_;
   Db<VersionHandler::Key, VersionHandler::Value> db_;
+  // Commits the actions resolved by concurrently handled sync messages in shared batches.
+  CommitQueue<Db<VersionHandler::Key, VersionHandler::Value>> resolved_commits_;
   const NodeId kThisNodeId_;
   Sync<VersionHandler::UnresolvedCreateVersionTree> sync_create_version_tree_;
   Sync<VersionHandler::UnresolvedPutVersion> sync_put_versions_;
@@ -36,10 +36,12 @@ namespace {
 typedef StructuredDataVersions::VersionName VersionName;
 }
 
-class VersionHandlerServiceTest : public testing::Test {
+// Runs each test against every backend.
+class VersionHandlerServiceTest : public testing::TestWithParam<KeyValueBackendType> {
  public:
   VersionHandlerServiceTest()
-      : pmid_(passport::CreatePmidAndSigner().first),
+      : metadata_backend_(GetParam()),
+        pmid_(passport::CreatePmidAndSigner().first),
         kTestRoot_(maidsafe::test::CreateTestPath("MaidSafe_Test_Vault")),
         vault_root_dir_(*kTestRoot_),
         routing_(pmid_),
@@ -60,6 +62,8 @@ class VersionHandlerServiceTest : public testing::Test {
                 const std::vector<routing::GroupSource>& group_source);
 
  protected:
+  // Selects the backend of version_handler_service_'s db, so constructed first.
+  const ScopedMetadataBackend metadata_backend_;
   passport::Pmid pmid_;
   const maidsafe::test::TestPath kTestRoot_;
   boost::filesystem::path vault_root_dir_;
@@ -107,7 +111,7 @@ void VersionHandlerServiceTest::SendSync<VersionHandler::UnresolvedDeleteBranchU
       unresolved_actions, group_source);
 }
 
-TEST_F(VersionHandlerServiceTest, BEH_GetVersionsRequestFromMaidNodeToVersionHandler) {
+TEST_P(VersionHandlerServiceTest, BEH_GetVersionsRequestFromMaidNodeToVersionHandler) {
   routing::SingleSource maid_node((NodeId(RandomString(NodeId::kSize))));
   routing::GroupId version_group_id((NodeId(RandomString(NodeId::kSize))));
   auto content(CreateContent<nfs::GetVersionsRequestFromMaidNodeToVersionHandler::Contents>());
@@ -116,7 +120,7 @@ TEST_F(VersionHandlerServiceTest, BEH_GetVersionsRequestFromMaidNodeToVersionHan
       SingleSendsToGroup(&version_handler_service_, get_version, maid_node, version_group_id));
 }
 
-TEST_F(VersionHandlerServiceTest, BEH_GetVersionsRequestFromDataGetterToVersionHandler) {
+TEST_P(VersionHandlerServiceTest, BEH_GetVersionsRequestFromDataGetterToVersionHandler) {
   routing::SingleSource data_getter_id((NodeId(RandomString(NodeId::kSize))));
   routing::GroupId version_group_id((NodeId(RandomString(NodeId::kSize))));
   auto content(CreateContent<nfs::GetVersionsRequestFromDataGetterToVersionHandler::Contents>());
@@ -125,7 +129,7 @@ TEST_F(VersionHandlerServiceTest, BEH_GetVersionsRequestFromDataGetterToVersionH
       SingleSendsToGroup(&version_handler_service_, get_version, data_getter_id, version_group_id));
 }
 
-TEST_F(VersionHandlerServiceTest, BEH_GetBranchRequestFromMaidNodeToVersionHandler) {
+TEST_P(VersionHandlerServiceTest, BEH_GetBranchRequestFromMaidNodeToVersionHandler) {
   routing::SingleSource maid_node((NodeId(RandomString(NodeId::kSize))));
   routing::GroupId version_group_id((NodeId(RandomString(NodeId::kSize))));
   auto content(CreateContent<nfs::GetBranchRequestFromMaidNodeToVersionHandler::Contents>());
@@ -134,7 +138,7 @@ TEST_F(VersionHandlerServiceTest, BEH_GetBranchRequestFromMaidNodeToVersionHandl
       SingleSendsToGroup(&version_handler_service_, get_branch, maid_node, version_group_id));
 }
 
-TEST_F(VersionHandlerServiceTest, BEH_GetBranchRequestFromDataGetterToVersionHandler) {
+TEST_P(VersionHandlerServiceTest, BEH_GetBranchRequestFromDataGetterToVersionHandler) {
   routing::SingleSource data_getter_id((NodeId(RandomString(NodeId::kSize))));
   routing::GroupId version_group_id((NodeId(RandomString(NodeId::kSize))));
   auto content(CreateContent<nfs::GetBranchRequestFromDataGetterToVersionHandler::Contents>());
@@ -143,7 +147,7 @@ TEST_F(VersionHandlerServiceTest, BEH_GetBranchRequestFromDataGetterToVersionHan
       SingleSendsToGroup(&version_handler_service_, get_branch, data_getter_id, version_group_id));
 }
 
-TEST_F(VersionHandlerServiceTest, BEH_CreateVersioTreenRequestFromMaidManagerToVersionHandler) {
+TEST_P(VersionHandlerServiceTest, BEH_CreateVersioTreenRequestFromMaidManagerToVersionHandler) {
   auto group_source(CreateGroupSource((NodeId(RandomString(NodeId::kSize)))));
   routing::GroupId version_group_id((NodeId(RandomString(NodeId::kSize))));
   auto content(CreateContent<CreateVersionTreeRequestFromMaidManagerToVersionHandler::Contents>());
@@ -153,7 +157,7 @@ TEST_F(VersionHandlerServiceTest, BEH_CreateVersioTreenRequestFromMaidManagerToV
       GroupSendToGroup(&version_handler_service_, create_version, group_source, version_group_id));
 }
 
-TEST_F(VersionHandlerServiceTest, BEH_PutVersionRequestFromMaidManagerToVersionHandler) {
+TEST_P(VersionHandlerServiceTest, BEH_PutVersionRequestFromMaidManagerToVersionHandler) {
   auto group_source(CreateGroupSource((NodeId(RandomString(NodeId::kSize)))));
   routing::GroupId version_group_id((NodeId(RandomString(NodeId::kSize))));
   auto content(CreateContent<PutVersionRequestFromMaidManagerToVersionHandler::Contents>());
@@ -162,7 +166,7 @@ TEST_F(VersionHandlerServiceTest, BEH_PutVersionRequestFromMaidManagerToVersionH
       GroupSendToGroup(&version_handler_service_, put_version, group_source, version_group_id));
 }
 
-TEST_F(VersionHandlerServiceTest, BEH_DeleteBranchUntilForkRequestFromMaidManagerToVersionHandler) {
+TEST_P(VersionHandlerServiceTest, BEH_DeleteBranchUntilForkRequestFromMaidManagerToVersionHandler) {
   auto group_source(CreateGroupSource((NodeId(RandomString(NodeId::kSize)))));
   routing::GroupId version_group_id((NodeId(RandomString(NodeId::kSize))));
   auto content(
@@ -173,7 +177,7 @@ TEST_F(VersionHandlerServiceTest, BEH_DeleteBranchUntilForkRequestFromMaidManage
       GroupSendToGroup(&version_handler_service_, delete_branch, group_source, version_group_id));
 }
 
-TEST_F(VersionHandlerServiceTest, BEH_SynchroniseFromVersionHandlerToVersionHandler) {
+TEST_P(VersionHandlerServiceTest, BEH_SynchroniseFromVersionHandlerToVersionHandler) {
   NodeId group_id(RandomString(NodeId::kSize));
   auto group_source(CreateGroupSource(group_id));
   routing::GroupId version_group_id(group_id);
@@ -183,7 +187,7 @@ TEST_F(VersionHandlerServiceTest, BEH_SynchroniseFromVersionHandlerToVersionHand
       GroupSendToGroup(&version_handler_service_, sync, group_source, version_group_id));
 }
 
-TEST_F(VersionHandlerServiceTest, BEH_CreateVersionTree) {
+TEST_P(VersionHandlerServiceTest, BEH_CreateVersionTree) {
   NodeId sender_id(RandomString(NodeId::kSize));
   Identity originator(NodeId(RandomString(NodeId::kSize)).string());
   auto content(CreateContent<nfs_vault::VersionTreeCreation>());
@@ -199,7 +203,7 @@ TEST_F(VersionHandlerServiceTest, BEH_CreateVersionTree) {
   EXPECT_NO_THROW(Get(key));
 }
 
-TEST_F(VersionHandlerServiceTest, BEH_PutVersion) {
+TEST_P(VersionHandlerServiceTest, BEH_PutVersion) {
   NodeId sender_id(RandomString(NodeId::kSize));
   Identity originator(NodeId(RandomString(NodeId::kSize)).string());
   auto content(CreateContent<nfs_vault::DataNameOldNewVersion>());
@@ -217,7 +221,7 @@ TEST_F(VersionHandlerServiceTest, BEH_PutVersion) {
   EXPECT_NO_THROW(Get(key));
 }
 
-TEST_F(VersionHandlerServiceTest, BEH_DeleteBranchUntilFork) {
+TEST_P(VersionHandlerServiceTest, BEH_DeleteBranchUntilFork) {
   NodeId sender_id(RandomString(NodeId::kSize));
   Identity originator(NodeId(RandomString(NodeId::kSize)).string());
   VersionHandler::Key key(Identity(RandomString(64)), ImmutableData::Tag::kValue);
@@ -256,6 +260,10 @@ TEST_F(VersionHandlerServiceTest, BEH_DeleteBranchUntilFork) {
   EXPECT_ANY_THROW(Get(key).GetBranch(v4_iii));
 }
 
+INSTANTIATE_TEST_CASE_P(Backends, VersionHandlerServiceTest,
+                        testing::Values(KeyValueBackendType::kSqlite, KeyValueBackendType::kMemory,
+                                        KeyValueBackendType::kLsm));
+
 }  //  namespace test
 
 }  //  namespace vault
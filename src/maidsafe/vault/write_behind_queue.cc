@@ -0,0 +1,170 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/vault/write_behind_queue.h"
+
+#ifdef MAIDSAFE_WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifdef MAIDSAFE_LINUX
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <utility>
+
+#include "boost/exception/diagnostic_information.hpp"
+
+#include "maidsafe/common/log.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+namespace {
+
+// The thread's tasks take locks shared with request handling (e.g. the memory cache's shard
+// locks), so it must never be starved of CPU time outright, or it could hold one of them
+// indefinitely (i.e. no SCHED_IDLE).  It's just given a smaller share.
+void LowerCurrentThreadPriority() {
+#if defined(MAIDSAFE_WIN32)
+  if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST))
+    LOG(kWarning) << "Failed to lower the write-behind thread's priority.";
+#elif defined(MAIDSAFE_LINUX)
+  // Treated as CPU-bound by the scheduler, and niced, which on Linux applies to this thread only.
+  sched_param param;
+  param.sched_priority = 0;
+  if (pthread_setschedparam(pthread_self(), SCHED_BATCH, &param) != 0 ||
+      setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10) != 0) {
+    LOG(kWarning) << "Failed to lower the write-behind thread's priority.";
+  }
+#else
+  sched_param param;
+  param.sched_priority = sched_get_priority_min(SCHED_OTHER);
+  if (pthread_setschedparam(pthread_self(), SCHED_OTHER, &param) != 0)
+    LOG(kWarning) << "Failed to lower the write-behind thread's priority.";
+#endif
+}
+
+}  // unnamed namespace
+
+WriteBehindQueue::WriteBehindQueue(MemoryUsage max_queued_size)
+    : kMaxQueuedSize_(max_queued_size.data),
+      mutex_(),
+      condition_(),
+      entries_(),
+      keys_(),
+      queued_size_(0),
+      statistics_(),
+      stop_(false),
+      worker_([this] { Run(); }) {}
+
+WriteBehindQueue::~WriteBehindQueue() { Stop(); }
+
+WriteBehindQueue::PushResult WriteBehindQueue::Push(size_t key, uint64_t size, Task task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (keys_.count(key) != 0) {
+      ++statistics_.merged;
+      return PushResult::kMerged;
+    }
+    if (stop_ || queued_size_ + size > kMaxQueuedSize_) {
+      ++statistics_.shed;
+      return PushResult::kShed;
+    }
+    Entry entry = {key, size, std::move(task)};
+    entries_.push_back(std::move(entry));
+    keys_.insert(key);
+    queued_size_ += size;
+    ++statistics_.queued;
+  }
+  condition_.notify_one();
+  return PushResult::kQueued;
+}
+
+bool WriteBehindQueue::HasRoomFor(uint64_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (stop_ || queued_size_ + size > kMaxQueuedSize_) {
+    ++statistics_.shed;
+    return false;
+  }
+  return true;
+}
+
+void WriteBehindQueue::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    entries_.clear();
+    keys_.clear();
+    queued_size_ = 0;
+  }
+  condition_.notify_one();
+  if (worker_.joinable())
+    worker_.join();
+}
+
+size_t WriteBehindQueue::Size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+MemoryUsage WriteBehindQueue::GetQueuedSize() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return MemoryUsage(queued_size_);
+}
+
+WriteBehindQueue::Statistics WriteBehindQueue::GetStatistics() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return statistics_;
+}
+
+void WriteBehindQueue::Run() {
+  LowerCurrentThreadPriority();
+  for (;;) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this] { return stop_ || !entries_.empty(); });
+      if (stop_)
+        return;
+      task = std::move(entries_.front().task);
+      // The key is released before the task runs, so a write arriving meanwhile isn't lost.
+      keys_.erase(entries_.front().key);
+      queued_size_ -= entries_.front().size;
+      entries_.pop_front();
+    }
+    try {
+      task();
+    }
+    catch (const std::exception& e) {
+      LOG(kError) << "Write-behind task failed: " << boost::diagnostic_information(e);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++statistics_.completed;
+  }
+}
+
+}  // namespace vault
+
+}  // namespace maidsafe
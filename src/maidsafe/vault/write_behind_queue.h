@@ -0,0 +1,96 @@
+/*  Copyright 2014 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.maidsafe.net/licenses
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_VAULT_WRITE_BEHIND_QUEUE_H_
+#define MAIDSAFE_VAULT_WRITE_BEHIND_QUEUE_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+#include "maidsafe/common/types.h"
+
+namespace maidsafe {
+
+namespace vault {
+
+// Bounded queue of deferrable writes (such as cache stores), run in order on a dedicated thread of
+// reduced scheduling priority, so that they yield to request handling.  The thread isn't given
+// idle priority, since its tasks can hold locks which request handling waits on.
+//
+// Each task is pushed with a key identifying what it writes; a task whose key is already queued
+// is merged with (i.e. dropped in favour of) the queued one.  The queue is bounded by the total of
+// the sizes given for its tasks, and sheds new tasks while full rather than blocking the caller.
+class WriteBehindQueue {
+ public:
+  typedef std::function<void()> Task;
+
+  enum class PushResult { kQueued, kMerged, kShed };
+
+  struct Statistics {
+    Statistics() : queued(0), merged(0), shed(0), completed(0) {}
+    uint64_t queued, merged, shed, completed;
+  };
+
+  explicit WriteBehindQueue(MemoryUsage max_queued_size);
+  // Discards any tasks not yet started, and waits for the running one.
+  ~WriteBehindQueue();
+  WriteBehindQueue(const WriteBehindQueue&) = delete;
+  WriteBehindQueue& operator=(const WriteBehindQueue&) = delete;
+
+  // Tasks are expected to handle their own errors; any exception escaping one is logged.
+  PushResult Push(size_t key, uint64_t size, Task task);
+  // Returns false, counting the task as shed, if a task of 'size' would be shed were it pushed now.
+  // Lets a caller skip the cost of preparing a task for which there's no room.
+  bool HasRoomFor(uint64_t size);
+  // As the destructor; subsequent pushes are shed.
+  void Stop();
+
+  size_t Size() const;
+  MemoryUsage GetQueuedSize() const;
+  Statistics GetStatistics() const;
+
+ private:
+  struct Entry {
+    size_t key;
+    uint64_t size;
+    Task task;
+  };
+
+  void Run();
+
+  const uint64_t kMaxQueuedSize_;
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<Entry> entries_;
+  std::unordered_set<size_t> keys_;
+  uint64_t queued_size_;
+  Statistics statistics_;
+  bool stop_;
+  std::thread worker_;
+};
+
+}  // namespace vault
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_VAULT_WRITE_BEHIND_QUEUE_H_